@@ -23,7 +23,7 @@ function wasmTextPlugin({ debug } = {}) {
         };
       });
       build.onLoad({ filter: /.*/, namespace: "wasm-text" }, async (args) => {
-        let flags = [];
+        let flags = ["--enable-exceptions"];
         if (debug) {
           flags.push("--debug-names");
         }
@@ -110,7 +110,7 @@ function parseDataElement(line: string): DataElement | null {
   if (!line.match(/^\s*\(data\s+/)) {
     return null;
   }
-  if (line.match(/= MODULE_HEADER_BASE/)) {
+  if (line.match(/= (MODULE_HEADER_BASE|INLINE_TEMPLATES_BASE|OPERATOR_BASE)/)) {
     return null;
   }
 
@@ -0,0 +1,25 @@
+\ Counts the prime numbers below a limit, by trial division. The range is
+\ split into segments, which are counted in parallel (see PAR-DO).
+
+64 CONSTANT SEGMENTS
+CREATE COUNTS SEGMENTS CELLS ALLOT
+VARIABLE LIMIT
+
+: PRIME? ( n -- flag )
+  DUP 2 < IF DROP FALSE EXIT THEN
+  2 BEGIN 2DUP DUP * < 0= WHILE
+    2DUP MOD 0= IF 2DROP FALSE EXIT THEN
+    1+
+  REPEAT 2DROP TRUE ;
+
+: SEGMENT-BOUNDS ( segment -- end start )
+  DUP 1+ LIMIT @ SEGMENTS */ SWAP LIMIT @ SEGMENTS */ ;
+
+: COUNT-SEGMENT ( segment -- )
+  0 OVER SEGMENT-BOUNDS ?DO I PRIME? IF 1+ THEN LOOP
+  SWAP CELLS COUNTS + ! ;
+
+: PRIMES ( n -- count )
+  LIMIT !
+  SEGMENTS 0 ['] COUNT-SEGMENT PAR-DO
+  COUNTS SEGMENTS VSUM ;
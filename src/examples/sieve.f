@@ -1,10 +1,13 @@
 ( Copied from https://rosettacode.org/wiki/Sieve_of_Eratosthenes#Forth )
 
-: prime? HERE + C@ 0= ;
-: composite! HERE + 1 SWAP C! ;
+0 VALUE flags
+
+: prime? flags + C@ 0= ;
+: composite! flags + 1 SWAP C! ;
 
 : sieve
-  HERE OVER ERASE
+  HERE TO flags  DUP ALLOT
+  flags OVER ERASE
   2
   BEGIN
     2DUP DUP * >
@@ -18,4 +21,5 @@
   REPEAT
   DROP
   1 SWAP 2 DO I prime? IF DROP I THEN LOOP .
+  flags HERE - ALLOT
 ;
@@ -0,0 +1,197 @@
+// Line-based input for the native hosts.
+//
+// Regular files are memory-mapped (or read in one go where mmap is not
+// available), and other input (terminals, pipes) is read in chunks into a
+// buffer. Lines are found with `memchr`, and copied once, straight into the
+// target buffer (the core's input buffer).
+//
+// Shared by the standalone hosts and the waforthc runtime.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#include <io.h>
+#define INPUT_NO_MMAP
+#define input_sys_read _read
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#define input_sys_read read
+#endif
+
+// Size of the chunks in which streaming input is read
+#define INPUT_CHUNK_SIZE 0x10000
+
+// Return value of `input_read_line` for lines that don't fit the target buffer
+#define INPUT_LINE_TOO_LONG -1
+
+typedef struct {
+  const char *data; // Available input
+  size_t size;      // Size of `data`
+  size_t offset;    // Read position in `data`
+  bool complete;    // Whether `data` holds all remaining input
+
+  int fd;        // Streamed file descriptor, or -1
+  char *buffer;  // Owned buffer (streaming input, or files read in one go)
+  size_t capacity;
+  bool mapped; // Whether `data` is a mapping of the file
+
+  size_t lines; // Number of lines read
+} input_t;
+
+static inline void input_init(input_t *in) {
+  memset(in, 0, sizeof(*in));
+  in->fd = -1;
+}
+
+// Reads from in-memory data. The data needs to outlive the input.
+static inline void input_open_memory(input_t *in, const char *data, size_t size) {
+  input_init(in);
+  in->data = data;
+  in->size = size;
+  in->complete = true;
+}
+
+// Reads from a file descriptor.
+// Returns false (and sets errno) on failure.
+static inline bool input_open_fd(input_t *in, int fd) {
+  input_init(in);
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    size_t size = st.st_size;
+    if (size == 0) {
+      in->complete = true;
+      return true;
+    }
+#ifndef INPUT_NO_MMAP
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      madvise(data, size, MADV_SEQUENTIAL);
+      in->data = (const char *)data;
+      in->size = size;
+      in->complete = true;
+      in->mapped = true;
+      return true;
+    }
+#endif
+    // Read the whole file in one go
+    if ((in->buffer = (char *)malloc(size)) == NULL) {
+      return false;
+    }
+    size_t n = 0;
+    while (n < size) {
+      int r = input_sys_read(fd, in->buffer + n, (unsigned)(size - n));
+      if (r <= 0) {
+        break;
+      }
+      n += r;
+    }
+    in->data = in->buffer;
+    in->size = n;
+    in->complete = true;
+    return true;
+  }
+  in->fd = fd;
+  return true;
+}
+
+// Reads from a file.
+// Returns false (and sets errno) on failure.
+static inline bool input_open_file(input_t *in, const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    input_init(in);
+    return false;
+  }
+  bool ok = input_open_fd(in, fileno(f));
+  if (in->fd >= 0) {
+    // Keep streamed files open
+    in->fd = dup(fileno(f));
+  }
+  fclose(f);
+  return ok;
+}
+
+static inline void input_close(input_t *in) {
+#ifndef INPUT_NO_MMAP
+  if (in->mapped) {
+    munmap((void *)in->data, in->size);
+  }
+#endif
+  free(in->buffer);
+  input_init(in);
+}
+
+// Reads the next chunk of streaming input, keeping the unread data.
+// Returns false at the end of the input.
+static inline bool input_fill(input_t *in, size_t min_capacity) {
+  if (in->fd < 0) {
+    in->complete = true;
+    return false;
+  }
+  size_t left = in->size - in->offset;
+  if (in->buffer != NULL && in->offset > 0) {
+    memmove(in->buffer, in->buffer + in->offset, left);
+  }
+  in->offset = 0;
+  in->size = left;
+  if (in->capacity < min_capacity + INPUT_CHUNK_SIZE) {
+    size_t capacity = min_capacity + INPUT_CHUNK_SIZE;
+    char *buffer = (char *)realloc(in->buffer, capacity);
+    if (buffer == NULL) {
+      in->complete = true;
+      return false;
+    }
+    in->buffer = buffer;
+    in->capacity = capacity;
+  }
+  in->data = in->buffer;
+  // Interactive input returns as soon as a line is available
+  int r = input_sys_read(in->fd, in->buffer + in->size, (unsigned)(in->capacity - in->size));
+  if (r <= 0) {
+    in->complete = true;
+    return false;
+  }
+  in->size += r;
+  return true;
+}
+
+// Copies the next line (including its newline, if any) into `dst`, which
+// can hold `max` bytes.
+// Returns the size of the line, 0 at the end of the input, or
+// INPUT_LINE_TOO_LONG if the line doesn't fit in `dst` (in which case
+// nothing is consumed).
+static inline int input_read_line(input_t *in, char *dst, size_t max) {
+  for (;;) {
+    const char *start = in->data + in->offset;
+    size_t left = in->size - in->offset;
+    const char *nl = left == 0 ? NULL : (const char *)memchr(start, '\n', left < max ? left : max);
+    size_t n;
+    if (nl != NULL) {
+      n = (size_t)(nl - start) + 1;
+    } else if (in->complete) {
+      n = left;
+    } else if (left < max) {
+      input_fill(in, max);
+      continue;
+    } else {
+      return INPUT_LINE_TOO_LONG;
+    }
+    if (n > max) {
+      return INPUT_LINE_TOO_LONG;
+    }
+    if (n > 0) {
+      memcpy(dst, start, n);
+      in->offset += n;
+      in->lines += 1;
+    }
+    return (int)n;
+  }
+}
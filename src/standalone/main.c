@@ -5,10 +5,13 @@
 #include <termios.h>
 #endif
 
+#include "input.h"
 #include "waforth_core.h"
 #include "wasm.h"
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef VERSION
 #define VERSION "dev"
@@ -18,6 +21,7 @@
 #define CORE_TABLE_EXPORT_INDEX 1
 #define CORE_MEMORY_EXPORT_INDEX 2
 #define CORE_ERROR_EXPORT_INDEX 10
+#define CORE_EXECUTE_EXPORT_INDEX 14
 
 #define ERR_UNKNOWN 0x1
 #define ERR_QUIT 0x2
@@ -25,11 +29,16 @@
 #define ERR_EOI 0x4
 #define ERR_BYE 0x5
 
+#define PAGE_SIZE 0x10000
+
 wasm_memory_t *memory;
 wasm_table_t *table;
 wasm_store_t *store;
+const wasm_func_t *execute_fn;
 
-FILE *input;
+input_t input;
+bool interactive;
+bool input_too_long;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Utility
@@ -43,6 +52,34 @@ wasm_trap_t *trap_from_string(const char *s) {
   return trap;
 }
 
+// Parses a size in bytes, with an optional K, M, or G suffix
+bool parse_size(const char *s, size_t *result) {
+  char *end;
+  unsigned long long n = strtoull(s, &end, 10);
+  if (end == s) {
+    return false;
+  }
+  switch (*end) {
+  case 'G':
+  case 'g':
+    n <<= 10;
+    // fallthrough
+  case 'M':
+  case 'm':
+    n <<= 10;
+    // fallthrough
+  case 'K':
+  case 'k':
+    n <<= 10;
+    ++end;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+  *result = n;
+  return true;
+}
+
 void print_trap(wasm_trap_t *trap) {
   wasm_name_t message;
   wasm_trap_message(trap, &message);
@@ -54,25 +91,40 @@ void print_trap(wasm_trap_t *trap) {
 // Callbacks
 ////////////////////////////////////////////////////////////////////////////////
 
+// Output is fully buffered, and flushed before waiting for user input,
+// and when the run loop stops
+static char output_buffer[0x10000];
+
 wasm_trap_t *emit_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
   putchar(args->data[0].of.i32);
   return NULL;
 }
 
+wasm_trap_t *type_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  fwrite(&wasm_memory_data(memory)[args->data[0].of.i32], 1, args->data[1].of.i32, stdout);
+  return NULL;
+}
+
 wasm_trap_t *read_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  if (interactive) {
+    fflush(stdout);
+  }
   char *addr = &wasm_memory_data(memory)[args->data[0].of.i32];
   size_t len = args->data[1].of.i32;
-  *addr = 0;
-  int n = 0;
-  if (fgets(addr, len, input)) {
-    n = strlen(addr);
-  };
+  int n = input_read_line(&input, addr, len);
+  if (n == INPUT_LINE_TOO_LONG) {
+    // Stop reading, instead of splitting the line
+    printf("input line %zu is longer than %zu bytes\n", input.lines + 1, len);
+    input_too_long = true;
+    n = 0;
+  }
   results->data[0].kind = WASM_I32;
   results->data[0].of.i32 = n;
   return NULL;
 }
 
 wasm_trap_t *key_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  fflush(stdout);
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
   HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
   if (h == NULL) {
@@ -143,17 +195,92 @@ wasm_trap_t *call_cb(void *env, const wasm_val_vec_t *args, wasm_val_vec_t *resu
   return trap;
 }
 
+// There are no threads, so the core runs PAR-DO and SPAWN itself
+
+wasm_trap_t *parallel_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  results->data[0].kind = WASM_I32;
+  results->data[0].of.i32 = -1;
+  return NULL;
+}
+
+wasm_trap_t *spawn_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  results->data[0].kind = WASM_I32;
+  results->data[0].of.i32 = 0;
+  return NULL;
+}
+
+wasm_trap_t *join_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  results->data[0].kind = WASM_I32;
+  results->data[0].of.i32 = 0;
+  return NULL;
+}
+
+// The engine doesn't support exception handling, so exceptions are thrown as
+// traps, which are caught by the innermost `tryExecute` (see `Exceptions` in
+// the core)
+
+// The code of the exception being thrown, or 0
+int32_t thrown;
+
+wasm_trap_t *raise_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  thrown = args->data[0].of.i32;
+  return trap_from_string("uncaught exception");
+}
+
+wasm_trap_t *try_execute_cb(const wasm_val_vec_t *args, wasm_val_vec_t *results) {
+  wasm_val_t execute_as[2] = {WASM_I32_VAL(args->data[0].of.i32), WASM_I32_VAL(args->data[1].of.i32)};
+  wasm_val_vec_t execute_args = WASM_ARRAY_VEC(execute_as);
+  wasm_val_t execute_rs[1] = {WASM_INIT_VAL};
+  wasm_val_vec_t execute_results = WASM_ARRAY_VEC(execute_rs);
+  thrown = 0;
+  wasm_trap_t *trap = wasm_func_call(execute_fn, &execute_args, &execute_results);
+  results->data[0].kind = WASM_I32;
+  results->data[1].kind = WASM_I32;
+  if (trap == NULL) {
+    results->data[0].of.i32 = execute_rs[0].of.i32;
+    results->data[1].of.i32 = 0;
+    return NULL;
+  }
+  if (thrown == 0) {
+    // Not an exception (e.g. an abort back to the host), so pass it on
+    return trap;
+  }
+  wasm_trap_delete(trap);
+  results->data[0].of.i32 = args->data[0].of.i32;
+  results->data[1].of.i32 = thrown;
+  thrown = 0;
+  return NULL;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Main
 ////////////////////////////////////////////////////////////////////////////////
 
 int main(int argc, char *argv[]) {
-  if (argc >= 2) {
-    input = fopen(argv[1], "r");
-  } else {
-    input = stdin;
+  size_t memory_size = 0;
+  const char *input_path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--memory=", 9) == 0) {
+      if (!parse_size(argv[i] + 9, &memory_size)) {
+        printf("invalid memory size: %s\n", argv[i] + 9);
+        return -1;
+      }
+    } else if (input_path == NULL) {
+      input_path = argv[i];
+    } else {
+      printf("usage: waforth [--memory=SIZE] [FILE]\n");
+      return -1;
+    }
   }
 
+  interactive = input_path == NULL;
+  if (interactive ? !input_open_fd(&input, 0) : !input_open_file(&input, input_path)) {
+    printf("error opening %s\n", interactive ? "standard input" : input_path);
+    return -1;
+  }
+
+  setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+
   wasm_engine_t *engine = wasm_engine_new();
   store = wasm_store_new(engine);
   wasm_byte_vec_t core = {.data = (wasm_byte_t *)waforth_core, .size = sizeof(waforth_core)};
@@ -167,6 +294,10 @@ int main(int argc, char *argv[]) {
   wasm_func_t *emit_fn = wasm_func_new(store, emit_ft, emit_cb);
   wasm_functype_delete(emit_ft);
 
+  wasm_functype_t *type_ft = wasm_functype_new_2_0(wasm_valtype_new_i32(), wasm_valtype_new_i32());
+  wasm_func_t *type_fn = wasm_func_new(store, type_ft, type_cb);
+  wasm_functype_delete(type_ft);
+
   wasm_functype_t *read_ft = wasm_functype_new_2_1(wasm_valtype_new_i32(), wasm_valtype_new_i32(), wasm_valtype_new_i32());
   wasm_func_t *read_fn = wasm_func_new(store, read_ft, read_cb);
   wasm_functype_delete(read_ft);
@@ -187,8 +318,34 @@ int main(int argc, char *argv[]) {
   wasm_func_t *call_fn = wasm_func_new_with_env(store, call_ft, call_cb, store, NULL);
   wasm_functype_delete(call_ft);
 
-  wasm_extern_t *externs[] = {wasm_func_as_extern(emit_fn), wasm_func_as_extern(read_fn), wasm_func_as_extern(key_fn), wasm_func_as_extern(random_fn), wasm_func_as_extern(load_fn),
-                              wasm_func_as_extern(call_fn)};
+  wasm_functype_t *parallel_ft = wasm_functype_new_3_1(wasm_valtype_new_i32(), wasm_valtype_new_i32(), wasm_valtype_new_i32(), wasm_valtype_new_i32());
+  wasm_func_t *parallel_fn = wasm_func_new(store, parallel_ft, parallel_cb);
+  wasm_functype_delete(parallel_ft);
+
+  wasm_functype_t *spawn_ft = wasm_functype_new_2_1(wasm_valtype_new_i32(), wasm_valtype_new_i32(), wasm_valtype_new_i32());
+  wasm_func_t *spawn_fn = wasm_func_new(store, spawn_ft, spawn_cb);
+  wasm_functype_delete(spawn_ft);
+
+  wasm_functype_t *join_ft = wasm_functype_new_1_1(wasm_valtype_new_i32(), wasm_valtype_new_i32());
+  wasm_func_t *join_fn = wasm_func_new(store, join_ft, join_cb);
+  wasm_functype_delete(join_ft);
+
+  wasm_functype_t *raise_ft = wasm_functype_new_1_0(wasm_valtype_new_i32());
+  wasm_func_t *raise_fn = wasm_func_new(store, raise_ft, raise_cb);
+  wasm_functype_delete(raise_ft);
+
+  wasm_valtype_vec_t try_execute_params, try_execute_results;
+  wasm_valtype_t *try_execute_ps[] = {wasm_valtype_new_i32(), wasm_valtype_new_i32()};
+  wasm_valtype_t *try_execute_rs[] = {wasm_valtype_new_i32(), wasm_valtype_new_i32()};
+  wasm_valtype_vec_new(&try_execute_params, 2, try_execute_ps);
+  wasm_valtype_vec_new(&try_execute_results, 2, try_execute_rs);
+  wasm_functype_t *try_execute_ft = wasm_functype_new(&try_execute_params, &try_execute_results);
+  wasm_func_t *try_execute_fn = wasm_func_new(store, try_execute_ft, try_execute_cb);
+  wasm_functype_delete(try_execute_ft);
+
+  wasm_extern_t *externs[] = {wasm_func_as_extern(emit_fn), wasm_func_as_extern(type_fn), wasm_func_as_extern(read_fn), wasm_func_as_extern(key_fn), wasm_func_as_extern(random_fn), wasm_func_as_extern(load_fn),
+                              wasm_func_as_extern(call_fn), wasm_func_as_extern(parallel_fn), wasm_func_as_extern(spawn_fn), wasm_func_as_extern(join_fn),
+                              wasm_func_as_extern(raise_fn), wasm_func_as_extern(try_execute_fn)};
   wasm_extern_vec_t imports = WASM_ARRAY_VEC(externs);
   wasm_trap_t *trap = NULL;
   wasm_instance_t *instance = wasm_instance_new(store, module, &imports, &trap);
@@ -203,7 +360,7 @@ int main(int argc, char *argv[]) {
 
   wasm_extern_vec_t exports;
   wasm_instance_exports(instance, &exports);
-  if (exports.size == 0) {
+  if (exports.size <= CORE_EXECUTE_EXPORT_INDEX) {
     printf("error accessing exports\n");
     return -1;
   }
@@ -214,6 +371,14 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
+  // The core starts out with a small memory, which grows on demand.
+  // Grow it to the requested initial size up front.
+  size_t memory_pages = (memory_size + PAGE_SIZE - 1) / PAGE_SIZE;
+  if (memory_pages > wasm_memory_size(memory) && !wasm_memory_grow(memory, memory_pages - wasm_memory_size(memory))) {
+    printf("error growing memory to %zu bytes\n", memory_size);
+    return -1;
+  }
+
   table = wasm_extern_as_table(exports.data[CORE_TABLE_EXPORT_INDEX]);
   if (table == NULL) {
     printf("error accessing `table` export\n");
@@ -232,11 +397,17 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
-  if (input == stdin) {
+  execute_fn = wasm_extern_as_func(exports.data[CORE_EXECUTE_EXPORT_INDEX]);
+  if (execute_fn == NULL) {
+    printf("error accessing `execute` export\n");
+    return -1;
+  }
+
+  if (interactive) {
     printf("WAForth (" VERSION ")\n");
   }
 
-  wasm_val_t run_as[1] = {WASM_I32_VAL(input != stdin)};
+  wasm_val_t run_as[1] = {WASM_I32_VAL(!interactive)};
   wasm_val_vec_t run_args = WASM_ARRAY_VEC(run_as);
   wasm_val_vec_t run_results = WASM_EMPTY_VEC;
 
@@ -253,6 +424,7 @@ int main(int argc, char *argv[]) {
     case ERR_ABORT:
       assert(trap != NULL);
       wasm_trap_delete(trap);
+      fflush(stdout);
       break;
     case ERR_EOI:
       assert(trap == NULL);
@@ -267,6 +439,7 @@ int main(int argc, char *argv[]) {
       assert(trap != NULL);
       print_trap(trap);
       wasm_trap_delete(trap);
+      fflush(stdout);
       break;
     default:
       printf("unknown error: %d\n", err_results.data[0].of.i32);
@@ -274,22 +447,27 @@ int main(int argc, char *argv[]) {
       assert(false);
     }
   }
+  fflush(stdout);
 
   wasm_extern_vec_delete(&exports);
   wasm_instance_delete(instance);
+  wasm_func_delete(try_execute_fn);
+  wasm_func_delete(raise_fn);
+  wasm_func_delete(join_fn);
+  wasm_func_delete(spawn_fn);
+  wasm_func_delete(parallel_fn);
   wasm_func_delete(call_fn);
   wasm_func_delete(load_fn);
   wasm_func_delete(random_fn);
   wasm_func_delete(key_fn);
   wasm_func_delete(read_fn);
+  wasm_func_delete(type_fn);
   wasm_func_delete(emit_fn);
   wasm_module_delete(module);
   wasm_store_delete(store);
   wasm_engine_delete(engine);
 
-  if (input != stdin) {
-    fclose(input);
-  }
+  input_close(&input);
 
-  return 0;
+  return input_too_long ? 1 : 0;
 }
@@ -0,0 +1,83 @@
+// Measures the throughput of evaluations on a pool of instances, for an
+// increasing number of threads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "waforth.h"
+
+static const char *prelude = ": FIB DUP 2 < IF EXIT THEN DUP 1- RECURSE SWAP 2 - RECURSE + ;\n";
+
+// Every request compiles a word of its own, and uses a word of the prelude
+static const char *request = ": SQUARES 0 SWAP 0 DO I DUP * + LOOP ; 100 SQUARES . 15 FIB .\n";
+static const char *expected = "328350 610 ";
+
+using Clock = std::chrono::steady_clock;
+
+static double measure(waforth::Pool &pool, unsigned threads, double seconds) {
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> count(0);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < threads; ++i) {
+    workers.emplace_back([&] {
+      std::string output;
+      while (!stop) {
+        auto forth = pool.acquire();
+        output.clear();
+        forth->setOutput([&](const char *data, size_t size) { output.append(data, size); });
+        forth->interpret(request);
+        if (output != expected) {
+          fprintf(stderr, "unexpected output: %s\n", output.c_str());
+          exit(1);
+        }
+        count += 1;
+      }
+    });
+  }
+  auto start = Clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return count / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  double seconds = 2;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--threads=", 10) == 0) {
+      threads = std::max(1, atoi(argv[i] + 10));
+    } else if (strncmp(argv[i], "--seconds=", 10) == 0) {
+      seconds = atof(argv[i] + 10);
+    } else {
+      printf("usage: waforth-bench [--threads=N] [--seconds=N]\n");
+      return 1;
+    }
+  }
+
+  auto start = Clock::now();
+  waforth::Pool pool;
+  if (!pool.load(threads, prelude)) {
+    printf("error loading instances\n");
+    return 1;
+  }
+  printf("loading %u instances: %.1fms\n", threads, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+  for (unsigned n = 1;; n = std::min(n * 2, threads)) {
+    printf("%u thread(s): %.0f evaluations/s\n", n, measure(pool, n, seconds));
+    fflush(stdout);
+    if (n == threads) {
+      break;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,168 @@
+// Measures how fast a session server (see server.h) sets up sessions, and
+// the latency of evaluations on a number of active sessions while the other
+// sessions stay idle.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "net.h"
+
+static const char *request = "21 2 * .\n";
+static const char *expected = "42 ok\n";
+
+using Clock = std::chrono::steady_clock;
+
+struct Connection {
+  int fd;
+  std::string received;
+  Clock::time_point start;
+};
+
+static bool endsWith(const std::string &s, const char *suffix) {
+  auto n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Connects, and waits for the greeting of the server
+static int connectSession(const sockaddr_storage &addr, socklen_t len) {
+  int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(fd, (const sockaddr *)&addr, len) < 0) {
+    perror("connect");
+    close(fd);
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  for (char c = 0; c != '\n';) {
+    if (read(fd, &c, 1) != 1) {
+      fprintf(stderr, "session closed\n");
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+static bool sendRequest(Connection &c) {
+  c.received.clear();
+  c.start = Clock::now();
+  auto size = strlen(request);
+  return write(c.fd, request, size) == (ssize_t)size;
+}
+
+int main(int argc, char *argv[]) {
+  const char *address = nullptr;
+  size_t sessions = 1000;
+  size_t active = 10;
+  double seconds = 2;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--sessions=", 11) == 0) {
+      sessions = std::max(1, atoi(argv[i] + 11));
+    } else if (strncmp(argv[i], "--active=", 9) == 0) {
+      active = std::max(1, atoi(argv[i] + 9));
+    } else if (strncmp(argv[i], "--seconds=", 10) == 0) {
+      seconds = atof(argv[i] + 10);
+    } else if (address == nullptr && argv[i][0] != '-') {
+      address = argv[i];
+    } else {
+      address = nullptr;
+      break;
+    }
+  }
+  sockaddr_storage addr;
+  socklen_t len;
+  if (address == nullptr || !parseAddress(address, addr, len)) {
+    printf("usage: waforth-loadgen [--sessions=N] [--active=N] [--seconds=N] ADDRESS\n");
+    return 1;
+  }
+  active = std::min(active, sessions);
+  raiseFileLimit();
+
+  // Set up all sessions
+  std::vector<Connection> connections;
+  auto start = Clock::now();
+  for (size_t i = 0; i < sessions; ++i) {
+    int fd = connectSession(addr, len);
+    if (fd < 0) {
+      return 1;
+    }
+    connections.push_back({fd, "", {}});
+  }
+  auto setup = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("%zu sessions: %.1fms (%.0f sessions/s)\n", sessions, setup * 1000, sessions / setup);
+  fflush(stdout);
+
+  // Evaluate on the active sessions, as fast as the server responds
+  std::vector<pollfd> fds(active);
+  for (size_t i = 0; i < active; ++i) {
+    fds[i] = {connections[i].fd, POLLIN, 0};
+    if (!sendRequest(connections[i])) {
+      perror("write");
+      return 1;
+    }
+  }
+  std::vector<double> latencies;
+  start = Clock::now();
+  auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  while (Clock::now() < end) {
+    if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR) {
+      perror("poll");
+      return 1;
+    }
+    for (size_t i = 0; i < active; ++i) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      auto &c = connections[i];
+      char buffer[256];
+      auto n = read(c.fd, buffer, sizeof(buffer));
+      if (n <= 0) {
+        fprintf(stderr, "session closed\n");
+        return 1;
+      }
+      c.received.append(buffer, n);
+      if (!endsWith(c.received, expected)) {
+        if (c.received.size() > strlen(expected)) {
+          fprintf(stderr, "unexpected output: %s\n", c.received.c_str());
+          return 1;
+        }
+        continue;
+      }
+      latencies.push_back(std::chrono::duration<double>(Clock::now() - c.start).count());
+      if (!sendRequest(c)) {
+        perror("write");
+        return 1;
+      }
+    }
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  for (auto &c : connections) {
+    close(c.fd);
+  }
+
+  if (latencies.empty()) {
+    printf("no responses\n");
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto n = latencies.size();
+  printf("%zu active sessions: %.0f evaluations/s, latency (ms): p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", active, n / elapsed,
+         latencies[n * 50 / 100] * 1000, latencies[n * 90 / 100] * 1000, latencies[n * 99 / 100] * 1000, latencies[n - 1] * 1000);
+  return 0;
+}
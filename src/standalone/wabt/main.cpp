@@ -5,46 +5,54 @@
 #endif
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-#include <wabt/binary-reader.h>
-#include <wabt/interp/binary-reader-interp.h>
-#include <wabt/interp/interp-util.h>
-#include <wabt/interp/interp.h>
-#include <wabt/result.h>
-
-#include "waforth_core.h"
-
-namespace wabti = wabt::interp;
+#include "server.h"
+#include "waforth.h"
 
 #ifndef VERSION
 #define VERSION "dev"
 #endif
 
-#define ERR_UNKNOWN 0x1
-#define ERR_QUIT 0x2
-#define ERR_ABORT 0x3
-#define ERR_EOI 0x4
-#define ERR_BYE 0x5
-
-static wabti::Store store;
-static std::unique_ptr<wabt::FileStream> stderrStream;
-static wabt::Features features;
-static wabti::Memory::Ptr memory;
-static wabti::Table::Ptr table;
-static wabt::Errors errors;
-
-FILE *input;
-
-wabt::Result emit_cb(wabti::Thread &thread, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
-  putchar(params[0].Get<wabti::s32>());
-  return wabt::Result::Ok;
+// Parses a size in bytes, with an optional K, M, or G suffix
+bool parseSize(const char *s, size_t &result) {
+  char *end;
+  unsigned long long n = strtoull(s, &end, 10);
+  if (end == s) {
+    return false;
+  }
+  switch (*end) {
+  case 'G':
+  case 'g':
+    n <<= 10;
+    [[fallthrough]];
+  case 'M':
+  case 'm':
+    n <<= 10;
+    [[fallthrough]];
+  case 'K':
+  case 'k':
+    n <<= 10;
+    ++end;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+  result = n;
+  return true;
 }
 
-wabt::Result key_cb(wabti::Thread &thread, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
+// Output is fully buffered, and flushed before waiting for user input,
+// and when the run loop stops
+static char outputBuffer[0x10000];
+
+int key() {
+  fflush(stdout);
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
   HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
   if (h == NULL) {
-    return trap_from_string("no console");
+    return -1;
   }
   DWORD mode;
   GetConsoleMode(h, &mode);
@@ -63,162 +71,72 @@ wabt::Result key_cb(wabti::Thread &thread, const wabti::Values &params, wabti::V
   char ch = getchar();
   tcsetattr(0, TCSANOW, &old);
 #endif
-  results[0].Set((wabti::u32)ch);
-  return wabt::Result::Ok;
-}
-
-wabt::Result read_cb(wabti::Thread &thread, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
-  auto addr = (char *)memory->UnsafeData() + params[0].Get<wabti::s32>();
-  auto size = params[1].Get<wabti::s32>();
-  *addr = 0;
-  fgets(addr, size, input);
-  int n = strlen(addr);
-  results[0].Set((wabti::u32)n);
-  return wabt::Result::Ok;
-}
-
-wabt::Result load_cb(wabti::Thread &thread, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
-  auto addr = params[0].Get<wabti::s32>();
-  auto size = params[1].Get<wabti::s32>();
-  wabti::ModuleDesc desc;
-  CHECK_RESULT(wabti::ReadBinaryInterp("word.wasm", memory->UnsafeData() + addr, size, wabt::ReadBinaryOptions(features, nullptr, true, true, true),
-                                       &errors, &desc));
-  auto mod = wabti::Module::New(store, desc);
-  wabti::RefVec imports = {table.ref(), memory.ref()};
-  auto modi = wabti::Instance::Instantiate(store, mod.ref(), imports, trap);
-  if (!modi) {
-    printf("error instantiating word module\n");
-    return wabt::Result::Error;
-    ;
-  }
-  return wabt::Result::Ok;
-}
-
-wabt::Result call_cb(wabti::Thread &thread, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
-  printf("`call` is not available in standalone\n");
-  return wabt::Result::Error;
+  return ch;
 }
 
-wabt::Result run(bool interactive) {
-  stderrStream = wabt::FileStream::CreateStderr();
-
-  // Load core module
-  wabti::ModuleDesc desc;
-  CHECK_RESULT(wabti::ReadBinaryInterp("waforth.wasm", waforth_core, sizeof(waforth_core),
-                                       wabt::ReadBinaryOptions(features, nullptr, true, true, true), &errors, &desc));
-  auto core = wabti::Module::New(store, desc);
-
-  // Core Exports
-  wabti::Func::Ptr errorFn;
-  wabti::Func::Ptr runFn;
-
-  // Bind core imports
-  wabti::RefVec imports;
-  for (auto &&import : core->desc().imports) {
-    if (import.type.type->kind == wabti::ExternKind::Func && import.type.module == "shell") {
-      auto ft = *wabt::cast<wabti::FuncType>(import.type.type.get());
-      wabti::HostFunc::Callback cb;
-      if (import.type.name == "emit") {
-        cb = emit_cb;
-      } else if (import.type.name == "read") {
-        cb = read_cb;
-      } else if (import.type.name == "key") {
-        cb = key_cb;
-      } else if (import.type.name == "load") {
-        cb = load_cb;
-      } else if (import.type.name == "call") {
-        cb = call_cb;
-      } else {
-        printf("Unknown import: %s\n", import.type.name.c_str());
-        return wabt::Result::Error;
+int main(int argc, char *argv[]) {
+  size_t memorySize = 0;
+  const char *inputPath = nullptr;
+  const char *imagePath = nullptr;
+  const char *saveImagePath = nullptr;
+  const char *listenAddress = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--memory=", 9) == 0) {
+      if (!parseSize(argv[i] + 9, memorySize)) {
+        printf("invalid memory size: %s\n", argv[i] + 9);
+        return 1;
       }
-      auto func = wabti::HostFunc::New(store, ft, cb);
-      imports.push_back(func.ref());
-      continue;
+    } else if (strncmp(argv[i], "--image=", 8) == 0) {
+      imagePath = argv[i] + 8;
+    } else if (strncmp(argv[i], "--save-image=", 13) == 0) {
+      saveImagePath = argv[i] + 13;
+    } else if (strncmp(argv[i], "--listen=", 9) == 0) {
+      listenAddress = argv[i] + 9;
+    } else if (inputPath == nullptr) {
+      inputPath = argv[i];
+    } else {
+      printf("usage: waforth [--memory=SIZE] [--image=FILE] [--save-image=FILE] [FILE]\n");
+      printf("       waforth [--memory=SIZE] [--image=FILE] --listen=ADDRESS\n");
+      return 1;
     }
-    imports.push_back(wabti::Ref::Null);
   }
 
-  // Instantiate module
-  wabti::Trap::Ptr trap;
-  auto corei = wabti::Instance::Instantiate(store, core.ref(), imports, &trap);
-  if (!corei) {
-    printf("error instantiating module\n");
-    if (trap) {
-      wabti::WriteTrap(stderrStream.get(), " error ", trap);
+  if (listenAddress != nullptr) {
+    if (inputPath != nullptr || saveImagePath != nullptr) {
+      printf("--listen can't be combined with an input file or --save-image\n");
+      return 1;
     }
-    return wabt::Result::Error;
+    return serve(listenAddress, memorySize, imagePath);
   }
 
-  // Load exports
-  for (auto &&export_ : core->desc().exports) {
-    if (export_.type.type->kind == wabt::ExternalKind::Memory) {
-      memory = store.UnsafeGet<wabti::Memory>(corei->memories()[export_.index]);
-    } else if (export_.type.type->kind == wabt::ExternalKind::Table) {
-      table = store.UnsafeGet<wabti::Table>(corei->tables()[export_.index]);
-    } else if (export_.type.name == "run") {
-      runFn = store.UnsafeGet<wabti::Func>(corei->funcs()[export_.index]);
-    } else if (export_.type.name == "error") {
-      errorFn = store.UnsafeGet<wabti::Func>(corei->funcs()[export_.index]);
-    }
-  }
+  waforth::Instance forth;
+  forth.setKey(key);
+  forth.setRecordWords(saveImagePath != nullptr);
 
-  // Run
-  wabti::Values runParams = {wabti::Value::Make(interactive ? 0 : 1)};
-  wabti::Values runResults;
-  wabti::Values errorParams;
-  wabti::Values errorResults;
-  for (int stopped = false; !stopped;) {
-    auto runRes = runFn->Call(store, runParams, runResults, &trap, nullptr);
-    CHECK_RESULT(errorFn->Call(store, errorParams, errorResults, &trap, nullptr));
-    switch (errorResults[0].Get<wabti::s32>()) {
-    case ERR_QUIT:
-    case ERR_ABORT:
-      assert(!Succeeded(runRes));
-      break;
-    case ERR_EOI:
-      assert(Succeeded(runRes));
-      stopped = true;
-      break;
-    case ERR_BYE:
-      assert(!Succeeded(runRes));
-      stopped = true;
-      break;
-    case ERR_UNKNOWN:
-      assert(!Succeeded(runRes));
-      if (trap) {
-        wabti::WriteTrap(stderrStream.get(), " error ", trap);
-      } else {
-        printf("unknown error\n");
-      }
-      break;
-    default:
-      printf("unknown error code\n");
-      if (trap) {
-        wabti::WriteTrap(stderrStream.get(), " error ", trap);
-      }
-      assert(false);
-    }
+  bool interactive = inputPath == nullptr;
+  if (interactive ? !forth.setInputFD(0) : !forth.setInputFile(inputPath)) {
+    printf("error opening %s\n", interactive ? "standard input" : inputPath);
+    return 1;
   }
-  return wabt::Result::Ok;
-}
 
-int main(int argc, char *argv[]) {
-  if (argc >= 2) {
-    input = fopen(argv[1], "r");
-  } else {
-    input = stdin;
+  setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+  if (!forth.load(memorySize) || (imagePath != nullptr && !forth.loadImage(imagePath))) {
+    fflush(stdout);
+    return 1;
   }
 
-  if (input == stdin) {
+  if (interactive) {
     printf("WAForth (" VERSION ")\n");
   }
 
-  auto result = run(input == stdin);
-
-  if (input != stdin) {
-    fclose(input);
+  auto status = forth.run(!interactive);
+  if (status == waforth::Status::Unknown) {
+    return 1;
   }
-
-  return Succeeded(result) ? 0 : 1;
-}
\ No newline at end of file
+  if (saveImagePath != nullptr && !forth.saveImage(saveImagePath)) {
+    fflush(stdout);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+// Socket helpers for the session server (see server.h) and its load
+// generator.
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstring>
+#include <string>
+
+// Parses `unix:PATH` (a Unix domain socket), `HOST:PORT`, or `PORT` (on the
+// loopback interface).
+inline bool parseAddress(const char *address, sockaddr_storage &addr, socklen_t &len) {
+  memset(&addr, 0, sizeof(addr));
+  if (strncmp(address, "unix:", 5) == 0) {
+    auto un = (sockaddr_un *)&addr;
+    auto path = address + 5;
+    if (*path == '\0' || strlen(path) >= sizeof(un->sun_path)) {
+      return false;
+    }
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, path);
+    len = sizeof(sockaddr_un);
+    return true;
+  }
+  std::string host = "127.0.0.1";
+  const char *port = address;
+  if (auto colon = strrchr(address, ':')) {
+    host = std::string(address, colon - address);
+    port = colon + 1;
+  }
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *ai;
+  if (getaddrinfo(host.c_str(), port, &hints, &ai) != 0) {
+    return false;
+  }
+  memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+  len = ai->ai_addrlen;
+  freeaddrinfo(ai);
+  return true;
+}
+
+// Every session needs a file descriptor, so allow as many as possible
+inline void raiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
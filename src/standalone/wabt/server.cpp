@@ -0,0 +1,362 @@
+#include "server.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "net.h"
+#include "waforth.h"
+
+#ifndef VERSION
+#define VERSION "dev"
+#endif
+
+// Lines that don't fit the input buffer of the core are interpreted (and
+// reported as too long) without waiting for the rest of the line
+#define MAX_LINE_SIZE 0x2000
+
+#define READ_CHUNK_SIZE 0x4000
+
+// Loop iterations a session can run for every batch of input, so that it
+// can't hold up the other sessions for long (see Fuel in the core)
+#define SESSION_FUEL 10000000
+
+// Output that a session can have waiting to be sent. Sessions that produce
+// more than this in one run are closed.
+#define MAX_OUTPUT_SIZE 0x100000
+
+#define MAX_EVENTS 256
+
+namespace {
+
+struct Session {
+  int fd;
+  waforth::Instance forth;
+
+  // Received input that wasn't interpreted yet
+  std::string input;
+
+  // Output that wasn't sent yet. Sessions with pending output don't read
+  // (or interpret) more input until the client has read it.
+  std::string output;
+
+  bool eof = false;
+
+  // Close the session when all output is sent
+  bool closing = false;
+
+  // Events the session is registered for
+  uint32_t events = 0;
+};
+
+volatile sig_atomic_t stopping = 0;
+
+void stop(int) {
+  stopping = 1;
+}
+
+class Server {
+public:
+  Server(size_t memorySize, const char *imagePath) : memorySize(memorySize), imagePath(imagePath) {}
+
+  ~Server() {
+    for (auto &entry : sessions) {
+      close(entry.first);
+    }
+    if (listenFD >= 0) {
+      close(listenFD);
+    }
+    if (epollFD >= 0) {
+      close(epollFD);
+    }
+  }
+
+  bool listen(const sockaddr_storage &addr, socklen_t len) {
+    if ((epollFD = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+      perror("epoll_create1");
+      return false;
+    }
+    if ((listenFD = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+      perror("socket");
+      return false;
+    }
+    int one = 1;
+    setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (addr.ss_family == AF_UNIX) {
+      unlink(((const sockaddr_un *)&addr)->sun_path);
+    }
+    if (bind(listenFD, (const sockaddr *)&addr, len) < 0) {
+      perror("bind");
+      return false;
+    }
+    if (::listen(listenFD, SOMAXCONN) < 0) {
+      perror("listen");
+      return false;
+    }
+    return watchListener(true);
+  }
+
+  void run() {
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+      int n = epoll_wait(epollFD, events, MAX_EVENTS, -1);
+      if (n < 0) {
+        if (errno != EINTR) {
+          perror("epoll_wait");
+          break;
+        }
+        continue;
+      }
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.fd == listenFD) {
+          accept();
+          continue;
+        }
+        auto it = sessions.find(events[i].data.fd);
+        if (it == sessions.end()) {
+          continue;
+        }
+        auto &session = *it->second;
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+          receive(session);
+        }
+        update(session);
+      }
+    }
+    fprintf(stderr, "%zu sessions served (at most %zu at once)\n", sessionCount, maxSessions);
+  }
+
+private:
+  bool watchListener(bool watch) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listenFD;
+    if (epoll_ctl(epollFD, watch ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, listenFD, &event) < 0) {
+      perror("epoll_ctl");
+      return false;
+    }
+    acceptPaused = !watch;
+    return true;
+  }
+
+  void accept() {
+    for (;;) {
+      int fd = accept4(listenFD, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EMFILE || errno == ENFILE) {
+          // Stop accepting until a session closes, instead of spinning
+          perror("accept");
+          watchListener(false);
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR) {
+          perror("accept");
+        }
+        return;
+      }
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      auto session = std::make_unique<Session>();
+      session->fd = fd;
+      auto s = session.get();
+      s->forth.setOutput([s](const char *data, size_t size) {
+        if (s->closing) {
+          return;
+        }
+        if (s->output.size() + size > MAX_OUTPUT_SIZE) {
+          s->output += "\noutput limit exceeded\n";
+          s->closing = true;
+          // Don't interpret the rest of the input
+          s->forth.setInput({});
+          s->forth.interrupt("output limit exceeded");
+          return;
+        }
+        s->output.append(data, size);
+      });
+      // The interpreter can't wait for input in the middle of a run
+      s->forth.setKey([s]() {
+        s->forth.interrupt("KEY is not supported by the server");
+        return -1;
+      });
+      s->forth.setFuel(SESSION_FUEL);
+      if (!s->forth.load(memorySize) || (imagePath != nullptr && !s->forth.loadImage(imagePath))) {
+        // The instance reported the error in the output
+        s->closing = true;
+      } else {
+        s->output += "WAForth (" VERSION ")\n";
+      }
+      sessions[fd] = std::move(session);
+      sessionCount += 1;
+      if (sessions.size() > maxSessions) {
+        maxSessions = sessions.size();
+      }
+      update(*s);
+    }
+  }
+
+  void receive(Session &session) {
+    char buffer[READ_CHUNK_SIZE];
+    for (;;) {
+      auto n = read(session.fd, buffer, sizeof(buffer));
+      if (n > 0) {
+        session.input.append(buffer, n);
+        continue;
+      }
+      if (n == 0) {
+        session.eof = true;
+      } else if (errno == EINTR) {
+        continue;
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        // The client is gone, so there's no point in interpreting anything
+        session.eof = true;
+        session.input.clear();
+      }
+      return;
+    }
+  }
+
+  // Interprets the complete lines of input
+  void interpret(Session &session) {
+    if (session.closing) {
+      return;
+    }
+    auto end = session.input.rfind('\n');
+    if (end != std::string::npos) {
+      end += 1;
+    } else if (session.eof || session.input.size() >= MAX_LINE_SIZE) {
+      end = session.input.size();
+    } else {
+      return;
+    }
+    if (end > 0) {
+      session.forth.setInput(std::string_view(session.input).substr(0, end));
+      session.input.erase(0, end);
+      if (session.forth.run(false) == waforth::Status::Bye) {
+        session.closing = true;
+      }
+    }
+    if (session.eof && session.input.empty()) {
+      session.closing = true;
+    }
+  }
+
+  bool send(Session &session) {
+    size_t offset = 0;
+    while (offset < session.output.size()) {
+      auto n = ::send(session.fd, session.output.data() + offset, session.output.size() - offset, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          return false;
+        }
+        break;
+      }
+      offset += n;
+    }
+    session.output.erase(0, offset);
+    return true;
+  }
+
+  // Runs the session as far as it can get, and waits for whatever it needs
+  // next (more output room, or more input)
+  void update(Session &session) {
+    for (;;) {
+      if (!send(session)) {
+        return closeSession(session);
+      }
+      if (!session.output.empty()) {
+        return watch(session, EPOLLOUT);
+      }
+      if (session.closing) {
+        return closeSession(session);
+      }
+      auto inputSize = session.input.size();
+      interpret(session);
+      if (session.output.empty() && !session.closing && session.input.size() == inputSize) {
+        return watch(session, EPOLLIN | EPOLLRDHUP);
+      }
+    }
+  }
+
+  void watch(Session &session, uint32_t events) {
+    if (session.events == events) {
+      return;
+    }
+    epoll_event event = {};
+    event.events = events;
+    event.data.fd = session.fd;
+    if (epoll_ctl(epollFD, session.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, session.fd, &event) < 0) {
+      perror("epoll_ctl");
+      return closeSession(session);
+    }
+    session.events = events;
+  }
+
+  void closeSession(Session &session) {
+    int fd = session.fd;
+    close(fd);
+    sessions.erase(fd);
+    if (acceptPaused) {
+      watchListener(true);
+    }
+  }
+
+  size_t memorySize;
+  const char *imagePath;
+  int epollFD = -1;
+  int listenFD = -1;
+  bool acceptPaused = false;
+  std::unordered_map<int, std::unique_ptr<Session>> sessions;
+  size_t sessionCount = 0;
+  size_t maxSessions = 0;
+};
+
+} // namespace
+
+int serve(const char *address, size_t memorySize, const char *imagePath) {
+  sockaddr_storage addr;
+  socklen_t len;
+  if (!parseAddress(address, addr, len)) {
+    fprintf(stderr, "invalid address: %s\n", address);
+    return 1;
+  }
+  raiseFileLimit();
+
+  struct sigaction sa = {};
+  sa.sa_handler = stop;
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  Server server(memorySize, imagePath);
+  if (!server.listen(addr, len)) {
+    return 1;
+  }
+  fprintf(stderr, "listening on %s\n", address);
+  server.run();
+  if (addr.ss_family == AF_UNIX) {
+    unlink(((const sockaddr_un *)&addr)->sun_path);
+  }
+  return 0;
+}
+
+#else
+
+#include <cstdio>
+
+int serve(const char *, size_t, const char *) {
+  fprintf(stderr, "--listen is not supported on this platform\n");
+  return 1;
+}
+
+#endif
@@ -0,0 +1,25 @@
+// Serves interactive sessions over TCP or Unix domain sockets (Linux only).
+//
+// Every connection gets its own instance, and all sessions are multiplexed
+// on a single thread with an event loop, so mostly idle sessions only cost
+// memory.
+//
+// An instance can't block while waiting for input. Instead, the interpreter
+// only runs when a session has received one or more complete lines. It
+// interprets them, and returns to the event loop when it runs out of input.
+// The state of the interpreter is kept between runs, so definitions can
+// span multiple lines. KEY (and ACCEPT) would have to wait, so they fail.
+//
+// A long running evaluation holds up all other sessions, so every run gets
+// a limited number of loop iterations (of the words compiled in the
+// session), and sessions that produce too much output are closed.
+
+#pragma once
+
+#include <cstddef>
+
+// `address` is `unix:PATH`, `HOST:PORT`, or `PORT` (see `parseAddress`).
+// If `imagePath` is set, every session starts from the image.
+//
+// Runs until SIGINT or SIGTERM, and returns the exit code.
+int serve(const char *address, size_t memorySize, const char *imagePath);
@@ -0,0 +1,808 @@
+#include "waforth.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <wabt/binary-reader-ir.h>
+#include <wabt/binary-reader.h>
+#include <wabt/binary-writer.h>
+#include <wabt/interp/binary-reader-interp.h>
+#include <wabt/interp/interp-util.h>
+#include <wabt/interp/interp.h>
+#include <wabt/ir.h>
+#include <wabt/result.h>
+#include <wabt/stream.h>
+
+#include "../input.h"
+#include "waforth_core.h"
+
+namespace wabti = wabt::interp;
+
+namespace waforth {
+
+// FIXME: This is unsafe. Need a better way to extract this (e.g. through symbols)
+#define HERE_GLOBAL_INDEX 6
+#define NEXT_TABLE_INDEX_GLOBAL_INDEX 7
+#define HEAP_BASE_GLOBAL_INDEX 31
+#define HEAP_TOP_GLOBAL_INDEX 32
+
+// Size of the transient regions above HERE (PAD, WORD, ...; see the core)
+#define HERE_RESERVE 0x404
+
+// Instances whose memory grew more than this since their snapshot are
+// replaced by a new instance when they are returned to the pool, as memory
+// can't shrink
+#define MAX_RESET_MEMORY_GROWTH 0x1000000
+
+// Image layout (all numbers are little-endian 32-bit words):
+//   - "WAFI", IMAGE_VERSION
+//   - Size and checksum of the core the image was saved from
+//   - Number of core globals, followed by their values
+//   - Size of the table
+//   - Size of the data, followed by the memory up to HERE
+//   - Size of the heap, followed by the memory of the heap (which starts at
+//     the heap base in the globals)
+//   - Size of the words module, followed by the module
+//
+// The words module contains all compiled words, merged into a single module,
+// so loading them takes only one instantiation.
+#define IMAGE_MAGIC 0x49464157 // "WAFI"
+#define IMAGE_VERSION 2
+
+static wabt::Features getFeatures() {
+  wabt::Features features;
+  // The core uses SIMD instructions
+  features.enable_simd();
+  // The core uses exceptions for CATCH and THROW
+  features.enable_exceptions();
+  return features;
+}
+
+static const wabt::Features features = getFeatures();
+
+// The core is only parsed once, and shared by all instances
+static const wabti::ModuleDesc *getCoreDesc() {
+  static wabti::ModuleDesc desc;
+  static bool ok = [] {
+    wabt::Errors errors;
+    return Succeeded(wabti::ReadBinaryInterp("waforth.wasm", waforth_core, sizeof(waforth_core),
+                                             wabt::ReadBinaryOptions(features, nullptr, true, true, true), &errors, &desc));
+  }();
+  return ok ? &desc : nullptr;
+}
+
+// FNV-1a
+static uint32_t checksum(const uint8_t *data, size_t size) {
+  uint32_t h = 0x811c9dc5;
+  for (size_t i = 0; i < size; ++i) {
+    h = (h ^ data[i]) * 0x01000193;
+  }
+  return h;
+}
+
+// Moves the direct calls of a word to the functions of its module (see
+// RECURSE) to where these functions end up in the merged module
+static void relocateCalls(wabt::ExprList &exprs, wabt::Index funcBase) {
+  for (auto &expr : exprs) {
+    switch (expr.type()) {
+    case wabt::ExprType::Block:
+      relocateCalls(wabt::cast<wabt::BlockExpr>(&expr)->block.exprs, funcBase);
+      break;
+    case wabt::ExprType::Loop:
+      relocateCalls(wabt::cast<wabt::LoopExpr>(&expr)->block.exprs, funcBase);
+      break;
+    case wabt::ExprType::If: {
+      auto ifExpr = wabt::cast<wabt::IfExpr>(&expr);
+      relocateCalls(ifExpr->true_.exprs, funcBase);
+      relocateCalls(ifExpr->false_, funcBase);
+      break;
+    }
+    case wabt::ExprType::Try: {
+      auto tryExpr = wabt::cast<wabt::TryExpr>(&expr);
+      relocateCalls(tryExpr->block.exprs, funcBase);
+      for (auto &c : tryExpr->catches) {
+        relocateCalls(c.exprs, funcBase);
+      }
+      break;
+    }
+    case wabt::ExprType::Call: {
+      auto &var = wabt::cast<wabt::CallExpr>(&expr)->var;
+      var.set_index(funcBase + var.index());
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+// State of an instance, to return to (see `snapshot()`)
+struct Snapshot {
+  std::vector<wabti::u32> globals;
+  wabti::u32 tableSize = 0;
+  std::vector<uint8_t> data; // Memory up to HERE
+  std::vector<uint8_t> heap; // Memory from the heap base up to the heap top
+  size_t memorySize = 0;
+};
+
+struct Instance::Impl {
+  wabti::Store store{features};
+  wabt::Errors errors;
+  wabti::Instance::Ptr core;
+  wabti::Memory::Ptr memory;
+  wabti::Table::Ptr table;
+  wabti::Func::Ptr runFn;
+  wabti::Func::Ptr errorFn;
+  wabti::Func::Ptr pushFn;
+  wabti::Func::Ptr popFn;
+  wabti::Func::Ptr setFuelFn;
+
+  OutputCallback output;
+  KeyCallback key;
+
+  input_t input;
+  std::string inputData;
+  bool silent = true;
+  bool inputTooLong = false;
+  bool failed = false;
+  uint32_t fuel = 0;
+
+  // Set by `interrupt()`, and reported by the callback that is running
+  bool interrupted = false;
+  std::string interruption;
+
+  Snapshot initial;
+  Snapshot snapshot;
+
+  // Compiled word modules, recorded for images
+  bool recordWords = false;
+  std::vector<std::vector<uint8_t>> wordModules;
+
+  Impl() {
+    input_init(&input);
+    output = [](const char *data, size_t size) {
+      if (size == 0) {
+        fflush(stdout);
+      } else {
+        fwrite(data, 1, size, stdout);
+      }
+    };
+    key = [] {
+      return getchar();
+    };
+  }
+
+  ~Impl() {
+    input_close(&input);
+  }
+
+  void print(const std::string &s) {
+    output(s.data(), s.size());
+  }
+
+  void printTrap(const wabti::Trap::Ptr &trap) {
+    print("error: " + trap->message() + "\n");
+  }
+
+  // Makes the running callback trap if the run was interrupted
+  wabt::Result checkInterrupted(wabti::Trap::Ptr *trap) {
+    if (!interrupted) {
+      return wabt::Result::Ok;
+    }
+    interrupted = false;
+    *trap = wabti::Trap::New(store, interruption);
+    return wabt::Result::Error;
+  }
+
+  wabti::Global::Ptr global(wabt::Index index) {
+    return store.UnsafeGet<wabti::Global>(core->globals()[index]);
+  }
+
+  wabt::Result load(size_t memorySize) {
+    auto desc = getCoreDesc();
+    if (desc == nullptr) {
+      print("error reading core\n");
+      return wabt::Result::Error;
+    }
+    auto mod = wabti::Module::New(store, *desc);
+
+    // Bind core imports
+    wabti::RefVec imports;
+    for (auto &&import : mod->desc().imports) {
+      if (import.type.type->kind == wabti::ExternKind::Func && import.type.module == "shell") {
+        auto ft = *wabt::cast<wabti::FuncType>(import.type.type.get());
+        wabti::HostFunc::Callback cb;
+        if (import.type.name == "emit") {
+          cb = [this](wabti::Thread &, const wabti::Values &params, wabti::Values &, wabti::Trap::Ptr *trap) {
+            char c = (char)params[0].Get<wabti::s32>();
+            output(&c, 1);
+            return checkInterrupted(trap);
+          };
+        } else if (import.type.name == "type") {
+          cb = [this](wabti::Thread &, const wabti::Values &params, wabti::Values &, wabti::Trap::Ptr *trap) {
+            output((const char *)memory->UnsafeData() + params[0].Get<wabti::s32>(), params[1].Get<wabti::s32>());
+            return checkInterrupted(trap);
+          };
+        } else if (import.type.name == "read") {
+          cb = [this](wabti::Thread &, const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
+            return read(params, results, trap);
+          };
+        } else if (import.type.name == "key") {
+          cb = [this](wabti::Thread &, const wabti::Values &, wabti::Values &results, wabti::Trap::Ptr *trap) {
+            results[0].Set((wabti::u32)key());
+            return checkInterrupted(trap);
+          };
+        } else if (import.type.name == "load") {
+          cb = [this](wabti::Thread &, const wabti::Values &params, wabti::Values &, wabti::Trap::Ptr *trap) {
+            auto addr = params[0].Get<wabti::s32>();
+            auto size = params[1].Get<wabti::s32>();
+            if (recordWords) {
+              wordModules.push_back(std::vector<uint8_t>(memory->UnsafeData() + addr, memory->UnsafeData() + addr + size));
+            }
+            return loadWords(memory->UnsafeData() + addr, size, trap);
+          };
+        } else if (import.type.name == "call") {
+          cb = [this](wabti::Thread &, const wabti::Values &, wabti::Values &, wabti::Trap::Ptr *) {
+            print("`call` is not available in standalone\n");
+            return wabt::Result::Error;
+          };
+        } else if (import.type.name == "parallel") {
+          // The interpreter has no threads, so the core runs PAR-DO and SPAWN itself
+          cb = [](wabti::Thread &, const wabti::Values &, wabti::Values &results, wabti::Trap::Ptr *) {
+            results[0].Set((wabti::s32)-1);
+            return wabt::Result::Ok;
+          };
+        } else if (import.type.name == "spawn" || import.type.name == "join") {
+          cb = [](wabti::Thread &, const wabti::Values &, wabti::Values &results, wabti::Trap::Ptr *) {
+            results[0].Set((wabti::s32)0);
+            return wabt::Result::Ok;
+          };
+        } else {
+          print("Unknown import: " + import.type.name + "\n");
+          return wabt::Result::Error;
+        }
+        auto func = wabti::HostFunc::New(store, ft, cb);
+        imports.push_back(func.ref());
+        continue;
+      }
+      imports.push_back(wabti::Ref::Null);
+    }
+
+    // Instantiate module
+    wabti::Trap::Ptr trap;
+    core = wabti::Instance::Instantiate(store, mod.ref(), imports, &trap);
+    if (!core) {
+      print("error instantiating module\n");
+      if (trap) {
+        printTrap(trap);
+      }
+      return wabt::Result::Error;
+    }
+
+    // Load exports
+    for (auto &&export_ : mod->desc().exports) {
+      if (export_.type.type->kind == wabt::ExternalKind::Memory) {
+        memory = store.UnsafeGet<wabti::Memory>(core->memories()[export_.index]);
+      } else if (export_.type.type->kind == wabt::ExternalKind::Table) {
+        table = store.UnsafeGet<wabti::Table>(core->tables()[export_.index]);
+      } else if (export_.type.name == "run") {
+        runFn = store.UnsafeGet<wabti::Func>(core->funcs()[export_.index]);
+      } else if (export_.type.name == "error") {
+        errorFn = store.UnsafeGet<wabti::Func>(core->funcs()[export_.index]);
+      } else if (export_.type.name == "push") {
+        pushFn = store.UnsafeGet<wabti::Func>(core->funcs()[export_.index]);
+      } else if (export_.type.name == "pop") {
+        popFn = store.UnsafeGet<wabti::Func>(core->funcs()[export_.index]);
+      } else if (export_.type.name == "setFuel") {
+        setFuelFn = store.UnsafeGet<wabti::Func>(core->funcs()[export_.index]);
+      }
+    }
+
+    // The core starts out with a small memory, which grows on demand.
+    // Grow it to the requested initial size up front.
+    if (memorySize > memory->ByteSize()) {
+      auto pages = (memorySize - memory->ByteSize() + WABT_PAGE_SIZE - 1) / WABT_PAGE_SIZE;
+      if (Failed(memory->Grow(pages))) {
+        print("error growing memory to " + std::to_string(memorySize) + " bytes\n");
+        return wabt::Result::Error;
+      }
+    }
+
+    capture(initial);
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result read(const wabti::Values &params, wabti::Values &results, wabti::Trap::Ptr *trap) {
+    if (!silent) {
+      output("", 0);
+      CHECK_RESULT(checkInterrupted(trap));
+    }
+    auto addr = (char *)memory->UnsafeData() + params[0].Get<wabti::s32>();
+    auto size = params[1].Get<wabti::s32>();
+    int n = input_read_line(&input, addr, size);
+    if (n == INPUT_LINE_TOO_LONG) {
+      // Stop reading, instead of splitting the line
+      print("input line " + std::to_string(input.lines + 1) + " is longer than " + std::to_string(size) + " bytes\n");
+      inputTooLong = true;
+      n = 0;
+    }
+    results[0].Set((wabti::u32)n);
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result loadWords(const uint8_t *data, size_t size, wabti::Trap::Ptr *trap) {
+    wabti::ModuleDesc desc;
+    CHECK_RESULT(wabti::ReadBinaryInterp("word.wasm", data, size, wabt::ReadBinaryOptions(features, nullptr, true, true, true), &errors, &desc));
+    auto mod = wabti::Module::New(store, desc);
+    wabti::RefVec imports = {table.ref(), memory.ref()};
+    auto modi = wabti::Instance::Instantiate(store, mod.ref(), imports, trap);
+    if (!modi) {
+      print("error instantiating word module\n");
+      return wabt::Result::Error;
+    }
+    return wabt::Result::Ok;
+  }
+
+  Status run(bool silent) {
+    this->silent = silent;
+    inputTooLong = false;
+    failed = false;
+    interrupted = false;
+    wabti::Values runParams = {wabti::Value::Make(silent ? 1 : 0)};
+    wabti::Values runResults;
+    wabti::Values errorParams;
+    wabti::Values errorResults;
+    wabti::Trap::Ptr trap;
+    if (fuel != 0) {
+      // The fuel is for the whole run, so a run that ran out doesn't get new
+      // fuel for the rest of the input
+      wabti::Values fuelParams = {wabti::Value::Make(fuel)};
+      wabti::Values fuelResults;
+      if (Failed(setFuelFn->Call(store, fuelParams, fuelResults, &trap, nullptr))) {
+        failed = true;
+        return Status::Unknown;
+      }
+    }
+    for (;;) {
+      auto runRes = runFn->Call(store, runParams, runResults, &trap, nullptr);
+      if (Failed(errorFn->Call(store, errorParams, errorResults, &trap, nullptr))) {
+        failed = true;
+        return Status::Unknown;
+      }
+      auto status = (Status)errorResults[0].Get<wabti::s32>();
+      switch (status) {
+      case Status::Quit:
+        assert(!Succeeded(runRes));
+        break;
+      case Status::Abort:
+        assert(!Succeeded(runRes));
+        failed = true;
+        break;
+      case Status::EOI:
+        assert(Succeeded(runRes));
+        output("", 0);
+        return inputTooLong ? Status::Unknown : status;
+      case Status::Bye:
+        assert(!Succeeded(runRes));
+        output("", 0);
+        return status;
+      case Status::Unknown:
+        assert(!Succeeded(runRes));
+        failed = true;
+        if (trap) {
+          printTrap(trap);
+        } else {
+          print("unknown error\n");
+        }
+        break;
+      default:
+        print("unknown error code\n");
+        if (trap) {
+          printTrap(trap);
+        }
+        assert(false);
+        failed = true;
+        return Status::Unknown;
+      }
+    }
+  }
+
+  // Captures the state of the instance. The core only has i32 globals.
+  void capture(Snapshot &s) {
+    auto &globals = core->globals();
+    s.globals.clear();
+    for (auto &g : globals) {
+      s.globals.push_back(store.UnsafeGet<wabti::Global>(g)->Get().Get<wabti::u32>());
+    }
+    s.tableSize = table->size();
+    auto here = s.globals[HERE_GLOBAL_INDEX];
+    s.data.assign(memory->UnsafeData(), memory->UnsafeData() + here);
+    auto heapBase = s.globals[HEAP_BASE_GLOBAL_INDEX];
+    s.heap.assign(memory->UnsafeData() + heapBase, memory->UnsafeData() + s.globals[HEAP_TOP_GLOBAL_INDEX]);
+    s.memorySize = memory->ByteSize();
+  }
+
+  // Restores the state of the instance. Compiled words are not restored.
+  wabt::Result restore(const Snapshot &s) {
+    auto &globals = core->globals();
+    if (s.globals.size() != globals.size()) {
+      return wabt::Result::Error;
+    }
+
+    // Clear everything that may have been written since the snapshot: all
+    // memory above the HERE of the snapshot, except for the heap of the
+    // snapshot (which is copied back below)
+    auto heapBase = s.globals[HEAP_BASE_GLOBAL_INDEX];
+    auto currentHeapBase = global(HEAP_BASE_GLOBAL_INDEX)->Get().Get<wabti::u32>();
+    auto clear = [&](size_t begin, size_t end) {
+      end = std::min<size_t>(end, memory->ByteSize());
+      if (end > begin) {
+        std::memset(memory->UnsafeData() + begin, 0, end - begin);
+      }
+    };
+    if (heapBase != 0 && currentHeapBase == heapBase) {
+      clear(s.data.size(), heapBase);
+      clear(heapBase + s.heap.size(), memory->ByteSize());
+    } else {
+      clear(s.data.size(), memory->ByteSize());
+    }
+
+    // Memory
+    size_t memoryEnd = s.heap.empty() ? s.data.size() : heapBase + s.heap.size();
+    if (memoryEnd > memory->ByteSize() && Failed(memory->Grow((memoryEnd - memory->ByteSize() + WABT_PAGE_SIZE - 1) / WABT_PAGE_SIZE))) {
+      print("error growing memory to " + std::to_string(memoryEnd) + " bytes\n");
+      return wabt::Result::Error;
+    }
+    std::memcpy(memory->UnsafeData(), s.data.data(), s.data.size());
+    if (!s.heap.empty()) {
+      std::memcpy(memory->UnsafeData() + heapBase, s.heap.data(), s.heap.size());
+    }
+
+    // Drop the words compiled since the snapshot, so they can be collected
+    auto nextTableIndex = global(NEXT_TABLE_INDEX_GLOBAL_INDEX)->Get().Get<wabti::u32>();
+    auto snapshotNextTableIndex = s.globals[NEXT_TABLE_INDEX_GLOBAL_INDEX];
+    for (auto i = snapshotNextTableIndex; i < nextTableIndex && i < table->size(); ++i) {
+      table->Set(store, i, wabti::Ref::Null);
+    }
+
+    for (size_t i = 0; i < globals.size(); ++i) {
+      store.UnsafeGet<wabti::Global>(globals[i])->UnsafeSet(wabti::Value::Make(s.globals[i]));
+    }
+
+    if (s.tableSize > table->size() && Failed(table->Grow(store, s.tableSize - table->size(), wabti::Ref::Null))) {
+      print("error growing table\n");
+      return wabt::Result::Error;
+    }
+
+    if (nextTableIndex > snapshotNextTableIndex) {
+      store.Collect();
+    }
+    return wabt::Result::Ok;
+  }
+
+  // Merges the recorded word modules into a single module.
+  // All word modules are created from the same module header (see the core),
+  // and only import the table and the memory, so their functions can be moved
+  // as is, as long as the element segments are renumbered.
+  wabt::Result mergeWordModules(std::vector<uint8_t> &result) {
+    if (wordModules.empty()) {
+      result.clear();
+      return wabt::Result::Ok;
+    }
+    wabt::ReadBinaryOptions options(features, nullptr, false, true, true);
+    wabt::Module merged;
+    CHECK_RESULT(wabt::ReadBinaryIr("words.wasm", wordModules[0].data(), wordModules[0].size(), options, &errors, &merged));
+    for (size_t i = 1; i < wordModules.size(); ++i) {
+      wabt::Module word;
+      CHECK_RESULT(wabt::ReadBinaryIr("word.wasm", wordModules[i].data(), wordModules[i].size(), options, &errors, &word));
+      assert(word.types.size() == merged.types.size());
+      auto funcBase = merged.funcs.size();
+      for (auto wordFunc : word.funcs) {
+        auto ff = std::make_unique<wabt::FuncModuleField>();
+        auto &f = ff->func;
+        f.decl = wordFunc->decl;
+        f.local_types = wordFunc->local_types;
+        f.exprs.splice(f.exprs.end(), wordFunc->exprs);
+        relocateCalls(f.exprs, funcBase);
+        merged.AppendField(std::move(ff));
+      }
+      for (auto elem : word.elem_segments) {
+        auto esf = std::make_unique<wabt::ElemSegmentModuleField>();
+        wabt::ElemSegment &es = esf->elem_segment;
+        es.kind = elem->kind;
+        es.table_var = elem->table_var;
+        es.elem_type = elem->elem_type;
+        es.offset = std::move(elem->offset);
+        for (auto &expr : elem->elem_exprs) {
+          assert(expr.size() == 1 && expr.front().type() == wabt::ExprType::RefFunc);
+          auto index = wabt::cast<wabt::RefFuncExpr>(&expr.front())->var.index();
+          es.elem_exprs.push_back(wabt::ExprList{std::make_unique<wabt::RefFuncExpr>(wabt::Var(funcBase + index, wabt::Location()))});
+        }
+        merged.AppendField(std::move(esf));
+      }
+      // The imported table needs to be as large as the largest one of the words
+      merged.tables[0]->elem_limits.initial = std::max(merged.tables[0]->elem_limits.initial, word.tables[0]->elem_limits.initial);
+    }
+    wabt::MemoryStream out(nullptr);
+    CHECK_RESULT(wabt::WriteBinaryModule(&out, &merged, wabt::WriteBinaryOptions(features, false, false, false)));
+    result = std::move(out.output_buffer().data);
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result saveImage(const char *path) {
+    std::vector<uint8_t> words;
+    if (Failed(mergeWordModules(words))) {
+      print("error merging word modules\n");
+      return wabt::Result::Error;
+    }
+    Snapshot s;
+    capture(s);
+
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr) {
+      print("error opening " + std::string(path) + "\n");
+      return wabt::Result::Error;
+    }
+    auto writeU32 = [&](uint32_t v) {
+      uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+      fwrite(b, 1, 4, f);
+    };
+    auto writeData = [&](const std::vector<uint8_t> &data) {
+      writeU32((uint32_t)data.size());
+      fwrite(data.data(), 1, data.size(), f);
+    };
+    writeU32(IMAGE_MAGIC);
+    writeU32(IMAGE_VERSION);
+    writeU32(sizeof(waforth_core));
+    writeU32(checksum(waforth_core, sizeof(waforth_core)));
+    writeU32((uint32_t)s.globals.size());
+    for (auto v : s.globals) {
+      writeU32(v);
+    }
+    writeU32(s.tableSize);
+    writeData(s.data);
+    writeData(s.heap);
+    writeData(words);
+
+    bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+      print("error writing " + std::string(path) + "\n");
+      return wabt::Result::Error;
+    }
+    return wabt::Result::Ok;
+  }
+
+  wabt::Result loadImage(const char *path) {
+    std::vector<uint8_t> image;
+    if (Failed(wabt::ReadFile(path, &image))) {
+      print("error reading " + std::string(path) + "\n");
+      return wabt::Result::Error;
+    }
+    size_t offset = 0;
+    bool ok = true;
+    auto readU32 = [&]() -> uint32_t {
+      if (offset + 4 > image.size()) {
+        ok = false;
+        return 0;
+      }
+      auto p = image.data() + offset;
+      offset += 4;
+      return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    };
+    auto readData = [&](std::vector<uint8_t> &data) {
+      size_t size = readU32();
+      if (!ok || offset + size > image.size()) {
+        ok = false;
+        return;
+      }
+      data.assign(image.data() + offset, image.data() + offset + size);
+      offset += size;
+    };
+
+    if (readU32() != IMAGE_MAGIC || readU32() != IMAGE_VERSION) {
+      print(std::string(path) + " is not an image\n");
+      return wabt::Result::Error;
+    }
+    if (readU32() != sizeof(waforth_core) || readU32() != checksum(waforth_core, sizeof(waforth_core))) {
+      print(std::string(path) + " was saved by a different version\n");
+      return wabt::Result::Error;
+    }
+    Snapshot s;
+    s.globals.resize(readU32());
+    for (size_t i = 0; ok && i < s.globals.size(); ++i) {
+      s.globals[i] = readU32();
+    }
+    s.tableSize = readU32();
+    readData(s.data);
+    readData(s.heap);
+    std::vector<uint8_t> words;
+    readData(words);
+    if (!ok || s.globals.size() != core->globals().size()) {
+      print(std::string(path) + " is corrupt\n");
+      return wabt::Result::Error;
+    }
+
+    CHECK_RESULT(restore(s));
+    if (!words.empty()) {
+      wabti::Trap::Ptr trap;
+      CHECK_RESULT(loadWords(words.data(), words.size(), &trap));
+      if (recordWords) {
+        wordModules.push_back(std::move(words));
+      }
+    }
+    return wabt::Result::Ok;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Instance
+////////////////////////////////////////////////////////////////////////////////
+
+Instance::Instance() : impl(std::make_unique<Impl>()) {}
+
+Instance::~Instance() = default;
+
+bool Instance::load(size_t memorySize) {
+  return Succeeded(impl->load(memorySize));
+}
+
+void Instance::setOutput(OutputCallback output) {
+  impl->output = std::move(output);
+}
+
+void Instance::setKey(KeyCallback key) {
+  impl->key = std::move(key);
+}
+
+void Instance::setFuel(uint32_t fuel) {
+  impl->fuel = fuel;
+}
+
+void Instance::interrupt(std::string_view message) {
+  impl->interrupted = true;
+  impl->interruption = message;
+}
+
+void Instance::setInput(std::string_view input) {
+  input_close(&impl->input);
+  impl->inputData = input;
+  input_open_memory(&impl->input, impl->inputData.data(), impl->inputData.size());
+}
+
+bool Instance::setInputFD(int fd) {
+  input_close(&impl->input);
+  return input_open_fd(&impl->input, fd);
+}
+
+bool Instance::setInputFile(const char *path) {
+  input_close(&impl->input);
+  return input_open_file(&impl->input, path);
+}
+
+Status Instance::run(bool silent) {
+  return impl->run(silent);
+}
+
+Status Instance::interpret(std::string_view input) {
+  setInput(input);
+  return run();
+}
+
+bool Instance::failed() const {
+  return impl->failed;
+}
+
+void Instance::push(int32_t value) {
+  wabti::Values params = {wabti::Value::Make(value)};
+  wabti::Values results;
+  wabti::Trap::Ptr trap;
+  impl->pushFn->Call(impl->store, params, results, &trap, nullptr);
+}
+
+int32_t Instance::pop() {
+  wabti::Values params;
+  wabti::Values results;
+  wabti::Trap::Ptr trap;
+  if (Failed(impl->popFn->Call(impl->store, params, results, &trap, nullptr))) {
+    return 0;
+  }
+  return results[0].Get<wabti::s32>();
+}
+
+void Instance::snapshot() {
+  impl->capture(impl->snapshot);
+}
+
+void Instance::reset() {
+  impl->restore(impl->snapshot.globals.empty() ? impl->initial : impl->snapshot);
+}
+
+size_t Instance::memoryGrowth() const {
+  auto &s = impl->snapshot.globals.empty() ? impl->initial : impl->snapshot;
+  return impl->memory->ByteSize() - s.memorySize;
+}
+
+void Instance::setRecordWords(bool record) {
+  impl->recordWords = record;
+}
+
+bool Instance::saveImage(const char *path) {
+  return Succeeded(impl->saveImage(path));
+}
+
+bool Instance::loadImage(const char *path) {
+  return Succeeded(impl->loadImage(path));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pool
+////////////////////////////////////////////////////////////////////////////////
+
+bool Pool::load(size_t size, std::string_view prelude, size_t memorySize) {
+  this->prelude = prelude;
+  this->memorySize = memorySize;
+  instances.resize(size);
+  std::vector<char> ok(size);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < size; ++i) {
+    threads.emplace_back([&, i] { ok[i] = create(instances[i]); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto &instance : instances) {
+    available.push_back(instance.get());
+  }
+  return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+Pool::Lease Pool::acquire() {
+  std::unique_lock<std::mutex> lock(mutex);
+  released.wait(lock, [this] { return !available.empty(); });
+  auto instance = available.back();
+  available.pop_back();
+  return Lease(this, instance);
+}
+
+bool Pool::create(std::unique_ptr<Instance> &instance) {
+  instance = std::make_unique<Instance>();
+  if (!instance->load(memorySize)) {
+    return false;
+  }
+  bool ok = prelude.empty() || (instance->interpret(prelude) == Status::EOI && !instance->failed());
+
+  // Set up the heap before taking the snapshot, so it stays in place.
+  // Otherwise, every reset would drop the heap set up by a request, and the
+  // next request would set up a new one past the end of the (grown) memory.
+  ok = ok && instance->interpret("1 ALLOCATE THROW FREE THROW") == Status::EOI && !instance->failed();
+  instance->snapshot();
+  return ok;
+}
+
+void Pool::release(Instance *instance) {
+  std::unique_ptr<Instance> replacement;
+  if (instance->memoryGrowth() > MAX_RESET_MEMORY_GROWTH && !create(replacement)) {
+    replacement.reset();
+  }
+  if (!replacement) {
+    instance->reset();
+  }
+  std::unique_ptr<Instance> old;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (replacement) {
+      auto it = std::find_if(instances.begin(), instances.end(), [&](auto &i) { return i.get() == instance; });
+      old = std::move(*it);
+      *it = std::move(replacement);
+      instance = it->get();
+    }
+    available.push_back(instance);
+  }
+  released.notify_one();
+}
+
+} // namespace waforth
@@ -0,0 +1,188 @@
+// Embeddable WAForth, running the core in the WABT interpreter.
+//
+// Every instance is a separate Forth system, with its own store, memory,
+// table, I/O, and error state. Different instances can be used concurrently
+// from different threads, but a single instance can only be used by one
+// thread at a time.
+//
+// A pool keeps a number of instances warmed up (with the core loaded and a
+// prelude compiled), and hands them out one at a time. Instances are reset
+// to their warmed-up state when they are handed back, or replaced by a new
+// instance if their memory grew a lot.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waforth {
+
+// Reason the interpreter stopped (the error codes of the core)
+enum class Status {
+  Unknown = 0x1, // Unknown error (e.g. a trap)
+  Quit = 0x2,    // QUIT was called
+  Abort = 0x3,   // ABORT or ABORT" was called
+  EOI = 0x4,     // No more input
+  Bye = 0x5,     // BYE was called
+};
+
+class Instance {
+public:
+  // Called with all output (including error messages).
+  // Called with an empty string when the output needs to be flushed (before
+  // waiting for interactive input, and at the end of a run).
+  using OutputCallback = std::function<void(const char *data, size_t size)>;
+
+  // Called for KEY
+  using KeyCallback = std::function<int()>;
+
+  Instance();
+  ~Instance();
+  Instance(const Instance &) = delete;
+  Instance &operator=(const Instance &) = delete;
+
+  // Loads the core. Needs to be called before anything else.
+  //
+  // `memorySize` is the initial size (in bytes) of the memory. Memory grows on
+  // demand beyond this.
+  bool load(size_t memorySize = 0);
+
+  // Defaults to writing to stdout
+  void setOutput(OutputCallback output);
+
+  // Defaults to reading from stdin
+  void setKey(KeyCallback key);
+
+  // Limits the number of loop iterations of every run (see Fuel in the core),
+  // so that runs can't take forever. Running out aborts the run with "out of
+  // fuel". Only the loops of words compiled after setting a limit count.
+  // 0 means no limit (the default).
+  void setFuel(uint32_t fuel);
+
+  // Fails the running word with `message`, as soon as the output or key
+  // callback that calls this returns. CATCH can't catch this. The
+  // interpreter continues with the next line of input.
+  void interrupt(std::string_view message);
+
+  // Sets the input to interpret. The string is copied.
+  void setInput(std::string_view input);
+
+  // Sets the input to the given file descriptor (e.g. a terminal or a pipe)
+  // or file. Return false on failure.
+  bool setInputFD(int fd);
+  bool setInputFile(const char *path);
+
+  // Runs the interpreter until there is no more input, or until BYE is called.
+  // Aborts don't stop the interpreter (but are reported by `failed()`).
+  // Prompts are only shown if `silent` is not set.
+  //
+  // Returns Status::EOI or Status::Bye, or Status::Unknown if the input
+  // couldn't be read (e.g. because a line was too long).
+  Status run(bool silent = true);
+
+  // Interprets `input`
+  Status interpret(std::string_view input);
+
+  // Whether an error occurred during the last run (an abort, or an uncaught
+  // trap)
+  bool failed() const;
+
+  // Data stack
+  void push(int32_t value);
+  int32_t pop();
+
+  // Remembers the current state, to return to with `reset()`
+  void snapshot();
+
+  // Returns to the state of the last `snapshot()` (or to the initial state
+  // if there was none). Only the memory up to HERE and the heap are copied
+  // back, so this is a lot cheaper than loading a new instance. All other
+  // memory is cleared.
+  //
+  // A heap that was set up after the snapshot is dropped, so the next
+  // ALLOCATE sets up a new one at the end of the memory. Set up the heap
+  // before taking the snapshot to keep memory from growing on every reset
+  // (as the pool does).
+  void reset();
+
+  // Number of bytes the memory grew since the last `snapshot()`. Memory
+  // can't shrink, so `reset()` doesn't give these back.
+  size_t memoryGrowth() const;
+
+  // Images contain the state of an instance (see `snapshot()`), together with
+  // all compiled words, so they can be loaded into a fresh instance.
+  //
+  // Saving an image needs all compiled words of the instance, so they need
+  // to be recorded from the start.
+  void setRecordWords(bool record);
+  bool saveImage(const char *path);
+  bool loadImage(const char *path);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+class Pool {
+public:
+  // An instance handed out by the pool.
+  // The instance is reset and returned to the pool when the lease is destroyed.
+  class Lease {
+  public:
+    Lease(Lease &&other) noexcept : pool(other.pool), instance(other.instance) {
+      other.instance = nullptr;
+    }
+    Lease(const Lease &) = delete;
+    ~Lease() {
+      if (instance != nullptr) {
+        pool->release(instance);
+      }
+    }
+    Instance &operator*() const {
+      return *instance;
+    }
+    Instance *operator->() const {
+      return instance;
+    }
+
+  private:
+    friend class Pool;
+    Lease(Pool *pool, Instance *instance) : pool(pool), instance(instance) {}
+    Pool *pool;
+    Instance *instance;
+  };
+
+  // Creates `size` instances (in parallel), and interprets `prelude` in all of
+  // them.
+  // Returns false if any of the instances fails to load.
+  bool load(size_t size, std::string_view prelude = "", size_t memorySize = 0);
+
+  // Takes an instance from the pool, waiting until one is available
+  Lease acquire();
+
+  size_t size() const {
+    return instances.size();
+  }
+
+private:
+  // Creates an instance, and interprets the prelude in it.
+  // Returns false if the instance fails to load.
+  bool create(std::unique_ptr<Instance> &instance);
+  void release(Instance *instance);
+
+  std::string prelude;
+  size_t memorySize = 0;
+  std::vector<std::unique_ptr<Instance>> instances;
+  std::vector<Instance *> available;
+  std::mutex mutex;
+  std::condition_variable released;
+};
+
+} // namespace waforth
@@ -14,6 +14,10 @@
   ;; Write a character to the output device
   (import "shell" "emit" (func $shell_emit (param i32)))
 
+  ;; Write a string to the output device
+  ;; Parameters: string address, length
+  (import "shell" "type" (func $shell_type (param i32 i32)))
+
   ;; Read input from input device
   ;; Parameters: target address, maximum size
   ;; Returns: number of bytes read
@@ -32,6 +36,30 @@
   ;; Generic signal to shell
   (import "shell" "call" (func $shell_call))
 
+  ;; Run the iterations of a parallel loop (see PAR-DO), e.g. on other threads
+  ;; (see `runTask`)
+  ;; Parameters: execution token, start index, limit (greater than the start)
+  ;; Returns: -1 if the shell can't run the loop (the core then runs it), the
+  ;;   exception code of an iteration that failed, or 0
+  (import "shell" "parallel" (func $shell_parallel (param i32 i32 i32) (result i32)))
+
+  ;; Start a task (see SPAWN)
+  ;; Parameters: execution token, argument
+  ;; Returns: a task handle, or 0 if the shell can't start tasks (the core then
+  ;;   runs the task itself)
+  (import "shell" "spawn" (func $shell_spawn (param i32 i32) (result i32)))
+
+  ;; Wait for a task to finish (see JOIN)
+  ;; Parameters: task handle
+  ;; Returns: the exception code if the task failed, or 0
+  (import "shell" "join" (func $shell_join (param i32) (result i32)))
+
+  ;; Throw an exception, and execute an execution token while catching
+  ;; exceptions (see `Exceptions`). Only imported by the version of the core
+  ;; for engines without exception handling.
+  ;; traps: (import "shell" "raise" (func $raise (param i32)))
+  ;; traps: (import "shell" "tryExecute" (func $tryExecute (param i32 i32) (result i32 i32)))
+
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Interpreter
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -54,6 +82,12 @@
     ;; We'll reset the error to a real value later if no trap occurs.
     (global.set $error (i32.const 0x1 (; = ERR_UNKNOWN ;)))
 
+    ;; There are no CATCH frames (yet) at the top level
+    (global.set $catchDepth (i32.const 0))
+
+    ;; The interpreter runs in the operator task
+    (global.set $up (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+
     ;; Start looping until there is no more input
     ;; The loop has the threaded TOS local as parameter and return value
     (block $endLoop (param i32) (result i32)
@@ -67,7 +101,7 @@
 
         ;; Check for stack underflow
         (if (i32.lt_s (local.get $tos) (i32.const 0x10000 (; = STACK_BASE ;)))
-          (then (call $fail (i32.const 0x20085 (; = str("stack empty") ;)))))
+          (then (call $fail (i32.const -0x4 (; = EXC_STACK_UNDERFLOW ;)) (i32.const 0x3b085 (; = str("stack empty") ;)))))
 
         ;; Show prompt, depending on STATE
         (if (i32.eqz (local.get $silent))
@@ -77,10 +111,10 @@
                 (block $caseOK
                   (block $caseCompiled
                     (br_table $caseOK $caseCompiled $caseDefault
-                      (i32.load (i32.const 0x209a0 (; = body(STATE) ;)))))
-                  (i32.const 0x2009c (; = str("compiled\n") ;)) (br $endCase))
-                (i32.const 0x20091 (; = str("ok\n") ;)) (br $endCase))
-              (i32.const 0x20095 (; = str("error\n") ;))))))
+                      (i32.load (i32.const 0x3bb64 (; = body(STATE) ;)))))
+                  (i32.const 0x3b09c (; = str("compiled\n") ;)) (br $endCase))
+                (i32.const 0x3b091 (; = str("ok\n") ;)) (br $endCase))
+              (i32.const 0x3b095 (; = str("error\n") ;))))))
 
         (local.get $tos)
         (br $loop)))
@@ -88,6 +122,9 @@
       ;; Reset the global TOS pointer to the current local value (still on the WASM operand stack)
       (global.set $tos)
 
+      ;; Load all pending code before returning to the shell
+      (call $flushCode)
+
       ;; End of input was reached
       (global.set $error (i32.const 0x4 (; = ERR_EOI ;))))
 
@@ -121,7 +158,7 @@
             ;; Name found in the dictionary.
             (block
               ;; Are we interpreting? Then jump out of this block
-              (br_if 0 (i32.eqz (i32.load (i32.const 0x209a0 (; = body(STATE) ;)))))
+              (br_if 0 (i32.eqz (i32.load (i32.const 0x3bb64 (; = body(STATE) ;)))))
               ;; Is the word immediate? Then jump out of this block
               (br_if 0 (i32.eq (local.get $findResult) (i32.const 1)))
 
@@ -142,7 +179,7 @@
                 (local.set $number)
 
                 ;; Are we compiling?
-                (if (i32.load (i32.const 0x209a0 (; = body(STATE) ;)))
+                (if (i32.load (i32.const 0x3bb64 (; = body(STATE) ;)))
                   (then
                     ;; We're compiling. Add a push of the number to the current compilation body.
                     (local.set $tos (call $compilePushConst (local.get $tos) (local.get $number))))
@@ -163,6 +200,11 @@
     ;; Get the table index of the dictionary entry
     (local.set $body (call $body (local.get $xt)))
 
+    ;; Load the code if it is still pending
+    (if (i32.ge_u (i32.load (local.get $body))
+                  (i32.sub (global.get $nextTableIndex) (global.get $batchCount)))
+      (then (call $flushCode)))
+
     ;; Perform an indirect call to the table index
     (if (result i32) (i32.and
           (i32.load8_u (i32.add (local.get $xt) (i32.const 4)))
@@ -187,9 +229,141 @@
     (global.set $tos (local.get $tos))
     (global.set $tors (i32.const 0x2000 (; = RETURN_STACK_BASE ;)))
     (global.set $sourceID (i32.const 0))
-    (i32.store (i32.const 0x209a0 (; = body(STATE) ;)) (i32.const 0))
+    (global.set $catchDepth (i32.const 0))
+    (global.set $up (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+    (i32.store (i32.const 0x3bb64 (; = body(STATE) ;)) (i32.const 0))
     (unreachable))
 
+  ;; Exceptions
+  ;;
+  ;; THROW throws a WebAssembly exception, which unwinds to the `try` of the
+  ;; innermost CATCH. Without a CATCH frame, exceptions abort back to the
+  ;; system (see $quit).
+  ;;
+  ;; Engines without exception handling (e.g. the one of the standalone shell)
+  ;; use a version of the core without the code between the `exceptions:`
+  ;; markers, and with the `traps:` lines uncommented. This version imports
+  ;; $raise and $tryExecute from the host, which implements them with traps
+  ;; (using the exported `execute`).
+  ;;
+  ;; Exception codes raised by the system (the THROW codes of the standard):
+  ;;   EXC_ABORT               := -1
+  ;;   EXC_ABORTQ              := -2
+  ;;   EXC_STACK_UNDERFLOW     := -4
+  ;;   EXC_DICTIONARY_OVERFLOW := -8
+  ;;   EXC_DIVISION_BY_ZERO    := -10
+  ;;   EXC_UNDEFINED_WORD      := -13
+  ;;   EXC_COMPILE_ONLY        := -14
+  ;;   EXC_ZERO_LENGTH_NAME    := -16
+  ;;   EXC_UNSUPPORTED         := -21
+  ;; exceptions: begin
+  (tag $exception (param i32))
+
+  ;; Throws exception `code`
+  (func $raise (param $code i32)
+    (throw $exception (local.get $code)))
+
+  ;; Executes `xt`, catching the exceptions it throws.
+  ;; Returns the resulting top of stack and 0, or (if an exception was caught)
+  ;; the original top of stack and the exception code.
+  (func $tryExecute (param $tos i32) (param $xt i32) (result i32 i32)
+    (try (result i32 i32)
+      (do
+        (call $execute (local.get $tos) (local.get $xt))
+        (i32.const 0))
+      (catch $exception
+        (local.set $xt)
+        (local.get $tos)
+        (local.get $xt))))
+  ;; exceptions: end
+
+  ;; Throws exception `code` to the innermost CATCH frame, or aborts if there
+  ;; is none.
+  (func $throw (param $tos i32) (param $code i32) (result i32)
+    (if (global.get $catchDepth)
+      (then (call $raise (local.get $code))))
+    (global.set $error (i32.const 0x3 (; = ERR_ABORT ;)))
+    (call $quit (i32.const 0x10000 (; = STACK_BASE ;))))
+
+  ;; Scheduler
+  ;;
+  ;; Tasks (see TASK) are run in turns. This is not a multitasker that
+  ;; switches between tasks: WebAssembly can't switch between call stacks, so
+  ;; a task can't be suspended. Instead, every time a task gets a turn, it
+  ;; executes its action (see SCHEDULE) once, to completion, on its own data
+  ;; stack, until it is stopped (see STOP). A turn can therefore use the
+  ;; return stack of the caller.
+  ;;
+  ;; The main task (the one running the interpreter) is the operator. Only
+  ;; the operator gives turns to other tasks (see RUN-TASKS), and it does so
+  ;; while it waits for input (KEY, ACCEPT and REFILL). A task that wants to
+  ;; wait has to return from its action, and continue on its next turn (e.g.
+  ;; based on state kept in its stack or its USER variables). RUN-TASKS in a
+  ;; turn fails (which stops the task).
+  ;; All tasks are linked in a ring, starting and ending with the operator.
+  ;;
+  ;; Every task has a task control block (TCB):
+  ;;   TCB_LINK       := 0x0    (next task in the ring)
+  ;;   TCB_STATUS     := 0x4    (non-zero if the task is active)
+  ;;   TCB_TOS        := 0x8    (top of the data stack of the task)
+  ;;   TCB_XT         := 0xc    (the action of the task)
+  ;;   TCB_STACK_BASE := 0x10   (bottom of the data stack of the task)
+  ;;   TCB_USER       := 0x14   (user area, see USER)
+  ;;   USER_AREA_SIZE := 0x80
+  ;;   TCB_SIZE       := 0x94   (TCB_USER + USER_AREA_SIZE)
+  ;;
+  ;; The data stack of a task follows its TCB:
+  ;;   TASK_DATA_STACK_SIZE := 0x400
+  ;;   TASK_SIZE            := 0x494 (TCB_SIZE + TASK_DATA_STACK_SIZE)
+  ;;
+  ;; The TCB of the operator is at OPERATOR_BASE, followed by the offset of
+  ;; the next USER variable:
+  ;;   NEXT_USER_OFFSET_BASE := 0x30894 (OPERATOR_BASE + TCB_SIZE)
+  (data (i32.const 0x30800 (; = OPERATOR_BASE ;))
+    "\00\08\03\00" (; = pack(OPERATOR_BASE) ;)
+    "\ff\ff\ff\ff" "\00\00\00\00" "\00\00\00\00"
+    "\00\00\01\00" (; = pack(STACK_BASE) ;))
+
+  ;; Gives every active task a turn, if called from the operator.
+  ;; An exception in a turn stops the task.
+  (func $runTasks
+    (local $task i32)
+    (local $tos i32)
+    (local $n i32)
+    (local $prevCatchDepth i32)
+    (local $prevTors i32)
+    (if (i32.ne (global.get $up) (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+      (then (return)))
+    (local.set $prevCatchDepth (global.get $catchDepth))
+    (local.set $prevTors (global.get $tors))
+    (local.set $task (i32.load (i32.const 0x30800 (; = OPERATOR_BASE ;))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $task) (i32.const 0x30800 (; = OPERATOR_BASE ;))))
+        (if (i32.load (i32.add (local.get $task) (i32.const 0x4 (; = TCB_STATUS ;))))
+          (then
+            (global.set $up (local.get $task))
+            (global.set $catchDepth (i32.add (local.get $prevCatchDepth) (i32.const 1)))
+            (call $tryExecute
+              (i32.load (i32.add (local.get $task) (i32.const 0x8 (; = TCB_TOS ;))))
+              (i32.load (i32.add (local.get $task) (i32.const 0xc (; = TCB_XT ;)))))
+            (local.set $n)
+            (local.set $tos)
+            (if (local.get $n)
+              (then
+                (i32.store (i32.add (local.get $task) (i32.const 0x4 (; = TCB_STATUS ;))) (i32.const 0))
+                (global.set $tors (local.get $prevTors)))
+              (else
+                (i32.store (i32.add (local.get $task) (i32.const 0x8 (; = TCB_TOS ;))) (local.get $tos))))))
+        (local.set $task (i32.load (local.get $task)))
+        (br $loop)))
+    (global.set $up (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+    (global.set $catchDepth (local.get $prevCatchDepth)))
+
+  ;; Returns the bottom of the data stack of the current task
+  (func $stackBase (result i32)
+    (i32.load (i32.add (global.get $up) (i32.const 0x10 (; = TCB_STACK_BASE ;)))))
+
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Function table
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -204,7 +378,6 @@
   ;; Predefined entries:
   ;;
   ;;   START_DO_INDEX := 1
-  ;;   UPDATE_DO_INDEX := 2
   ;;   PUSH_DATA_ADDRESS_INDEX := 3
   ;;   SET_LATEST_BODY_INDEX := 4
   ;;   COMPILE_EXECUTE_INDEX := 5
@@ -212,7 +385,10 @@
   ;;   RESET_MARKER_INDEX := 7
   ;;   EXECUTE_DEFER_INDEX := 8
   ;;   END_DO_INDEX := 9
-  (table (export "table") 0xc4 funcref)
+  ;;   ABORT_MESSAGE_INDEX := 10
+  ;;   USER_ADDRESS_INDEX := 11
+  ;;   BURN_FUEL_INDEX := 12
+  (table (export "table") 0xe3 funcref)
 
   ;; The function table contains 2 type of entries for: entries for
   ;; regular compiled words, and entries for data words.
@@ -226,34 +402,55 @@
   ;; as second parameter.
   (type $dataWord (func (param i32) (param i32) (result i32)))
 
+  ;; Some helpers return an extra value.
+  (type $wordWithResult (func (param i32) (result i32 i32)))
+
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Data
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 
   ;;
   ;; Memory size:
-  ;;   MEMORY_SIZE       := 104857600   (100*1024*1024)
-  ;;   MEMORY_SIZE_PAGES :=      1600   (MEMORY_SIZE / 65536)
+  ;;   INITIAL_MEMORY_PAGES :=        0x5   (320 KiB)
+  ;;   MAX_MEMORY_PAGES     :=     0x8000   (2 GiB)
+  ;;   MAX_MEMORY_SIZE      := 0x80000000   (MAX_MEMORY_PAGES * 65536)
+  ;;
+  ;; Memory starts out small, and grows on demand when HERE moves up (see
+  ;; `reserve`), or when the heap grows. Hosts can grow it further up front.
+  ;; The maximum keeps all addresses positive when interpreted as signed cells.
   ;;
   ;; Memory layout:
-  ;;   INPUT_BUFFER_BASE  :=     0x0
-  ;;   INPUT_BUFFER_SIZE  :=  0x1000
-  ;;   (Compiled modules are limited to 4096 bytes until Chrome refuses to load them synchronously)
-  ;;   MODULE_HEADER_BASE :=  0x1000
-  ;;   RETURN_STACK_BASE  :=  0x2000
-  ;;   STACK_BASE         := 0x10000
-  ;;   DATA_SPACE_BASE    := 0x20000
+  ;;   INPUT_BUFFER_BASE     :=     0x0
+  ;;   INPUT_BUFFER_SIZE     :=  0x2000
+  ;;   RETURN_STACK_BASE     :=  0x2000
+  ;;   STACK_BASE            := 0x10000
+  ;;   MODULE_HEADER_BASE    := 0x20000
+  ;;   MODULE_END            := 0x30000 (compiled modules are limited to 64 KiB)
+  ;;   INLINE_TEMPLATES_BASE := 0x30000
+  ;;   STACK_CACHE_BASE      := 0x30700
+  ;;   OPERATOR_BASE         := 0x30800 (see Scheduler)
+  ;;   TASK_STATE_BASE       := 0x30900 (see Tasks)
+  ;;   BATCH_BASE            := 0x31000
+  ;;   DICTIONARY_BLOOM_BASE := 0x32800
+  ;;   DICTIONARY_INDEX_BASE := 0x33000
+  ;;   DATA_SPACE_BASE       := 0x3B000
+  ;;   (heap, see Heap)
   ;;
   ;; Transient regions, offset from HERE:
   ;;   PICTURED_OUTPUT_OFFSET := 0x200 (filled backward)
   ;;   WORD_OFFSET            := 0x200
   ;;   PAD_OFFSET             := 0x304 (WORD_OFSET + 1 + 0xFF)
+  ;;   PAD_SIZE               := 0x100
+  ;;   HERE_RESERVE           := 0x404 (PAD_OFFSET + PAD_SIZE)
   ;;
-  (memory (export "memory") 0x640 (; = MEMORY_SIZE_PAGES ;))
+  (memory (export "memory") 0x5 (; = INITIAL_MEMORY_PAGES ;) 0x8000 (; = MAX_MEMORY_PAGES ;))
 
   ;; The header of a WebAssembly module for a compiled word.
   ;; The body of the compiled word is directly appended to the end
-  ;; of this chunk:
+  ;; of this chunk. When the word is done, its function body is moved to
+  ;; the batch of code to load (see `flushCode`), which reuses the type and
+  ;; import sections of this header. A body that is too large for a batch
+  ;; is loaded together with this header instead (see `loadModule`).
   ;;
   ;; Bytes with the top 4 bits set (0xF.) are placeholders
   ;; for patching, for which the offsets are computed below:
@@ -264,7 +461,7 @@
   ;;   MODULE_HEADER_TABLE_INDEX_PLACEHOLDER        := 0xFC
   ;;   MODULE_HEADER_TABLE_INITIAL_SIZE_PLACEHOLDER := 0xFB
   ;;   MODULE_HEADER_FUNCTION_TYPE_PLACEHOLDER      := 0xFA
-  (data (i32.const 0x1000 (; = MODULE_HEADER_BASE ;))
+  (data (i32.const 0x20000 (; = MODULE_HEADER_BASE ;))
     "\00\61\73\6D" ;; Header
     "\01\00\00\00" ;; Version
 
@@ -310,29 +507,123 @@
   ;;   MODULE_HEADER_TABLE_INITIAL_SIZE_OFFSET := 0x2c
   ;;   MODULE_HEADER_FUNCTION_TYPE_OFFSET := 0x41
   ;;
-  ;;   MODULE_BODY_BASE := 0x105E                      (MODULE_HEADER_BASE + 0x5e (; = MODULE_HEADER_SIZE ;))
-  ;;   MODULE_HEADER_CODE_SIZE_BASE := 0x104f          (MODULE_HEADER_BASE + 0x4f (; = MODULE_HEADER_CODE_SIZE_OFFSET ;))
-  ;;   MODULE_HEADER_BODY_SIZE_BASE := 0x1054          (MODULE_HEADER_BASE + 0x54 (; = MODULE_HEADER_BODY_SIZE_OFFSET ;))
-  ;;   MODULE_HEADER_LOCAL_COUNT_BASE := 0x1059        (MODULE_HEADER_BASE + 0x59 (; = MODULE_HEADER_LOCAL_COUNT_OFFSET ;))
-  ;;   MODULE_HEADER_TABLE_INDEX_BASE := 0x1047        (MODULE_HEADER_BASE + 0x47 (; = MODULE_HEADER_TABLE_INDEX_OFFSET ;))
-  ;;   MODULE_HEADER_TABLE_INITIAL_SIZE_BASE := 0x102c (MODULE_HEADER_BASE + 0x2c (; = MODULE_HEADER_TABLE_INITIAL_SIZE_OFFSET ;))
-  ;;   MODULE_HEADER_FUNCTION_TYPE_BASE := 0x1041      (MODULE_HEADER_BASE + 0x41 (; = MODULE_HEADER_FUNCTION_TYPE_OFFSET ;))
+  ;;   MODULE_BODY_BASE := 0x2005E                      (MODULE_HEADER_BASE + 0x5e (; = MODULE_HEADER_SIZE ;))
+  ;;   MODULE_HEADER_CODE_SIZE_BASE := 0x2004f          (MODULE_HEADER_BASE + 0x4f (; = MODULE_HEADER_CODE_SIZE_OFFSET ;))
+  ;;   MODULE_HEADER_BODY_SIZE_BASE := 0x20054          (MODULE_HEADER_BASE + 0x54 (; = MODULE_HEADER_BODY_SIZE_OFFSET ;))
+  ;;   MODULE_HEADER_LOCAL_COUNT_BASE := 0x20059        (MODULE_HEADER_BASE + 0x59 (; = MODULE_HEADER_LOCAL_COUNT_OFFSET ;))
+  ;;   MODULE_HEADER_TABLE_INDEX_BASE := 0x20047        (MODULE_HEADER_BASE + 0x47 (; = MODULE_HEADER_TABLE_INDEX_OFFSET ;))
+  ;;   MODULE_HEADER_TABLE_INITIAL_SIZE_BASE := 0x2002c (MODULE_HEADER_BASE + 0x2c (; = MODULE_HEADER_TABLE_INITIAL_SIZE_OFFSET ;))
+  ;;   MODULE_HEADER_FUNCTION_TYPE_BASE := 0x20041      (MODULE_HEADER_BASE + 0x41 (; = MODULE_HEADER_FUNCTION_TYPE_OFFSET ;))
+  ;;
+  ;; Code is only emitted while the end of the body is below the code limit
+  ;; (MODULE_CODE_LIMIT by default), leaving room for the largest single
+  ;; emission (an inline template), and for the name section.
+  ;; Hosts can lower the limit (see `setModuleSizeLimit`), e.g. because Chrome
+  ;; refuses to load modules larger than 4 KiB synchronously.
+  ;;
+  ;;   MODULE_CODE_LIMIT := 0x2FE00                     (MODULE_END - 0x200)
+  ;;   MODULE_CODE_ROOM := 0x200
+
+  ;; Code templates of primitive words that are inlined in compiled words,
+  ;; instead of being called through the function table (see `compileInline`).
+  ;;
+  ;; Templates operate on the top stack cells, which are kept in locals while
+  ;; compiling (see `Stack cache` below). Every entry consists of:
+  ;;
+  ;;   - the table index of the word (4 bytes)
+  ;;   - the size of the rest of the entry (1 byte)
+  ;;   - the number of stack cells consumed by the word
+  ;;   - the number of arguments, followed by the cells to push on the operand stack
+  ;;   - the size of the code, followed by the code itself
+  ;;   - the number of resulting stack cells, followed by the resulting cells
+  ;;
+  ;; Cells are numbered from the deepest consumed cell, followed by the values
+  ;; the code leaves on the operand stack. Local 0 can be used as scratch.
+  ;;
+  ;; The list is terminated by a 0 index.
+  (data (i32.const 0x30000 (; = INLINE_TEMPLATES_BASE ;))
+    ;; ( x1 x2 -- x3 )
+    "\1a\00\00\00" (; = pack(index("*")) ;) "\08" "\02" "\02\00\01" "\01\6c" "\01\02"
+    "\1d\00\00\00" (; = pack(index("+")) ;) "\08" "\02" "\02\00\01" "\01\6a" "\01\02"
+    "\21\00\00\00" (; = pack(index("-")) ;) "\08" "\02" "\02\00\01" "\01\6b" "\01\02"
+    "\51\00\00\00" (; = pack(index("AND")) ;) "\08" "\02" "\02\00\01" "\01\71" "\01\02"
+    "\8f\00\00\00" (; = pack(index("LSHIFT")) ;) "\08" "\02" "\02\00\01" "\01\74" "\01\02"
+    "\98\00\00\00" (; = pack(index("OR")) ;) "\08" "\02" "\02\00\01" "\01\72" "\01\02"
+    "\ab\00\00\00" (; = pack(index("RSHIFT")) ;) "\08" "\02" "\02\00\01" "\01\76" "\01\02"
+    "\dd\00\00\00" (; = pack(index("XOR")) ;) "\08" "\02" "\02\00\01" "\01\73" "\01\02"
+    "\92\00\00\00" (; = pack(index("MAX")) ;) "\0b" "\02" "\04\00\01\00\01" "\02\4a\1b" "\01\02" ;; i32.gt_s, select
+    "\93\00\00\00" (; = pack(index("MIN")) ;) "\0b" "\02" "\04\00\01\00\01" "\02\48\1b" "\01\02" ;; i32.lt_s, select
+    ;; ( x1 x2 -- flag ), where flag = -(x1 <op> x2)
+    "\3f\00\00\00" (; = pack(index("<")) ;) "\0b" "\02" "\02\00\01" "\04\48\41\7f\6c" "\01\02"
+    "\29\00\00\00" (; = pack(index("<>")) ;) "\0b" "\02" "\02\00\01" "\04\47\41\7f\6c" "\01\02"
+    "\41\00\00\00" (; = pack(index("=")) ;) "\0b" "\02" "\02\00\01" "\04\46\41\7f\6c" "\01\02"
+    "\42\00\00\00" (; = pack(index(">")) ;) "\0b" "\02" "\02\00\01" "\04\4a\41\7f\6c" "\01\02"
+    "\c5\00\00\00" (; = pack(index("U<")) ;) "\0b" "\02" "\02\00\01" "\04\49\41\7f\6c" "\01\02"
+    "\c6\00\00\00" (; = pack(index("U>")) ;) "\0b" "\02" "\02\00\01" "\04\4b\41\7f\6c" "\01\02"
+    ;; ( x1 -- x2 )
+    "\30\00\00\00" (; = pack(index("1+")) ;) "\09" "\01" "\01\00" "\03\41\01\6a" "\01\01"
+    "\31\00\00\00" (; = pack(index("1-")) ;) "\09" "\01" "\01\00" "\03\41\01\6b" "\01\01"
+    "\33\00\00\00" (; = pack(index("2*")) ;) "\09" "\01" "\01\00" "\03\41\01\74" "\01\01"
+    "\34\00\00\00" (; = pack(index("2/")) ;) "\09" "\01" "\01\00" "\03\41\01\75" "\01\01"
+    "\47\00\00\00" (; = pack(index("@")) ;) "\09" "\01" "\01\00" "\03\28\02\00" "\01\01"
+    "\5a\00\00\00" (; = pack(index("C@")) ;) "\09" "\01" "\01\00" "\03\2d\00\00" "\01\01"
+    "\5c\00\00\00" (; = pack(index("CELL+")) ;) "\09" "\01" "\01\00" "\03\41\04\6a" "\01\01"
+    "\5d\00\00\00" (; = pack(index("CELLS")) ;) "\09" "\01" "\01\00" "\03\41\02\74" "\01\01"
+    "\5f\00\00\00" (; = pack(index("CHAR+")) ;) "\09" "\01" "\01\00" "\03\41\01\6a" "\01\01"
+    "\86\00\00\00" (; = pack(index("INVERT")) ;) "\09" "\01" "\01\00" "\03\41\7f\73" "\01\01"
+    "\96\00\00\00" (; = pack(index("NEGATE")) ;) "\09" "\01" "\01\00" "\03\41\7f\6c" "\01\01"
+    "\2c\00\00\00" (; = pack(index("0<")) ;) "\09" "\01" "\01\00" "\03\41\1f\75" "\01\01"
+    "\2d\00\00\00" (; = pack(index("0<>")) ;) "\0c" "\01" "\01\00" "\06\41\00\47\41\7f\6c" "\01\01"
+    "\2e\00\00\00" (; = pack(index("0=")) ;) "\0a" "\01" "\01\00" "\04\45\41\7f\6c" "\01\01"
+    "\2f\00\00\00" (; = pack(index("0>")) ;) "\0c" "\01" "\01\00" "\06\41\00\4a\41\7f\6c" "\01\01"
+    "\4a\00\00\00" (; = pack(index("ABS")) ;) "\10" "\01" "\02\00\00" "\09\41\1f\75\22\00\73\20\00\6b" "\01\01" ;; (x ^ y) - y, with y = x >> 31 (in local 0)
+    "\af\00\00\00" (; = pack(index("S>D")) ;) "\0a" "\01" "\01\00" "\03\41\1f\75" "\02\00\01"
+    "\da\00\00\00" (; = pack(index("WITHIN")) ;) "\13" "\03" "\04\02\01\00\01" "\0a\6b\21\00\6b\20\00\4b\41\7f\6c" "\01\03" ;; (hi - lo) >u (n - lo)
+    ;; ( -- x )
+    "\53\00\00\00" (; = pack(index("BL")) ;) "\07" "\00" "\00" "\02\41\20" "\01\00"
+    "\78\00\00\00" (; = pack(index("FALSE")) ;) "\07" "\00" "\00" "\02\41\00" "\01\00"
+    "\c1\00\00\00" (; = pack(index("TRUE")) ;) "\07" "\00" "\00" "\02\41\7f" "\01\00"
+    ;; Memory
+    "\12\00\00\00" (; = pack(index("!")) ;) "\09" "\02" "\02\01\00" "\03\36\02\00" "\00"
+    "\1e\00\00\00" (; = pack(index("+!")) ;) "\0e" "\02" "\03\01\00\01" "\07\28\02\00\6a\36\02\00" "\00"
+    "\57\00\00\00" (; = pack(index("C!")) ;) "\09" "\02" "\02\01\00" "\03\3a\00\00" "\00"
+    ;; Stack manipulation (no code)
+    "\37\00\00\00" (; = pack(index("2DROP")) ;) "\04" "\02" "\00" "\00" "\00"
+    "\38\00\00\00" (; = pack(index("2DUP")) ;) "\08" "\02" "\00" "\00" "\04\00\01\00\01"
+    "\39\00\00\00" (; = pack(index("2OVER")) ;) "\0a" "\04" "\00" "\00" "\06\00\01\02\03\00\01"
+    "\3c\00\00\00" (; = pack(index("2SWAP")) ;) "\08" "\04" "\00" "\00" "\04\02\03\00\01"
+    "\60\00\00\00" (; = pack(index("CHARS")) ;) "\04" "\00" "\00" "\00" "\00"
+    "\6f\00\00\00" (; = pack(index("DROP")) ;) "\04" "\01" "\00" "\00" "\00"
+    "\70\00\00\00" (; = pack(index("DUP")) ;) "\06" "\01" "\00" "\00" "\02\00\00"
+    "\97\00\00\00" (; = pack(index("NIP")) ;) "\05" "\02" "\00" "\00" "\01\01"
+    "\99\00\00\00" (; = pack(index("OVER")) ;) "\07" "\02" "\00" "\00" "\03\00\01\00"
+    "\aa\00\00\00" (; = pack(index("ROT")) ;) "\07" "\03" "\00" "\00" "\03\01\02\00"
+    "\bc\00\00\00" (; = pack(index("SWAP")) ;) "\06" "\02" "\00" "\00" "\02\01\00"
+    "\c2\00\00\00" (; = pack(index("TUCK")) ;) "\07" "\02" "\00" "\00" "\03\01\00\01"
+    "\00\00\00\00")
 
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Constant strings
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 
-  (data (i32.const 0x20000) "\0e" "undefined word")
-  (data (i32.const 0x2000f) "\0d" "division by 0")
-  (data (i32.const 0x2001d) "\10" "incomplete input")
-  (data (i32.const 0x2002e) "\24" "word not supported in interpret mode")
-  (data (i32.const 0x20053) "\0f" "not implemented")
-  (data (i32.const 0x20063) "\11" "ADDRESS-UNIT-BITS")
-  (data (i32.const 0x20075) "\0f" "/COUNTED-STRING")
-  (data (i32.const 0x20085) "\0b" "stack empty")
-  (data (i32.const 0x20091) "\03" "ok\n")
-  (data (i32.const 0x20095) "\06" "error\n")
-  (data (i32.const 0x2009c) "\09" "compiled\n")
+  (data (i32.const 0x3b000) "\0e" "undefined word")
+  (data (i32.const 0x3b00f) "\0d" "division by 0")
+  (data (i32.const 0x3b01d) "\10" "incomplete input")
+  (data (i32.const 0x3b02e) "\24" "word not supported in interpret mode")
+  (data (i32.const 0x3b053) "\0f" "not implemented")
+  (data (i32.const 0x3b063) "\11" "ADDRESS-UNIT-BITS")
+  (data (i32.const 0x3b075) "\0f" "/COUNTED-STRING")
+  (data (i32.const 0x3b085) "\0b" "stack empty")
+  (data (i32.const 0x3b091) "\03" "ok\n")
+  (data (i32.const 0x3b095) "\06" "error\n")
+  (data (i32.const 0x3b09c) "\09" "compiled\n")
+  (data (i32.const 0x3b0a6) "\0d" "out of memory")
+  (data (i32.const 0x3b0b4) "\12" "uncaught exception")
+  (data (i32.const 0x3b0c7) "\13" "definition too long")
+  (data (i32.const 0x3b0db) "\13" "RUN-TASKS in a task")
+  (data (i32.const 0x3b0ef) "\1e" "not supported in a task thread")
+  (data (i32.const 0x3b10e) "\21" "memory can't grow while tasks run")
+  (data (i32.const 0x3b130) "\0b" "out of fuel")
 
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Built-in words
@@ -364,7 +655,7 @@
   ;; [15.6.2.0470](https://forth-standard.org/standard/tools/SemiCODE)
   (func $semiCODE (param $tos i32) (result i32)
     (call $semicolon (local.get $tos)))
-  (data (i32.const 0x200a8) "\00\00\00\00" "\85" (; F_IMMEDIATE ;) ";CODE  " "\10\00\00\00")
+  (data (i32.const 0x3b13c) "\00\00\00\00" "\85" (; F_IMMEDIATE ;) ";CODE  " "\10\00\00\00")
   (elem (i32.const 0x10) $semiCODE)
 
   ;; [6.2.0455](https://forth-standard.org/standard/core/ColonNONAME)
@@ -374,7 +665,7 @@
     (call $emitGetLocal (i32.const 0))
     (call $push (local.get $tos) (global.get $latest))
     (call $right-bracket))
-  (data (i32.const 0x200b8) "\a8\00\02\00" "\07" ":NONAME" "\11\00\00\00")
+  (data (i32.const 0x3b14c) "\3c\b1\03\00" "\07" ":NONAME" "\11\00\00\00")
   (elem (i32.const 0x11) $:NONAME)
 
   ;; [6.1.0010](https://forth-standard.org/standard/core/Store)
@@ -383,7 +674,7 @@
     (i32.store (i32.load (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.get $bbtos))
-  (data (i32.const 0x200c8) "\b8\00\02\00" "\01" "!  " "\12\00\00\00")
+  (data (i32.const 0x3b15c) "\4c\b1\03\00" "\01" "!  " "\12\00\00\00")
   (elem (i32.const 0x12) $!)
 
   ;; [6.2.0620](https://forth-standard.org/standard/core/qDO)
@@ -391,14 +682,14 @@
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileDo (i32.const 1)))
-  (data (i32.const 0x200d4) "\c8\00\02\00" "\83" (; F_IMMEDIATE ;) "?DO" "\13\00\00\00")
+  (data (i32.const 0x3b168) "\5c\b1\03\00" "\83" (; F_IMMEDIATE ;) "?DO" "\13\00\00\00")
   (elem (i32.const 0x13) $?DO)
 
   ;; [6.2.0200](https://forth-standard.org/standard/core/Dotp)
   (func $.p (param $tos i32) (result i32)
     (call $type (call $parse (i32.const 0x29 (; = ')' ;))))
     (local.get $tos))
-  (data (i32.const 0x200e0) "\d4\00\02\00" "\82" (; F_IMMEDIATE ;) ".( " "\14\00\00\00")
+  (data (i32.const 0x3b174) "\68\b1\03\00" "\82" (; F_IMMEDIATE ;) ".( " "\14\00\00\00")
   (elem (i32.const 0x14) $.p)
 
   ;; [6.1.0030](https://forth-standard.org/standard/core/num)
@@ -408,7 +699,7 @@
     (local $bbtos i32)
     (local $m i64)
     (local $npo i32)
-    (local.set $base (i64.extend_i32_u (i32.load (i32.const 0x2040c (; = body(BASE) ;)))))
+    (local.set $base (i64.extend_i32_u (i32.load (i32.const 0x3b4d8 (; = body(BASE) ;)))))
     (local.set $v (i64.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.set $m (i64.rem_u (local.get $v) (local.get $base)))
     (local.set $v (i64.div_u (local.get $v) (local.get $base)))
@@ -417,7 +708,7 @@
     (i64.store (local.get $bbtos) (local.get $v))
     (global.set $po (local.get $npo))
     (local.get $tos))
-  (data (i32.const 0x200ec) "\e0\00\02\00" "\01" "#  " "\15\00\00\00")
+  (data (i32.const 0x3b180) "\74\b1\03\00" "\01" "#  " "\15\00\00\00")
   (elem (i32.const 0x15) $#)
 
   ;; [6.1.0040](https://forth-standard.org/standard/core/num-end)
@@ -425,7 +716,7 @@
     (i32.store (i32.sub (local.get $tos) (i32.const 8)) (global.get $po))
     (i32.store (i32.sub (local.get $tos) (i32.const 4)) (i32.sub (i32.add (global.get $here) (i32.const 0x200 (; = PICTURED_OUTPUT_OFFSET ;))) (global.get $po)))
     (local.get $tos))
-  (data (i32.const 0x200f8) "\ec\00\02\00" "\02" "#> " "\16\00\00\00")
+  (data (i32.const 0x3b18c) "\80\b1\03\00" "\02" "#> " "\16\00\00\00")
   (elem (i32.const 0x16) $#>)
 
   ;; [6.1.0050](https://forth-standard.org/standard/core/numS)
@@ -435,7 +726,7 @@
     (local $bbtos i32)
     (local $m i64)
     (local $po i32)
-    (local.set $base (i64.extend_i32_u (i32.load (i32.const 0x2040c (; = body(BASE) ;)))))
+    (local.set $base (i64.extend_i32_u (i32.load (i32.const 0x3b4d8 (; = body(BASE) ;)))))
     (local.set $v (i64.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.set $po (global.get $po))
     (loop $loop
@@ -447,21 +738,21 @@
     (i64.store (local.get $bbtos) (local.get $v))
     (global.set $po (local.get $po))
     (local.get $tos))
-  (data (i32.const 0x20104) "\f8\00\02\00" "\02" "#S " "\17\00\00\00")
+  (data (i32.const 0x3b198) "\8c\b1\03\00" "\02" "#S " "\17\00\00\00")
   (elem (i32.const 0x17) $#S)
 
   ;; [6.1.0070](https://forth-standard.org/standard/core/Tick)
   (func $' (param $tos i32) (result i32)
     (i32.store (local.get $tos) (drop (call $find! (call $parseName))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20110) "\04\01\02\00" "\01" "'  " "\18\00\00\00")
+  (data (i32.const 0x3b1a4) "\98\b1\03\00" "\01" "'  " "\18\00\00\00")
   (elem (i32.const 0x18) $')
 
   ;; [6.1.0080](https://forth-standard.org/standard/core/p)
   (func $paren (param $tos i32) (result i32)
     (drop (drop (call $parse (i32.const 0x29 (; = ')' ;)))))
     (local.get $tos))
-  (data (i32.const 0x2011c) "\10\01\02\00" "\81" (; F_IMMEDIATE ;) "(  " "\19\00\00\00")
+  (data (i32.const 0x3b1b0) "\a4\b1\03\00" "\81" (; F_IMMEDIATE ;) "(  " "\19\00\00\00")
   (elem (i32.const 0x19) $paren)
 
   ;; [6.1.0090](https://forth-standard.org/standard/core/Times)
@@ -472,7 +763,7 @@
                 (i32.mul (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))
                         (i32.load (local.get $bbtos))))
     (local.get $btos))
-  (data (i32.const 0x20128) "\1c\01\02\00" "\01" "*  " "\1a\00\00\00")
+  (data (i32.const 0x3b1bc) "\b0\b1\03\00" "\01" "*  " "\1a\00\00\00")
   (elem (i32.const 0x1a) $*)
 
   ;; [6.1.0100](https://forth-standard.org/standard/core/TimesDiv)
@@ -486,7 +777,7 @@
                                 (i64.extend_i32_s (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8))))))
                       (i64.extend_i32_s (i32.load (i32.sub (local.get $tos) (i32.const 4)))))))
     (local.get $bbtos))
-  (data (i32.const 0x20134) "\28\01\02\00" "\02" "*/ " "\1b\00\00\00")
+  (data (i32.const 0x3b1c8) "\bc\b1\03\00" "\02" "*/ " "\1b\00\00\00")
   (elem (i32.const 0x1b) $*/)
 
   ;; [6.1.0110](https://forth-standard.org/standard/core/TimesDivMOD)
@@ -504,7 +795,7 @@
                       (local.tee $x2 (i64.extend_i32_s (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))))))
     (i32.store (local.get $bbtos) (i32.wrap_i64 (i64.div_s (local.get $x1) (local.get $x2))))
     (local.get $btos))
-  (data (i32.const 0x20140) "\34\01\02\00" "\05" "*/MOD  " "\1c\00\00\00")
+  (data (i32.const 0x3b1d4) "\c8\b1\03\00" "\05" "*/MOD  " "\1c\00\00\00")
   (elem (i32.const 0x1c) $*/MOD)
 
   ;; [6.1.0120](https://forth-standard.org/standard/core/Plus)
@@ -515,7 +806,7 @@
                 (i32.add (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))
                         (i32.load (local.get $bbtos))))
     (local.get $btos))
-  (data (i32.const 0x20150) "\40\01\02\00" "\01" "+  " "\1d\00\00\00")
+  (data (i32.const 0x3b1e4) "\d4\b1\03\00" "\01" "+  " "\1d\00\00\00")
   (elem (i32.const 0x1d) $+)
 
   ;; [6.1.0130](https://forth-standard.org/standard/core/PlusStore)
@@ -526,7 +817,7 @@
                 (i32.add (i32.load (local.get $addr))
                         (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8))))))
     (local.get $bbtos))
-  (data (i32.const 0x2015c) "\50\01\02\00" "\02" "+! " "\1e\00\00\00")
+  (data (i32.const 0x3b1f0) "\e4\b1\03\00" "\02" "+! " "\1e\00\00\00")
   (elem (i32.const 0x1e) $+!)
 
   ;; [6.1.0140](https://forth-standard.org/standard/core/PlusLOOP)
@@ -534,7 +825,7 @@
     (local.get $tos)
     (call $ensureCompiling)
     (call $compilePlusLoop))
-  (data (i32.const 0x20168) "\5c\01\02\00" "\85" (; F_IMMEDIATE ;) "+LOOP  " "\1f\00\00\00")
+  (data (i32.const 0x3b1fc) "\f0\b1\03\00" "\85" (; F_IMMEDIATE ;) "+LOOP  " "\1f\00\00\00")
   (elem (i32.const 0x1f) $+LOOP)
 
   ;; [6.1.0150](https://forth-standard.org/standard/core/Comma)
@@ -542,9 +833,9 @@
     (i32.store
       (global.get $here)
       (i32.load (i32.sub (local.get $tos) (i32.const 4))))
-    (global.set $here (i32.add (global.get $here) (i32.const 4)))
+    (call $setHere (i32.add (global.get $here) (i32.const 4)))
     (i32.sub (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20178) "\68\01\02\00" "\01" ",  " "\20\00\00\00")
+  (data (i32.const 0x3b20c) "\fc\b1\03\00" "\01" ",  " "\20\00\00\00")
   (elem (i32.const 0x20) $comma)
 
   ;; [6.1.0160](https://forth-standard.org/standard/core/Minus)
@@ -555,9 +846,20 @@
                 (i32.sub (i32.load (local.get $bbtos))
                         (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x20184) "\78\01\02\00" "\01" "-  " "\21\00\00\00")
+  (data (i32.const 0x3b218) "\0c\b2\03\00" "\01" "-  " "\21\00\00\00")
   (elem (i32.const 0x21) $-)
 
+  ;; [17.6.1.0170](https://forth-standard.org/standard/string/MinusTRAILING)
+  (func $-TRAILING (param $tos i32) (result i32)
+    (local $btos i32)
+    (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
+      (call $trailing
+        (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+        (i32.load (local.get $btos))))
+    (local.get $tos))
+  (data (i32.const 0x3b224) "\18\b2\03\00" "\09" "-TRAILING  " "\22\00\00\00")
+  (elem (i32.const 0x22) $-TRAILING)
+
   ;; [6.1.0180](https://forth-standard.org/standard/core/d)
   (func $. (param $tos i32) (result i32)
     (local $v i32)
@@ -565,36 +867,34 @@
     (local.set $v (call $pop))
     (if (i32.lt_s (local.get $v) (i32.const 0))
       (then
-        (call $shell_emit (i32.const 0x2d))
-        (local.set $v (i32.sub (i32.const 0) (local.get $v)))))
-    (call $U._ (local.get $v) (i32.load (i32.const 0x2040c (; = body(BASE) ;))))
-    (call $shell_emit (i32.const 0x20)))
-  (data (i32.const 0x20190) "\84\01\02\00" "\01" ".  " "\22\00\00\00")
-  (elem (i32.const 0x22) $.)
+        (call $U._ (i32.sub (i32.const 0) (local.get $v)) (i32.const 1)))
+      (else
+        (call $U._ (local.get $v) (i32.const 0)))))
+  (data (i32.const 0x3b238) "\24\b2\03\00" "\01" ".  " "\23\00\00\00")
+  (elem (i32.const 0x23) $.)
 
   ;; [6.1.0190](https://forth-standard.org/standard/core/Dotq)
   (func $.q (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $Sq)
-    (call $compileCall (i32.const 0) (i32.const 0xb0 (; = index("TYPE") ;))))
-  (data (i32.const 0x2019c) "\90\01\02\00" "\82" (; F_IMMEDIATE ;) ".\22 " "\23\00\00\00")
-  (elem (i32.const 0x23) $.q)
+    (call $compileCall (i32.const 0) (i32.const 0xc3 (; = index("TYPE") ;))))
+  (data (i32.const 0x3b244) "\38\b2\03\00" "\82" (; F_IMMEDIATE ;) ".\22 " "\24\00\00\00")
+  (elem (i32.const 0x24) $.q)
 
   ;; [15.6.1.0220](https://forth-standard.org/standard/tools/DotS)
   (func $.S (param $tos i32) (result i32)
     (local $p i32)
-    (local.set $p (i32.const 0x10000 (; = STACK_BASE ;)))
+    (local.set $p (call $stackBase))
     (block $endLoop
       (loop $loop
         (br_if $endLoop (i32.ge_u (local.get $p) (local.get $tos)))
-        (call $U._ (i32.load (local.get $p)) (i32.load (i32.const 0x2040c (; = body(BASE) ;))))
-        (call $shell_emit (i32.const 0x20))
+        (call $U._ (i32.load (local.get $p)) (i32.const 0))
         (local.set $p (i32.add (local.get $p) (i32.const 4)))
         (br $loop)))
     (local.get $tos))
-  (data (i32.const 0x201a8) "\9c\01\02\00" "\02" ".S " "\24\00\00\00")
-  (elem (i32.const 0x24) $.S)
+  (data (i32.const 0x3b250) "\44\b2\03\00" "\02" ".S " "\25\00\00\00")
+  (elem (i32.const 0x25) $.S)
 
   ;; [6.1.0230](https://forth-standard.org/standard/core/Div)
   (func $/ (param $tos i32) (result i32)
@@ -602,12 +902,12 @@
     (local $bbtos i32)
     (local $divisor i32)
     (if (i32.eqz (local.tee $divisor (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
-      (then (call $fail (i32.const 0x2000f (; = str("division by 0") ;)))))
+      (then (call $fail (i32.const -0xa (; = EXC_DIVISION_BY_ZERO ;)) (i32.const 0x3b00f (; = str("division by 0") ;)))))
     (i32.store (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))
                 (i32.div_s (i32.load (local.get $bbtos)) (local.get $divisor)))
     (local.get $btos))
-  (data (i32.const 0x201b4) "\a8\01\02\00" "\01" "/  " "\25\00\00\00")
-  (elem (i32.const 0x25) $/)
+  (data (i32.const 0x3b25c) "\50\b2\03\00" "\01" "/  " "\26\00\00\00")
+  (elem (i32.const 0x26) $/)
 
   ;; [6.1.0240](https://forth-standard.org/standard/core/DivMOD)
   (func $/MOD (param $tos i32) (result i32)
@@ -621,8 +921,23 @@
                                                                               (i32.const 4)))))))
     (i32.store (local.get $btos) (i32.div_s (local.get $n1) (local.get $n2)))
     (local.get $tos))
-  (data (i32.const 0x201c0) "\b4\01\02\00" "\04" "/MOD   " "\26\00\00\00")
-  (elem (i32.const 0x26) $/MOD)
+  (data (i32.const 0x3b268) "\5c\b2\03\00" "\04" "/MOD   " "\27\00\00\00")
+  (elem (i32.const 0x27) $/MOD)
+
+  ;; [17.6.1.0245](https://forth-standard.org/standard/string/DivSTRING)
+  (func $/STRING (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $bbtos i32)
+    (local $bbbtos i32)
+    (local $n i32)
+    (local.set $n (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
+    (i32.store (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12)))
+      (i32.add (i32.load (local.get $bbbtos)) (local.get $n)))
+    (i32.store (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.sub (i32.load (local.get $bbtos)) (local.get $n)))
+    (local.get $btos))
+  (data (i32.const 0x3b278) "\68\b2\03\00" "\07" "/STRING" "\28\00\00\00")
+  (elem (i32.const 0x28) $/STRING)
 
   ;; [6.2.0500](https://forth-standard.org/standard/core/ne)
   (func $<> (param $tos i32) (result i32)
@@ -634,24 +949,28 @@
       (then (i32.store (local.get $bbtos) (i32.const 0)))
       (else (i32.store (local.get $bbtos) (i32.const -1))))
     (local.get $btos))
-  (data (i32.const 0x201d0) "\c0\01\02\00" "\02" "<> " "\27\00\00\00")
-  (elem (i32.const 0x27) $<>)
+  (data (i32.const 0x3b288) "\78\b2\03\00" "\02" "<> " "\29\00\00\00")
+  (elem (i32.const 0x29) $<>)
 
   (func $$Scomma (param $tos i32) (result i32)
     (local $btos i32)
+    (call $compileSpill)
+    (call $checkCode)
     (global.set $cp
       (call $leb128 (global.get $cp) (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x201dc) "\d0\01\02\00" "\03" "$S," "\28\00\00\00")
-  (elem (i32.const 0x28) $$Scomma)
+  (data (i32.const 0x3b294) "\88\b2\03\00" "\03" "$S," "\2a\00\00\00")
+  (elem (i32.const 0x2a) $$Scomma)
 
   (func $$Ucomma (param $tos i32) (result i32)
     (local $btos i32)
+    (call $compileSpill)
+    (call $checkCode)
     (global.set $cp
       (call $leb128u (global.get $cp) (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x201e8) "\dc\01\02\00" "\03" "$U," "\29\00\00\00")
-  (elem (i32.const 0x29) $$Ucomma)
+  (data (i32.const 0x3b2a0) "\94\b2\03\00" "\03" "$U," "\2b\00\00\00")
+  (elem (i32.const 0x2b) $$Ucomma)
 
   ;; [6.1.0250](https://forth-standard.org/standard/core/Zeroless)
   (func $0< (param $tos i32) (result i32)
@@ -662,8 +981,8 @@
       (then (i32.store (local.get $btos) (i32.const -1)))
       (else (i32.store (local.get $btos) (i32.const 0))))
     (local.get $tos))
-  (data (i32.const 0x201f4) "\e8\01\02\00" "\02" "0< " "\2a\00\00\00")
-  (elem (i32.const 0x2a) $0<)
+  (data (i32.const 0x3b2ac) "\a0\b2\03\00" "\02" "0< " "\2c\00\00\00")
+  (elem (i32.const 0x2c) $0<)
 
   ;; [6.2.0260](https://forth-standard.org/standard/core/Zerone)
   (func $0<> (param $tos i32) (result i32)
@@ -672,8 +991,8 @@
       (then (i32.store (local.get $btos) (i32.const -1)))
       (else (i32.store (local.get $btos) (i32.const 0))))
     (local.get $tos))
-  (data (i32.const 0x20200) "\f4\01\02\00" "\03" "0<>" "\2b\00\00\00")
-  (elem (i32.const 0x2b) $0<>)
+  (data (i32.const 0x3b2b8) "\ac\b2\03\00" "\03" "0<>" "\2d\00\00\00")
+  (elem (i32.const 0x2d) $0<>)
 
   ;; [6.1.0270](https://forth-standard.org/standard/core/ZeroEqual)
   (func $0= (param $tos i32) (result i32)
@@ -682,8 +1001,8 @@
       (then (i32.store (local.get $btos) (i32.const -1)))
       (else (i32.store (local.get $btos) (i32.const 0))))
     (local.get $tos))
-  (data (i32.const 0x2020c) "\00\02\02\00" "\02" "0= " "\2c\00\00\00")
-  (elem (i32.const 0x2c) $0=)
+  (data (i32.const 0x3b2c4) "\b8\b2\03\00" "\02" "0= " "\2e\00\00\00")
+  (elem (i32.const 0x2e) $0=)
 
   ;; [6.2.0280](https://forth-standard.org/standard/core/Zeromore)
   (func $0> (param $tos i32) (result i32)
@@ -694,8 +1013,8 @@
       (then (i32.store (local.get $btos) (i32.const -1)))
       (else (i32.store (local.get $btos) (i32.const 0))))
     (local.get $tos))
-  (data (i32.const 0x20218) "\0c\02\02\00" "\02" "0> " "\2d\00\00\00")
-  (elem (i32.const 0x2d) $0>)
+  (data (i32.const 0x3b2d0) "\c4\b2\03\00" "\02" "0> " "\2f\00\00\00")
+  (elem (i32.const 0x2f) $0>)
 
   ;; [6.1.0290](https://forth-standard.org/standard/core/OnePlus)
   (func $1+ (param $tos i32) (result i32)
@@ -703,8 +1022,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.add (i32.load (local.get $btos)) (i32.const 1)))
     (local.get $tos))
-  (data (i32.const 0x20224) "\18\02\02\00" "\02" "1+ " "\2e\00\00\00")
-  (elem (i32.const 0x2e) $1+)
+  (data (i32.const 0x3b2dc) "\d0\b2\03\00" "\02" "1+ " "\30\00\00\00")
+  (elem (i32.const 0x30) $1+)
 
   ;; [6.1.0300](https://forth-standard.org/standard/core/OneMinus)
   (func $1- (param $tos i32) (result i32)
@@ -712,15 +1031,15 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.sub (i32.load (local.get $btos)) (i32.const 1)))
     (local.get $tos))
-  (data (i32.const 0x20230) "\24\02\02\00" "\02" "1- " "\2f\00\00\00")
-  (elem (i32.const 0x2f) $1-)
+  (data (i32.const 0x3b2e8) "\dc\b2\03\00" "\02" "1- " "\31\00\00\00")
+  (elem (i32.const 0x31) $1-)
 
   ;; [6.1.0310](https://forth-standard.org/standard/core/TwoStore)
   (func $2! (param $tos i32) (result i32)
     (local.get $tos)
     (call $SWAP) (call $OVER) (call $!) (call $CELL+) (call $!))
-  (data (i32.const 0x2023c) "\30\02\02\00" "\02" "2! " "\30\00\00\00")
-  (elem (i32.const 0x30) $2!)
+  (data (i32.const 0x3b2f4) "\e8\b2\03\00" "\02" "2! " "\32\00\00\00")
+  (elem (i32.const 0x32) $2!)
 
   ;; [6.1.0320](https://forth-standard.org/standard/core/TwoTimes)
   (func $2* (param $tos i32) (result i32)
@@ -728,8 +1047,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.shl (i32.load (local.get $btos)) (i32.const 1)))
     (local.get $tos))
-  (data (i32.const 0x20248) "\3c\02\02\00" "\02" "2* " "\31\00\00\00")
-  (elem (i32.const 0x31) $2*)
+  (data (i32.const 0x3b300) "\f4\b2\03\00" "\02" "2* " "\33\00\00\00")
+  (elem (i32.const 0x33) $2*)
 
   ;; [6.1.0330](https://forth-standard.org/standard/core/TwoDiv)
   (func $2/ (param $tos i32) (result i32)
@@ -737,8 +1056,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.shr_s (i32.load (local.get $btos)) (i32.const 1)))
     (local.get $tos))
-  (data (i32.const 0x20254) "\48\02\02\00" "\02" "2/ " "\32\00\00\00")
-  (elem (i32.const 0x32) $2/)
+  (data (i32.const 0x3b30c) "\00\b3\03\00" "\02" "2/ " "\34\00\00\00")
+  (elem (i32.const 0x34) $2/)
 
   ;; [6.1.0350](https://forth-standard.org/standard/core/TwoFetch)
   (func $2@  (param $tos i32) (result i32)
@@ -748,8 +1067,8 @@
     (call $@)
     (call $SWAP)
     (call $@))
-  (data (i32.const 0x20260) "\54\02\02\00" "\02" "2@ " "\33\00\00\00")
-  (elem (i32.const 0x33) $2@)
+  (data (i32.const 0x3b318) "\0c\b3\03\00" "\02" "2@ " "\35\00\00\00")
+  (elem (i32.const 0x35) $2@)
 
   ;; [6.2.0340](https://forth-standard.org/standard/core/TwotoR)
   (func $2>R (param $tos i32) (result i32)
@@ -759,14 +1078,14 @@
       (i32.load (local.tee $tos (i32.sub (local.get $tos) (i32.const 8)))))
     (global.set $tors (i32.add (global.get $tors) (i32.const 8)))
     (local.get $tos))
-  (data (i32.const 0x2026c) "\60\02\02\00" "\03" "2>R" "\34\00\00\00")
-  (elem (i32.const 0x34) $2>R)
+  (data (i32.const 0x3b324) "\18\b3\03\00" "\03" "2>R" "\36\00\00\00")
+  (elem (i32.const 0x36) $2>R)
 
   ;; [6.1.0370](https://forth-standard.org/standard/core/TwoDROP)
   (func $2DROP (param $tos i32) (result i32)
     (i32.sub (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x20278) "\6c\02\02\00" "\05" "2DROP  " "\35\00\00\00")
-  (elem (i32.const 0x35) $2DROP)
+  (data (i32.const 0x3b330) "\24\b3\03\00" "\05" "2DROP  " "\37\00\00\00")
+  (elem (i32.const 0x37) $2DROP)
 
   ;; [6.1.0380](https://forth-standard.org/standard/core/TwoDUP)
   (func $2DUP (param $tos i32) (result i32)
@@ -775,8 +1094,8 @@
     (i32.store (i32.add (local.get $tos) (i32.const 4))
                 (i32.load (i32.sub (local.get $tos) (i32.const 4))))
     (i32.add (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x20288) "\78\02\02\00" "\04" "2DUP   " "\36\00\00\00")
-  (elem (i32.const 0x36) $2DUP)
+  (data (i32.const 0x3b340) "\30\b3\03\00" "\04" "2DUP   " "\38\00\00\00")
+  (elem (i32.const 0x38) $2DUP)
 
   ;; [6.1.0400](https://forth-standard.org/standard/core/TwoOVER)
   (func $2OVER (param $tos i32) (result i32)
@@ -785,8 +1104,8 @@
     (i32.store (i32.add (local.get $tos) (i32.const 4))
                 (i32.load (i32.sub (local.get $tos) (i32.const 12))))
     (i32.add (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x20298) "\88\02\02\00" "\05" "2OVER  " "\37\00\00\00")
-  (elem (i32.const 0x37) $2OVER)
+  (data (i32.const 0x3b350) "\40\b3\03\00" "\05" "2OVER  " "\39\00\00\00")
+  (elem (i32.const 0x39) $2OVER)
 
   ;; [6.2.0415](https://forth-standard.org/standard/core/TwoRFetch)
   (func $2R@ (param $tos i32) (result i32)
@@ -796,8 +1115,8 @@
     (i32.store (i32.add (local.get $tos) (i32.const 4))
       (i32.load (i32.add (local.get $bbtors) (i32.const 4))))
     (i32.add (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x202a8) "\98\02\02\00" "\03" "2R@" "\38\00\00\00")
-  (elem (i32.const 0x38) $2R@)
+  (data (i32.const 0x3b360) "\50\b3\03\00" "\03" "2R@" "\3a\00\00\00")
+  (elem (i32.const 0x3a) $2R@)
 
   ;; [6.2.0410](https://forth-standard.org/standard/core/TwoRfrom)
   (func $2R> (param $tos i32) (result i32)
@@ -808,8 +1127,8 @@
       (i32.load (i32.add (local.get $bbtors) (i32.const 4))))
     (global.set $tors (local.get $bbtors))
     (i32.add (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x202b4) "\a8\02\02\00" "\03" "2R>" "\39\00\00\00")
-  (elem (i32.const 0x39) $2R>)
+  (data (i32.const 0x3b36c) "\60\b3\03\00" "\03" "2R>" "\3b\00\00\00")
+  (elem (i32.const 0x3b) $2R>)
 
   ;; [6.1.0430](https://forth-standard.org/standard/core/TwoSWAP)
   (func $2SWAP (param $tos i32) (result i32)
@@ -826,15 +1145,15 @@
     (i32.store (i32.sub (local.get $tos) (i32.const 4))
                 (local.get $x2))
     (local.get $tos))
-  (data (i32.const 0x202c0) "\b4\02\02\00" "\05" "2SWAP  " "\3a\00\00\00")
-  (elem (i32.const 0x3a) $2SWAP)
+  (data (i32.const 0x3b378) "\6c\b3\03\00" "\05" "2SWAP  " "\3c\00\00\00")
+  (elem (i32.const 0x3c) $2SWAP)
 
   ;; [6.1.0450](https://forth-standard.org/standard/core/Colon)
   (func $: (param $tos i32) (result i32)
     (call $startCode (local.get $tos))
     (call $emitGetLocal (i32.const 0)))
-  (data (i32.const 0x202d0) "\c0\02\02\00" "\01" ":  " "\3b\00\00\00")
-  (elem (i32.const 0x3b) $:)
+  (data (i32.const 0x3b388) "\78\b3\03\00" "\01" ":  " "\3d\00\00\00")
+  (elem (i32.const 0x3d) $:)
 
   ;; [6.1.0460](https://forth-standard.org/standard/core/Semi)
   (func $semicolon (param $tos i32) (result i32)
@@ -845,9 +1164,11 @@
       (i32.and
         (i32.load (i32.add (global.get $latest) (i32.const 4)))
         (i32.const -0x21 (; = ~F_HIDDEN ;))))
+    (if (i32.eq (global.get $latest) (global.get $dictionaryIndexLatest))
+      (then (call $indexEntry (global.get $latest) (i32.const 1))))
     (call $left-bracket))
-  (data (i32.const 0x202dc) "\d0\02\02\00" "\81" (; F_IMMEDIATE ;) ";  " "\3c\00\00\00")
-  (elem (i32.const 0x3c) $semicolon)
+  (data (i32.const 0x3b394) "\88\b3\03\00" "\81" (; F_IMMEDIATE ;) ";  " "\3e\00\00\00")
+  (elem (i32.const 0x3e) $semicolon)
 
   ;; [6.1.0480](https://forth-standard.org/standard/core/less)
   (func $< (param $tos i32) (result i32)
@@ -858,15 +1179,15 @@
       (then (i32.store (local.get $bbtos) (i32.const -1)))
       (else (i32.store (local.get $bbtos) (i32.const 0))))
     (local.get $btos))
-  (data (i32.const 0x202e8) "\dc\02\02\00" "\01" "<  " "\3d\00\00\00")
-  (elem (i32.const 0x3d) $<)
+  (data (i32.const 0x3b3a0) "\94\b3\03\00" "\01" "<  " "\3f\00\00\00")
+  (elem (i32.const 0x3f) $<)
 
   ;; [6.1.0490](https://forth-standard.org/standard/core/num-start)
   (func $<# (param $tos i32) (result i32)
     (global.set $po (i32.add (global.get $here) (i32.const 0x200 (; = PICTURED_OUTPUT_OFFSET ;))))
     (local.get $tos))
-  (data (i32.const 0x202f4) "\e8\02\02\00" "\02" "<# " "\3e\00\00\00")
-  (elem (i32.const 0x3e) $<#)
+  (data (i32.const 0x3b3ac) "\a0\b3\03\00" "\02" "<# " "\40\00\00\00")
+  (elem (i32.const 0x40) $<#)
 
   ;; [6.1.0530](https://forth-standard.org/standard/core/Equal)
   (func $= (param $tos i32) (result i32)
@@ -877,8 +1198,8 @@
       (then (i32.store (local.get $bbtos) (i32.const -1)))
       (else (i32.store (local.get $bbtos) (i32.const 0))))
     (local.get $btos))
-  (data (i32.const 0x20300) "\f4\02\02\00" "\01" "=  " "\3f\00\00\00")
-  (elem (i32.const 0x3f) $=)
+  (data (i32.const 0x3b3b8) "\ac\b3\03\00" "\01" "=  " "\41\00\00\00")
+  (elem (i32.const 0x41) $=)
 
   ;; [6.1.0540](https://forth-standard.org/standard/core/more)
   (func $> (param $tos i32) (result i32)
@@ -889,8 +1210,8 @@
       (then (i32.store (local.get $bbtos) (i32.const -1)))
       (else (i32.store (local.get $bbtos) (i32.const 0))))
     (local.get $btos))
-  (data (i32.const 0x2030c) "\00\03\02\00" "\01" ">  " "\40\00\00\00")
-  (elem (i32.const 0x40) $>)
+  (data (i32.const 0x3b3c4) "\b8\b3\03\00" "\01" ">  " "\42\00\00\00")
+  (elem (i32.const 0x42) $>)
 
   ;; [6.1.0550](https://forth-standard.org/standard/core/toBODY)
   (func $>BODY (param $tos i32) (result i32)
@@ -898,11 +1219,11 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
       (i32.add (call $body (i32.load (local.get $btos))) (i32.const 4)))
     (local.get $tos))
-  (data (i32.const 0x20318) "\0c\03\02\00" "\05" ">BODY  " "\41\00\00\00")
-  (elem (i32.const 0x41) $>BODY)
+  (data (i32.const 0x3b3d0) "\c4\b3\03\00" "\05" ">BODY  " "\43\00\00\00")
+  (elem (i32.const 0x43) $>BODY)
 
   ;; [6.1.0560](https://forth-standard.org/standard/core/toIN)
-  (data (i32.const 0x20328) "\18\03\02\00" "\43" (; F_DATA ;) ">IN" "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\00\00\00\00")
+  (data (i32.const 0x3b3e0) "\d0\b3\03\00" "\43" (; F_DATA ;) ">IN" "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\00\00\00\00")
 
   ;; [6.1.0570](https://forth-standard.org/standard/core/toNUMBER)
   (func $>NUMBER (param $tos i32) (result i32)
@@ -923,16 +1244,16 @@
     (i32.store (local.get $bbtos) (local.get $rest))
     (i64.store (local.get $bbbbtos) (local.get $value))
     (local.get $tos))
-  (data (i32.const 0x20338) "\28\03\02\00" "\07" ">NUMBER" "\42\00\00\00")
-  (elem (i32.const 0x42) $>NUMBER)
+  (data (i32.const 0x3b3f0) "\e0\b3\03\00" "\07" ">NUMBER" "\44\00\00\00")
+  (elem (i32.const 0x44) $>NUMBER)
 
   ;; [6.1.0580](https://forth-standard.org/standard/core/toR)
   (func $>R (param $tos i32) (result i32)
     (local.tee $tos (i32.sub (local.get $tos) (i32.const 4)))
     (i32.store (global.get $tors) (i32.load (local.get $tos)))
     (global.set $tors (i32.add (global.get $tors) (i32.const 4))))
-  (data (i32.const 0x20348) "\38\03\02\00" "\02" ">R " "\43\00\00\00")
-  (elem (i32.const 0x43) $>R)
+  (data (i32.const 0x3b400) "\f0\b3\03\00" "\02" ">R " "\45\00\00\00")
+  (elem (i32.const 0x45) $>R)
 
   ;; [6.1.0630](https://forth-standard.org/standard/core/qDUP)
   (func $?DUP (param $tos i32) (result i32)
@@ -944,8 +1265,8 @@
         (i32.add (local.get $tos) (i32.const 4)))
       (else
         (local.get $tos))))
-  (data (i32.const 0x20354) "\48\03\02\00" "\04" "?DUP   " "\44\00\00\00")
-  (elem (i32.const 0x44) $?DUP)
+  (data (i32.const 0x3b40c) "\00\b4\03\00" "\04" "?DUP   " "\46\00\00\00")
+  (elem (i32.const 0x46) $?DUP)
 
   ;; [6.1.0650](https://forth-standard.org/standard/core/Fetch)
   (func $@ (param $tos i32) (result i32)
@@ -953,26 +1274,24 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
       (i32.load (i32.load (local.get $btos))))
     (local.get $tos))
-  (data (i32.const 0x20364) "\54\03\02\00" "\01" "@  " "\45\00\00\00")
-  (elem (i32.const 0x45) $@)
+  (data (i32.const 0x3b41c) "\0c\b4\03\00" "\01" "@  " "\47\00\00\00")
+  (elem (i32.const 0x47) $@)
 
   ;; [6.1.0670](https://forth-standard.org/standard/core/ABORT)
   (func $ABORT (param $tos i32) (result i32)
-    (global.set $error (i32.const 0x3 (; = ERR_ABORT ;)))
-    (call $quit (i32.const 0x10000 (; = STACK_BASE ;))))
-  (data (i32.const 0x20370) "\64\03\02\00" "\05" "ABORT  " "\46\00\00\00")
-  (elem (i32.const 0x46) $ABORT)
+    (call $throw (local.get $tos) (i32.const -0x1 (; = EXC_ABORT ;))))
+  (data (i32.const 0x3b428) "\1c\b4\03\00" "\05" "ABORT  " "\48\00\00\00")
+  (elem (i32.const 0x48) $ABORT)
 
   ;; [6.1.0680](https://forth-standard.org/standard/core/ABORTq)
   (func $ABORTq (param $tos i32) (result i32)
     (local.get $tos)
     (call $compileIf)
     (call $Sq)
-    (call $compileCall (i32.const 0) (i32.const 0xb0 (; = index("TYPE") ;)))
-    (call $compileCall (i32.const 0) (i32.const 0x46 (; = index("ABORT") ;)))
+    (call $compileCall (i32.const 0) (i32.const 0xa (; = ABORT_MESSAGE_INDEX ;)))
     (call $compileThen))
-  (data (i32.const 0x20380) "\70\03\02\00" "\86" (; F_IMMEDIATE ;) "ABORT\22 " "\47\00\00\00")
-  (elem (i32.const 0x47) $ABORTq)
+  (data (i32.const 0x3b438) "\28\b4\03\00" "\86" (; F_IMMEDIATE ;) "ABORT\22 " "\49\00\00\00")
+  (elem (i32.const 0x49) $ABORTq)
 
   ;; [6.1.0690](https://forth-standard.org/standard/core/ABS)
   (func $ABS (param $tos i32) (result i32)
@@ -984,8 +1303,8 @@
                                   (local.tee $y (i32.shr_s (local.get $v) (i32.const 31))))
                         (local.get $y)))
     (local.get $tos))
-  (data (i32.const 0x20390) "\80\03\02\00" "\03" "ABS" "\48\00\00\00")
-  (elem (i32.const 0x48) $ABS)
+  (data (i32.const 0x3b448) "\38\b4\03\00" "\03" "ABS" "\4a\00\00\00")
+  (elem (i32.const 0x4a) $ABS)
 
   ;; [6.1.0695](https://forth-standard.org/standard/core/ACCEPT)
   (func $ACCEPT (param $tos i32) (result i32)
@@ -1002,6 +1321,7 @@
     (local.set $p (local.get $addr))
     (block $endLoop
       (loop $loop
+        (call $runTasks)
         (br_if $endLoop (i32.eq (local.tee $c (call $shell_key)) (i32.const 0xa)))
         (i32.store8 (local.get $p) (local.get $c))
         (local.set $p (i32.add (local.get $p) (i32.const 1)))
@@ -1009,8 +1329,8 @@
         (br_if $loop (i32.lt_u (local.get $p) (local.get $endp)))))
     (i32.store (local.get $bbtos)  (i32.sub (local.get $p) (local.get $addr)))
     (local.get $btos))
-  (data (i32.const 0x2039c) "\90\03\02\00" "\06" "ACCEPT " "\49\00\00\00")
-  (elem (i32.const 0x49) $ACCEPT)
+  (data (i32.const 0x3b454) "\48\b4\03\00" "\06" "ACCEPT " "\4b\00\00\00")
+  (elem (i32.const 0x4b) $ACCEPT)
 
   ;; [6.2.0698](https://forth-standard.org/standard/core/ACTION-OF)
   (func $ACTION-OF (param $tos i32) (result i32)
@@ -1020,7 +1340,7 @@
       (i32.add
         (call $body (drop (call $find! (call $parseName))))
         (i32.const 4)))
-    (if (result i32) (i32.eqz (i32.load (i32.const 0x209a0 (; = body(STATE) ;))))
+    (if (result i32) (i32.eqz (i32.load (i32.const 0x3bb64 (; = body(STATE) ;))))
       (then
         (call $push (local.get $tos) (i32.load (local.get $xtp))))
       (else
@@ -1028,15 +1348,15 @@
         (call $emitLoad)
         (call $compilePush)
         (local.get $tos))))
-  (data (i32.const 0x203ac) "\9c\03\02\00" "\89" (; F_IMMEDIATE ;) "ACTION-OF  " "\4a\00\00\00")
-  (elem (i32.const 0x4a) $ACTION-OF)
+  (data (i32.const 0x3b464) "\54\b4\03\00" "\89" (; F_IMMEDIATE ;) "ACTION-OF  " "\4c\00\00\00")
+  (elem (i32.const 0x4c) $ACTION-OF)
 
   ;; [6.1.0705](https://forth-standard.org/standard/core/ALIGN)
   (func $ALIGN (param $tos i32) (result i32)
-    (global.set $here (call $aligned (global.get $here)))
+    (call $setHere (call $aligned (global.get $here)))
     (local.get $tos))
-  (data (i32.const 0x203c0) "\ac\03\02\00" "\05" "ALIGN  " "\4b\00\00\00")
-  (elem (i32.const 0x4b) $ALIGN)
+  (data (i32.const 0x3b478) "\64\b4\03\00" "\05" "ALIGN  " "\4d\00\00\00")
+  (elem (i32.const 0x4d) $ALIGN)
 
   ;; [6.1.0706](https://forth-standard.org/standard/core/ALIGNED)
   (func $ALIGNED (param $tos i32) (result i32)
@@ -1044,17 +1364,29 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
       (call $aligned (i32.load (local.get $btos))))
     (local.get $tos))
-  (data (i32.const 0x203d0) "\c0\03\02\00" "\07" "ALIGNED" "\4c\00\00\00")
-  (elem (i32.const 0x4c) $ALIGNED)
+  (data (i32.const 0x3b488) "\78\b4\03\00" "\07" "ALIGNED" "\4e\00\00\00")
+  (elem (i32.const 0x4e) $ALIGNED)
+
+  ;; [14.6.1.0707](https://forth-standard.org/standard/memory/ALLOCATE)
+  (func $ALLOCATE (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $addr i32)
+    (call $checkMainThread)
+    (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
+      (local.tee $addr (call $heapAllocate (i32.load (local.get $btos)))))
+    (call $push (local.get $tos)
+      (select (i32.const 0) (i32.const -0x3b (; = ERR_ALLOCATE ;)) (local.get $addr))))
+  (data (i32.const 0x3b498) "\88\b4\03\00" "\08" "ALLOCATE   " "\4f\00\00\00")
+  (elem (i32.const 0x4f) $ALLOCATE)
 
   ;; [6.1.0710](https://forth-standard.org/standard/core/ALLOT)
   (func $ALLOT (param $tos i32) (result i32)
     (local $v i32)
     (local.get $tos)
     (local.set $v (call $pop))
-    (global.set $here (i32.add (global.get $here) (local.get $v))))
-  (data (i32.const 0x203e0) "\d0\03\02\00" "\05" "ALLOT  " "\4d\00\00\00")
-  (elem (i32.const 0x4d) $ALLOT)
+    (call $setHere (i32.add (global.get $here) (local.get $v))))
+  (data (i32.const 0x3b4ac) "\98\b4\03\00" "\05" "ALLOT  " "\50\00\00\00")
+  (elem (i32.const 0x50) $ALLOT)
 
   ;; [6.1.0720](https://forth-standard.org/standard/core/AND)
   (func $AND (param $tos i32) (result i32)
@@ -1064,40 +1396,52 @@
                 (i32.and (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))
                         (i32.load (local.get $bbtos))))
     (local.get $btos))
-  (data (i32.const 0x203f0) "\e0\03\02\00" "\03" "AND" "\4e\00\00\00")
-  (elem (i32.const 0x4e) $AND)
+  (data (i32.const 0x3b4bc) "\ac\b4\03\00" "\03" "AND" "\51\00\00\00")
+  (elem (i32.const 0x51) $AND)
 
   ;; [6.1.0750](https://forth-standard.org/standard/core/BASE)
-  (data (i32.const 0x203fc) "\f0\03\02\00" "\44" (; F_DATA ;) "BASE   " "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\0a\00\00\00" (; = pack(10) ;))
+  (data (i32.const 0x3b4c8) "\bc\b4\03\00" "\44" (; F_DATA ;) "BASE   " "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\0a\00\00\00" (; = pack(10) ;))
 
   ;; [6.1.0760](https://forth-standard.org/standard/core/BEGIN)
   (func $BEGIN (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileBegin))
-  (data (i32.const 0x20410) "\fc\03\02\00" "\85" (; F_IMMEDIATE ;) "BEGIN  " "\4f\00\00\00")
-  (elem (i32.const 0x4f) $BEGIN)
+  (data (i32.const 0x3b4dc) "\c8\b4\03\00" "\85" (; F_IMMEDIATE ;) "BEGIN  " "\52\00\00\00")
+  (elem (i32.const 0x52) $BEGIN)
 
   ;; [6.1.0770](https://forth-standard.org/standard/core/BL)
   (func $BL (param $tos i32) (result i32)
     (call $push (local.get $tos) (i32.const 32)))
-  (data (i32.const 0x20420) "\10\04\02\00" "\02" "BL " "\50\00\00\00")
-  (elem (i32.const 0x50) $BL)
+  (data (i32.const 0x3b4ec) "\dc\b4\03\00" "\02" "BL " "\53\00\00\00")
+  (elem (i32.const 0x53) $BL)
+
+  ;; [17.6.1.0780](https://forth-standard.org/standard/string/BLANK)
+  (func $BLANK (param $tos i32) (result i32)
+    (local $bbtos i32)
+    (memory.fill
+      (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8))))
+      (i32.const 0x20 (; = ' ' ;))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbtos))
+  (data (i32.const 0x3b4f8) "\ec\b4\03\00" "\05" "BLANK  " "\54\00\00\00")
+  (elem (i32.const 0x54) $BLANK)
 
   ;; [6.2.0825](https://forth-standard.org/standard/core/BUFFERColon)
   (func $BUFFER: (param $tos i32) (result i32)
     (local.get $tos)
     (call $CREATE)
     (call $ALLOT))
-  (data (i32.const 0x2042c) "\20\04\02\00" "\07" "BUFFER:" "\51\00\00\00")
-  (elem (i32.const 0x51) $BUFFER:)
+  (data (i32.const 0x3b508) "\f8\b4\03\00" "\07" "BUFFER:" "\55\00\00\00")
+  (elem (i32.const 0x55) $BUFFER:)
 
   ;; [15.6.2.0830](https://forth-standard.org/standard/tools/BYE)
   (func $BYE (param $tos i32) (result i32)
+    (call $flushCode)
     (global.set $error (i32.const 0x5 (; = ERR_BYE ;)))
     (call $quit (local.get $tos)))
-  (data (i32.const 0x2043c) "\2c\04\02\00" "\03" "BYE" "\52\00\00\00")
-  (elem (i32.const 0x52) $BYE)
+  (data (i32.const 0x3b518) "\08\b5\03\00" "\03" "BYE" "\56\00\00\00")
+  (elem (i32.const 0x56) $BYE)
 
   ;; [6.1.0850](https://forth-standard.org/standard/core/CStore)
   (func $C! (param $tos i32) (result i32)
@@ -1105,17 +1449,17 @@
     (i32.store8 (i32.load (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.get $bbtos))
-  (data (i32.const 0x20448) "\3c\04\02\00" "\02" "C! " "\53\00\00\00")
-  (elem (i32.const 0x53) $C!)
+  (data (i32.const 0x3b524) "\18\b5\03\00" "\02" "C! " "\57\00\00\00")
+  (elem (i32.const 0x57) $C!)
 
   ;; [6.1.0860](https://forth-standard.org/standard/core/CComma)
   (func $Cc (param $tos i32) (result i32)
     (i32.store8 (global.get $here)
                 (i32.load (i32.sub (local.get $tos) (i32.const 4))))
-    (global.set $here (i32.add (global.get $here) (i32.const 1)))
+    (call $setHere (i32.add (global.get $here) (i32.const 1)))
     (i32.sub (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20454) "\48\04\02\00" "\02" "C, " "\54\00\00\00")
-  (elem (i32.const 0x54) $Cc)
+  (data (i32.const 0x3b530) "\24\b5\03\00" "\02" "C, " "\58\00\00\00")
+  (elem (i32.const 0x58) $Cc)
 
   ;; [6.2.0855](https://forth-standard.org/standard/core/Cq)
   (func $Cq (param $tos i32) (result i32)
@@ -1125,16 +1469,17 @@
     (local.get $tos)
     (call $ensureCompiling)
     (local.set $addr (local.set $len (call $parse (i32.const 0x22 (; = '"' ;)))))
+    (call $reserve (i32.add (local.get $len) (i32.const 1)))
     (i32.store8 (global.get $here) (local.get $len))
     (memory.copy
       (i32.add (global.get $here) (i32.const 1))
       (local.get $addr)
       (local.get $len))
     (call $compilePushConst (global.get $here))
-    (global.set $here
+    (call $setHere
       (call $aligned (i32.add (i32.add (global.get $here) (i32.const 1)) (local.get $len)))))
-  (data (i32.const 0x20460) "\54\04\02\00" "\82" (; F_IMMEDIATE ;) "C\22 " "\55\00\00\00")
-  (elem (i32.const 0x55) $Cq)
+  (data (i32.const 0x3b53c) "\30\b5\03\00" "\82" (; F_IMMEDIATE ;) "C\22 " "\59\00\00\00")
+  (elem (i32.const 0x59) $Cq)
 
   ;; [6.1.0870](https://forth-standard.org/standard/core/CFetch)
   (func $C@ (param $tos i32) (result i32)
@@ -1142,8 +1487,47 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.load8_u (i32.load (local.get $btos))))
     (local.get $tos))
-  (data (i32.const 0x2046c) "\60\04\02\00" "\02" "C@ " "\56\00\00\00")
-  (elem (i32.const 0x56) $C@)
+  (data (i32.const 0x3b548) "\3c\b5\03\00" "\02" "C@ " "\5a\00\00\00")
+  (elem (i32.const 0x5a) $C@)
+
+  ;; [9.6.1.0875](https://forth-standard.org/standard/exception/CATCH)
+  (func $CATCH (param $tos i32) (result i32)
+    (local $xt i32)
+    (local $n i32)
+    (local $prevCatchDepth i32)
+    (local $prevTors i32)
+    (local $prevSourceID i32)
+    (local $prevIn i32)
+    (local $prevInputBufferBase i32)
+    (local $prevInputBufferSize i32)
+    (local.set $xt (i32.load (local.tee $tos (i32.sub (local.get $tos) (i32.const 4)))))
+
+    ;; Save the state to restore when an exception is caught
+    (local.set $prevCatchDepth (global.get $catchDepth))
+    (local.set $prevTors (global.get $tors))
+    (local.set $prevSourceID (global.get $sourceID))
+    (local.set $prevIn (i32.load (i32.const 0x3b3ec (; = body(>IN) ;))))
+    (local.set $prevInputBufferBase (global.get $inputBufferBase))
+    (local.set $prevInputBufferSize (global.get $inputBufferSize))
+
+    (global.set $catchDepth (i32.add (local.get $prevCatchDepth) (i32.const 1)))
+    (call $tryExecute (local.get $tos) (local.get $xt))
+    (local.set $n)
+    (local.set $tos)
+    (global.set $catchDepth (local.get $prevCatchDepth))
+    (if (local.get $n)
+      (then
+        (global.set $tors (local.get $prevTors))
+        (global.set $sourceID (local.get $prevSourceID))
+        ;; Task threads don't parse, and >IN is the one of the main thread
+        (if (i32.eqz (global.get $taskStacks))
+          (then (i32.store (i32.const 0x3b3ec (; = body(>IN) ;)) (local.get $prevIn))))
+        (global.set $inputBufferBase (local.get $prevInputBufferBase))
+        (global.set $inputBufferSize (local.get $prevInputBufferSize))))
+    ;; On an exception, this restores the stack depth from before the CATCH
+    (call $push (local.get $tos) (local.get $n)))
+  (data (i32.const 0x3b554) "\48\b5\03\00" "\05" "CATCH  " "\5b\00\00\00")
+  (elem (i32.const 0x5b) $CATCH)
 
   ;; [6.1.0880](https://forth-standard.org/standard/core/CELLPlus)
   (func $CELL+ (param $tos i32) (result i32)
@@ -1151,8 +1535,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.add (i32.load (local.get $btos)) (i32.const 4)))
     (local.get $tos))
-  (data (i32.const 0x20478) "\6c\04\02\00" "\05" "CELL+  " "\57\00\00\00")
-  (elem (i32.const 0x57) $CELL+)
+  (data (i32.const 0x3b564) "\54\b5\03\00" "\05" "CELL+  " "\5c\00\00\00")
+  (elem (i32.const 0x5c) $CELL+)
 
   ;; [6.1.0890](https://forth-standard.org/standard/core/CELLS)
   (func $CELLS (param $tos i32) (result i32)
@@ -1160,8 +1544,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.shl (i32.load (local.get $btos)) (i32.const 2)))
     (local.get $tos))
-  (data (i32.const 0x20488) "\78\04\02\00" "\05" "CELLS  " "\58\00\00\00")
-  (elem (i32.const 0x58) $CELLS)
+  (data (i32.const 0x3b574) "\64\b5\03\00" "\05" "CELLS  " "\5d\00\00\00")
+  (elem (i32.const 0x5d) $CELLS)
 
   ;; [6.1.0895](https://forth-standard.org/standard/core/CHAR)
   (func $CHAR (param $tos i32) (result i32)
@@ -1170,35 +1554,70 @@
     (local.set $addr (local.set $len (call $parseName)))
     (if (i32.eqz (local.get $len))
       (then
-        (call $fail (i32.const 0x2001d (; = str("incomplete input") ;)))))
+        (call $fail (i32.const -0x10 (; = EXC_ZERO_LENGTH_NAME ;)) (i32.const 0x3b01d (; = str("incomplete input") ;)))))
     (i32.store (local.get $tos) (i32.load8_u (local.get $addr)))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20498) "\88\04\02\00" "\04" "CHAR   " "\59\00\00\00")
-  (elem (i32.const 0x59) $CHAR)
+  (data (i32.const 0x3b584) "\74\b5\03\00" "\04" "CHAR   " "\5e\00\00\00")
+  (elem (i32.const 0x5e) $CHAR)
 
   ;; [6.1.0897](https://forth-standard.org/standard/core/CHARPlus)
   (func $CHAR+ (param $tos i32) (result i32)
     (call $1+ (local.get $tos)))
-  (data (i32.const 0x204a8) "\98\04\02\00" "\05" "CHAR+  " "\5a\00\00\00")
-  (elem (i32.const 0x5a) $CHAR+)
+  (data (i32.const 0x3b594) "\84\b5\03\00" "\05" "CHAR+  " "\5f\00\00\00")
+  (elem (i32.const 0x5f) $CHAR+)
 
   ;; [6.1.0898](https://forth-standard.org/standard/core/CHARS)
   (func $CHARS (param $tos i32) (result i32)
     (local.get $tos))
-  (data (i32.const 0x204b8) "\a8\04\02\00" "\05" "CHARS  " "\5b\00\00\00")
-  (elem (i32.const 0x5b) $CHARS)
+  (data (i32.const 0x3b5a4) "\94\b5\03\00" "\05" "CHARS  " "\60\00\00\00")
+  (elem (i32.const 0x60) $CHARS)
 
   ;; [15.6.2.0930](https://forth-standard.org/standard/tools/CODE)
   (func $CODE (param $tos i32) (result i32)
     (call $startCode (local.get $tos)))
-  (data (i32.const 0x204c8) "\b8\04\02\00" "\04" "CODE   " "\5c\00\00\00")
-  (elem (i32.const 0x5c) $CODE)
+  (data (i32.const 0x3b5b4) "\a4\b5\03\00" "\04" "CODE   " "\61\00\00\00")
+  (elem (i32.const 0x61) $CODE)
+
+  ;; [17.6.1.0935](https://forth-standard.org/standard/string/COMPARE)
+  (func $COMPARE (param $tos i32) (result i32)
+    (local $bbbbtos i32)
+    (local $addr1 i32)
+    (local $len1 i32)
+    (local $addr2 i32)
+    (local $len2 i32)
+    (local $n i32)
+    (local $i i32)
+    (local $result i32)
+    (local.set $addr1 (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16)))))
+    (local.set $len1 (i32.load (i32.sub (local.get $tos) (i32.const 12))))
+    (local.set $addr2 (i32.load (i32.sub (local.get $tos) (i32.const 8))))
+    (local.set $len2 (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.set $n
+      (select (local.get $len1) (local.get $len2) (i32.lt_u (local.get $len1) (local.get $len2))))
+    (if (i32.lt_u
+          (local.tee $i (call $mismatch (local.get $addr1) (local.get $addr2) (local.get $n)))
+          (local.get $n))
+      (then
+        (local.set $result
+          (select (i32.const -1) (i32.const 1)
+            (i32.lt_u
+              (i32.load8_u (i32.add (local.get $addr1) (local.get $i)))
+              (i32.load8_u (i32.add (local.get $addr2) (local.get $i)))))))
+      (else
+        (local.set $result
+          (i32.sub
+            (i32.gt_u (local.get $len1) (local.get $len2))
+            (i32.lt_u (local.get $len1) (local.get $len2))))))
+    (i32.store (local.get $bbbbtos) (local.get $result))
+    (i32.add (local.get $bbbbtos) (i32.const 4)))
+  (data (i32.const 0x3b5c4) "\b4\b5\03\00" "\07" "COMPARE" "\62\00\00\00")
+  (elem (i32.const 0x62) $COMPARE)
 
   ;; [6.2.0945](https://forth-standard.org/standard/core/COMPILEComma)
   (func $COMPILEComma (param $tos i32) (result i32)
     (call $compileExecute (call $pop (local.get $tos))))
-  (data (i32.const 0x204d8) "\c8\04\02\00" "\08" "COMPILE,   " "\5d\00\00\00")
-  (elem (i32.const 0x5d) $COMPILEComma)
+  (data (i32.const 0x3b5d4) "\c4\b5\03\00" "\08" "COMPILE,   " "\63\00\00\00")
+  (elem (i32.const 0x63) $COMPILEComma)
 
   ;; [6.1.0950](https://forth-standard.org/standard/core/CONSTANT)
   (func $CONSTANT (param $tos i32) (result i32)
@@ -1208,9 +1627,9 @@
     (i32.store (i32.sub (global.get $here) (i32.const 4)) (i32.const 0x6 (; = PUSH_INDIRECT_INDEX ;)))
     (local.set $v (call $pop))
     (i32.store (global.get $here) (local.get $v))
-    (global.set $here (i32.add (global.get $here) (i32.const 4))))
-  (data (i32.const 0x204ec) "\d8\04\02\00" "\08" "CONSTANT   " "\5e\00\00\00")
-  (elem (i32.const 0x5e) $CONSTANT)
+    (call $setHere (i32.add (global.get $here) (i32.const 4))))
+  (data (i32.const 0x3b5e8) "\d4\b5\03\00" "\08" "CONSTANT   " "\64\00\00\00")
+  (elem (i32.const 0x64) $CONSTANT)
 
   ;; [6.1.0980](https://forth-standard.org/standard/core/COUNT)
   (func $COUNT (param $tos i32) (result i32)
@@ -1221,15 +1640,15 @@
                                                                                 (i32.const 4)))))))
     (i32.store (local.get $btos) (i32.add (local.get $addr) (i32.const 1)))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20500) "\ec\04\02\00" "\05" "COUNT  " "\5f\00\00\00")
-  (elem (i32.const 0x5f) $COUNT)
+  (data (i32.const 0x3b5fc) "\e8\b5\03\00" "\05" "COUNT  " "\65\00\00\00")
+  (elem (i32.const 0x65) $COUNT)
 
   ;; [6.1.0990](https://forth-standard.org/standard/core/CR)
   (func $CR (param $tos i32) (result i32)
     (call $shell_emit (i32.const 0x0a))
     (local.get $tos))
-  (data (i32.const 0x20510) "\00\05\02\00" "\02" "CR " "\60\00\00\00")
-  (elem (i32.const 0x60) $CR)
+  (data (i32.const 0x3b60c) "\fc\b5\03\00" "\02" "CR " "\66\00\00\00")
+  (elem (i32.const 0x66) $CR)
 
   ;; [6.1.1000](https://forth-standard.org/standard/core/CREATE)
   (func $CREATE (param $tos i32) (result i32)
@@ -1237,22 +1656,22 @@
     (local $nameLen i32)
     (local.set $nameAddr (local.set $nameLen (call $parseName)))
     (if (i32.eqz (local.get $nameLen))
-      (then (call $fail (i32.const 0x2001d (; = str("incomplete input") ;)))))
+      (then (call $fail (i32.const -0x10 (; = EXC_ZERO_LENGTH_NAME ;)) (i32.const 0x3b01d (; = str("incomplete input") ;)))))
     (call $create
       (local.get $nameAddr)
       (local.get $nameLen)
       (i32.const 0x40 (; = F_DATA ;))
       (i32.const 0x3 (; = PUSH_DATA_ADDRESS_INDEX ;)))
     (local.get $tos))
-  (data (i32.const 0x2051c) "\10\05\02\00" "\06" "CREATE " "\61\00\00\00")
-  (elem (i32.const 0x61) $CREATE)
+  (data (i32.const 0x3b618) "\0c\b6\03\00" "\06" "CREATE " "\67\00\00\00")
+  (elem (i32.const 0x67) $CREATE)
 
   ;; [6.1.1170](https://forth-standard.org/standard/core/DECIMAL)
   (func $DECIMAL (param $tos i32) (result i32)
-    (i32.store (i32.const 0x2040c (; = body(BASE) ;)) (i32.const 10))
+    (i32.store (i32.const 0x3b4d8 (; = body(BASE) ;)) (i32.const 10))
     (local.get $tos))
-  (data (i32.const 0x2052c) "\1c\05\02\00" "\07" "DECIMAL" "\62\00\00\00")
-  (elem (i32.const 0x62) $DECIMAL)
+  (data (i32.const 0x3b628) "\18\b6\03\00" "\07" "DECIMAL" "\68\00\00\00")
+  (elem (i32.const 0x68) $DECIMAL)
 
   ;; [6.2.1173](https://forth-standard.org/standard/core/DEFER)
   (func $DEFER (param $tos i32) (result i32)
@@ -1260,7 +1679,7 @@
     (local $nameLen i32)
     (local.set $nameAddr (local.set $nameLen (call $parseName)))
     (if (i32.eqz (local.get $nameLen))
-      (then (call $fail (i32.const 0x2001d (; = str("incomplete input") ;)))))
+      (then (call $fail (i32.const -0x10 (; = EXC_ZERO_LENGTH_NAME ;)) (i32.const 0x3b01d (; = str("incomplete input") ;)))))
     (call $create
       (local.get $nameAddr)
       (local.get $nameLen)
@@ -1268,10 +1687,10 @@
       (i32.const 0x8 (; = EXECUTE_DEFER_INDEX ;)))
     (; Store `here` and `latest` pointer before this definition in the data
        area of the word, so we can reset it in `$resetMarker` ;)
-    (global.set $here (i32.add (global.get $here) (i32.const 4)))
+    (call $setHere (i32.add (global.get $here) (i32.const 4)))
     (local.get $tos))
-  (data (i32.const 0x2053c) "\2c\05\02\00" "\05" "DEFER  " "\63\00\00\00")
-  (elem (i32.const 0x63) $DEFER)
+  (data (i32.const 0x3b638) "\28\b6\03\00" "\05" "DEFER  " "\69\00\00\00")
+  (elem (i32.const 0x69) $DEFER)
 
   ;; [6.2.1175](https://forth-standard.org/standard/core/DEFERStore)
   (func $DEFER! (param $tos i32) (result i32)
@@ -1282,8 +1701,8 @@
         (i32.const 4))
       (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.get $bbtos))
-  (data (i32.const 0x2054c) "\3c\05\02\00" "\06" "DEFER! " "\64\00\00\00")
-  (elem (i32.const 0x64) $DEFER!)
+  (data (i32.const 0x3b648) "\38\b6\03\00" "\06" "DEFER! " "\6a\00\00\00")
+  (elem (i32.const 0x6a) $DEFER!)
 
   ;; [6.2.1177](https://forth-standard.org/standard/core/DEFERFetch)
   (func $DEFER@ (param $tos i32) (result i32)
@@ -1295,66 +1714,68 @@
           (call $body (i32.load (local.get $btos)))
           (i32.const 4))))
     (local.get $tos))
-  (data (i32.const 0x2055c) "\4c\05\02\00" "\06" "DEFER@ " "\65\00\00\00")
-  (elem (i32.const 0x65) $DEFER@)
+  (data (i32.const 0x3b658) "\48\b6\03\00" "\06" "DEFER@ " "\6b\00\00\00")
+  (elem (i32.const 0x6b) $DEFER@)
 
   ;; [6.1.1200](https://forth-standard.org/standard/core/DEPTH)
   (func $DEPTH (param $tos i32) (result i32)
     (i32.store (local.get $tos)
-              (i32.shr_u (i32.sub (local.get $tos) (i32.const 0x10000 (; = STACK_BASE ;))) (i32.const 2)))
+              (i32.shr_u (i32.sub (local.get $tos) (call $stackBase)) (i32.const 2)))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x2056c) "\5c\05\02\00" "\05" "DEPTH  " "\66\00\00\00")
-  (elem (i32.const 0x66) $DEPTH)
+  (data (i32.const 0x3b668) "\58\b6\03\00" "\05" "DEPTH  " "\6c\00\00\00")
+  (elem (i32.const 0x6c) $DEPTH)
 
   ;; [6.1.1240](https://forth-standard.org/standard/core/DO)
   (func $DO (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileDo (i32.const 0)))
-  (data (i32.const 0x2057c) "\6c\05\02\00" "\82" (; F_IMMEDIATE ;) "DO " "\67\00\00\00")
-  (elem (i32.const 0x67) $DO)
+  (data (i32.const 0x3b678) "\68\b6\03\00" "\82" (; F_IMMEDIATE ;) "DO " "\6d\00\00\00")
+  (elem (i32.const 0x6d) $DO)
 
   ;; [6.1.1250](https://forth-standard.org/standard/core/DOES)
   (func $DOES> (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
+    (call $compileSpill)
     (call $emitConst (i32.add (global.get $nextTableIndex) (i32.const 1)))
     (call $compileCall (i32.const 1) (i32.const 0x4 (; = SET_LATEST_BODY_INDEX ;)))
     (call $endColon)
     (call $startColon (i32.const 1))
     (call $emitGetLocal (i32.const 0))
     (call $compilePushLocal (i32.const 1)))
-  (data (i32.const 0x20588) "\7c\05\02\00" "\85" (; F_IMMEDIATE ;) "DOES>  " "\68\00\00\00")
-  (elem (i32.const 0x68) $DOES>)
+  (data (i32.const 0x3b684) "\78\b6\03\00" "\85" (; F_IMMEDIATE ;) "DOES>  " "\6e\00\00\00")
+  (elem (i32.const 0x6e) $DOES>)
 
   ;; [6.1.1260](https://forth-standard.org/standard/core/DROP)
   (func $DROP (param $tos i32) (result i32)
     (i32.sub (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20598) "\88\05\02\00" "\04" "DROP   " "\69\00\00\00")
-  (elem (i32.const 0x69) $DROP)
+  (data (i32.const 0x3b694) "\84\b6\03\00" "\04" "DROP   " "\6f\00\00\00")
+  (elem (i32.const 0x6f) $DROP)
 
   ;; [6.1.1290](https://forth-standard.org/standard/core/DUP)
   (func $DUP (param $tos i32) (result i32)
     (i32.store (local.get $tos)
       (i32.load (i32.sub (local.get $tos) (i32.const 4))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x205a8) "\98\05\02\00" "\03" "DUP" "\6a\00\00\00")
-  (elem (i32.const 0x6a) $DUP)
+  (data (i32.const 0x3b6a4) "\94\b6\03\00" "\03" "DUP" "\70\00\00\00")
+  (elem (i32.const 0x70) $DUP)
 
   ;; [6.1.1310](https://forth-standard.org/standard/core/ELSE)
   (func $ELSE (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
+    (call $compileSpill)
     (call $emitElse))
-  (data (i32.const 0x205b4) "\a8\05\02\00" "\84" (; F_IMMEDIATE ;) "ELSE   " "\6b\00\00\00")
-  (elem (i32.const 0x6b) $ELSE)
+  (data (i32.const 0x3b6b0) "\a4\b6\03\00" "\84" (; F_IMMEDIATE ;) "ELSE   " "\71\00\00\00")
+  (elem (i32.const 0x71) $ELSE)
 
   ;; [6.1.1320](https://forth-standard.org/standard/core/EMIT)
   (func $EMIT (param $tos i32) (result i32)
     (call $shell_emit (i32.load (i32.sub (local.get $tos) (i32.const 4))))
     (i32.sub (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x205c4) "\b4\05\02\00" "\04" "EMIT   " "\6c\00\00\00")
-  (elem (i32.const 0x6c) $EMIT)
+  (data (i32.const 0x3b6c0) "\b0\b6\03\00" "\04" "EMIT   " "\72\00\00\00")
+  (elem (i32.const 0x72) $EMIT)
 
   ;; [6.1.1345](https://forth-standard.org/standard/core/ENVIRONMENTq)
   (func $ENVIRONMENT? (param $tos i32) (result i32)
@@ -1364,13 +1785,13 @@
     (local $bbtos i32)
     (local.set $addr (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (local.set $len (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
-    (if (result i32) (call $stringEqual (local.get $addr) (local.get $len) (i32.const 0x20064 (; = str("ADDRESS-UNIT-BITS") + 1 ;)) (i32.const 0x11 (; = len("ADDRESS-UNIT-BITS") ;)))
+    (if (result i32) (call $stringEqual (local.get $addr) (local.get $len) (i32.const 0x3b064 (; = str("ADDRESS-UNIT-BITS") + 1 ;)) (i32.const 0x11 (; = len("ADDRESS-UNIT-BITS") ;)))
       (then
         (i32.store (local.get $bbtos) (i32.const 8))
         (i32.store (local.get $btos) (i32.const -1))
         (local.get $tos))
       (else
-        (if (result i32) (call $stringEqual (local.get $addr) (local.get $len) (i32.const 0x20076 (; = str("/COUNTED-STRING") + 1 ;)) (i32.const 0xf (; = len("/COUNTED-STRING") ;)))
+        (if (result i32) (call $stringEqual (local.get $addr) (local.get $len) (i32.const 0x3b076 (; = str("/COUNTED-STRING") + 1 ;)) (i32.const 0xf (; = len("/COUNTED-STRING") ;)))
           (then
             (i32.store (local.get $bbtos) (i32.const 255))
             (i32.store (local.get $btos) (i32.const -1))
@@ -1378,8 +1799,8 @@
           (else
             (i32.store (local.get $bbtos) (i32.const 0))
             (local.get $btos))))))
-  (data (i32.const 0x205d4) "\c4\05\02\00" "\0c" "ENVIRONMENT?   " "\6d\00\00\00")
-  (elem (i32.const 0x6d) $ENVIRONMENT?)
+  (data (i32.const 0x3b6d0) "\c0\b6\03\00" "\0c" "ENVIRONMENT?   " "\73\00\00\00")
+  (elem (i32.const 0x73) $ENVIRONMENT?)
 
   ;; [6.2.1350](https://forth-standard.org/standard/core/ERASE)
   (func $ERASE (param $tos i32) (result i32)
@@ -1389,8 +1810,8 @@
       (i32.const 0)
       (i32.load (i32.sub (local.get $tos) (i32.const 4))))
     (local.get $bbtos))
-  (data (i32.const 0x205ec) "\d4\05\02\00" "\05" "ERASE  " "\6e\00\00\00")
-  (elem (i32.const 0x6e) $ERASE)
+  (data (i32.const 0x3b6e8) "\d0\b6\03\00" "\05" "ERASE  " "\74\00\00\00")
+  (elem (i32.const 0x74) $ERASE)
 
   ;; [6.1.1360](https://forth-standard.org/standard/core/EVALUATE)
   (func $EVALUATE (param $tos i32) (result i32)
@@ -1399,47 +1820,50 @@
     (local $prevIn i32)
     (local $prevInputBufferBase i32)
     (local $prevInputBufferSize i32)
+    (call $checkMainThread)
 
     ;; Save input state
     (local.set $prevSourceID (global.get $sourceID))
-    (local.set $prevIn (i32.load (i32.const 0x20334 (; = body(>IN) ;))))
+    (local.set $prevIn (i32.load (i32.const 0x3b3ec (; = body(>IN) ;))))
     (local.set $prevInputBufferSize (global.get $inputBufferSize))
     (local.set $prevInputBufferBase (global.get $inputBufferBase))
 
     (global.set $sourceID (i32.const -1))
     (global.set $inputBufferBase (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (global.set $inputBufferSize (i32.load (i32.sub (local.get $tos) (i32.const 4))))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;)) (i32.const 0))
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;)) (i32.const 0))
 
     (call $interpret (local.get $bbtos))
 
     ;; Restore input state
     (global.set $sourceID (local.get $prevSourceID))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;)) (local.get $prevIn))
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;)) (local.get $prevIn))
     (global.set $inputBufferBase (local.get $prevInputBufferBase))
     (global.set $inputBufferSize (local.get $prevInputBufferSize)))
-  (data (i32.const 0x205fc) "\ec\05\02\00" "\08" "EVALUATE   " "\6f\00\00\00")
-  (elem (i32.const 0x6f) $EVALUATE)
+  (data (i32.const 0x3b6f8) "\e8\b6\03\00" "\08" "EVALUATE   " "\75\00\00\00")
+  (elem (i32.const 0x75) $EVALUATE)
 
   ;; [6.1.1370](https://forth-standard.org/standard/core/EXECUTE)
   (func $EXECUTE (param $tos i32) (result i32)
     (call $execute (call $pop (local.get $tos))))
-  (data (i32.const 0x20610) "\fc\05\02\00" "\07" "EXECUTE" "\70\00\00\00")
-  (elem (i32.const 0x70) $EXECUTE)
+  (data (i32.const 0x3b70c) "\f8\b6\03\00" "\07" "EXECUTE" "\76\00\00\00")
+  (elem (i32.const 0x76) $EXECUTE)
 
   ;; [6.1.1380](https://forth-standard.org/standard/core/EXIT)
   (func $EXIT (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
-    (call $emitReturn))
-  (data (i32.const 0x20620) "\10\06\02\00" "\84" (; F_IMMEDIATE ;) "EXIT   " "\71\00\00\00")
-  (elem (i32.const 0x71) $EXIT)
+    (call $compileSpill)
+    (call $emitReturn)
+    (global.set $unloops (i32.const 0)))
+  (data (i32.const 0x3b71c) "\0c\b7\03\00" "\84" (; F_IMMEDIATE ;) "EXIT   " "\77\00\00\00")
+  (elem (i32.const 0x77) $EXIT)
 
   ;; [6.2.1485](https://forth-standard.org/standard/core/FALSE)
   (func $FALSE (param $tos i32) (result i32)
     (call $push (local.get $tos) (i32.const 0x0)))
-  (data (i32.const 0x20630) "\20\06\02\00" "\05" "FALSE  " "\72\00\00\00")
-  (elem (i32.const 0x72) $FALSE)
+  (data (i32.const 0x3b72c) "\1c\b7\03\00" "\05" "FALSE  " "\78\00\00\00")
+  (elem (i32.const 0x78) $FALSE)
 
   ;; [6.1.1540](https://forth-standard.org/standard/core/FILL)
   (func $FILL (param $tos i32) (result i32)
@@ -1449,8 +1873,8 @@
       (i32.load (i32.sub (local.get $tos) (i32.const 4)))
       (i32.load (i32.sub (local.get $tos) (i32.const 8))))
     (local.get $bbbtos))
-  (data (i32.const 0x20640) "\30\06\02\00" "\04" "FILL   " "\73\00\00\00")
-  (elem (i32.const 0x73) $FILL)
+  (data (i32.const 0x3b73c) "\2c\b7\03\00" "\04" "FILL   " "\79\00\00\00")
+  (elem (i32.const 0x79) $FILL)
 
   ;; [6.1.1550](https://forth-standard.org/standard/core/FIND)
   (func $FIND (param $tos i32) (result i32)
@@ -1466,8 +1890,16 @@
       (else (i32.store (i32.sub (local.get $tos) (i32.const 4)) (local.get $xt))))
     (i32.store (local.get $tos) (local.get $r))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20650) "\40\06\02\00" "\04" "FIND   " "\74\00\00\00")
-  (elem (i32.const 0x74) $FIND)
+  (data (i32.const 0x3b74c) "\3c\b7\03\00" "\04" "FIND   " "\7a\00\00\00")
+  (elem (i32.const 0x7a) $FIND)
+
+  ;; Loads the code of all words that were compiled, but not loaded yet.
+  ;; This normally happens automatically when the code is needed.
+  (func $FLUSH-CODE (param $tos i32) (result i32)
+    (call $flushCode)
+    (local.get $tos))
+  (data (i32.const 0x3b75c) "\4c\b7\03\00" "\0a" "FLUSH-CODE " "\7b\00\00\00")
+  (elem (i32.const 0x7b) $FLUSH-CODE)
 
   ;; [6.1.1561](https://forth-standard.org/standard/core/FMDivMOD)
   (func $FM/MOD (param $tos i32) (result i32)
@@ -1492,22 +1924,48 @@
     (i32.store (local.get $bbbtos) (local.get $mod))
     (i32.store (i32.sub (local.get $tos) (i32.const 8)) (local.get $q))
     (local.get $btos))
-  (data (i32.const 0x20660) "\50\06\02\00" "\06" "FM/MOD " "\75\00\00\00")
-  (elem (i32.const 0x75) $FM/MOD)
+  (data (i32.const 0x3b770) "\5c\b7\03\00" "\06" "FM/MOD " "\7c\00\00\00")
+  (elem (i32.const 0x7c) $FM/MOD)
+
+  ;; [14.6.1.1605](https://forth-standard.org/standard/memory/FREE)
+  (func $FREE (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $b i32)
+    (call $checkMainThread)
+    (if (local.tee $b (call $heapBlock (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
+      (then
+        (call $heapRelease (local.get $b))
+        (i32.store (local.get $btos) (i32.const 0)))
+      (else
+        (i32.store (local.get $btos) (i32.const -0x3c (; = ERR_FREE ;)))))
+    (local.get $tos))
+  (data (i32.const 0x3b780) "\70\b7\03\00" "\04" "FREE   " "\7d\00\00\00")
+  (elem (i32.const 0x7d) $FREE)
+
+  ;; Pushes the number of bytes in allocated heap blocks, the number of bytes
+  ;; in free heap blocks, and the number of free heap blocks.
+  ;; ( -- u1 u2 u3 )
+  (func $HEAP-STATS (param $tos i32) (result i32)
+    (i32.store (local.get $tos) (global.get $heapUsed))
+    (i32.store (i32.add (local.get $tos) (i32.const 4)) (global.get $heapFree))
+    (i32.store (i32.add (local.get $tos) (i32.const 8)) (global.get $heapFreeBlocks))
+    (i32.add (local.get $tos) (i32.const 12)))
+  (data (i32.const 0x3b790) "\80\b7\03\00" "\0a" "HEAP-STATS " "\7e\00\00\00")
+  (elem (i32.const 0x7e) $HEAP-STATS)
 
   ;; [6.1.1650](https://forth-standard.org/standard/core/HERE)
   (func $HERE (param $tos i32) (result i32)
     (i32.store (local.get $tos) (global.get $here))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20670) "\60\06\02\00" "\04" "HERE   " "\76\00\00\00")
-  (elem (i32.const 0x76) $HERE)
+  (data (i32.const 0x3b7a4) "\90\b7\03\00" "\04" "HERE   " "\7f\00\00\00")
+  (elem (i32.const 0x7f) $HERE)
 
   ;; [6.2.1660](https://forth-standard.org/standard/core/HEX)
   (func $HEX (param $tos i32) (result i32)
-    (i32.store (i32.const 0x2040c (; = body(BASE) ;)) (i32.const 16))
+    (i32.store (i32.const 0x3b4d8 (; = body(BASE) ;)) (i32.const 16))
     (local.get $tos))
-  (data (i32.const 0x20680) "\70\06\02\00" "\03" "HEX" "\77\00\00\00")
-  (elem (i32.const 0x77) $HEX)
+  (data (i32.const 0x3b7b4) "\a4\b7\03\00" "\03" "HEX" "\80\00\00\00")
+  (elem (i32.const 0x80) $HEX)
 
   ;; [6.1.1670](https://forth-standard.org/standard/core/HOLD)
   (func $HOLD (param $tos i32) (result i32)
@@ -1518,8 +1976,8 @@
       (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
     (global.set $po (local.get $npo))
     (local.get $btos))
-  (data (i32.const 0x2068c) "\80\06\02\00" "\04" "HOLD   " "\78\00\00\00")
-  (elem (i32.const 0x78) $HOLD)
+  (data (i32.const 0x3b7c0) "\b4\b7\03\00" "\04" "HOLD   " "\81\00\00\00")
+  (elem (i32.const 0x81) $HOLD)
 
   ;; [6.2.1675](https://forth-standard.org/standard/core/HOLDS)
   (func $HOLDS (param $tos i32) (result i32)
@@ -1534,23 +1992,23 @@
       (local.get $len))
     (global.set $po (local.get $npo))
     (i32.sub (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x2069c) "\8c\06\02\00" "\05" "HOLDS  " "\79\00\00\00")
-  (elem (i32.const 0x79) $HOLDS)
+  (data (i32.const 0x3b7d0) "\c0\b7\03\00" "\05" "HOLDS  " "\82\00\00\00")
+  (elem (i32.const 0x82) $HOLDS)
 
   ;; [6.1.1680](https://forth-standard.org/standard/core/I)
   (func $I (param $tos i32) (result i32)
     (i32.store (local.get $tos) (i32.load (i32.sub (global.get $tors) (i32.const 4))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x206ac) "\9c\06\02\00" "\01" "I  " "\7a\00\00\00")
-  (elem (i32.const 0x7a) $I)
+  (data (i32.const 0x3b7e0) "\d0\b7\03\00" "\01" "I  " "\83\00\00\00")
+  (elem (i32.const 0x83) $I)
 
   ;; [6.1.1700](https://forth-standard.org/standard/core/IF)
   (func $IF (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileIf))
-  (data (i32.const 0x206b8) "\ac\06\02\00" "\82" (; F_IMMEDIATE ;) "IF " "\7b\00\00\00")
-  (elem (i32.const 0x7b) $IF)
+  (data (i32.const 0x3b7ec) "\e0\b7\03\00" "\82" (; F_IMMEDIATE ;) "IF " "\84\00\00\00")
+  (elem (i32.const 0x84) $IF)
 
   ;; [6.1.1710](https://forth-standard.org/standard/core/IMMEDIATE)
   (func $IMMEDIATE (param $tos i32) (result i32)
@@ -1559,8 +2017,8 @@
         (i32.load (i32.add (global.get $latest) (i32.const 4)))
         (i32.const 0x80 (; = F_IMMEDIATE ;))))
     (local.get $tos))
-  (data (i32.const 0x206c4) "\b8\06\02\00" "\09" "IMMEDIATE  " "\7c\00\00\00")
-  (elem (i32.const 0x7c) $IMMEDIATE)
+  (data (i32.const 0x3b7f8) "\ec\b7\03\00" "\09" "IMMEDIATE  " "\85\00\00\00")
+  (elem (i32.const 0x85) $IMMEDIATE)
 
   ;; [6.1.1720](https://forth-standard.org/standard/core/INVERT)
   (func $INVERT (param $tos i32) (result i32)
@@ -1568,58 +2026,77 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.xor (i32.load (local.get $btos)) (i32.const -1)))
     (local.get $tos))
-  (data (i32.const 0x206d8) "\c4\06\02\00" "\06" "INVERT " "\7d\00\00\00")
-  (elem (i32.const 0x7d) $INVERT)
+  (data (i32.const 0x3b80c) "\f8\b7\03\00" "\06" "INVERT " "\86\00\00\00")
+  (elem (i32.const 0x86) $INVERT)
 
   ;; [6.2.1725](https://forth-standard.org/standard/core/IS)
   (func $IS (param $tos i32) (result i32)
     (call $to (local.get $tos)))
-  (data (i32.const 0x206e8) "\d8\06\02\00" "\82" (; F_IMMEDIATE ;) "IS " "\7e\00\00\00")
-  (elem (i32.const 0x7e) $IS)
+  (data (i32.const 0x3b81c) "\0c\b8\03\00" "\82" (; F_IMMEDIATE ;) "IS " "\87\00\00\00")
+  (elem (i32.const 0x87) $IS)
 
   ;; [6.1.1730](https://forth-standard.org/standard/core/J)
   (func $J (param $tos i32) (result i32)
     (i32.store (local.get $tos) (i32.load (i32.sub (global.get $tors) (i32.const 8))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x206f4) "\e8\06\02\00" "\01" "J  " "\7f\00\00\00")
-  (elem (i32.const 0x7f) $J)
+  (data (i32.const 0x3b828) "\1c\b8\03\00" "\01" "J  " "\88\00\00\00")
+  (elem (i32.const 0x88) $J)
+
+  ;; Waits for a task started with SPAWN to finish. Rethrows the exception if
+  ;; the task failed.
+  ;; ( task -- )
+  (func $JOIN (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $task i32)
+    (local $n i32)
+    (local.set $task (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
+    (if (local.get $task)
+      (then
+        (if (global.get $spawnedTasks)
+          (then (global.set $spawnedTasks (i32.sub (global.get $spawnedTasks) (i32.const 1)))))
+        (if (local.tee $n (call $shell_join (local.get $task)))
+          (then (return (call $throw (local.get $btos) (local.get $n)))))))
+    (local.get $btos))
+  (data (i32.const 0x3b834) "\28\b8\03\00" "\04" "JOIN   " "\89\00\00\00")
+  (elem (i32.const 0x89) $JOIN)
 
   ;; [6.1.1750](https://forth-standard.org/standard/core/KEY)
   (func $KEY (param $tos i32) (result i32)
+    (call $runTasks)
     (i32.store (local.get $tos) (call $shell_key))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20700) "\f4\06\02\00" "\03" "KEY" "\80\00\00\00")
-  (elem (i32.const 0x80) $KEY)
+  (data (i32.const 0x3b844) "\34\b8\03\00" "\03" "KEY" "\8a\00\00\00")
+  (elem (i32.const 0x8a) $KEY)
 
   (func $LATEST (param $tos i32) (result i32)
     (i32.store (local.get $tos) (global.get $latest))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x2070c) "\00\07\02\00" "\06" "LATEST " "\81\00\00\00")
-  (elem (i32.const 0x81) $LATEST)
+  (data (i32.const 0x3b850) "\44\b8\03\00" "\06" "LATEST " "\8b\00\00\00")
+  (elem (i32.const 0x8b) $LATEST)
 
   ;; [6.1.1760](https://forth-standard.org/standard/core/LEAVE)
   (func $LEAVE (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileLeave))
-  (data (i32.const 0x2071c) "\0c\07\02\00" "\85" (; F_IMMEDIATE ;) "LEAVE  " "\82\00\00\00")
-  (elem (i32.const 0x82) $LEAVE)
+  (data (i32.const 0x3b860) "\50\b8\03\00" "\85" (; F_IMMEDIATE ;) "LEAVE  " "\8c\00\00\00")
+  (elem (i32.const 0x8c) $LEAVE)
 
   ;; [6.1.1780](https://forth-standard.org/standard/core/LITERAL)
   (func $LITERAL (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compilePushConst (call $pop)))
-  (data (i32.const 0x2072c) "\1c\07\02\00" "\87" (; F_IMMEDIATE ;) "LITERAL" "\83\00\00\00")
-  (elem (i32.const 0x83) $LITERAL)
+  (data (i32.const 0x3b870) "\60\b8\03\00" "\87" (; F_IMMEDIATE ;) "LITERAL" "\8d\00\00\00")
+  (elem (i32.const 0x8d) $LITERAL)
 
   ;; [6.1.1800](https://forth-standard.org/standard/core/LOOP)
   (func $LOOP (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileLoop))
-  (data (i32.const 0x2073c) "\2c\07\02\00" "\84" (; F_IMMEDIATE ;) "LOOP   " "\84\00\00\00")
-  (elem (i32.const 0x84) $LOOP)
+  (data (i32.const 0x3b880) "\70\b8\03\00" "\84" (; F_IMMEDIATE ;) "LOOP   " "\8e\00\00\00")
+  (elem (i32.const 0x8e) $LOOP)
 
   ;; [6.1.1805](https://forth-standard.org/standard/core/LSHIFT)
   (func $LSHIFT (param $tos i32) (result i32)
@@ -1629,8 +2106,8 @@
                 (i32.shl (i32.load (local.get $bbtos))
                         (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x2074c) "\3c\07\02\00" "\06" "LSHIFT " "\85\00\00\00")
-  (elem (i32.const 0x85) $LSHIFT)
+  (data (i32.const 0x3b890) "\80\b8\03\00" "\06" "LSHIFT " "\8f\00\00\00")
+  (elem (i32.const 0x8f) $LSHIFT)
 
   ;; [6.1.1810](https://forth-standard.org/standard/core/MTimes)
   (func $M* (param $tos i32) (result i32)
@@ -1640,8 +2117,8 @@
                         (i64.extend_i32_s (i32.load (i32.sub (local.get $tos)
                                                               (i32.const 4))))))
     (local.get $tos))
-  (data (i32.const 0x2075c) "\4c\07\02\00" "\02" "M* " "\86\00\00\00")
-  (elem (i32.const 0x86) $M*)
+  (data (i32.const 0x3b8a0) "\90\b8\03\00" "\02" "M* " "\90\00\00\00")
+  (elem (i32.const 0x90) $M*)
 
   ;; [16.2.1850](https://forth-standard.org/standard/core/MARKER)
   (func $MARKER (param $tos i32) (result i32)
@@ -1651,7 +2128,7 @@
     (local $oldLatest i32)
     (local.set $nameAddr (local.set $nameLen (call $parseName)))
     (if (i32.eqz (local.get $nameLen))
-      (then (call $fail (i32.const 0x2001d (; = str("incomplete input") ;)))))
+      (then (call $fail (i32.const -0x10 (; = EXC_ZERO_LENGTH_NAME ;)) (i32.const 0x3b01d (; = str("incomplete input") ;)))))
     (local.set $oldHere (global.get $here))
     (local.set $oldLatest (global.get $latest))
     (call $create
@@ -1663,10 +2140,10 @@
        area of the word, so we can reset it in `$resetMarker` ;)
     (i32.store (global.get $here) (local.get $oldHere))
     (i32.store (i32.add (global.get $here) (i32.const 4)) (local.get $oldLatest))
-    (global.set $here (i32.add (global.get $here) (i32.const 8)))
+    (call $setHere (i32.add (global.get $here) (i32.const 8)))
     (local.get $tos))
-  (data (i32.const 0x20768) "\5c\07\02\00" "\06" "MARKER " "\87\00\00\00")
-  (elem (i32.const 0x87) $MARKER)
+  (data (i32.const 0x3b8ac) "\a0\b8\03\00" "\06" "MARKER " "\91\00\00\00")
+  (elem (i32.const 0x91) $MARKER)
 
   ;; [6.1.1870](https://forth-standard.org/standard/core/MAX)
   (func $MAX (param $tos i32) (result i32)
@@ -1679,8 +2156,8 @@
       (then
         (i32.store (local.get $bbtos) (local.get $v))))
     (local.get $btos))
-  (data (i32.const 0x20778) "\68\07\02\00" "\03" "MAX" "\88\00\00\00")
-  (elem (i32.const 0x88) $MAX)
+  (data (i32.const 0x3b8bc) "\ac\b8\03\00" "\03" "MAX" "\92\00\00\00")
+  (elem (i32.const 0x92) $MAX)
 
   ;; [6.1.1880](https://forth-standard.org/standard/core/MIN)
   (func $MIN (param $tos i32) (result i32)
@@ -1693,8 +2170,8 @@
       (then
         (i32.store (local.get $bbtos) (local.get $v))))
     (local.get $btos))
-  (data (i32.const 0x20784) "\78\07\02\00" "\03" "MIN" "\89\00\00\00")
-  (elem (i32.const 0x89) $MIN)
+  (data (i32.const 0x3b8c8) "\bc\b8\03\00" "\03" "MIN" "\93\00\00\00")
+  (elem (i32.const 0x93) $MIN)
 
   ;; [6.1.1890](https://forth-standard.org/standard/core/MOD)
   (func $MOD (param $tos i32) (result i32)
@@ -1704,8 +2181,8 @@
                 (i32.rem_s (i32.load (local.get $bbtos))
                           (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x20790) "\84\07\02\00" "\03" "MOD" "\8a\00\00\00")
-  (elem (i32.const 0x8a) $MOD)
+  (data (i32.const 0x3b8d4) "\c8\b8\03\00" "\03" "MOD" "\94\00\00\00")
+  (elem (i32.const 0x94) $MOD)
 
   ;; [6.1.1900](https://forth-standard.org/standard/core/MOVE)
   (func $MOVE (param $tos i32) (result i32)
@@ -1715,8 +2192,8 @@
       (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12))))
       (i32.load (i32.sub (local.get $tos) (i32.const 4))))
     (local.get $bbbtos))
-  (data (i32.const 0x2079c) "\90\07\02\00" "\04" "MOVE   " "\8b\00\00\00")
-  (elem (i32.const 0x8b) $MOVE)
+  (data (i32.const 0x3b8e0) "\d4\b8\03\00" "\04" "MOVE   " "\95\00\00\00")
+  (elem (i32.const 0x95) $MOVE)
 
   ;; [6.1.1910](https://forth-standard.org/standard/core/NEGATE)
   (func $NEGATE (param $tos i32) (result i32)
@@ -1724,8 +2201,8 @@
     (i32.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
                 (i32.sub (i32.const 0) (i32.load (local.get $btos))))
     (local.get $tos))
-  (data (i32.const 0x207ac) "\9c\07\02\00" "\06" "NEGATE " "\8c\00\00\00")
-  (elem (i32.const 0x8c) $NEGATE)
+  (data (i32.const 0x3b8f0) "\e0\b8\03\00" "\06" "NEGATE " "\96\00\00\00")
+  (elem (i32.const 0x96) $NEGATE)
 
   ;; [6.2.1930](https://forth-standard.org/standard/core/NIP)
   (func $NIP (param $tos i32) (result i32)
@@ -1733,8 +2210,12 @@
     (i32.store (i32.sub (local.get $tos) (i32.const 8))
       (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
     (local.get $btos))
-  (data (i32.const 0x207bc) "\ac\07\02\00" "\03" "NIP" "\8d\00\00\00")
-  (elem (i32.const 0x8d) $NIP)
+  (data (i32.const 0x3b900) "\f0\b8\03\00" "\03" "NIP" "\97\00\00\00")
+  (elem (i32.const 0x97) $NIP)
+
+  ;; The main task, which runs the interpreter.
+  ;; ( -- task )
+  (data (i32.const 0x3b90c) "\00\b9\03\00" "\48" (; F_DATA ;) "OPERATOR   " "\06\00\00\00" (; = pack(PUSH_INDIRECT_INDEX) ;) "\00\08\03\00" (; = pack(OPERATOR_BASE) ;))
 
   ;; [6.1.1980](https://forth-standard.org/standard/core/OR)
   (func $OR (param $tos i32) (result i32)
@@ -1744,23 +2225,59 @@
                 (i32.or (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))
                         (i32.load (local.get $bbtos))))
     (local.get $btos))
-  (data (i32.const 0x207c8) "\bc\07\02\00" "\02" "OR " "\8e\00\00\00")
-  (elem (i32.const 0x8e) $OR)
+  (data (i32.const 0x3b924) "\0c\b9\03\00" "\02" "OR " "\98\00\00\00")
+  (elem (i32.const 0x98) $OR)
 
   ;; [6.1.1990](https://forth-standard.org/standard/core/OVER)
   (func $OVER (param $tos i32) (result i32)
     (i32.store (local.get $tos)
                 (i32.load (i32.sub (local.get $tos) (i32.const 8))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x207d4) "\c8\07\02\00" "\04" "OVER   " "\8f\00\00\00")
-  (elem (i32.const 0x8f) $OVER)
+  (data (i32.const 0x3b930) "\24\b9\03\00" "\04" "OVER   " "\99\00\00\00")
+  (elem (i32.const 0x99) $OVER)
 
   ;; [6.2.2000](https://forth-standard.org/standard/core/PAD)
   (func $PAD (param $tos i32) (result i32)
     (i32.store (local.get $tos) (i32.add (global.get $here) (i32.const 0x304 (; = PAD_OFFSET ;))))
     (i32.add (local.get $tos) (i32.const 0x4)))
-  (data (i32.const 0x207e4) "\d4\07\02\00" "\03" "PAD" "\90\00\00\00")
-  (elem (i32.const 0x90) $PAD)
+  (data (i32.const 0x3b940) "\30\b9\03\00" "\03" "PAD" "\9a\00\00\00")
+  (elem (i32.const 0x9a) $PAD)
+
+  ;; Executes xt for every index from start up to (but not including) limit,
+  ;; with the index on the stack. The shell can run the iterations in
+  ;; parallel on task threads (see Tasks), so they should only communicate
+  ;; through memory. Rethrows the exception of an iteration that failed.
+  ;; ( limit start xt -- )
+  (func $PAR-DO (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (local $xt i32)
+    (local $i i32)
+    (local $limit i32)
+    (local $n i32)
+    (local.set $limit (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12)))))
+    (local.set $i (i32.load (i32.sub (local.get $tos) (i32.const 8))))
+    (local.set $xt (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (if (i32.ge_s (local.get $i) (local.get $limit))
+      (then (return (local.get $bbbtos))))
+    (call $publishTaskState)
+    (local.set $n (call $shell_parallel (local.get $xt) (local.get $i) (local.get $limit)))
+    (if (i32.eq (local.get $n) (i32.const -1))
+      (then
+        ;; The shell can't run the loop, so run it here
+        (block $endLoop
+          (loop $loop
+            (br_if $endLoop (i32.ge_s (local.get $i) (local.get $limit)))
+            (local.set $bbbtos (call $burnFuel (local.get $bbbtos)))
+            (local.set $bbbtos
+              (call $execute (call $push (local.get $bbbtos) (local.get $i)) (local.get $xt)))
+            (local.set $i (i32.add (local.get $i) (i32.const 1)))
+            (br $loop))))
+      (else
+        (if (local.get $n)
+          (then (return (call $throw (local.get $bbbtos) (local.get $n)))))))
+    (local.get $bbbtos))
+  (data (i32.const 0x3b94c) "\40\b9\03\00" "\06" "PAR-DO " "\9b\00\00\00")
+  (elem (i32.const 0x9b) $PAR-DO)
 
   ;; [6.2.2008](https://forth-standard.org/standard/core/PARSE)
   (func $PARSE (param $tos i32) (result i32)
@@ -1773,8 +2290,8 @@
     (i32.store (local.get $btos) (local.get $addr))
     (i32.store (local.get $tos) (local.get $len))
     (i32.add (local.get $tos) (i32.const 0x4)))
-  (data (i32.const 0x207f0) "\e4\07\02\00" "\05" "PARSE  " "\91\00\00\00")
-  (elem (i32.const 0x91) $PARSE)
+  (data (i32.const 0x3b95c) "\4c\b9\03\00" "\05" "PARSE  " "\9c\00\00\00")
+  (elem (i32.const 0x9c) $PARSE)
 
   ;; [6.2.2020](https://forth-standard.org/standard/core/PARSE-NAME)
   (func $PARSE-NAME (param $tos i32) (result i32)
@@ -1784,8 +2301,8 @@
     (i32.store (local.get $tos) (local.get $addr))
     (i32.store (i32.add (local.get $tos) (i32.const 0x4)) (local.get $len))
     (i32.add (local.get $tos) (i32.const 0x8)))
-  (data (i32.const 0x20800) "\f0\07\02\00" "\0a" "PARSE-NAME " "\92\00\00\00")
-  (elem (i32.const 0x92) $PARSE-NAME)
+  (data (i32.const 0x3b96c) "\5c\b9\03\00" "\0a" "PARSE-NAME " "\9d\00\00\00")
+  (elem (i32.const 0x9d) $PARSE-NAME)
 
   ;; [6.2.2030](https://forth-standard.org/standard/core/PICK)
   (func $PICK (param $tos i32) (result i32)
@@ -1796,8 +2313,8 @@
           (local.get $tos)
           (i32.shl (i32.add (i32.load (local.get $btos)) (i32.const 2)) (i32.const 2)))))
     (local.get $tos))
-  (data (i32.const 0x20814) "\00\08\02\00" "\04" "PICK   " "\93\00\00\00")
-  (elem (i32.const 0x93) $PICK)
+  (data (i32.const 0x3b980) "\6c\b9\03\00" "\04" "PICK   " "\9e\00\00\00")
+  (elem (i32.const 0x9e) $PICK)
 
   ;; [6.1.2033](https://forth-standard.org/standard/core/POSTPONE)
   (func $POSTPONE (param $tos i32) (result i32)
@@ -1810,84 +2327,110 @@
       (then
         (call $compileExecute (local.get $findToken)))
       (else
+        (call $compileSpill)
         (call $emitConst (local.get $findToken))
         (call $compileCall (i32.const 1) (i32.const 0x5 (; = COMPILE_EXECUTE_INDEX ;))))))
-  (data (i32.const 0x20824) "\14\08\02\00" "\88" (; F_IMMEDIATE ;) "POSTPONE   " "\94\00\00\00")
-  (elem (i32.const 0x94) $POSTPONE)
+  (data (i32.const 0x3b990) "\80\b9\03\00" "\88" (; F_IMMEDIATE ;) "POSTPONE   " "\9f\00\00\00")
+  (elem (i32.const 0x9f) $POSTPONE)
 
   ;; [6.1.2050](https://forth-standard.org/standard/core/QUIT)
   (func $QUIT (param $tos i32) (result i32)
     (global.set $error (i32.const 0x2 (; = ERR_QUIT ;)))
     (call $quit (local.get $tos)))
-  (data (i32.const 0x20838) "\24\08\02\00" "\04" "QUIT   " "\95\00\00\00")
-  (elem (i32.const 0x95) $QUIT)
+  (data (i32.const 0x3b9a4) "\90\b9\03\00" "\04" "QUIT   " "\a0\00\00\00")
+  (elem (i32.const 0xa0) $QUIT)
 
   ;; [6.1.2060](https://forth-standard.org/standard/core/Rfrom)
   (func $R> (param $tos i32) (result i32)
     (global.set $tors (i32.sub (global.get $tors) (i32.const 4)))
     (i32.store (local.get $tos) (i32.load (global.get $tors)))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20848) "\38\08\02\00" "\02" "R> " "\96\00\00\00")
-  (elem (i32.const 0x96) $R>)
+  (data (i32.const 0x3b9b4) "\a4\b9\03\00" "\02" "R> " "\a1\00\00\00")
+  (elem (i32.const 0xa1) $R>)
 
   ;; [6.1.2070](https://forth-standard.org/standard/core/RFetch)
   (func $R@ (param $tos i32) (result i32)
     (i32.store (local.get $tos) (i32.load (i32.sub (global.get $tors) (i32.const 4))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x20854) "\48\08\02\00" "\02" "R@ " "\97\00\00\00")
-  (elem (i32.const 0x97) $R@)
+  (data (i32.const 0x3b9c0) "\b4\b9\03\00" "\02" "R@ " "\a2\00\00\00")
+  (elem (i32.const 0xa2) $R@)
 
   ;; Generate a random number from 0 to 2^31-1
   (func $RANDOM (param $tos i32) (result i32)
     (call $push (local.get $tos) (call $shell_random)))
-  (data (i32.const 0x20860) "\54\08\02\00" "\06" "RANDOM " "\98\00\00\00")
-  (elem (i32.const 0x98) $RANDOM)
+  (data (i32.const 0x3b9cc) "\c0\b9\03\00" "\06" "RANDOM " "\a3\00\00\00")
+  (elem (i32.const 0xa3) $RANDOM)
 
   ;; [6.1.2120](https://forth-standard.org/standard/core/RECURSE)
   (func $RECURSE  (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileRecurse))
-  (data (i32.const 0x20870) "\60\08\02\00" "\87" (; F_IMMEDIATE ;) "RECURSE" "\99\00\00\00")
-  (elem (i32.const 0x99) $RECURSE)
+  (data (i32.const 0x3b9dc) "\cc\b9\03\00" "\87" (; F_IMMEDIATE ;) "RECURSE" "\a4\00\00\00")
+  (elem (i32.const 0xa4) $RECURSE)
 
   ;; [6.2.2125](https://forth-standard.org/standard/core/REFILL)
   (func $REFILL (param $tos i32) (result i32)
     (local $char i32)
+    (call $checkMainThread)
     (global.set $inputBufferSize (i32.const 0))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;)) (i32.const 0))
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;)) (i32.const 0))
     (local.get $tos)
     (if (param i32) (result i32) (i32.eq (global.get $sourceID) (i32.const -1))
       (then
         (call $push (i32.const -1))
         (return)))
+    ;; Give the other tasks a turn while waiting for input
+    (call $runTasks)
     (global.set $inputBufferSize
       (call $shell_read
         (i32.const 0x0 (; = INPUT_BUFFER_BASE ;))
-        (i32.const 0x1000 (; = INPUT_BUFFER_SIZE ;))))
+        (i32.const 0x2000 (; = INPUT_BUFFER_SIZE ;))))
     (if (param i32) (result i32) (i32.eqz (global.get $inputBufferSize))
       (then (call $push (i32.const 0)))
       (else (call $push (i32.const -1)))))
-  (data (i32.const 0x20880) "\70\08\02\00" "\06" "REFILL " "\9a\00\00\00")
-  (elem (i32.const 0x9a) $REFILL)
+  (data (i32.const 0x3b9ec) "\dc\b9\03\00" "\06" "REFILL " "\a5\00\00\00")
+  (elem (i32.const 0xa5) $REFILL)
 
   ;; [6.1.2140](https://forth-standard.org/standard/core/REPEAT)
   (func $REPEAT (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileRepeat))
-  (data (i32.const 0x20890) "\80\08\02\00" "\86" (; F_IMMEDIATE ;) "REPEAT " "\9b\00\00\00")
-  (elem (i32.const 0x9b) $REPEAT)
+  (data (i32.const 0x3b9fc) "\ec\b9\03\00" "\86" (; F_IMMEDIATE ;) "REPEAT " "\a6\00\00\00")
+  (elem (i32.const 0xa6) $REPEAT)
+
+  ;; [14.6.1.2145](https://forth-standard.org/standard/memory/RESIZE)
+  (func $RESIZE (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $bbtos i32)
+    (local $b i32)
+    (local $addr i32)
+    (call $checkMainThread)
+    (local.set $btos (i32.sub (local.get $tos) (i32.const 4)))
+    (if (local.tee $b (call $heapBlock (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8))))))
+      (then
+        (local.set $addr (call $heapResize (local.get $b) (i32.load (local.get $btos))))))
+    (if (local.get $addr)
+      (then
+        (i32.store (local.get $bbtos) (local.get $addr))
+        (i32.store (local.get $btos) (i32.const 0)))
+      (else
+        (i32.store (local.get $btos) (i32.const -0x3d (; = ERR_RESIZE ;)))))
+    (local.get $tos))
+  (data (i32.const 0x3ba0c) "\fc\b9\03\00" "\06" "RESIZE " "\a7\00\00\00")
+  (elem (i32.const 0xa7) $RESIZE)
 
   ;; [6.2.2148](https://forth-standard.org/standard/core/RESTORE-INPUT)
   (func $RESTORE-INPUT (param $tos i32) (result i32)
     (local $bbtos i32)
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;))
+    (call $checkMainThread)
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;))
       (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (i32.store (local.get $bbtos) (i32.const 0))
     (i32.sub (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x208a0) "\90\08\02\00" "\0d" "RESTORE-INPUT  " "\9c\00\00\00")
-  (elem (i32.const 0x9c) $RESTORE-INPUT)
+  (data (i32.const 0x3ba1c) "\0c\ba\03\00" "\0d" "RESTORE-INPUT  " "\a8\00\00\00")
+  (elem (i32.const 0xa8) $RESTORE-INPUT)
 
   ;; [6.1.2150](https://forth-standard.org/standard/core/ROLL)
   (func $ROLL (param $tos i32) (result i32)
@@ -1909,8 +2452,8 @@
       (i32.shl (local.get $u) (i32.const 2)))
     (i32.store (i32.sub (local.get $tos) (i32.const 8)) (local.get $x))
     (local.get $btos))
-  (data (i32.const 0x208b8) "\a0\08\02\00" "\04" "ROLL   " "\9d\00\00\00")
-  (elem (i32.const 0x9d) $ROLL)
+  (data (i32.const 0x3ba34) "\1c\ba\03\00" "\04" "ROLL   " "\a9\00\00\00")
+  (elem (i32.const 0xa9) $ROLL)
 
   ;; [6.1.2160](https://forth-standard.org/standard/core/ROT)
   (func $ROT (param $tos i32) (result i32)
@@ -1925,8 +2468,8 @@
       (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
     (i32.store (local.get $bbtos) (local.get $tmp))
     (local.get $tos))
-  (data (i32.const 0x208c8) "\b8\08\02\00" "\03" "ROT" "\9e\00\00\00")
-  (elem (i32.const 0x9e) $ROT)
+  (data (i32.const 0x3ba44) "\34\ba\03\00" "\03" "ROT" "\aa\00\00\00")
+  (elem (i32.const 0xaa) $ROT)
 
   ;; [6.1.2162](https://forth-standard.org/standard/core/RSHIFT)
   (func $RSHIFT (param $tos i32) (result i32)
@@ -1936,8 +2479,25 @@
                 (i32.shr_u (i32.load (local.get $bbtos))
                           (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
     (local.get $btos))
-  (data (i32.const 0x208d4) "\c8\08\02\00" "\06" "RSHIFT " "\9f\00\00\00")
-  (elem (i32.const 0x9f) $RSHIFT)
+  (data (i32.const 0x3ba50) "\44\ba\03\00" "\06" "RSHIFT " "\ab\00\00\00")
+  (elem (i32.const 0xab) $RSHIFT)
+
+  ;; Gives every scheduled task one turn, and returns when all turns are
+  ;; done (see Scheduler). Fails when called from a task other than the
+  ;; operator.
+  ;; ( -- )
+  (func $RUN-TASKS (param $tos i32) (result i32)
+    (if (i32.ne (global.get $up) (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+      (then
+        ;; Report the error even though the turn catches it, as it would
+        ;; otherwise only silently stop the task
+        (call $ctype (i32.const 0x3b0db (; = str("RUN-TASKS in a task") ;)))
+        (call $shell_emit (i32.const 10))
+        (return (call $throw (local.get $tos) (i32.const -0x15 (; = EXC_UNSUPPORTED ;))))))
+    (call $runTasks)
+    (local.get $tos))
+  (data (i32.const 0x3ba60) "\50\ba\03\00" "\09" "RUN-TASKS  " "\ac\00\00\00")
+  (elem (i32.const 0xac) $RUN-TASKS)
 
   ;; [6.1.2165](https://forth-standard.org/standard/core/Sq)
   (func $Sq (param $tos i32) (result i32)
@@ -1947,13 +2507,14 @@
     (local.get $tos)
     (call $ensureCompiling)
     (local.set $addr (local.set $len (call $parse (i32.const 0x22 (; = '"' ;)))))
+    (call $reserve (local.get $len))
     (memory.copy (global.get $here) (local.get $addr) (local.get $len))
     (call $compilePushConst (global.get $here))
     (call $compilePushConst (local.get $len))
-    (global.set $here
+    (call $setHere
       (call $aligned (i32.add (global.get $here) (local.get $len)))))
-  (data (i32.const 0x208e4) "\d4\08\02\00" "\82" (; F_IMMEDIATE ;) "S\22 " "\a0\00\00\00")
-  (elem (i32.const 0xa0) $Sq)
+  (data (i32.const 0x3ba74) "\60\ba\03\00" "\82" (; F_IMMEDIATE ;) "S\22 " "\ad\00\00\00")
+  (elem (i32.const 0xad) $Sq)
 
   ;; [6.2.2266](https://forth-standard.org/standard/core/Seq)
   (func $Seq (param $tos i32) (result i32)
@@ -1964,12 +2525,15 @@
     (local $c i32)
     (local $c2 i32)
     (local $delimited i32)
+    (call $checkMainThread)
     (local.get $tos)
     (call $ensureCompiling)
     (local.set $p
       (local.tee $addr (i32.add (global.get $inputBufferBase)
-      (i32.load (i32.const 0x20334 (; = body(>IN) ;))))))
+      (i32.load (i32.const 0x3b3ec (; = body(>IN) ;))))))
     (local.set $end (i32.add (global.get $inputBufferBase) (global.get $inputBufferSize)))
+    ;; Unescaping never makes the string longer than the remaining input
+    (call $reserve (i32.sub (local.get $end) (local.get $p)))
     (local.set $tp (global.get $here))
     (local.set $delimited (i32.const 0))
     (block $endOfInput
@@ -2025,13 +2589,13 @@
             (i32.store8 (local.get $tp) (local.get $c))
             (local.set $tp (i32.add (local.get $tp) (i32.const 1)))))
         (br $read)))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;))
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;))
       (i32.sub (local.get $p) (global.get $inputBufferBase)))
     (call $compilePushConst (global.get $here))
     (call $compilePushConst (i32.sub (local.get $tp) (global.get $here)))
-    (global.set $here (call $aligned (local.get $tp))))
-  (data (i32.const 0x208f0) "\e4\08\02\00" "\83" (; F_IMMEDIATE ;) "S\5c\22" "\a1\00\00\00")
-  (elem (i32.const 0xa1) $Seq)
+    (call $setHere (call $aligned (local.get $tp))))
+  (data (i32.const 0x3ba80) "\74\ba\03\00" "\83" (; F_IMMEDIATE ;) "S\5c\22" "\ae\00\00\00")
+  (elem (i32.const 0xae) $Seq)
 
   ;; [6.1.2170](https://forth-standard.org/standard/core/StoD)
   (func $S>D (param $tos i32) (result i32)
@@ -2039,23 +2603,69 @@
     (i64.store (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))
       (i64.extend_i32_s (i32.load (local.get $btos))))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x208fc) "\f0\08\02\00" "\03" "S>D" "\a2\00\00\00")
-  (elem (i32.const 0xa2) $S>D)
+  (data (i32.const 0x3ba8c) "\80\ba\03\00" "\03" "S>D" "\af\00\00\00")
+  (elem (i32.const 0xaf) $S>D)
 
   ;; [6.2.2182](https://forth-standard.org/standard/core/SAVE-INPUT)
   (func $SAVE-INPUT (param $tos i32) (result i32)
-    (i32.store (local.get $tos) (i32.load (i32.const 0x20334 (; = body(>IN) ;))))
+    (i32.store (local.get $tos) (i32.load (i32.const 0x3b3ec (; = body(>IN) ;))))
     (i32.store (i32.add (local.get $tos) (i32.const 4)) (i32.const 1))
     (i32.add (local.get $tos) (i32.const 8)))
-  (data (i32.const 0x20908) "\fc\08\02\00" "\0a" "SAVE-INPUT " "\a3\00\00\00")
-  (elem (i32.const 0xa3) $SAVE-INPUT)
+  (data (i32.const 0x3ba98) "\8c\ba\03\00" "\0a" "SAVE-INPUT " "\b0\00\00\00")
+  (elem (i32.const 0xb0) $SAVE-INPUT)
 
   (func $SCALL (param $tos i32) (result i32)
     (global.set $tos (local.get $tos))
     (call $shell_call)
     (global.get $tos))
-  (data (i32.const 0x2091c) "\08\09\02\00" "\05" "SCALL  " "\a4\00\00\00")
-  (elem (i32.const 0xa4) $SCALL)
+  (data (i32.const 0x3baac) "\98\ba\03\00" "\05" "SCALL  " "\b1\00\00\00")
+  (elem (i32.const 0xb1) $SCALL)
+
+  ;; Makes the task execute xt every time it gets a turn (see RUN-TASKS),
+  ;; starting from an empty stack. Every turn runs xt to the end, so xt can't
+  ;; loop forever or wait for other tasks (see Scheduler).
+  ;; ( xt task -- )
+  (func $SCHEDULE (param $tos i32) (result i32)
+    (local $bbtos i32)
+    (local $task i32)
+    (local.set $task (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (i32.store (i32.add (local.get $task) (i32.const 0xc (; = TCB_XT ;)))
+      (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))))
+    (i32.store (i32.add (local.get $task) (i32.const 0x8 (; = TCB_TOS ;)))
+      (i32.load (i32.add (local.get $task) (i32.const 0x10 (; = TCB_STACK_BASE ;)))))
+    (i32.store (i32.add (local.get $task) (i32.const 0x4 (; = TCB_STATUS ;))) (i32.const -1))
+    (local.get $bbtos))
+  (data (i32.const 0x3babc) "\ac\ba\03\00" "\08" "SCHEDULE   " "\b2\00\00\00")
+  (elem (i32.const 0xb2) $SCHEDULE)
+
+  ;; [17.6.1.2191](https://forth-standard.org/standard/string/SEARCH)
+  (func $SEARCH (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (local $bbbbtos i32)
+    (local $len1 i32)
+    (local $len2 i32)
+    (local $i i32)
+    (local.set $len1 (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12)))))
+    (local.set $len2 (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.set $i (i32.const 0))
+    (if (local.get $len2)
+      (then
+        (local.set $i
+          (call $search
+            (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16))))
+            (local.get $len1)
+            (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+            (local.get $len2)))
+        (if (i32.ge_s (local.get $i) (i32.const 0))
+          (then
+            (i32.store (local.get $bbbbtos)
+              (i32.add (i32.load (local.get $bbbbtos)) (local.get $i)))
+            (i32.store (local.get $bbbtos) (i32.sub (local.get $len1) (local.get $i)))))))
+    (i32.store (i32.sub (local.get $tos) (i32.const 8))
+      (select (i32.const -1) (i32.const 0) (i32.ge_s (local.get $i) (i32.const 0))))
+    (i32.sub (local.get $tos) (i32.const 4)))
+  (data (i32.const 0x3bad0) "\bc\ba\03\00" "\06" "SEARCH " "\b3\00\00\00")
+  (elem (i32.const 0xb3) $SEARCH)
 
   ;; [6.1.2210](https://forth-standard.org/standard/core/SIGN)
   (func $SIGN (param $tos i32) (result i32)
@@ -2066,8 +2676,8 @@
         (i32.store8 (local.tee $npo (i32.sub (global.get $po) (i32.const 1))) (i32.const 0x2d (; = '-' ;)))
         (global.set $po (local.get $npo))))
     (local.get $btos))
-  (data (i32.const 0x2092c) "\1c\09\02\00" "\04" "SIGN   " "\a5\00\00\00")
-  (elem (i32.const 0xa5) $SIGN)
+  (data (i32.const 0x3bae0) "\d0\ba\03\00" "\04" "SIGN   " "\b4\00\00\00")
+  (elem (i32.const 0xb4) $SIGN)
 
   ;; [6.1.2214](https://forth-standard.org/standard/core/SMDivREM)
   ;;
@@ -2088,29 +2698,29 @@
       (i32.wrap_i64
         (i64.div_s (local.get $n1) (local.get $n2))))
     (local.get $btos))
-  (data (i32.const 0x2093c) "\2c\09\02\00" "\06" "SM/REM " "\a6\00\00\00")
-  (elem (i32.const 0xa6) $SM/REM)
+  (data (i32.const 0x3baf0) "\e0\ba\03\00" "\06" "SM/REM " "\b5\00\00\00")
+  (elem (i32.const 0xb5) $SM/REM)
 
   ;; [6.1.2216](https://forth-standard.org/standard/core/SOURCE)
   (func $SOURCE (param $tos i32) (result i32)
     (local.get $tos)
     (call $push (global.get $inputBufferBase))
     (call $push (global.get $inputBufferSize)))
-  (data (i32.const 0x2094c) "\3c\09\02\00" "\06" "SOURCE " "\a7\00\00\00")
-  (elem (i32.const 0xa7) $SOURCE)
+  (data (i32.const 0x3bb00) "\f0\ba\03\00" "\06" "SOURCE " "\b6\00\00\00")
+  (elem (i32.const 0xb6) $SOURCE)
 
   ;; [6.2.2218](https://forth-standard.org/standard/core/SOURCE-ID)
   (func $SOURCE-ID (param $tos i32) (result i32)
     (call $push (local.get $tos) (global.get $sourceID)))
-  (data (i32.const 0x2095c) "\4c\09\02\00" "\09" "SOURCE-ID  " "\a8\00\00\00")
-  (elem (i32.const 0xa8) $SOURCE-ID)
+  (data (i32.const 0x3bb10) "\00\bb\03\00" "\09" "SOURCE-ID  " "\b7\00\00\00")
+  (elem (i32.const 0xb7) $SOURCE-ID)
 
   ;; [6.1.2220](https://forth-standard.org/standard/core/SPACE)
   (func $SPACE (param $tos i32) (result i32)
     (local.get $tos)
     (call $BL) (call $EMIT))
-  (data (i32.const 0x20970) "\5c\09\02\00" "\05" "SPACE  " "\a9\00\00\00")
-  (elem (i32.const 0xa9) $SPACE)
+  (data (i32.const 0x3bb24) "\10\bb\03\00" "\05" "SPACE  " "\b8\00\00\00")
+  (elem (i32.const 0xb8) $SPACE)
 
   ;; [6.1.2230](https://forth-standard.org/standard/core/SPACES)
   (func $SPACES (param $tos i32) (result i32)
@@ -2123,11 +2733,43 @@
         (call $SPACE)
         (local.set $i (i32.sub (local.get $i) (i32.const 1)))
         (br $loop))))
-  (data (i32.const 0x20980) "\70\09\02\00" "\06" "SPACES " "\aa\00\00\00")
-  (elem (i32.const 0xaa) $SPACES)
+  (data (i32.const 0x3bb34) "\24\bb\03\00" "\06" "SPACES " "\b9\00\00\00")
+  (elem (i32.const 0xb9) $SPACES)
+
+  ;; Starts a task that executes xt with x on the stack, and returns a handle to
+  ;; wait for it with JOIN. The shell can run the task in parallel on a task
+  ;; thread (see Tasks); otherwise, it runs to completion before SPAWN returns.
+  ;; ( x xt -- task )
+  (func $SPAWN (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $bbtos i32)
+    (local $xt i32)
+    (local $task i32)
+    (local.set $xt (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
+    (call $publishTaskState)
+    (local.set $task
+      (call $shell_spawn (local.get $xt) (i32.load (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8))))))
+    (if (i32.eqz (local.get $task))
+      (then
+        ;; The shell can't start tasks, so run it here
+        (return (call $push (call $execute (local.get $btos) (local.get $xt)) (i32.const 0)))))
+    (global.set $spawnedTasks (i32.add (global.get $spawnedTasks) (i32.const 1)))
+    (i32.store (local.get $bbtos) (local.get $task))
+    (local.get $btos))
+  (data (i32.const 0x3bb44) "\34\bb\03\00" "\05" "SPAWN  " "\ba\00\00\00")
+  (elem (i32.const 0xba) $SPAWN)
 
   ;; [6.1.2250](https://forth-standard.org/standard/core/STATE)
-  (data (i32.const 0x20990) "\80\09\02\00" "\45" (; F_DATA ;) "STATE  " "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\00\00\00\00" (; = pack(0) ;))
+  (data (i32.const 0x3bb54) "\44\bb\03\00" "\45" (; F_DATA ;) "STATE  " "\03\00\00\00" (; = pack(PUSH_DATA_ADDRESS_INDEX) ;) "\00\00\00\00" (; = pack(0) ;))
+
+  ;; Stops the current task: it gets no more turns until it is scheduled
+  ;; again. Does nothing in the operator.
+  ;; ( -- )
+  (func $STOP (param $tos i32) (result i32)
+    (i32.store (i32.add (global.get $up) (i32.const 0x4 (; = TCB_STATUS ;))) (i32.const 0))
+    (local.get $tos))
+  (data (i32.const 0x3bb68) "\54\bb\03\00" "\04" "STOP   " "\bb\00\00\00")
+  (elem (i32.const 0xbb) $STOP)
 
   ;; [6.1.2260](https://forth-standard.org/standard/core/SWAP)
   (func $SWAP (param $tos i32) (result i32)
@@ -2139,28 +2781,67 @@
                 (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
     (i32.store (local.get $btos) (local.get $tmp))
     (local.get $tos))
-  (data (i32.const 0x209a4) "\90\09\02\00" "\04" "SWAP   " "\ab\00\00\00")
-  (elem (i32.const 0xab) $SWAP)
+  (data (i32.const 0x3bb78) "\68\bb\03\00" "\04" "SWAP   " "\bc\00\00\00")
+  (elem (i32.const 0xbc) $SWAP)
+
+  ;; Creates a stopped task (see SCHEDULE), with its own data stack and user
+  ;; area. Executing name pushes the task. Tasks don't run on their own call
+  ;; stack, but get turns from the operator (see Scheduler).
+  ;; ( "<spaces>name" -- )
+  (func $TASK (param $tos i32) (result i32)
+    (local $task i32)
+    (local.get $tos)
+    (call $CREATE)
+    (local.set $task (global.get $here))
+    (call $setHere (i32.add (local.get $task) (i32.const 0x494 (; = TASK_SIZE ;))))
+    (memory.fill (local.get $task) (i32.const 0) (i32.const 0x94 (; = TCB_SIZE ;)))
+    (i32.store (i32.add (local.get $task) (i32.const 0x10 (; = TCB_STACK_BASE ;)))
+      (i32.add (local.get $task) (i32.const 0x94 (; = TCB_SIZE ;))))
+    ;; Link the task into the ring, after the operator
+    (i32.store (local.get $task) (i32.load (i32.const 0x30800 (; = OPERATOR_BASE ;))))
+    (i32.store (i32.const 0x30800 (; = OPERATOR_BASE ;)) (local.get $task)))
+  (data (i32.const 0x3bb88) "\78\bb\03\00" "\04" "TASK   " "\bd\00\00\00")
+  (elem (i32.const 0xbd) $TASK)
 
   ;; [6.1.2270](https://forth-standard.org/standard/core/THEN)
   (func $THEN (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileThen))
-  (data (i32.const 0x209b4) "\a4\09\02\00" "\84" (; F_IMMEDIATE ;) "THEN   " "\ac\00\00\00")
-  (elem (i32.const 0xac) $THEN)
+  (data (i32.const 0x3bb98) "\88\bb\03\00" "\84" (; F_IMMEDIATE ;) "THEN   " "\be\00\00\00")
+  (elem (i32.const 0xbe) $THEN)
+
+  ;; [9.6.1.2275](https://forth-standard.org/standard/exception/THROW)
+  (func $THROW (param $tos i32) (result i32)
+    (local $btos i32)
+    (local $n i32)
+    (if (i32.eqz (local.tee $n (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))))
+      (then (return (local.get $btos))))
+    ;; Uncaught exceptions show their code (except for ABORT and ABORT")
+    (if (i32.and
+          (i32.eqz (global.get $catchDepth))
+          (i32.gt_u (i32.add (local.get $n) (i32.const 2)) (i32.const 1)))
+      (then
+        (call $type (i32.const 0x3b0b5 (; = str("uncaught exception") + 1 ;)) (i32.const 0x12 (; = len("uncaught exception") ;)))
+        (call $shell_emit (i32.const 0x3a (; = ':' ;)))
+        (call $shell_emit (i32.const 0x20 (; = ' ' ;)))
+        (drop (call $. (local.get $tos)))
+        (call $shell_emit (i32.const 0x0a))))
+    (call $throw (local.get $btos) (local.get $n)))
+  (data (i32.const 0x3bba8) "\98\bb\03\00" "\05" "THROW  " "\bf\00\00\00")
+  (elem (i32.const 0xbf) $THROW)
 
   ;; [6.2.2295](https://forth-standard.org/standard/core/TO)
   (func $TO (param $tos i32) (result i32)
     (call $to (local.get $tos)))
-  (data (i32.const 0x209c4) "\b4\09\02\00" "\82" (; F_IMMEDIATE ;) "TO " "\ad\00\00\00")
-  (elem (i32.const 0xad) $TO)
+  (data (i32.const 0x3bbb8) "\a8\bb\03\00" "\82" (; F_IMMEDIATE ;) "TO " "\c0\00\00\00")
+  (elem (i32.const 0xc0) $TO)
 
   ;; [6.2.2298](https://forth-standard.org/standard/core/TRUE)
   (func $TRUE (param $tos i32) (result i32)
     (call $push (local.get $tos) (i32.const 0xffffffff)))
-  (data (i32.const 0x209d0) "\c4\09\02\00" "\04" "TRUE   " "\ae\00\00\00")
-  (elem (i32.const 0xae) $TRUE)
+  (data (i32.const 0x3bbc4) "\b8\bb\03\00" "\04" "TRUE   " "\c1\00\00\00")
+  (elem (i32.const 0xc1) $TRUE)
 
   ;; [6.2.2300](https://forth-standard.org/standard/core/TUCK)
   (func $TUCK (param $tos i32) (result i32)
@@ -2171,8 +2852,8 @@
       (i32.load (i32.sub (local.get $tos) (i32.const 8))))
     (i32.store (i32.sub (local.get $tos) (i32.const 8)) (local.get $v))
     (i32.add (local.get $tos) (i32.const 4)))
-  (data (i32.const 0x209e0) "\d0\09\02\00" "\04" "TUCK   " "\af\00\00\00")
-  (elem (i32.const 0xaf) $TUCK)
+  (data (i32.const 0x3bbd4) "\c4\bb\03\00" "\04" "TUCK   " "\c2\00\00\00")
+  (elem (i32.const 0xc2) $TUCK)
 
   ;; [6.1.2310](https://forth-standard.org/standard/core/TYPE)
   (func $TYPE (param $tos i32) (result i32)
@@ -2182,16 +2863,15 @@
     (local.set $len (call $pop))
     (local.set $p (call $pop))
     (call $type (local.get $p) (local.get $len)))
-  (data (i32.const 0x209f0) "\e0\09\02\00" "\04" "TYPE   " "\b0\00\00\00")
-  (elem (i32.const 0xb0) $TYPE)
+  (data (i32.const 0x3bbe4) "\d4\bb\03\00" "\04" "TYPE   " "\c3\00\00\00")
+  (elem (i32.const 0xc3) $TYPE)
 
   ;; [6.1.2320](https://forth-standard.org/standard/core/Ud)
   (func $U. (param $tos i32) (result i32)
     (local.get $tos)
-    (call $U._ (call $pop) (i32.load (i32.const 0x2040c (; = body(BASE) ;))))
-    (call $shell_emit (i32.const 0x20)))
-  (data (i32.const 0x20a00) "\f0\09\02\00" "\02" "U. " "\b1\00\00\00")
-  (elem (i32.const 0xb1) $U.)
+    (call $U._ (call $pop) (i32.const 0)))
+  (data (i32.const 0x3bbf4) "\e4\bb\03\00" "\02" "U. " "\c4\00\00\00")
+  (elem (i32.const 0xc4) $U.)
 
   ;; [6.1.2340](https://forth-standard.org/standard/core/Uless)
   (func $U< (param $tos i32) (result i32)
@@ -2202,8 +2882,8 @@
       (then (i32.store (local.get $bbtos) (i32.const -1)))
       (else (i32.store (local.get $bbtos) (i32.const 0))))
     (local.get $btos))
-  (data (i32.const 0x20a0c) "\00\0a\02\00" "\02" "U< " "\b2\00\00\00")
-  (elem (i32.const 0xb2) $U<)
+  (data (i32.const 0x3bc00) "\f4\bb\03\00" "\02" "U< " "\c5\00\00\00")
+  (elem (i32.const 0xc5) $U<)
 
   ;; [6.2.2350](https://forth-standard.org/standard/core/Umore)
   (func $U> (param $tos i32) (result i32)
@@ -2214,8 +2894,8 @@
       (then (i32.store (local.get $bbtos) (i32.const -1)))
       (else (i32.store (local.get $bbtos) (i32.const 0))))
     (local.get $btos))
-  (data (i32.const 0x20a18) "\0c\0a\02\00" "\02" "U> " "\b3\00\00\00")
-  (elem (i32.const 0xb3) $U>)
+  (data (i32.const 0x3bc0c) "\00\bc\03\00" "\02" "U> " "\c6\00\00\00")
+  (elem (i32.const 0xc6) $U>)
 
   ;; [6.1.2360](https://forth-standard.org/standard/core/UMTimes)
   (func $UM* (param $tos i32) (result i32)
@@ -2225,8 +2905,8 @@
                         (i64.extend_i32_u (i32.load (i32.sub (local.get $tos)
                                                               (i32.const 4))))))
     (local.get $tos))
-  (data (i32.const 0x20a24) "\18\0a\02\00" "\03" "UM*" "\b4\00\00\00")
-  (elem (i32.const 0xb4) $UM*)
+  (data (i32.const 0x3bc18) "\0c\bc\03\00" "\03" "UM*" "\c7\00\00\00")
+  (elem (i32.const 0xc7) $UM*)
 
   ;; [6.1.2370](https://forth-standard.org/standard/core/UMDivMOD)
   (func $UM/MOD (param $tos i32) (result i32)
@@ -2245,50 +2925,224 @@
       (i32.wrap_i64
         (i64.div_u (local.get $n1) (local.get $n2))))
     (local.get $btos))
-  (data (i32.const 0x20a30) "\24\0a\02\00" "\06" "UM/MOD " "\b5\00\00\00")
-  (elem (i32.const 0xb5) $UM/MOD)
+  (data (i32.const 0x3bc24) "\18\bc\03\00" "\06" "UM/MOD " "\c8\00\00\00")
+  (elem (i32.const 0xc8) $UM/MOD)
 
   ;; [6.1.2380](https://forth-standard.org/standard/core/UNLOOP)
   (func $UNLOOP (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
-    (call $compileCall (i32.const 0) (i32.const 0x9 (; = END_DO_INDEX ;))))
-  (data (i32.const 0x20a40) "\30\0a\02\00" "\86" (; F_IMMEDIATE ;) "UNLOOP " "\b6\00\00\00")
-  (elem (i32.const 0xb6) $UNLOOP)
+    (call $compileCall (i32.const 0) (i32.const 0x9 (; = END_DO_INDEX ;)))
+    (global.set $unloops (i32.add (global.get $unloops) (i32.const 1))))
+  (data (i32.const 0x3bc34) "\24\bc\03\00" "\86" (; F_IMMEDIATE ;) "UNLOOP " "\c9\00\00\00")
+  (elem (i32.const 0xc9) $UNLOOP)
 
   ;; [6.1.2390](https://forth-standard.org/standard/core/UNTIL)
   (func $UNTIL (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileUntil))
-  (data (i32.const 0x20a50) "\40\0a\02\00" "\85" (; F_IMMEDIATE ;) "UNTIL  " "\b7\00\00\00")
-  (elem (i32.const 0xb7) $UNTIL)
+  (data (i32.const 0x3bc44) "\34\bc\03\00" "\85" (; F_IMMEDIATE ;) "UNTIL  " "\ca\00\00\00")
+  (elem (i32.const 0xca) $UNTIL)
 
   ;; [6.2.2395](https://forth-standard.org/standard/core/UNUSED)
   (func $UNUSED (param $tos i32) (result i32)
     (local.get $tos)
-    (call $push (i32.sub (i32.const 0x6400000 (; = MEMORY_SIZE ;)) (global.get $here))))
-  (data (i32.const 0x20a60) "\50\0a\02\00" "\06" "UNUSED " "\b8\00\00\00")
-  (elem (i32.const 0xb8) $UNUSED)
+    (call $push (i32.sub (call $dataSpaceEnd) (global.get $here))))
+  (data (i32.const 0x3bc54) "\44\bc\03\00" "\06" "UNUSED " "\cb\00\00\00")
+  (elem (i32.const 0xcb) $UNUSED)
+
+  ;; Creates a task-local variable. Executing name pushes the address of the
+  ;; variable in the user area of the current task.
+  ;; ( "<spaces>name" -- )
+  (func $USER (param $tos i32) (result i32)
+    (local $offset i32)
+    (if (i32.ge_u (local.tee $offset (i32.load (i32.const 0x30894 (; = NEXT_USER_OFFSET_BASE ;))))
+                  (i32.const 0x80 (; = USER_AREA_SIZE ;)))
+      (then (call $fail (i32.const -0x8 (; = EXC_DICTIONARY_OVERFLOW ;)) (i32.const 0x3b0a6 (; = str("out of memory") ;)))))
+    (local.get $tos)
+    (call $CREATE)
+    (i32.store (i32.sub (global.get $here) (i32.const 4)) (i32.const 0xb (; = USER_ADDRESS_INDEX ;)))
+    (i32.store (global.get $here) (i32.add (local.get $offset) (i32.const 0x14 (; = TCB_USER ;))))
+    (call $setHere (i32.add (global.get $here) (i32.const 4)))
+    (i32.store (i32.const 0x30894 (; = NEXT_USER_OFFSET_BASE ;)) (i32.add (local.get $offset) (i32.const 4))))
+  (data (i32.const 0x3bc64) "\54\bc\03\00" "\04" "USER   " "\cc\00\00\00")
+  (elem (i32.const 0xcc) $USER)
+
+  ;; Stores the element-wise product of the u cells at a-addr1 and a-addr2 at
+  ;; a-addr3.
+  ;; ( a-addr1 a-addr2 a-addr3 u -- )
+  (func $V* (param $tos i32) (result i32)
+    (local $bbbbtos i32)
+    (call $vectorMul
+      (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 12)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbbtos))
+  (data (i32.const 0x3bc74) "\64\bc\03\00" "\02" "V* " "\cd\00\00\00")
+  (elem (i32.const 0xcd) $V*)
+
+  ;; Stores the element-wise sum of the u cells at a-addr1 and a-addr2 at
+  ;; a-addr3.
+  ;; ( a-addr1 a-addr2 a-addr3 u -- )
+  (func $V+ (param $tos i32) (result i32)
+    (local $bbbbtos i32)
+    (call $vectorAdd
+      (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 12)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbbtos))
+  (data (i32.const 0x3bc80) "\74\bc\03\00" "\02" "V+ " "\ce\00\00\00")
+  (elem (i32.const 0xce) $V+)
 
   ;; [6.2.2405](https://forth-standard.org/standard/core/VALUE)
-  (data (i32.const 0x20a70) "\60\0a\02\00" "\05" "VALUE  " "\5e\00\00\00" (; = pack(index("CONSTANT")) ;))
+  (data (i32.const 0x3bc8c) "\80\bc\03\00" "\05" "VALUE  " "\64\00\00\00" (; = pack(index("CONSTANT")) ;))
+
+  ;; Stores the element-wise bitwise and of the u cells at a-addr1 and a-addr2 at
+  ;; a-addr3.
+  ;; ( a-addr1 a-addr2 a-addr3 u -- )
+  (func $VAND (param $tos i32) (result i32)
+    (local $bbbbtos i32)
+    (call $vectorAnd
+      (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 12)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbbtos))
+  (data (i32.const 0x3bc9c) "\8c\bc\03\00" "\04" "VAND   " "\cf\00\00\00")
+  (elem (i32.const 0xcf) $VAND)
 
   ;; [6.1.2410](https://forth-standard.org/standard/core/VARIABLE)
   (func $VARIABLE (param $tos i32) (result i32)
     (local.get $tos)
     (call $CREATE)
-    (global.set $here (i32.add (global.get $here) (i32.const 4))))
-  (data (i32.const 0x20a80) "\70\0a\02\00" "\08" "VARIABLE   " "\b9\00\00\00")
-  (elem (i32.const 0xb9) $VARIABLE)
+    (call $setHere (i32.add (global.get $here) (i32.const 4))))
+  (data (i32.const 0x3bcac) "\9c\bc\03\00" "\08" "VARIABLE   " "\d0\00\00\00")
+  (elem (i32.const 0xd0) $VARIABLE)
+
+  ;; Returns the sum of the products of the u cells at a-addr1 and a-addr2.
+  ;; ( a-addr1 a-addr2 u -- n )
+  (func $VDOT (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (i32.store (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12)))
+      (call $vectorDot
+        (i32.load (local.get $bbbtos))
+        (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+        (i32.load (i32.sub (local.get $tos) (i32.const 4)))))
+    (i32.sub (local.get $tos) (i32.const 8)))
+  (data (i32.const 0x3bcc0) "\ac\bc\03\00" "\04" "VDOT   " "\d1\00\00\00")
+  (elem (i32.const 0xd1) $VDOT)
+
+  ;; Stores x in the u cells at a-addr.
+  ;; ( x a-addr u -- )
+  (func $VFILL (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (call $vectorFill
+      (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbtos))
+  (data (i32.const 0x3bcd0) "\c0\bc\03\00" "\05" "VFILL  " "\d2\00\00\00")
+  (elem (i32.const 0xd2) $VFILL)
+
+  ;; Adds the number of occurrences of each character in the u characters at
+  ;; c-addr to the corresponding cell of the 256-cell array at a-addr.
+  ;; ( c-addr u a-addr -- )
+  (func $VHISTOGRAM (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (local $p i32)
+    (local $end i32)
+    (local $counts i32)
+    (local $slot i32)
+    (local.set $p (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12)))))
+    (local.set $end (i32.add (local.get $p) (i32.load (i32.sub (local.get $tos) (i32.const 8)))))
+    (local.set $counts (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_u (local.get $p) (local.get $end)))
+        (i32.store
+          (local.tee $slot
+            (i32.add (local.get $counts) (i32.shl (i32.load8_u (local.get $p)) (i32.const 2))))
+          (i32.add (i32.load (local.get $slot)) (i32.const 1)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $loop)))
+    (local.get $bbbtos))
+  (data (i32.const 0x3bce0) "\d0\bc\03\00" "\0a" "VHISTOGRAM " "\d3\00\00\00")
+  (elem (i32.const 0xd3) $VHISTOGRAM)
+
+  ;; Returns the largest of the u cells at a-addr (or the smallest number if u
+  ;; is 0).
+  ;; ( a-addr u -- n )
+  (func $VMAX (param $tos i32) (result i32)
+    (local $bbtos i32)
+    (i32.store (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))
+      (call $vectorMax
+        (i32.load (local.get $bbtos))
+        (i32.load (i32.sub (local.get $tos) (i32.const 4)))))
+    (i32.sub (local.get $tos) (i32.const 4)))
+  (data (i32.const 0x3bcf4) "\e0\bc\03\00" "\04" "VMAX   " "\d4\00\00\00")
+  (elem (i32.const 0xd4) $VMAX)
+
+  ;; Returns the smallest of the u cells at a-addr (or the largest number if u
+  ;; is 0).
+  ;; ( a-addr u -- n )
+  (func $VMIN (param $tos i32) (result i32)
+    (local $bbtos i32)
+    (i32.store (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))
+      (call $vectorMin
+        (i32.load (local.get $bbtos))
+        (i32.load (i32.sub (local.get $tos) (i32.const 4)))))
+    (i32.sub (local.get $tos) (i32.const 4)))
+  (data (i32.const 0x3bd04) "\f4\bc\03\00" "\04" "VMIN   " "\d5\00\00\00")
+  (elem (i32.const 0xd5) $VMIN)
+
+  ;; Stores the element-wise bitwise or of the u cells at a-addr1 and a-addr2 at
+  ;; a-addr3.
+  ;; ( a-addr1 a-addr2 a-addr3 u -- )
+  (func $VOR (param $tos i32) (result i32)
+    (local $bbbbtos i32)
+    (call $vectorOr
+      (i32.load (local.tee $bbbbtos (i32.sub (local.get $tos) (i32.const 16))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 12)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbbtos))
+  (data (i32.const 0x3bd14) "\04\bd\03\00" "\03" "VOR" "\d6\00\00\00")
+  (elem (i32.const 0xd6) $VOR)
+
+  ;; Stores the running sums of the u cells at a-addr1 at a-addr2.
+  ;; ( a-addr1 a-addr2 u -- )
+  (func $VPREFIX (param $tos i32) (result i32)
+    (local $bbbtos i32)
+    (call $vectorPrefix
+      (i32.load (local.tee $bbbtos (i32.sub (local.get $tos) (i32.const 12))))
+      (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+      (i32.load (i32.sub (local.get $tos) (i32.const 4))))
+    (local.get $bbbtos))
+  (data (i32.const 0x3bd20) "\14\bd\03\00" "\07" "VPREFIX" "\d7\00\00\00")
+  (elem (i32.const 0xd7) $VPREFIX)
+
+  ;; Returns the sum of the u cells at a-addr.
+  ;; ( a-addr u -- n )
+  (func $VSUM (param $tos i32) (result i32)
+    (local $bbtos i32)
+    (i32.store (local.tee $bbtos (i32.sub (local.get $tos) (i32.const 8)))
+      (call $vectorSum
+        (i32.load (local.get $bbtos))
+        (i32.load (i32.sub (local.get $tos) (i32.const 4)))))
+    (i32.sub (local.get $tos) (i32.const 4)))
+  (data (i32.const 0x3bd30) "\20\bd\03\00" "\04" "VSUM   " "\d8\00\00\00")
+  (elem (i32.const 0xd8) $VSUM)
 
   ;; [6.1.2430](https://forth-standard.org/standard/core/WHILE)
   (func $WHILE (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
     (call $compileWhile))
-  (data (i32.const 0x20a94) "\80\0a\02\00" "\85" (; F_IMMEDIATE ;) "WHILE  " "\ba\00\00\00")
-  (elem (i32.const 0xba) $WHILE)
+  (data (i32.const 0x3bd40) "\30\bd\03\00" "\85" (; F_IMMEDIATE ;) "WHILE  " "\d9\00\00\00")
+  (elem (i32.const 0xd9) $WHILE)
 
   ;; [6.2.2440](https://forth-standard.org/standard/core/WITHIN)
   (func $WITHIN (param $tos i32) (result i32)
@@ -2309,8 +3163,8 @@
         (else
           (i32.const 0))))
     (local.get $bbtos))
-  (data (i32.const 0x20aa4) "\94\0a\02\00" "\06" "WITHIN " "\bb\00\00\00")
-  (elem (i32.const 0xbb) $WITHIN)
+  (data (i32.const 0x3bd50) "\40\bd\03\00" "\06" "WITHIN " "\da\00\00\00")
+  (elem (i32.const 0xda) $WITHIN)
 
   ;; [6.1.2450](https://forth-standard.org/standard/core/WORD)
   (func $WORD (param $tos i32) (result i32)
@@ -2330,8 +3184,8 @@
       (local.get $len))
     (i32.store8 (local.get $wordBase) (local.get $len))
     (call $push (local.get $wordBase)))
-  (data (i32.const 0x20ab4) "\a4\0a\02\00" "\04" "WORD   " "\bc\00\00\00")
-  (elem (i32.const 0xbc) $WORD)
+  (data (i32.const 0x3bd60) "\50\bd\03\00" "\04" "WORD   " "\db\00\00\00")
+  (elem (i32.const 0xdb) $WORD)
 
   ;; 15.6.1.2465
   (func $WORDS (param $tos i32) (result i32)
@@ -2352,8 +3206,8 @@
       (local.set $entryP (i32.load (local.get $entryP)))
       (br_if $loop (local.get $entryP)))
     (local.get $tos))
-  (data (i32.const 0x20ac4) "\b4\0a\02\00" "\05" "WORDS  " "\bd\00\00\00")
-  (elem (i32.const 0xbd) $WORDS)
+  (data (i32.const 0x3bd70) "\60\bd\03\00" "\05" "WORDS  " "\dc\00\00\00")
+  (elem (i32.const 0xdc) $WORDS)
 
   ;; [6.1.2490](https://forth-standard.org/standard/core/XOR)
   (func $XOR (param $tos i32) (result i32)
@@ -2363,16 +3217,16 @@
                 (i32.xor (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4))))
                         (i32.load (local.get $bbtos))))
     (local.get $btos))
-  (data (i32.const 0x20ad4) "\c4\0a\02\00" "\03" "XOR" "\be\00\00\00")
-  (elem (i32.const 0xbe) $XOR)
+  (data (i32.const 0x3bd80) "\70\bd\03\00" "\03" "XOR" "\dd\00\00\00")
+  (elem (i32.const 0xdd) $XOR)
 
   ;; [6.1.2500](https://forth-standard.org/standard/core/Bracket)
   (func $left-bracket (param $tos i32) (result i32)
     (local.get $tos)
     (call $ensureCompiling)
-    (i32.store (i32.const 0x209a0 (; = body(STATE) ;)) (i32.const 0)))
-  (data (i32.const 0x20ae0) "\d4\0a\02\00" "\81" (; F_IMMEDIATE ;) "[  " "\bf\00\00\00")
-  (elem (i32.const 0xbf) $left-bracket)
+    (i32.store (i32.const 0x3bb64 (; = body(STATE) ;)) (i32.const 0)))
+  (data (i32.const 0x3bd8c) "\80\bd\03\00" "\81" (; F_IMMEDIATE ;) "[  " "\de\00\00\00")
+  (elem (i32.const 0xde) $left-bracket)
 
   ;; [6.1.2510](https://forth-standard.org/standard/core/BracketTick)
   (func $bracket-tick (param $tos i32) (result i32)
@@ -2380,8 +3234,8 @@
     (call $ensureCompiling)
     (call $')
     (call $compilePushConst (call $pop)))
-  (data (i32.const 0x20aec) "\e0\0a\02\00" "\83" (; F_IMMEDIATE ;) "[']" "\c0\00\00\00")
-  (elem (i32.const 0xc0) $bracket-tick)
+  (data (i32.const 0x3bd98) "\8c\bd\03\00" "\83" (; F_IMMEDIATE ;) "[']" "\df\00\00\00")
+  (elem (i32.const 0xdf) $bracket-tick)
 
   ;; [6.1.2520](https://forth-standard.org/standard/core/BracketCHAR)
   (func $bracket-char (param $tos i32) (result i32)
@@ -2389,22 +3243,23 @@
     (call $ensureCompiling)
     (call $CHAR)
     (call $compilePushConst (call $pop)))
-  (data (i32.const 0x20af8) "\ec\0a\02\00" "\86" (; F_IMMEDIATE ;) "[CHAR] " "\c1\00\00\00")
-  (elem (i32.const 0xc1) $bracket-char)
+  (data (i32.const 0x3bda4) "\98\bd\03\00" "\86" (; F_IMMEDIATE ;) "[CHAR] " "\e0\00\00\00")
+  (elem (i32.const 0xe0) $bracket-char)
 
   ;; [6.2.2535](https://forth-standard.org/standard/core/bs)
   (func $\ (param $tos i32) (result i32)
     (drop (drop (call $parse (i32.const 0x0a (; '\n' ;)))))
     (local.get $tos))
-  (data (i32.const 0x20b08) "\f8\0a\02\00" "\81" (; F_IMMEDIATE ;) "\5c  " "\c2\00\00\00")
-  (elem (i32.const 0xc2) $\)
+  (data (i32.const 0x3bdb4) "\a4\bd\03\00" "\81" (; F_IMMEDIATE ;) "\5c  " "\e1\00\00\00")
+  (elem (i32.const 0xe1) $\)
 
   ;; [6.1.2540](https://forth-standard.org/standard/right-bracket)
   (func $right-bracket (param $tos i32) (result i32)
-    (i32.store (i32.const 0x209a0 (; = body(STATE) ;)) (i32.const 1))
+    (call $checkMainThread)
+    (i32.store (i32.const 0x3bb64 (; = body(STATE) ;)) (i32.const 1))
     (local.get $tos))
-  (data (i32.const 0x20b14) "\08\0b\02\00" "\01" "]  " "\c3\00\00\00")
-  (elem (i32.const 0xc3) $right-bracket)
+  (data (i32.const 0x3bdc0) "\b4\bd\03\00" "\01" "]  " "\e2\00\00\00")
+  (elem (i32.const 0xe2) $right-bracket)
 
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Interpreter state
@@ -2424,9 +3279,9 @@
   (global $sourceID (mut i32) (i32.const 0))
 
   ;; Dictionary pointers
-  (global $latest (mut i32) (i32.const 0x20b14))
-  (global $here (mut i32) (i32.const 0x20b20))
-  (global $nextTableIndex (mut i32) (i32.const 0xc4))
+  (global $latest (mut i32) (i32.const 0x3bdc0))
+  (global $here (mut i32) (i32.const 0x3bdcc))
+  (global $nextTableIndex (mut i32) (i32.const 0xe3))
 
   ;; Pictured output pointer
   (global $po (mut i32) (i32.const -1))
@@ -2443,6 +3298,12 @@
   ;;   ERR_BYE :=     0x5   (BYE called)
   (global $error (mut i32) (i32.const 0x0))
 
+  ;; Number of active CATCH frames
+  (global $catchDepth (mut i32) (i32.const 0x0))
+
+  ;; Current task (see Scheduler)
+  (global $up (mut i32) (i32.const 0x30800 (; = OPERATOR_BASE ;)))
+
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Compiler functions
   ;;
@@ -2459,7 +3320,7 @@
     (local $nameLen i32)
     (local.set $nameAddr (local.set $nameLen (call $parseName)))
     (if (i32.eqz (local.get $nameLen))
-      (then (call $fail (i32.const 0x2001d (; = str("incomplete input") ;)))))
+      (then (call $fail (i32.const -0x10 (; = EXC_ZERO_LENGTH_NAME ;)) (i32.const 0x3b01d (; = str("incomplete input") ;)))))
     (call $create
       (local.get $nameAddr)
       (local.get $nameLen)
@@ -2476,39 +3337,39 @@
   ;; Parameter indicates the type of code we're compiling: type 0 (no params),
   ;; or type 1 (1 param)
   (func $startColon (param $type i32)
-    (i32.store8 (i32.const 0x1041 (; = MODULE_HEADER_FUNCTION_TYPE_BASE ;)) (local.get $type))
-    (global.set $cp (i32.const 0x105e (; = MODULE_BODY_BASE ;)))
+    (call $checkMainThread)
+    (i32.store8 (i32.const 0x20041 (; = MODULE_HEADER_FUNCTION_TYPE_BASE ;)) (local.get $type))
+    (global.set $cp (i32.const 0x2005e (; = MODULE_BODY_BASE ;)))
     (global.set $firstTemporaryLocal (i32.add (local.get $type) (i32.const 1)))
-    ;; 1 temporary local for computations
-    (global.set $currentLocal (global.get $firstTemporaryLocal))
-    (global.set $lastLocal (global.get $currentLocal))
+    ;; 1 temporary local for computations, followed by the stack cache locals
+    (global.set $currentLocal (i32.add (global.get $firstTemporaryLocal)
+                                       (i32.const 0xa (; = STACK_CACHE_LOCALS ;))))
+    (global.set $lastLocal (global.get $firstTemporaryLocal))
     (global.set $branchNesting (i32.const 0))
-    (global.set $lastEmitWasGetTOS (i32.const 0)))
+    (global.set $lastEmitWasGetTOS (i32.const 0))
+    (global.set $cacheCount (i32.const 0))
+    (global.set $unloops (i32.const 0))
+    (global.set $recurseChain (i32.const 0)))
 
   (func $endColon
     (local $bodySize i32)
     (local $nameLength i32)
+    (local $entryP i32)
 
+    (call $compileSpill)
     (call $emitEnd)
 
-    ;; Update code size
-    (local.set $bodySize (i32.sub (global.get $cp) (i32.const 0x1000 (; = MODULE_HEADER_BASE ;))))
-    (i32.store
-      (i32.const 0x104f (; = MODULE_HEADER_CODE_SIZE_BASE ;))
-      (call $leb128-4p
-          (i32.sub (local.get $bodySize)
-                  (i32.const 0x53 (; = MODULE_HEADER_CODE_SIZE_OFFSET_PLUS_4 ;)))))
-
     ;; Update body size
+    (local.set $bodySize (i32.sub (global.get $cp) (i32.const 0x20000 (; = MODULE_HEADER_BASE ;))))
     (i32.store
-      (i32.const 0x1054 (; = MODULE_HEADER_BODY_SIZE_BASE ;))
+      (i32.const 0x20054 (; = MODULE_HEADER_BODY_SIZE_BASE ;))
       (call $leb128-4p
           (i32.sub (local.get $bodySize)
                   (i32.const 0x58 (; = MODULE_HEADER_BODY_SIZE_OFFSET_PLUS_4 ;)))))
 
     ;; Update #locals
     (i32.store
-      (i32.const 0x1059 (; = MODULE_HEADER_LOCAL_COUNT_BASE ;))
+      (i32.const 0x20059 (; = MODULE_HEADER_LOCAL_COUNT_BASE ;))
       (call $leb128-4p
         (i32.add
           (i32.sub
@@ -2516,30 +3377,101 @@
             (global.get $firstTemporaryLocal))
           (i32.const 1))))
 
+    ;; Name the function (if we're ending the code for the current dictionary entry)
+    (if (i32.eq
+          (i32.load (call $body (global.get $latest)))
+          (global.get $nextTableIndex))
+      (then
+        (local.set $entryP (global.get $latest))
+        (local.set $nameLength (i32.and (i32.load8_u (i32.add (global.get $latest) (i32.const 4)))
+                                        (i32.const 0x1f (; = LENGTH_MASK ;))))))
+
+    ;; Reserve the table slot
+    (if (i32.ge_u (global.get $nextTableIndex) (table.size 0))
+      (then (drop (table.grow 0 (ref.func $!) (table.size 0))))) ;; Double size
+
+    ;; A function that doesn't fit in a batch on its own is loaded in a
+    ;; module of its own, after the pending code.
+    (local.set $bodySize (i32.sub (global.get $cp) (i32.const 0x20054 (; = MODULE_HEADER_BODY_SIZE_BASE ;))))
+    (if (i32.gt_u
+          (i32.add (local.get $bodySize) (i32.add (local.get $nameLength) (i32.const 2)))
+          (i32.const 0xe00 (; = BATCH_MAX_CODE_SIZE ;)))
+      (then
+        (call $flushCode)
+        (call $patchRecurse (i32.const 0))
+        (call $loadModule (local.get $entryP))
+        (global.set $nextTableIndex (i32.add (global.get $nextTableIndex) (i32.const 1)))
+        (return)))
+
+    ;; Load the pending code first if this function doesn't fit in the batch
+    (if (i32.or
+          (i32.eq (global.get $batchCount) (i32.const 0x40 (; = BATCH_MAX_FUNCTIONS ;)))
+          (i32.gt_u
+            (i32.add
+              (i32.add
+                (i32.sub (global.get $batchCp) (i32.const 0x31300 (; = BATCH_CODE_BASE ;)))
+                (local.get $bodySize))
+              (i32.add
+                (global.get $batchNamesSize)
+                (i32.add (local.get $nameLength) (i32.const 2))))
+            (i32.const 0xe00 (; = BATCH_MAX_CODE_SIZE ;))))
+      (then (call $flushCode)))
+    (call $patchRecurse (global.get $batchCount))
+
+    ;; Add the function to the batch
+    (i32.store
+      (i32.add (i32.const 0x31000 (; = BATCH_FUNCTIONS_BASE ;))
+               (i32.shl (global.get $batchCount) (i32.const 3)))
+      (i32.load8_u (i32.const 0x20041 (; = MODULE_HEADER_FUNCTION_TYPE_BASE ;))))
+    (i32.store
+      (i32.add (i32.const 0x31004 (; = BATCH_FUNCTIONS_BASE + 4 ;))
+               (i32.shl (global.get $batchCount) (i32.const 3)))
+      (local.get $entryP))
+    (memory.copy
+      (global.get $batchCp)
+      (i32.const 0x20054 (; = MODULE_HEADER_BODY_SIZE_BASE ;))
+      (local.get $bodySize))
+    (global.set $batchCp (i32.add (global.get $batchCp) (local.get $bodySize)))
+    (if (local.get $entryP)
+      (then
+        (global.set $batchNamesSize
+          (i32.add (global.get $batchNamesSize)
+                   (i32.add (local.get $nameLength) (i32.const 2))))))
+    (global.set $batchCount (i32.add (global.get $batchCount) (i32.const 1)))
+
+    (global.set $nextTableIndex (i32.add (global.get $nextTableIndex) (i32.const 1))))
+
+  ;; Loads the compiled function as a module on its own, with the name of the
+  ;; given dictionary entry (if any)
+  (func $loadModule (param $entryP i32)
+    (local $nameLength i32)
+
+    ;; Update code size
+    (i32.store
+      (i32.const 0x2004f (; = MODULE_HEADER_CODE_SIZE_BASE ;))
+      (call $leb128-4p
+          (i32.sub (i32.sub (global.get $cp) (i32.const 0x20000 (; = MODULE_HEADER_BASE ;)))
+                  (i32.const 0x53 (; = MODULE_HEADER_CODE_SIZE_OFFSET_PLUS_4 ;)))))
+
     ;; Update table offset
     (i32.store
-      (i32.const 0x1047 (; = MODULE_HEADER_TABLE_INDEX_BASE ;))
+      (i32.const 0x20047 (; = MODULE_HEADER_TABLE_INDEX_BASE ;))
       (call $leb128-4p (global.get $nextTableIndex)))
     ;; Also store the initial table size to satisfy other tools (e.g. wasm-as)
     (i32.store
-      (i32.const 0x102c (; = MODULE_HEADER_TABLE_INITIAL_SIZE_BASE ;))
+      (i32.const 0x2002c (; = MODULE_HEADER_TABLE_INITIAL_SIZE_BASE ;))
       (call $leb128-4p (i32.add (global.get $nextTableIndex) (i32.const 1))))
 
-    ;; Write a name section (if we're ending the code for the current dictionary entry)
-    (if (i32.eq
-          (i32.load (call $body (global.get $latest)))
-          (global.get $nextTableIndex))
+    ;; Write a name section
+    (if (local.get $entryP)
       (then
-        (local.set $nameLength (i32.and (i32.load8_u (i32.add (global.get $latest) (i32.const 4)))
+        (local.set $nameLength (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
                                         (i32.const 0x1f (; = LENGTH_MASK ;))))
         (i32.store8 (global.get $cp) (i32.const 0))
         (i32.store8 (i32.add (global.get $cp) (i32.const 1))
                     (i32.add (i32.const 13) (i32.mul (i32.const 2) (local.get $nameLength))))
         (i32.store8 (i32.add (global.get $cp) (i32.const 2)) (i32.const 0x04))
-        (i32.store8 (i32.add (global.get $cp) (i32.const 3)) (i32.const 0x6e))
-        (i32.store8 (i32.add (global.get $cp) (i32.const 4)) (i32.const 0x61))
-        (i32.store8 (i32.add (global.get $cp) (i32.const 5)) (i32.const 0x6d))
-        (i32.store8 (i32.add (global.get $cp) (i32.const 6)) (i32.const 0x65))
+        (i32.store (i32.add (global.get $cp) (i32.const 3)) (i32.const 0x656d616e)) ;; "name"
         (global.set $cp (i32.add (global.get $cp) (i32.const 7)))
 
         (i32.store8 (global.get $cp) (i32.const 0x00))
@@ -2549,7 +3481,7 @@
         (global.set $cp (i32.add (global.get $cp) (i32.const 3)))
         (memory.copy
           (global.get $cp)
-          (i32.add (global.get $latest) (i32.const 5))
+          (i32.add (local.get $entryP) (i32.const 5))
           (local.get $nameLength))
         (global.set $cp (i32.add (global.get $cp) (local.get $nameLength)))
 
@@ -2562,61 +3494,203 @@
         (global.set $cp (i32.add (global.get $cp) (i32.const 5)))
         (memory.copy
           (global.get $cp)
-          (i32.add (global.get $latest) (i32.const 5))
+          (i32.add (local.get $entryP) (i32.const 5))
           (local.get $nameLength))
         (global.set $cp (i32.add (global.get $cp) (local.get $nameLength)))))
 
-    ;; Load the code
-    (if (i32.ge_u (global.get $nextTableIndex) (table.size 0))
-      (then (drop (table.grow 0 (ref.func $!) (table.size 0))))) ;; Double size
     (call $shell_load
-      (i32.const 0x1000 (; = MODULE_HEADER_BASE ;))
-      (i32.sub (global.get $cp) (i32.const 0x1000 (; = MODULE_HEADER_BASE ;))))
-
-    (global.set $nextTableIndex (i32.add (global.get $nextTableIndex) (i32.const 1))))
-
-  (func $compilePushConst (param $n i32)
-    (call $emitSetLocal (i32.const 0)) ;; Save tos currently on operand stack
-    (call $emitGetLocal (i32.const 0)) ;; Put tos on operand stack again
-    (call $emitConst (local.get $n))
-    (call $compilePush))
+      (i32.const 0x20000 (; = MODULE_HEADER_BASE ;))
+      (i32.sub (global.get $cp) (i32.const 0x20000 (; = MODULE_HEADER_BASE ;)))))
 
-  (func $compilePushLocal (param $n i32)
-    (call $emitSetLocal (i32.const 0)) ;; Save tos currently on operand stack
-    (call $emitGetLocal (i32.const 0)) ;; Put tos on operand stack again
-    (call $emitGetLocal (local.get $n))
-    (call $compilePush))
+  ;; Batched loading
+  ;;
+  ;; Instead of loading every compiled word as a separate module, the function
+  ;; bodies of consecutive words are collected, and loaded together as a single
+  ;; module. The table slots of the pending functions are reserved up front, so
+  ;; execution tokens don't change when the code is loaded.
+  ;;
+  ;; The batch is loaded when it is full, before executing a word whose code is
+  ;; still pending, at the end of the input, and by FLUSH-CODE.
+  ;;
+  ;; Per pending function, the batch keeps its type and the dictionary entry
+  ;; to take the name from (or 0). The module header is written right before
+  ;; the function bodies when the batch is loaded. Functions that are too large
+  ;; for a batch are loaded on their own (see `loadModule`).
+  ;;
+  ;;   BATCH_FUNCTIONS_BASE := 0x31000  (BATCH_BASE)
+  ;;   BATCH_CODE_BASE := 0x31300       (BATCH_BASE + 0x300)
+  ;;   BATCH_MAX_FUNCTIONS := 0x40
+  ;;   BATCH_MAX_CODE_SIZE := 0xe00     (0x1000 - room for the header and name section)
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 
-  (func $compilePush
-    (call $emitStore)
-    (call $emitGetLocal (i32.const 0)) ;; Put $tos+4 on operand stack
-    (call $emitConst (i32.const 4))
-    (call $emitAdd))
+  (func $flushCode
+    (local $n i32)
+    (local $i i32)
+    (local $p i32)
+    (local $start i32)
+    (local $hp i32)
+    (local $namesP i32)
+    (local $entryP i32)
+    (local $nameLength i32)
+    (local $named i32)
+    (if (i32.eqz (local.tee $n (global.get $batchCount)))
+      (then (return)))
 
-  (func $compileIf
-    (call $compilePop)
+    ;; Name section
+    (local.set $p (global.get $batchCp))
+    (if (global.get $batchNamesSize)
+      (then
+        (local.set $namesP (local.get $p))
+        (i32.store8 (local.get $p) (i32.const 0x00))
+        (i32.store8 (i32.add (local.get $p) (i32.const 5)) (i32.const 0x04))
+        (i32.store (i32.add (local.get $p) (i32.const 6)) (i32.const 0x656d616e)) ;; "name"
+        (i32.store8 (i32.add (local.get $p) (i32.const 10)) (i32.const 0x01))
+        (local.set $p (i32.add (local.get $p) (i32.const 16)))
+        (local.set $i (i32.const 0))
+        (block $endLoop
+          (loop $loop
+            (br_if $endLoop (i32.eq (local.get $i) (local.get $n)))
+            (if (local.tee $entryP
+                  (i32.load (i32.add (i32.const 0x31004 (; = BATCH_FUNCTIONS_BASE + 4 ;))
+                                     (i32.shl (local.get $i) (i32.const 3)))))
+              (then
+                (local.set $nameLength (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
+                                                (i32.const 0x1f (; = LENGTH_MASK ;))))
+                (i32.store8 (local.get $p) (local.get $i))
+                (i32.store8 (i32.add (local.get $p) (i32.const 1)) (local.get $nameLength))
+                (memory.copy
+                  (i32.add (local.get $p) (i32.const 2))
+                  (i32.add (local.get $entryP) (i32.const 5))
+                  (local.get $nameLength))
+                (local.set $p (i32.add (local.get $p) (i32.add (local.get $nameLength) (i32.const 2))))
+                (local.set $named (i32.add (local.get $named) (i32.const 1)))))
+            (local.set $i (i32.add (local.get $i) (i32.const 1)))
+            (br $loop)))
+        (i32.store (i32.add (local.get $namesP) (i32.const 1))
+          (call $leb128-4p (i32.sub (local.get $p) (i32.add (local.get $namesP) (i32.const 5)))))
+        (i32.store (i32.add (local.get $namesP) (i32.const 11))
+          (call $leb128-4p (i32.sub (local.get $p) (i32.add (local.get $namesP) (i32.const 15)))))
+        (i32.store8 (i32.add (local.get $namesP) (i32.const 15)) (local.get $named))))
+
+    ;; Header (type and import sections are the same as for a single word)
+    (local.set $start
+      (local.tee $hp
+        (i32.sub (i32.const 0x31300 (; = BATCH_CODE_BASE ;))
+                 (i32.add (i32.const 0x52) (i32.shl (local.get $n) (i32.const 1))))))
+    (memory.copy (local.get $hp) (i32.const 0x20000 (; = MODULE_HEADER_BASE ;)) (i32.const 0x3e))
+    (i32.store
+      (i32.add (local.get $hp) (i32.const 0x2c (; = MODULE_HEADER_TABLE_INITIAL_SIZE_OFFSET ;)))
+      (call $leb128-4p (global.get $nextTableIndex)))
+    (local.set $hp (i32.add (local.get $hp) (i32.const 0x3e)))
+
+    ;; Function section
+    (i32.store8 (local.get $hp) (i32.const 0x03))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 1)) (i32.add (local.get $n) (i32.const 1)))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 2)) (local.get $n))
+    (local.set $hp (i32.add (local.get $hp) (i32.const 3)))
+    (local.set $i (i32.const 0))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $i) (local.get $n)))
+        (i32.store8
+          (i32.add (local.get $hp) (local.get $i))
+          (i32.load (i32.add (i32.const 0x31000 (; = BATCH_FUNCTIONS_BASE ;))
+                             (i32.shl (local.get $i) (i32.const 3)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop)))
+    (local.set $hp (i32.add (local.get $hp) (local.get $n)))
+
+    ;; Element section
+    (i32.store8 (local.get $hp) (i32.const 0x09))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 1)) (i32.add (local.get $n) (i32.const 9)))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 2)) (i32.const 0x01))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 3)) (i32.const 0x00))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 4)) (i32.const 0x41))
+    (i32.store (i32.add (local.get $hp) (i32.const 5))
+      (call $leb128-4p (i32.sub (global.get $nextTableIndex) (local.get $n))))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 9)) (i32.const 0x0b))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 10)) (local.get $n))
+    (local.set $hp (i32.add (local.get $hp) (i32.const 11)))
+    (local.set $i (i32.const 0))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $i) (local.get $n)))
+        (i32.store8 (i32.add (local.get $hp) (local.get $i)) (local.get $i))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop)))
+    (local.set $hp (i32.add (local.get $hp) (local.get $n)))
+
+    ;; Code section
+    (i32.store8 (local.get $hp) (i32.const 0x0a))
+    (i32.store (i32.add (local.get $hp) (i32.const 1))
+      (call $leb128-4p
+        (i32.add (i32.sub (global.get $batchCp) (i32.const 0x31300 (; = BATCH_CODE_BASE ;)))
+                 (i32.const 1))))
+    (i32.store8 (i32.add (local.get $hp) (i32.const 5)) (local.get $n))
+
+    (call $shell_load (local.get $start) (i32.sub (local.get $p) (local.get $start)))
+
+    (global.set $batchCount (i32.const 0))
+    (global.set $batchCp (i32.const 0x31300 (; = BATCH_CODE_BASE ;)))
+    (global.set $batchNamesSize (i32.const 0)))
+
+  ;; Number of functions in the batch
+  (global $batchCount (mut i32) (i32.const 0))
+
+  ;; End of the function bodies in the batch
+  (global $batchCp (mut i32) (i32.const 0x31300 (; = BATCH_CODE_BASE ;)))
+
+  ;; Size of the names of the functions in the batch (+ 2 per name)
+  (global $batchNamesSize (mut i32) (i32.const 0))
+
+  (func $compilePushConst (param $n i32)
+    (call $emitConst (local.get $n))
+    (call $compilePush))
+
+  (func $compilePushLocal (param $n i32)
+    (call $emitGetLocal (local.get $n))
+    (call $compilePush))
+
+  ;; Pushes the value on top of the operand stack onto the stack
+  (func $compilePush
+    (local $l i32)
+    (call $emitSetLocal (local.tee $l (call $allocCacheLocal)))
+    (call $pushCache (local.get $l))
+    (if (i32.gt_u (global.get $cacheCount) (i32.const 0x8 (; = STACK_CACHE_SIZE ;)))
+      (then (call $compileSpill))))
+
+  (func $compileIf
+    (call $compilePop)
     (call $emitIf)
     (global.set $branchNesting (i32.add (global.get $branchNesting) (i32.const 1))))
 
   (func $compileThen (param $tos i32) (result i32)
+    (call $compileSpill)
     (global.set $branchNesting (i32.sub (global.get $branchNesting) (i32.const 1)))
     (call $emitEnd)
     (call $compileEndDests (local.get $tos)))
 
+  ;; Every DO loop uses 3 locals:
+  ;; 1: $slot_i = address of the loop's return stack cell
+  ;; 2: $diff_i = end index - current index
+  ;; 3: $end_i
+  ;;
+  ;; The current index ($diff_i + $end_i) only lives in these locals. It is
+  ;; only stored on the return stack before calling another word (which can
+  ;; look at it through I, J, or the return stack words). If the loop body
+  ;; doesn't call any words, the return stack cell isn't reserved at all.
   (func $compileDo (param $tos i32) (param $cond i32) (result i32)
     ;; Save branch nesting
     (i32.store (local.get $tos) (global.get $branchNesting))
     (local.set $tos (i32.add (local.get $tos) (i32.const 4)))
     (global.set $branchNesting (i32.const 0))
 
-    ;; 1: $diff_i = end index - current index
-    ;; 2: $end_i
-    (global.set $currentLocal (i32.add (global.get $currentLocal) (i32.const 2)))
+    (global.set $currentLocal (i32.add (global.get $currentLocal) (i32.const 3)))
     (if (i32.gt_s (global.get $currentLocal) (global.get $lastLocal))
       (then
         (global.set $lastLocal (global.get $currentLocal))))
 
-    ;; $1 = current index (temporary)
+    ;; $diff_i = current index (temporary)
     (call $compilePop)
     (call $emitSetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
     ;; $end_i = end index
@@ -2634,35 +3708,41 @@
         (call $emitEqual)
         (call $emitBrIf (i32.const 0))))
 
-    ;; startDo $1
-    (call $emitGetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
-    (call $compileCall (i32.const 1) (i32.const 0x1 (; = START_DO_INDEX ;)))
+    ;; Remember the number of calls, and where the return stack cell is
+    ;; reserved, so compileLoopEnd can remove it again if it isn't needed.
+    (i32.store (local.get $tos) (global.get $callCount))
+    (i32.store (i32.add (local.get $tos) (i32.const 4)) (global.get $cp))
 
-    ;; $diff = $1 - $end_i
+    ;; $slot_i = startDo
+    (call $emitConst (i32.const 0x1 (; = START_DO_INDEX ;)))
+    (call $emit2 (i32.const 0x11) (i32.const 0x2) (i32.const 0x0))
+    (call $emitSetLocal (i32.sub (global.get $currentLocal) (i32.const 2)))
+
+    (i32.store (i32.add (local.get $tos) (i32.const 8)) (global.get $cp))
+    (local.set $tos (i32.add (local.get $tos) (i32.const 12)))
+
+    ;; $diff_i = $diff_i - $end_i
     (call $emitGetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
     (call $emitGetLocal (global.get $currentLocal))
     (call $emitSub)
     (call $emitSetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
 
+    ;; Block to LEAVE to
+    (call $emitBlock)
     (call $emitLoop)
+    (call $compileBurnFuel)
     (local.get $tos))
 
   (func $compileLoop (param $tos i32) (result i32)
+    (call $compileSpill)
+
     ;; $diff = $diff + 1
     (call $emitConst (i32.const 1))
     (call $emitGetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
     (call $emitAdd)
     (call $emitTeeLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
 
-    ;; updateDo $diff + $end_i
-    (call $emitGetLocal (global.get $currentLocal))
-    (call $emitAdd)
-    (call $compileCall (i32.const 1) (i32.const 0x2 (; = UPDATE_DO_INDEX ;)))
-
     ;; loop if $diff != 0
-    (call $emitGetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
-    (call $emitConst (i32.const 0))
-    (call $emitNotEqual)
     (call $emitBrIf (i32.const 0))
 
     (call $compileLoopEnd (local.get $tos)))
@@ -2678,13 +3758,7 @@
     (call $emitAdd)
     (call $emitTeeLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
 
-    ;; updateDo $diff + $end_i
-    (call $emitGetLocal (global.get $currentLocal))
-    (call $emitAdd)
-    (call $compileCall (i32.const 1) (i32.const 0x2 (; = UPDATE_DO_INDEX ;)))
-
     ;; compare signs to see if limit crossed
-    (call $emitGetLocal (i32.sub (global.get $currentLocal) (i32.const 1)))
     (call $emitGetLocal (global.get $firstTemporaryLocal))
     (call $emitXOR)
     (call $emitConst (i32.const 0))
@@ -2693,32 +3767,89 @@
 
     (call $compileLoopEnd (local.get $tos)))
 
-  ;; Assumes increment is on the operand stack
   (func $compileLoopEnd (param $tos i32) (result i32)
     (local $btos i32)
-    (call $compileCall (i32.const 0) (i32.const 0x9 (; = END_DO_INDEX ;)))
     (call $emitEnd)
     (call $emitEnd)
-    (global.set $currentLocal (i32.sub (global.get $currentLocal) (i32.const 2)))
+    (local.set $btos (i32.sub (local.get $tos) (i32.const 12)))
+    (if (i32.eq (i32.load (local.get $btos)) (global.get $callCount))
+      (then
+        ;; No calls in the loop body: replace the startDo call by nops
+        (memory.fill
+          (i32.load (i32.add (local.get $btos) (i32.const 4)))
+          (i32.const 0x01 (; nop ;))
+          (i32.sub (i32.load (i32.add (local.get $btos) (i32.const 8)))
+                   (i32.load (i32.add (local.get $btos) (i32.const 4))))))
+      (else
+        (call $emitConst (i32.const 0x9 (; = END_DO_INDEX ;)))
+        (call $emit2 (i32.const 0x11) (i32.const 0x0) (i32.const 0x0))))
+    (call $emitEnd)
+    (global.set $currentLocal (i32.sub (global.get $currentLocal) (i32.const 3)))
 
     ;; Restore branch nesting
-    (global.set $branchNesting (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
+    (global.set $branchNesting (i32.load (local.tee $btos (i32.sub (local.get $btos) (i32.const 4)))))
     (local.get $btos))
 
   (func $compileLeave
-    (call $compileCall (i32.const 0) (i32.const 0x9 (; = END_DO_INDEX ;)))
+    (call $compileSpill)
     (call $emitBr (i32.add (global.get $branchNesting) (i32.const 1))))
 
+  ;; Stores the current index of all enclosing DO loops (that haven't been
+  ;; UNLOOPed) in their return stack cell.
+  (func $compileSyncLoops
+    (local $l i32)
+    (local.set $l (i32.sub (global.get $currentLocal)
+                           (i32.mul (global.get $unloops) (i32.const 3))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop
+          (i32.le_s (local.get $l)
+                    (i32.add (global.get $firstTemporaryLocal)
+                             (i32.const 0xa (; = STACK_CACHE_LOCALS ;)))))
+        (call $emitGetLocal (i32.sub (local.get $l) (i32.const 2)))
+        (call $emitGetLocal (i32.sub (local.get $l) (i32.const 1)))
+        (call $emitGetLocal (local.get $l))
+        (call $emitAdd)
+        (call $emitStore)
+        (local.set $l (i32.sub (local.get $l) (i32.const 3)))
+        (br $loop))))
+
+  ;; Compiles I (n = 0) or J (n = 1) directly from the loop locals.
+  ;; Returns 0 if the loop isn't part of the current definition.
+  (func $compileLoopIndex (param $n i32) (result i32)
+    (local $l i32)
+    (local.set $l (i32.sub (global.get $currentLocal)
+                           (i32.mul (i32.add (global.get $unloops) (local.get $n))
+                                    (i32.const 3))))
+    (if (i32.le_s (local.get $l)
+                  (i32.add (global.get $firstTemporaryLocal)
+                           (i32.const 0xa (; = STACK_CACHE_LOCALS ;))))
+      (then (return (i32.const 0))))
+    (call $emitGetLocal (i32.sub (local.get $l) (i32.const 1)))
+    (call $emitGetLocal (local.get $l))
+    (call $emitAdd)
+    (call $compilePush)
+    (i32.const 1))
+
   (func $compileBegin (param $tos i32) (result i32)
+    (call $compileSpill)
     (call $emitLoop)
+    (call $compileBurnFuel)
     (global.set $branchNesting (i32.add (global.get $branchNesting) (i32.const 1)))
     (i32.store (local.get $tos) (i32.or (global.get $branchNesting) (i32.const 0x80000000 (; dest bit ;))))
     (i32.add (local.get $tos) (i32.const 4)))
 
+  ;; Counts the iterations of the loop that was just started, if there is a
+  ;; fuel limit (see Fuel)
+  (func $compileBurnFuel
+    (if (i32.ne (global.get $fuel) (i32.const -1))
+      (then (call $compileCall (i32.const 0) (i32.const 0xc (; = BURN_FUEL_INDEX ;))))))
+
   (func $compileWhile
     (call $compileIf))
 
   (func $compileRepeat (param $tos i32) (result i32)
+    (call $compileSpill)
     (call $emitBr
       (i32.sub
         (global.get $branchNesting)
@@ -2749,34 +3880,295 @@
         (local.set $tos (local.get $btos))))
     (local.get $tos))
 
+  ;; The word is called through the table, because its function index in the
+  ;; (batched) module isn't known yet.
+  ;; Compiles a direct call to the function being compiled. Its index in the
+  ;; module it ends up in is only known at the end (see `endColon`), so the
+  ;; index is a padded placeholder, linked to the previous one.
   (func $compileRecurse
-    ;; call 0
-    (i32.store8 (global.get $cp) (i32.const 0x10))
-    (global.set $cp (i32.add (global.get $cp) (i32.const 1)))
-    (i32.store8 (global.get $cp) (i32.const 0x00))
-    (global.set $cp (i32.add (global.get $cp) (i32.const 1))))
+    (call $compileSpill)
+    (call $compileSyncLoops)
+    (global.set $callCount (i32.add (global.get $callCount) (i32.const 1)))
+    (if (i32.load8_u (i32.const 0x20041 (; = MODULE_HEADER_FUNCTION_TYPE_BASE ;)))
+      (then (call $emitGetLocal (i32.const 1))))
+    (call $emit0 (i32.const 0x10))
+    (i32.store (global.get $cp) (global.get $recurseChain))
+    (global.set $recurseChain (global.get $cp))
+    (global.set $cp (i32.add (global.get $cp) (i32.const 4))))
+
+  ;; Fills in the function index of the calls compiled by RECURSE
+  (func $patchRecurse (param $index i32)
+    (local $p i32)
+    (local $next i32)
+    (local.set $p (global.get $recurseChain))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eqz (local.get $p)))
+        (local.set $next (i32.load (local.get $p)))
+        (i32.store (local.get $p) (call $leb128-4p (local.get $index)))
+        (local.set $p (local.get $next))
+        (br $loop)))
+    (global.set $recurseChain (i32.const 0)))
+
+  ;; Last function index placeholder of RECURSE in the current body (or 0)
+  (global $recurseChain (mut i32) (i32.const 0))
 
+  ;; Pops the top of the stack onto the operand stack (on top of the
+  ;; top-of-stack pointer). The rest of the stack is spilled to memory.
   (func $compilePop
+    (local $l i32)
+    (if (global.get $cacheCount)
+      (then
+        (local.set $l (call $popCache))
+        (call $compileSpill)
+        (call $emitGetLocal (local.get $l))
+        (return)))
     (call $emitConst (i32.const 4))
     (call $emitSub)
     (call $emitTeeLocal (i32.const 0))
     (call $emitGetLocal (i32.const 0))
     (call $emitLoad))
 
+  ;; Compiles the execution of a word.
+  ;;
+  ;; Primitive words with a code template are inlined, and the data address of
+  ;; variables and constants is compiled in directly. Because this looks at the
+  ;; table index of the word, a redefinition of one of these words gets a new
+  ;; index, and is called like any other word.
   (func $compileExecute (param $tos i32) (param $xt i32) (result i32)
     (local $body i32)
+    (local $index i32)
     (local.set $body (call $body (local.get $xt)))
+    (local.set $index (i32.load (local.get $body)))
     (if (i32.and (i32.load (i32.add (local.get $xt) (i32.const 4)))
                  (i32.const 0x40 (; = F_DATA ;)))
       (then
-        (call $emitConst (i32.add (local.get $body) (i32.const 4)))
-        (call $compileCall (i32.const 1) (i32.load (local.get $body))))
+        (if (i32.eq (local.get $index) (i32.const 0x3 (; = PUSH_DATA_ADDRESS_INDEX ;)))
+          (then
+            (call $compilePushConst (i32.add (local.get $body) (i32.const 4))))
+          (else
+            (if (i32.eq (local.get $index) (i32.const 0x6 (; = PUSH_INDIRECT_INDEX ;)))
+              (then
+                (call $emitConst (i32.add (local.get $body) (i32.const 4)))
+                (call $emitLoad)
+                (call $compilePush))
+              (else
+                (call $compileSpill)
+                (call $emitConst (i32.add (local.get $body) (i32.const 4)))
+                (call $compileCall (i32.const 1) (local.get $index)))))))
       (else
-        (call $compileCall (i32.const 0) (i32.load (local.get $body)))))
+        (block $compiled
+          (if (i32.eq (local.get $index) (i32.const 0x83 (; = index("I") ;)))
+            (then (br_if $compiled (call $compileLoopIndex (i32.const 0)))))
+          (if (i32.eq (local.get $index) (i32.const 0x88 (; = index("J") ;)))
+            (then (br_if $compiled (call $compileLoopIndex (i32.const 1)))))
+          (br_if $compiled (call $compileInline (local.get $index)))
+          (call $compileCall (i32.const 0) (local.get $index)))))
     (local.get $tos))
   (elem (i32.const 0x5 (; = COMPILE_EXECUTE_INDEX ;)) $compileExecute)
 
+  ;; Compiles the code template of the word with the given table index.
+  ;; Returns 0 if there is no template for the word.
+  (func $compileInline (param $index i32) (result i32)
+    (local $p i32)
+    (local $n i32)
+    (local $i i32)
+    (local $in i32)
+    (local $base i32)
+    (local $results i32)
+    (local.set $p (i32.const 0x30000 (; = INLINE_TEMPLATES_BASE ;)))
+    (block $found
+      (loop $loop
+        (if (i32.eqz (i32.load (local.get $p)))
+          (then (return (i32.const 0))))
+        (br_if $found (i32.eq (i32.load (local.get $p)) (local.get $index)))
+        (local.set $p (i32.add (local.get $p)
+                               (i32.add (i32.load8_u (i32.add (local.get $p) (i32.const 4)))
+                                        (i32.const 5))))
+        (br $loop)))
+
+    ;; Make sure all consumed cells are in the cache
+    (local.set $in (i32.load8_u (i32.add (local.get $p) (i32.const 5))))
+    (call $compileFill (local.get $in))
+    (local.set $base (i32.sub (global.get $cacheCount) (local.get $in)))
+
+    ;; Push the arguments
+    (local.set $p (i32.add (local.get $p) (i32.const 6)))
+    (local.set $n (i32.load8_u (local.get $p)))
+    (local.set $i (i32.const 0))
+    (block $endArgs
+      (loop $args
+        (br_if $endArgs (i32.ge_u (local.get $i) (local.get $n)))
+        (call $emitGetLocal
+          (call $cacheLocal
+            (i32.add (local.get $base)
+                     (i32.load8_u (i32.add (local.get $p) (i32.add (local.get $i) (i32.const 1)))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $args)))
+
+    ;; Copy the code
+    (local.set $p (i32.add (local.get $p) (i32.add (local.get $n) (i32.const 1))))
+    (local.set $n (i32.load8_u (local.get $p)))
+    (call $checkCode)
+    (memory.copy (global.get $cp) (i32.add (local.get $p) (i32.const 1)) (local.get $n))
+    (global.set $cp (i32.add (global.get $cp) (local.get $n)))
+    (global.set $lastEmitWasGetTOS (i32.const 0))
+
+    ;; Store the values left by the code in new cache locals, on top of the consumed cells
+    (local.set $p (i32.add (local.get $p) (i32.add (local.get $n) (i32.const 1))))
+    (local.set $n (i32.load8_u (local.get $p)))
+    (local.set $results (i32.const 0))
+    (local.set $i (i32.const 0))
+    (block $endCount
+      (loop $count
+        (br_if $endCount (i32.ge_u (local.get $i) (local.get $n)))
+        (if (i32.ge_u (i32.load8_u (i32.add (local.get $p) (i32.add (local.get $i) (i32.const 1))))
+                      (local.get $in))
+          (then (local.set $results (i32.add (local.get $results) (i32.const 1)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $count)))
+    (local.set $i (i32.const 0))
+    (block $endAlloc
+      (loop $alloc
+        (br_if $endAlloc (i32.ge_u (local.get $i) (local.get $results)))
+        (call $pushCache (call $allocCacheLocal))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $alloc)))
+    (local.set $i (global.get $cacheCount))
+    (block $endSet
+      (loop $set
+        (br_if $endSet (i32.eqz (local.get $results)))
+        (local.set $i (i32.sub (local.get $i) (i32.const 1)))
+        (call $emitSetLocal (call $cacheLocal (local.get $i)))
+        (local.set $results (i32.sub (local.get $results) (i32.const 1)))
+        (br $set)))
+
+    ;; Replace the consumed cells by the resulting cells
+    (memory.copy
+      (i32.const 0x30710 (; = STACK_CACHE_SCRATCH_BASE ;))
+      (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (local.get $base))
+      (i32.sub (global.get $cacheCount) (local.get $base)))
+    (local.set $i (i32.const 0))
+    (block $endResults
+      (loop $results
+        (br_if $endResults (i32.ge_u (local.get $i) (local.get $n)))
+        (i32.store8
+          (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (i32.add (local.get $base) (local.get $i)))
+          (i32.load8_u
+            (i32.add (i32.const 0x30710 (; = STACK_CACHE_SCRATCH_BASE ;))
+                     (i32.load8_u (i32.add (local.get $p) (i32.add (local.get $i) (i32.const 1)))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $results)))
+    (global.set $cacheCount (i32.add (local.get $base) (local.get $n)))
+    (if (i32.gt_u (global.get $cacheCount) (i32.const 0x8 (; = STACK_CACHE_SIZE ;)))
+      (then (call $compileSpill)))
+    (i32.const 1))
+
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+  ;; Stack cache
+  ;;
+  ;; While compiling a word, the top cells of the stack are kept in locals
+  ;; instead of in memory. The cache records which local holds each cell
+  ;; (the same local can hold multiple cells, e.g. after DUP), starting with
+  ;; the deepest cell.
+  ;;
+  ;; The cache is spilled to memory before calls to other words, at
+  ;; control flow boundaries, and at the end of the word. Everything that emits
+  ;; code that accesses the stack directly needs to spill the cache first.
+  ;;
+  ;;   STACK_CACHE_SIZE := 8         (maximum number of cached cells)
+  ;;   STACK_CACHE_LOCALS := 10      (STACK_CACHE_SIZE + 2)
+  ;;   STACK_CACHE_SCRATCH_BASE := 0x30710 (STACK_CACHE_BASE + 0x10)
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; Stores all cached cells in memory
+  (func $compileSpill
+    (local $i i32)
+    (if (i32.eqz (global.get $cacheCount))
+      (then (return)))
+    (call $emitSetLocal (i32.const 0))
+    (local.set $i (i32.const 0))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_u (local.get $i) (global.get $cacheCount)))
+        (call $emitGetLocal (i32.const 0))
+        (call $emitGetLocal (call $cacheLocal (local.get $i)))
+        (call $emitStoreOffset (i32.shl (local.get $i) (i32.const 2)))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop)))
+    (call $emitGetLocal (i32.const 0))
+    (call $emitConst (i32.shl (global.get $cacheCount) (i32.const 2)))
+    (call $emitAdd)
+    (global.set $cacheCount (i32.const 0)))
+
+  ;; Loads cells from memory until at least $n cells are cached
+  (func $compileFill (param $n i32)
+    (local $m i32)
+    (local $i i32)
+    (local $l i32)
+    (if (i32.le_s (local.tee $m (i32.sub (local.get $n) (global.get $cacheCount))) (i32.const 0))
+      (then (return)))
+    ;; Make room at the bottom of the cache
+    (memory.copy
+      (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (local.get $m))
+      (i32.const 0x30700 (; = STACK_CACHE_BASE ;))
+      (global.get $cacheCount))
+    (memory.fill (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (i32.const 0) (local.get $m))
+    (global.set $cacheCount (local.get $n))
+
+    (call $emitConst (i32.shl (local.get $m) (i32.const 2)))
+    (call $emitSub)
+    (call $emitTeeLocal (i32.const 0))
+    (local.set $i (i32.const 0))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_u (local.get $i) (local.get $m)))
+        (local.set $l (call $allocCacheLocal))
+        (i32.store8 (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (local.get $i))
+                    (local.get $l))
+        (call $emitGetLocal (i32.const 0))
+        (call $emitLoadOffset (i32.shl (local.get $i) (i32.const 2)))
+        (call $emitSetLocal (local.get $l))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop))))
+
+  ;; Returns a stack cache local that doesn't hold any cached cell
+  (func $allocCacheLocal (result i32)
+    (local $l i32)
+    (local $i i32)
+    (local.set $l (global.get $firstTemporaryLocal))
+    (loop $loop
+      (local.set $l (i32.add (local.get $l) (i32.const 1)))
+      (local.set $i (i32.const 0))
+      (block $endScan
+        (loop $scan
+          (br_if $endScan (i32.ge_u (local.get $i) (global.get $cacheCount)))
+          (br_if $loop (i32.eq (call $cacheLocal (local.get $i)) (local.get $l)))
+          (local.set $i (i32.add (local.get $i) (i32.const 1)))
+          (br $scan))))
+    (if (i32.gt_s (local.get $l) (global.get $lastLocal))
+      (then (global.set $lastLocal (local.get $l))))
+    (local.get $l))
+
+  (func $cacheLocal (param $i i32) (result i32)
+    (i32.load8_u (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (local.get $i))))
+
+  (func $pushCache (param $l i32)
+    (i32.store8 (i32.add (i32.const 0x30700 (; = STACK_CACHE_BASE ;)) (global.get $cacheCount))
+                (local.get $l))
+    (global.set $cacheCount (i32.add (global.get $cacheCount) (i32.const 1))))
+
+  (func $popCache (result i32)
+    (global.set $cacheCount (i32.sub (global.get $cacheCount) (i32.const 1)))
+    (call $cacheLocal (global.get $cacheCount)))
+
+  ;; Compiles a call to the word with the given table index.
+  ;; The cache needs to be spilled before pushing any extra arguments.
+  ;; Enclosing DO loops store their index on the return stack first.
   (func $compileCall (param $type i32) (param $n i32)
+    (call $compileSpill)
+    (call $compileSyncLoops)
+    (global.set $callCount (i32.add (global.get $callCount) (i32.const 1)))
     (call $emitConst (local.get $n))
     (call $emit2 (i32.const 0x11) (local.get $type) (i32.const 0x0)))
 
@@ -2814,22 +4206,33 @@
   (func $emitReturn (call $emit0 (i32.const 0x0f)))
   (func $emitStore (call $emit2 (i32.const 0x36) (i32.const 0x02 (; align ;)) (i32.const 0x00 (; offset ;))))
   (func $emitLoad (call $emit2 (i32.const 0x28) (i32.const 0x02 (; align ;)) (i32.const 0x00 (; offset ;))))
+  (func $emitStoreOffset (param $offset i32) (call $emit2 (i32.const 0x36) (i32.const 0x02 (; align ;)) (local.get $offset)))
+  (func $emitLoadOffset (param $offset i32) (call $emit2 (i32.const 0x28) (i32.const 0x02 (; align ;)) (local.get $offset)))
+
+  ;; Fails if there's no more room for code in the module buffer
+  (func $checkCode
+    (if (i32.gt_u (global.get $cp) (global.get $codeLimit))
+      (then (call $fail (i32.const -0x8 (; = EXC_DICTIONARY_OVERFLOW ;)) (i32.const 0x3b0c7 (; = str("definition too long") ;))))))
 
   (func $emit0 (param $op i32)
+    (call $checkCode)
     (global.set $cp (call $leb128u (global.get $cp) (local.get $op)))
     (global.set $lastEmitWasGetTOS (i32.const 0)))
 
   (func $emit1v (param $op i32) (param $i1 i32)
+    (call $checkCode)
     (global.set $cp (call $leb128u (global.get $cp) (local.get $op)))
     (global.set $cp (call $leb128 (global.get $cp) (local.get $i1)))
     (global.set $lastEmitWasGetTOS (i32.const 0)))
 
   (func $emit1 (param $op i32) (param $i1 i32)
+    (call $checkCode)
     (global.set $cp (call $leb128u (global.get $cp) (local.get $op)))
     (global.set $cp (call $leb128u (global.get $cp) (local.get $i1)))
     (global.set $lastEmitWasGetTOS (i32.const 0)))
 
   (func $emit2 (param $op i32) (param $i1 i32) (param $i2 i32)
+    (call $checkCode)
     (global.set $cp (call $leb128u (global.get $cp) (local.get $op)))
     (global.set $cp (call $leb128u (global.get $cp) (local.get $i1)))
     (global.set $cp (call $leb128u (global.get $cp) (local.get $i2)))
@@ -2845,17 +4248,31 @@
   (global $branchNesting (mut i32) (i32.const -1))
   (global $lastEmitWasGetTOS (mut i32) (i32.const 0))
 
+  ;; Number of DO loops that were UNLOOPed (before an EXIT)
+  (global $unloops (mut i32) (i32.const 0))
+
+  ;; Number of calls compiled so far
+  (global $callCount (mut i32) (i32.const 0))
+
+  ;; Number of cells in the stack cache
+  (global $cacheCount (mut i32) (i32.const 0))
+
   ;; Compilation pointer
-  (global $cp (mut i32) (i32.const 0x105e (; = MODULE_BODY_BASE ;)))
+  (global $cp (mut i32) (i32.const 0x2005e (; = MODULE_BODY_BASE ;)))
+
+  ;; End of the room for code (see `checkCode`)
+  (global $codeLimit (mut i32) (i32.const 0x2fe00 (; = MODULE_CODE_LIMIT ;)))
 
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Word helper functions
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 
-  (func $startDo (param $tos i32) (param $i i32) (result i32)
-    (i32.store (global.get $tors) (local.get $i))
-    (global.set $tors (i32.add (global.get $tors) (i32.const 4)))
-    (local.get $tos))
+  ;; Reserves a return stack cell for the index of a DO loop, and returns
+  ;; its address.
+  (func $startDo (param $tos i32) (result i32 i32)
+    (local.get $tos)
+    (global.get $tors)
+    (global.set $tors (i32.add (global.get $tors) (i32.const 4))))
   (elem (i32.const 0x1 (; = START_DO_INDEX ;)) $startDo)
 
   (func $endDo (param $tos i32) (result i32)
@@ -2863,11 +4280,6 @@
     (local.get $tos))
   (elem (i32.const 0x9 (; = END_DO_INDEX ;)) $endDo)
 
-  (func $updateDo (param $tos i32) (param $i i32) (result i32)
-    (i32.store (i32.sub (global.get $tors) (i32.const 4)) (local.get $i))
-    (local.get $tos))
-  (elem (i32.const 0x2 (; = UPDATE_DO_INDEX ;)) $updateDo)
-
   (func $pushDataAddress (param $tos i32) (param $d i32) (result i32)
     (call $push (local.get $tos) (local.get $d)))
   (elem (i32.const 0x3 (; = PUSH_DATA_ADDRESS_INDEX ;)) $pushDataAddress)
@@ -2881,8 +4293,20 @@
   (elem (i32.const 0x6 (; = PUSH_INDIRECT_INDEX ;)) $pushIndirect)
 
   (func $resetMarker (param $tos i32) (param $dp i32) (result i32)
-    (global.set $here (i32.load (local.get $dp)))
+    (local $task i32)
+    (call $setHere (i32.load (local.get $dp)))
     (global.set $latest (i32.load (i32.add (local.get $dp) (i32.const 4))))
+    ;; Unlink the forgotten tasks (the newest tasks come first in the ring)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop
+          (i32.lt_u
+            (local.tee $task (i32.load (i32.const 0x30800 (; = OPERATOR_BASE ;))))
+            (global.get $here)))
+        (i32.store (i32.const 0x30800 (; = OPERATOR_BASE ;)) (i32.load (local.get $task)))
+        (br $loop)))
+    ;; Rebuild the dictionary index on the next lookup
+    (global.set $dictionaryIndexLatest (i32.const 0))
     (local.get $tos))
   (elem (i32.const 0x7 (; = RESET_MARKER_INDEX ;)) $resetMarker)
 
@@ -2890,6 +4314,634 @@
     (call $execute (local.get $tos) (i32.load (local.get $dp))))
   (elem (i32.const 0x8 (; = EXECUTE_DEFER_INDEX ;)) $executeDefer)
 
+  (func $userAddress (param $tos i32) (param $dp i32) (result i32)
+    (call $push (local.get $tos) (i32.add (global.get $up) (i32.load (local.get $dp)))))
+  (elem (i32.const 0xb (; = USER_ADDRESS_INDEX ;)) $userAddress)
+
+  ;; Run-time part of ABORT".
+  ;; The message is only shown if there is no CATCH frame to catch it.
+  (func $abortMessage (param $tos i32) (result i32)
+    (if (i32.eqz (global.get $catchDepth))
+      (then
+        (call $type
+          (i32.load (i32.sub (local.get $tos) (i32.const 8)))
+          (i32.load (i32.sub (local.get $tos) (i32.const 4))))))
+    (call $throw (i32.sub (local.get $tos) (i32.const 8)) (i32.const -0x2 (; = EXC_ABORTQ ;))))
+  (elem (i32.const 0xa (; = ABORT_MESSAGE_INDEX ;)) $abortMessage)
+
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+  ;; String scanning
+  ;;
+  ;; The functions below process 16 bytes at a time using SIMD
+  ;; instructions, and the remaining bytes one at a time. Each of them has a
+  ;; scalar-only version with the same signature, and a `Scalar` suffix. No
+  ;; other functions use SIMD instructions, so a host that can't use them can
+  ;; replace each of these functions by its scalar version (see waforthc's
+  ;; `--no-simd`).
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; Returns the address of the first newline or `c` in [p, end), or end
+  (func $scan (param $p i32) (param $end i32) (param $c i32) (result i32)
+    (local $m i32)
+    (local $v v128)
+    (local $vc v128)
+    (local $vnl v128)
+    (local.set $vc (i8x16.splat (local.get $c)))
+    (local.set $vnl (i8x16.splat (i32.const 0xa)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_u (i32.add (local.get $p) (i32.const 16)) (local.get $end)))
+        (if (local.tee $m
+              (i8x16.bitmask
+                (v128.or
+                  (i8x16.eq (local.tee $v (v128.load (local.get $p))) (local.get $vc))
+                  (i8x16.eq (local.get $v) (local.get $vnl)))))
+          (then (return (i32.add (local.get $p) (i32.ctz (local.get $m))))))
+        (local.set $p (i32.add (local.get $p) (i32.const 16)))
+        (br $loop)))
+    (block $endTail
+      (loop $tail
+        (br_if $endTail (i32.eq (local.get $p) (local.get $end)))
+        (br_if $endTail (i32.eq (local.tee $m (i32.load8_u (local.get $p))) (local.get $c)))
+        (br_if $endTail (i32.eq (local.get $m) (i32.const 0xa)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $tail)))
+    (local.get $p))
+
+  (func $scanScalar (param $p i32) (param $end i32) (param $c i32) (result i32)
+    (local $b i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $p) (local.get $end)))
+        (br_if $endLoop (i32.eq (local.tee $b (i32.load8_u (local.get $p))) (local.get $c)))
+        (br_if $endLoop (i32.eq (local.get $b) (i32.const 0xa)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $loop)))
+    (local.get $p))
+
+  ;; Returns the address of the first character other than `c` in [p, end), or end
+  (func $span (param $p i32) (param $end i32) (param $c i32) (result i32)
+    (local $m i32)
+    (local $vc v128)
+    (local.set $vc (i8x16.splat (local.get $c)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_u (i32.add (local.get $p) (i32.const 16)) (local.get $end)))
+        (if (local.tee $m
+              (i32.xor
+                (i8x16.bitmask (i8x16.eq (v128.load (local.get $p)) (local.get $vc)))
+                (i32.const 0xffff)))
+          (then (return (i32.add (local.get $p) (i32.ctz (local.get $m))))))
+        (local.set $p (i32.add (local.get $p) (i32.const 16)))
+        (br $loop)))
+    (block $endTail
+      (loop $tail
+        (br_if $endTail (i32.eq (local.get $p) (local.get $end)))
+        (br_if $endTail (i32.ne (i32.load8_u (local.get $p)) (local.get $c)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $tail)))
+    (local.get $p))
+
+  (func $spanScalar (param $p i32) (param $end i32) (param $c i32) (result i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $p) (local.get $end)))
+        (br_if $endLoop (i32.ne (i32.load8_u (local.get $p)) (local.get $c)))
+        (local.set $p (i32.add (local.get $p) (i32.const 1)))
+        (br $loop)))
+    (local.get $p))
+
+  ;; Returns the offset of the first byte that differs in the `n` bytes at
+  ;; `addr1` and `addr2`, or `n` if they are equal
+  (func $mismatch (param $addr1 i32) (param $addr2 i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $m i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_u (i32.add (local.get $i) (i32.const 16)) (local.get $n)))
+        (if (local.tee $m
+              (i32.xor
+                (i8x16.bitmask
+                  (i8x16.eq
+                    (v128.load (i32.add (local.get $addr1) (local.get $i)))
+                    (v128.load (i32.add (local.get $addr2) (local.get $i)))))
+                (i32.const 0xffff)))
+          (then (return (i32.add (local.get $i) (i32.ctz (local.get $m))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (block $endTail
+      (loop $tail
+        (br_if $endTail (i32.eq (local.get $i) (local.get $n)))
+        (br_if $endTail
+          (i32.ne
+            (i32.load8_u (i32.add (local.get $addr1) (local.get $i)))
+            (i32.load8_u (i32.add (local.get $addr2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $tail)))
+    (local.get $i))
+
+  (func $mismatchScalar (param $addr1 i32) (param $addr2 i32) (param $n i32) (result i32)
+    (local $i i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $i) (local.get $n)))
+        (br_if $endLoop
+          (i32.ne
+            (i32.load8_u (i32.add (local.get $addr1) (local.get $i)))
+            (i32.load8_u (i32.add (local.get $addr2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop)))
+    (local.get $i))
+
+  ;; Returns the offset of the first occurrence of the `len2` (> 0) bytes at
+  ;; `addr2` in the `len1` bytes at `addr1`, or -1 if there is none.
+  ;; Candidates are positions where both the first and the last byte match.
+  (func $search (param $addr1 i32) (param $len1 i32) (param $addr2 i32) (param $len2 i32) (result i32)
+    (local $i i32)
+    (local $m i32)
+    (local $r i32)
+    (local $vfirst v128)
+    (local $vlast v128)
+    (local.set $vfirst (i8x16.splat (i32.load8_u (local.get $addr2))))
+    (local.set $vlast (i8x16.splat (i32.load8_u (i32.sub (i32.add (local.get $addr2) (local.get $len2)) (i32.const 1)))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop
+          (i32.gt_u (i32.add (i32.add (local.get $i) (local.get $len2)) (i32.const 15)) (local.get $len1)))
+        (local.set $m
+          (i8x16.bitmask
+            (v128.and
+              (i8x16.eq (v128.load (i32.add (local.get $addr1) (local.get $i))) (local.get $vfirst))
+              (i8x16.eq
+                (v128.load (i32.sub (i32.add (i32.add (local.get $addr1) (local.get $i)) (local.get $len2)) (i32.const 1)))
+                (local.get $vlast)))))
+        (block $endCandidates
+          (loop $candidates
+            (br_if $endCandidates (i32.eqz (local.get $m)))
+            (if (i32.eq
+                  (call $mismatch
+                    (i32.add (i32.add (local.get $addr1) (local.get $i)) (local.tee $r (i32.ctz (local.get $m))))
+                    (local.get $addr2)
+                    (local.get $len2))
+                  (local.get $len2))
+              (then (return (i32.add (local.get $i) (local.get $r)))))
+            (local.set $m (i32.and (local.get $m) (i32.sub (local.get $m) (i32.const 1))))
+            (br $candidates)))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (if (i32.lt_s
+          (local.tee $r
+            (call $searchScalar
+              (i32.add (local.get $addr1) (local.get $i)) (i32.sub (local.get $len1) (local.get $i))
+              (local.get $addr2) (local.get $len2)))
+          (i32.const 0))
+      (then (return (i32.const -1))))
+    (i32.add (local.get $i) (local.get $r)))
+
+  (func $searchScalar (param $addr1 i32) (param $len1 i32) (param $addr2 i32) (param $len2 i32) (result i32)
+    (local $i i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (local.get $len2)) (local.get $len1)))
+        (if (i32.eq
+              (call $mismatchScalar (i32.add (local.get $addr1) (local.get $i)) (local.get $addr2) (local.get $len2))
+              (local.get $len2))
+          (then (return (local.get $i))))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (br $loop)))
+    (i32.const -1))
+
+  ;; Returns the length of the `len` bytes at `addr` without trailing spaces
+  (func $trailing (param $addr i32) (param $len i32) (result i32)
+    (local $m i32)
+    (local $vspace v128)
+    (local.set $vspace (i8x16.splat (i32.const 0x20 (; = ' ' ;))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.lt_u (local.get $len) (i32.const 16)))
+        (if (local.tee $m
+              (i32.xor
+                (i8x16.bitmask
+                  (i8x16.eq
+                    (v128.load (i32.sub (i32.add (local.get $addr) (local.get $len)) (i32.const 16)))
+                    (local.get $vspace)))
+                (i32.const 0xffff)))
+          (then (return (i32.sub (i32.add (local.get $len) (i32.const 16)) (i32.clz (local.get $m))))))
+        (local.set $len (i32.sub (local.get $len) (i32.const 16)))
+        (br $loop)))
+    (block $endTail
+      (loop $tail
+        (br_if $endTail (i32.eqz (local.get $len)))
+        (br_if $endTail
+          (i32.ne
+            (i32.load8_u (i32.sub (i32.add (local.get $addr) (local.get $len)) (i32.const 1)))
+            (i32.const 0x20 (; = ' ' ;))))
+        (local.set $len (i32.sub (local.get $len) (i32.const 1)))
+        (br $tail)))
+    (local.get $len))
+
+  (func $trailingScalar (param $addr i32) (param $len i32) (result i32)
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eqz (local.get $len)))
+        (br_if $endLoop
+          (i32.ne
+            (i32.load8_u (i32.sub (i32.add (local.get $addr) (local.get $len)) (i32.const 1)))
+            (i32.const 0x20 (; = ' ' ;))))
+        (local.set $len (i32.sub (local.get $len) (i32.const 1)))
+        (br $loop)))
+    (local.get $len))
+
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+  ;; Array operations
+  ;;
+  ;; Operations on arrays of cells, 4 cells at a time. As with the string
+  ;; scanning functions, each of these has a scalar version with a `Scalar`
+  ;; suffix, which also handles the last (at most 3) cells.
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; Stores the element-wise sum of the `n` cells at `src1` and `src2` at `dst`
+  (func $vectorAdd (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (v128.store (i32.add (local.get $dst) (local.get $i))
+          (i32x4.add
+            (v128.load (i32.add (local.get $src1) (local.get $i)))
+            (v128.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (call $vectorAddScalar
+      (i32.add (local.get $src1) (local.get $i))
+      (i32.add (local.get $src2) (local.get $i))
+      (i32.add (local.get $dst) (local.get $i))
+      (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))
+
+  (func $vectorAddScalar (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (i32.add
+            (i32.load (i32.add (local.get $src1) (local.get $i)))
+            (i32.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
+  ;; Stores the element-wise product of the `n` cells at `src1` and `src2` at `dst`
+  (func $vectorMul (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (v128.store (i32.add (local.get $dst) (local.get $i))
+          (i32x4.mul
+            (v128.load (i32.add (local.get $src1) (local.get $i)))
+            (v128.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (call $vectorMulScalar
+      (i32.add (local.get $src1) (local.get $i))
+      (i32.add (local.get $src2) (local.get $i))
+      (i32.add (local.get $dst) (local.get $i))
+      (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))
+
+  (func $vectorMulScalar (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (i32.mul
+            (i32.load (i32.add (local.get $src1) (local.get $i)))
+            (i32.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
+  ;; Stores the element-wise bitwise and of the `n` cells at `src1` and `src2` at `dst`
+  (func $vectorAnd (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (v128.store (i32.add (local.get $dst) (local.get $i))
+          (v128.and
+            (v128.load (i32.add (local.get $src1) (local.get $i)))
+            (v128.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (call $vectorAndScalar
+      (i32.add (local.get $src1) (local.get $i))
+      (i32.add (local.get $src2) (local.get $i))
+      (i32.add (local.get $dst) (local.get $i))
+      (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))
+
+  (func $vectorAndScalar (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (i32.and
+            (i32.load (i32.add (local.get $src1) (local.get $i)))
+            (i32.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
+  ;; Stores the element-wise bitwise or of the `n` cells at `src1` and `src2` at `dst`
+  (func $vectorOr (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (v128.store (i32.add (local.get $dst) (local.get $i))
+          (v128.or
+            (v128.load (i32.add (local.get $src1) (local.get $i)))
+            (v128.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (call $vectorOrScalar
+      (i32.add (local.get $src1) (local.get $i))
+      (i32.add (local.get $src2) (local.get $i))
+      (i32.add (local.get $dst) (local.get $i))
+      (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))
+
+  (func $vectorOrScalar (param $src1 i32) (param $src2 i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (i32.or
+            (i32.load (i32.add (local.get $src1) (local.get $i)))
+            (i32.load (i32.add (local.get $src2) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
+  ;; Stores `x` in the `n` cells at `dst`
+  (func $vectorFill (param $x i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local $v v128)
+    (local.set $v (i32x4.splat (local.get $x)))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (v128.store (i32.add (local.get $dst) (local.get $i)) (local.get $v))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (call $vectorFillScalar
+      (local.get $x)
+      (i32.add (local.get $dst) (local.get $i))
+      (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))
+
+  (func $vectorFillScalar (param $x i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i)) (local.get $x))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
+  ;; Returns the sum of the `n` cells at `src`
+  (func $vectorSum (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $v v128)
+    (local.set $v (v128.const i32x4 0 0 0 0))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (local.set $v (i32x4.add (local.get $v) (v128.load (i32.add (local.get $src) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (local.set $v
+      (i32x4.add (local.get $v) (i8x16.shuffle 8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7 (local.get $v) (local.get $v))))
+    (local.set $v
+      (i32x4.add (local.get $v) (i8x16.shuffle 4 5 6 7 0 1 2 3 12 13 14 15 8 9 10 11 (local.get $v) (local.get $v))))
+    (i32.add
+      (i32x4.extract_lane 0 (local.get $v))
+      (call $vectorSumScalar
+        (i32.add (local.get $src) (local.get $i))
+        (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2))))))
+
+  (func $vectorSumScalar (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $r i32)
+    (local.set $r (i32.const 0))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (local.set $r (i32.add (local.get $r) (i32.load (i32.add (local.get $src) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop)))
+    (local.get $r))
+
+  ;; Returns the smallest of the `n` cells at `src`, or the largest number if `n` is 0
+  (func $vectorMin (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $v v128)
+    (local.set $v (i32x4.splat (i32.const 0x7fffffff)))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (local.set $v (i32x4.min_s (local.get $v) (v128.load (i32.add (local.get $src) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (local.set $v
+      (i32x4.min_s
+        (local.get $v)
+        (i32x4.splat
+          (call $vectorMinScalar
+            (i32.add (local.get $src) (local.get $i))
+            (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))))
+    (local.set $v
+      (i32x4.min_s (local.get $v) (i8x16.shuffle 8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7 (local.get $v) (local.get $v))))
+    (local.set $v
+      (i32x4.min_s (local.get $v) (i8x16.shuffle 4 5 6 7 0 1 2 3 12 13 14 15 8 9 10 11 (local.get $v) (local.get $v))))
+    (i32x4.extract_lane 0 (local.get $v)))
+
+  (func $vectorMinScalar (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $r i32)
+    (local $x i32)
+    (local.set $r (i32.const 0x7fffffff))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (if (i32.lt_s (local.tee $x (i32.load (i32.add (local.get $src) (local.get $i)))) (local.get $r))
+          (then (local.set $r (local.get $x))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop)))
+    (local.get $r))
+
+  ;; Returns the largest of the `n` cells at `src`, or the smallest number if `n` is 0
+  (func $vectorMax (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $v v128)
+    (local.set $v (i32x4.splat (i32.const 0x80000000)))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (local.set $v (i32x4.max_s (local.get $v) (v128.load (i32.add (local.get $src) (local.get $i)))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (local.set $v
+      (i32x4.max_s
+        (local.get $v)
+        (i32x4.splat
+          (call $vectorMaxScalar
+            (i32.add (local.get $src) (local.get $i))
+            (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2)))))))
+    (local.set $v
+      (i32x4.max_s (local.get $v) (i8x16.shuffle 8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7 (local.get $v) (local.get $v))))
+    (local.set $v
+      (i32x4.max_s (local.get $v) (i8x16.shuffle 4 5 6 7 0 1 2 3 12 13 14 15 8 9 10 11 (local.get $v) (local.get $v))))
+    (i32x4.extract_lane 0 (local.get $v)))
+
+  (func $vectorMaxScalar (param $src i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $r i32)
+    (local $x i32)
+    (local.set $r (i32.const 0x80000000))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (if (i32.gt_s (local.tee $x (i32.load (i32.add (local.get $src) (local.get $i)))) (local.get $r))
+          (then (local.set $r (local.get $x))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop)))
+    (local.get $r))
+
+  ;; Returns the sum of the products of the `n` cells at `src1` and `src2`
+  (func $vectorDot (param $src1 i32) (param $src2 i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $v v128)
+    (local.set $v (v128.const i32x4 0 0 0 0))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        (local.set $v
+          (i32x4.add
+            (local.get $v)
+            (i32x4.mul
+              (v128.load (i32.add (local.get $src1) (local.get $i)))
+              (v128.load (i32.add (local.get $src2) (local.get $i))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (local.set $v
+      (i32x4.add (local.get $v) (i8x16.shuffle 8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7 (local.get $v) (local.get $v))))
+    (local.set $v
+      (i32x4.add (local.get $v) (i8x16.shuffle 4 5 6 7 0 1 2 3 12 13 14 15 8 9 10 11 (local.get $v) (local.get $v))))
+    (i32.add
+      (i32x4.extract_lane 0 (local.get $v))
+      (call $vectorDotScalar
+        (i32.add (local.get $src1) (local.get $i))
+        (i32.add (local.get $src2) (local.get $i))
+        (i32.sub (local.get $n) (i32.shr_u (local.get $i) (i32.const 2))))))
+
+  (func $vectorDotScalar (param $src1 i32) (param $src2 i32) (param $n i32) (result i32)
+    (local $i i32)
+    (local $end i32)
+    (local $r i32)
+    (local.set $r (i32.const 0))
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (local.set $r
+          (i32.add
+            (local.get $r)
+            (i32.mul
+              (i32.load (i32.add (local.get $src1) (local.get $i)))
+              (i32.load (i32.add (local.get $src2) (local.get $i))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop)))
+    (local.get $r))
+
+  ;; Stores the running sums of the `n` cells at `src` at `dst`
+  (func $vectorPrefix (param $src i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local $sum i32)
+    (local $v v128)
+    (local $carry v128)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.gt_s (i32.add (local.get $i) (i32.const 16)) (local.get $end)))
+        ;; Add each cell to the cells after it
+        (local.set $v (v128.load (i32.add (local.get $src) (local.get $i))))
+        (local.set $v
+          (i32x4.add
+            (local.get $v)
+            (i8x16.shuffle 16 17 18 19 0 1 2 3 4 5 6 7 8 9 10 11 (local.get $v) (v128.const i32x4 0 0 0 0))))
+        (local.set $v
+          (i32x4.add
+            (local.get $v)
+            (i8x16.shuffle 16 17 18 19 16 17 18 19 0 1 2 3 4 5 6 7 (local.get $v) (v128.const i32x4 0 0 0 0))))
+        (v128.store (i32.add (local.get $dst) (local.get $i))
+          (local.tee $v (i32x4.add (local.get $v) (local.get $carry))))
+        (local.set $carry (i8x16.shuffle 12 13 14 15 12 13 14 15 12 13 14 15 12 13 14 15 (local.get $v) (local.get $v)))
+        (local.set $i (i32.add (local.get $i) (i32.const 16)))
+        (br $loop)))
+    (local.set $sum (i32x4.extract_lane 0 (local.get $carry)))
+    (block $endTail
+      (loop $tail
+        (br_if $endTail (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (local.tee $sum (i32.add (local.get $sum) (i32.load (i32.add (local.get $src) (local.get $i))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $tail))))
+
+  (func $vectorPrefixScalar (param $src i32) (param $dst i32) (param $n i32)
+    (local $i i32)
+    (local $end i32)
+    (local $sum i32)
+    (local.set $end (i32.shl (local.get $n) (i32.const 2)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.ge_s (local.get $i) (local.get $end)))
+        (i32.store (i32.add (local.get $dst) (local.get $i))
+          (local.tee $sum (i32.add (local.get $sum) (i32.load (i32.add (local.get $src) (local.get $i))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $loop))))
+
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; Helper functions
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -2904,41 +4956,84 @@
 
   ;; Returns 1 if equal, 0 if not
   (func $stringEqual (param $addr1 i32) (param $len1 i32) (param $addr2 i32) (param $len2 i32) (result i32)
-    (local $end1 i32)
-    (local $end2 i32)
     (if (i32.eqz (local.get $len1))
       (then (return (i32.const 0))))
     (if (i32.ne (local.get $len1) (local.get $len2))
       (then (return (i32.const 0))))
-    (local.set $end1 (i32.add (local.get $addr1) (local.get $len1)))
-    (local.set $end2 (i32.add (local.get $addr2) (local.get $len2)))
-    (loop $loop (result i32)
-      (if (i32.eq (local.get $addr1) (local.get $end1))
-        (then (return (i32.const 1))))
-      (if (i32.ne (i32.load8_s (local.get $addr1)) (i32.load8_s (local.get $addr2)))
-        (then (return (i32.const 0))))
-      (local.set $addr1 (i32.add (local.get $addr1) (i32.const 1)))
-      (local.set $addr2 (i32.add (local.get $addr2)(i32.const 1)))
-      (br $loop)))
-
-  (func $fail (param $str i32)
-    (call $type
-      (i32.add (local.get $str) (i32.const 1))
-      (i32.load8_u (local.get $str)))
-    (call $shell_emit (i32.const 10))
-    (drop (call $ABORT (i32.const -1) (; unused ;))))
+    (i32.eq (call $mismatch (local.get $addr1) (local.get $addr2) (local.get $len1)) (local.get $len1)))
+
+  ;; Throws exception `code`. If there is no CATCH frame to catch it,
+  ;; the message `str` is shown first.
+  (func $fail (param $code i32) (param $str i32)
+    (if (i32.eqz (global.get $catchDepth))
+      (then
+        (call $type
+          (i32.add (local.get $str) (i32.const 1))
+          (i32.load8_u (local.get $str)))
+        (call $shell_emit (i32.const 10))))
+    (drop (call $throw (i32.const -1) (; unused ;) (local.get $code))))
 
   (func $failUndefinedWord (param $addr i32) (param $len i32)
-    (call $type (i32.const 0x20001) (i32.load8_u (i32.const 0x20000)))
-    (call $shell_emit (i32.const 0x3a (; = ':' ;)))
-    (call $shell_emit (i32.const 0x20 (; = ' ' ;)))
-    (call $type (local.get $addr) (local.get $len))
-    (call $shell_emit (i32.const 0x0a))
-    (drop (call $ABORT (i32.const -1) (; unused ;))))
+    (if (i32.eqz (global.get $catchDepth))
+      (then
+        (call $ctype (i32.const 0x3b000 (; = str("undefined word") ;)))
+        (call $shell_emit (i32.const 0x3a (; = ':' ;)))
+        (call $shell_emit (i32.const 0x20 (; = ' ' ;)))
+        (call $type (local.get $addr) (local.get $len))
+        (call $shell_emit (i32.const 0x0a))))
+    (drop (call $throw (i32.const -1) (; unused ;) (i32.const -0xd (; = EXC_UNDEFINED_WORD ;)))))
+
+  ;; Makes sure the `n` bytes at HERE, and the transient regions after them,
+  ;; are backed by memory, growing it if necessary.
+  ;; The data space can't grow into the heap region.
+  (func $reserve (param $n i32)
+    (local $end i32)
+    (if (i32.gt_u
+          (local.tee $end
+            (i32.add
+              (i32.add (global.get $here) (local.get $n))
+              (i32.const 0x404 (; = HERE_RESERVE ;))))
+          (call $dataSpaceEnd))
+      (then (call $fail (i32.const -0x8 (; = EXC_DICTIONARY_OVERFLOW ;)) (i32.const 0x3b0a6 (; = str("out of memory") ;)))))
+    (if (i32.gt_u (local.get $end) (i32.shl (memory.size) (i32.const 16)))
+      (then
+        (if (global.get $spawnedTasks)
+          (then (call $fail (i32.const -0x15 (; = EXC_UNSUPPORTED ;)) (i32.const 0x3b10e (; = str("memory can't grow while tasks run") ;)))))
+        (if (i32.eq
+              (memory.grow
+                (i32.sub
+                  (i32.shr_u (i32.add (local.get $end) (i32.const 0xffff)) (i32.const 16))
+                  (memory.size)))
+              (i32.const -1))
+          (then (call $fail (i32.const -0x8 (; = EXC_DICTIONARY_OVERFLOW ;)) (i32.const 0x3b0a6 (; = str("out of memory") ;))))))))
+
+  ;; Sets HERE, growing memory if necessary
+  (func $setHere (param $addr i32)
+    (call $checkMainThread)
+    (call $reserve (i32.sub (local.get $addr) (global.get $here)))
+    ;; Go back to the initial index table if the data space no longer holds
+    ;; the current one (see Dictionary index)
+    (if (i32.lt_u
+          (local.get $addr)
+          (i32.add (global.get $dictionaryIndexBase)
+                   (i32.shl (i32.add (global.get $dictionaryIndexMask) (i32.const 1)) (i32.const 2))))
+      (then
+        (call $setIndexTable (i32.const 0x33000 (; = DICTIONARY_INDEX_BASE ;)) (i32.const 0x2000 (; = DICTIONARY_INDEX_SLOTS ;)))
+        (global.set $dictionaryIndexLatest (i32.const 0))))
+    (global.set $here (local.get $addr)))
 
   ;; Create an entry in the dictionary, with given name, flags, and function index
   (func $create (param $nameAddr i32) (param $nameLen i32) (param $flags i32) (param $func i32)
     (local $here i32)
+    (local $indexed i32)
+    (local.set $indexed (i32.eq (global.get $latest) (global.get $dictionaryIndexLatest)))
+    ;; Make sure the index has room for this word, and for one that is
+    ;; still hidden
+    (if (i32.and
+          (local.get $indexed)
+          (i32.gt_u (i32.add (global.get $dictionaryIndexCount) (i32.const 2))
+                    (global.get $dictionaryIndexMax)))
+      (then (call $growIndex)))
     ;; Store `prev` pointer
     (i32.store (local.tee $here (global.get $here)) (global.get $latest))
     (global.set $latest (local.get $here))
@@ -2958,17 +5053,17 @@
     (i32.store (local.get $here) (local.get $func))
     (local.set $here (i32.add (local.get $here) (i32.const 4)))
 
-    (global.set $here (local.get $here)))
+    (call $setHere (local.get $here))
+
+    ;; Update the index (hidden words are added when they are revealed)
+    (if (local.get $indexed)
+      (then
+        (if (i32.eqz (i32.and (local.get $flags) (i32.const 0x20 (; = F_HIDDEN ;))))
+          (then (call $indexEntry (global.get $latest) (i32.const 1))))
+        (global.set $dictionaryIndexLatest (global.get $latest)))))
 
   (func $type (param $p i32) (param $len i32)
-    (local $end i32)
-    (local.set $end (i32.add (local.get $p) (local.get $len)))
-    (block $endLoop
-      (loop $loop
-        (br_if $endLoop (i32.eq (local.get $p) (local.get $end)))
-        (call $shell_emit (i32.load8_u (local.get $p)))
-        (local.set $p (i32.add (local.get $p) (i32.const 1)))
-        (br $loop))))
+    (call $shell_type (local.get $p) (local.get $len)))
 
   ;; Type a counted string
   (func $ctype (param $p i32)
@@ -2981,32 +5076,27 @@
       (i32.add
         (call $body (drop (call $find! (call $parseName))))
         (i32.const 4)))
-    (if (result i32) (i32.eqz (i32.load (i32.const 0x209a0 (; = body(STATE) ;))))
+    (if (result i32) (i32.eqz (i32.load (i32.const 0x3bb64 (; = body(STATE) ;))))
       (then
         (i32.store (local.get $dp)
           (i32.load (local.tee $btos (i32.sub (local.get $tos) (i32.const 4)))))
         (local.get $btos))
       (else
-        (call $emitSetLocal (i32.const 0)) ;; Save tos currently on operand stack
+        (call $compileFill (i32.const 1))
 
         ;; Push parameter pointer on operand stack
         (call $emitConst (local.get $dp))
 
         ;; Pop value from stack & push on operand stack
-        (call $emitGetLocal (i32.const 0))
-        (call $emitConst (i32.const 4))
-        (call $emitSub)
-        (call $emitTeeLocal (i32.const 0))
-        (call $emitLoad)
+        (call $emitGetLocal (call $popCache))
 
         (call $emitStore)
-        (call $emitGetLocal (i32.const 0)) ;; Put tos on operand stack again
         (local.get $tos))))
 
   (func $ensureCompiling (param $tos i32) (result i32)
     (local.get $tos)
-    (if (param i32) (result i32) (i32.eqz (i32.load (i32.const 0x209a0 (; = body(STATE) ;))))
-      (then (call $fail (i32.const 0x2002e (; = str("word not supported in interpret mode") ;))))))
+    (if (param i32) (result i32) (i32.eqz (i32.load (i32.const 0x3bb64 (; = body(STATE) ;))))
+      (then (call $fail (i32.const -0xe (; = EXC_COMPILE_ONLY ;)) (i32.const 0x3b02e (; = str("word not supported in interpret mode") ;))))))
 
   ;; LEB128 with fixed 4 bytes (with padding bytes)
   ;; This means we can only represent 28 bits, which should be plenty.
@@ -3096,47 +5186,36 @@
     (local $addr i32)
     (local $p i32)
     (local $end i32)
-    (local $c i32)
-    (local $delimited i32)
-    (local.set $p
-      (local.tee $addr (i32.add (global.get $inputBufferBase)
-      (i32.load (i32.const 0x20334 (; = body(>IN) ;))))))
+    (call $checkMainThread)
+    (local.set $addr (i32.add (global.get $inputBufferBase)
+      (i32.load (i32.const 0x3b3ec (; = body(>IN) ;)))))
     (local.set $end (i32.add (global.get $inputBufferBase) (global.get $inputBufferSize)))
-    (local.set $delimited (i32.const 0))
-    (block $endOfInput
-      (block $delimiter
-        (loop $read
-          (br_if $endOfInput (i32.eq (local.get $p) (local.get $end)))
-          (local.set $c (i32.load8_s (local.get $p)))
-          (local.set $p (i32.add (local.get $p) (i32.const 1)))
-          (br_if $delimiter (i32.eq (local.get $c) (i32.const 0xa)))
-          (br_if $read (i32.ne (local.get $c) (local.get $delim)))))
-      (local.set $delimited (i32.const 1)))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;))
-      (i32.sub (local.get $p) (global.get $inputBufferBase)))
+    (local.set $p (call $scan (local.get $addr) (local.get $end) (local.get $delim)))
+    ;; Skip the delimiter
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;))
+      (i32.sub
+        (i32.add (local.get $p) (i32.ne (local.get $p) (local.get $end)))
+        (global.get $inputBufferBase)))
     (local.get $addr)
-    (i32.sub
-      (i32.sub (local.get $p) (local.get $delimited))
-      (local.get $addr)))
+    (i32.sub (local.get $p) (local.get $addr)))
 
   (func $skip (param $delim i32)
     (local $addr i32)
     (local $p i32)
-    (local $end i32)
-    (local $c i32)
+    (call $checkMainThread)
+    (local.set $addr (i32.add (global.get $inputBufferBase)
+      (i32.load (i32.const 0x3b3ec (; = body(>IN) ;)))))
     (local.set $p
-      (local.tee $addr (i32.add (global.get $inputBufferBase)
-      (i32.load (i32.const 0x20334 (; = body(>IN) ;))))))
-    (local.set $end (i32.add (global.get $inputBufferBase) (global.get $inputBufferSize)))
-    (block $endLoop
-      (loop $loop
-        (br_if $endLoop (i32.eq (local.get $p) (local.get $end)))
-        (local.set $c (i32.load8_s (local.get $p)))
-        (br_if $endLoop (i32.ne (local.get $c) (local.get $delim)))
-        (local.set $p (i32.add (local.get $p) (i32.const 1)))
-        ;; Eat up a newline
-        (br_if $loop (i32.ne (local.get $c) (i32.const 0xa)))))
-    (i32.store (i32.const 0x20334 (; = body(>IN) ;))
+      (call $span
+        (local.get $addr)
+        (i32.add (global.get $inputBufferBase) (global.get $inputBufferSize))
+        (local.get $delim)))
+    ;; Eat up at most one newline
+    (if (i32.and
+          (i32.eq (local.get $delim) (i32.const 0xa))
+          (i32.gt_u (local.get $p) (local.get $addr)))
+      (then (local.set $p (i32.add (local.get $addr) (i32.const 1)))))
+    (i32.store (i32.const 0x3b3ec (; = body(>IN) ;))
       (i32.sub (local.get $p) (global.get $inputBufferBase))))
 
   ;; Returns (number, unparsed length)
@@ -3162,7 +5241,7 @@
     (local $n i32)
     (local.set $p (local.get $addr))
     (local.set $end (i32.add (local.get $p) (local.get $length)))
-    (local.set $base (i32.load (i32.const 0x2040c (; = body(BASE) ;))))
+    (local.set $base (i32.load (i32.const 0x3b4d8 (; = body(BASE) ;))))
 
     ;; Read first character
     (if (i32.eq (local.tee $char (i32.load8_u (local.get $p))) (i32.const 0x2d (; = '-' ;)))
@@ -3210,8 +5289,213 @@
            (then (i32.sub (local.get $c) (i32.const 55)))
            (else (i32.sub (local.get $c) (i32.const 87)))))))
 
+  ;; Dictionary index
+  ;;
+  ;; Hash table (open addressing, linear probing) mapping names to the most
+  ;; recent visible entry with that name, so $find doesn't need to walk the
+  ;; whole dictionary. A small bloom filter in front of it lets most lookups
+  ;; of undefined names (e.g. numbers) return without probing the table.
+  ;;
+  ;; Entries are added when they are created (or when `;` reveals them).
+  ;; Flags are always read from the entry itself, so IMMEDIATE doesn't
+  ;; need to update the index. The index remembers which `latest` it is
+  ;; up to date with; if `latest` was changed some other way (e.g. by a
+  ;; MARKER, or when starting from a precompiled image), the index is
+  ;; rebuilt on the next lookup.
+  ;;
+  ;; The table starts out at DICTIONARY_INDEX_BASE. When it is 3/4 full,
+  ;; creating a word moves the index to a table twice as big, allotted in
+  ;; the data space right before the new word (so the data of the word
+  ;; stays contiguous). When HERE moves back below that table (e.g. by a
+  ;; MARKER), the index goes back to the initial table. Until there's room
+  ;; again, a rebuilt index that doesn't fit is disabled, and $find falls
+  ;; back to walking the dictionary.
+  ;;
+  ;;   DICTIONARY_INDEX_SLOTS := 0x2000   (initially)
+  ;;   DICTIONARY_BLOOM_BITS  := 0x4000
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; FNV-1a
+  (func $hashName (param $addr i32) (param $len i32) (result i32)
+    (local $h i32)
+    (local $end i32)
+    (local.set $h (i32.const 0x811c9dc5))
+    (local.set $end (i32.add (local.get $addr) (local.get $len)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eq (local.get $addr) (local.get $end)))
+        (local.set $h
+          (i32.mul
+            (i32.xor (local.get $h) (i32.load8_u (local.get $addr)))
+            (i32.const 0x01000193)))
+        (local.set $addr (i32.add (local.get $addr) (i32.const 1)))
+        (br $loop)))
+    (local.get $h))
+
+  ;; Returns whether the bloom filter bit for the given hash bits is set,
+  ;; and sets it if $set is true.
+  (func $bloomBit (param $bits i32) (param $set i32) (result i32)
+    (local $p i32)
+    (local $m i32)
+    (local $v i32)
+    (local.set $p
+      (i32.add
+        (i32.const 0x32800 (; = DICTIONARY_BLOOM_BASE ;))
+        (i32.shr_u (i32.and (local.get $bits) (i32.const 0x3fff)) (i32.const 3))))
+    (local.set $m (i32.shl (i32.const 1) (i32.and (local.get $bits) (i32.const 7))))
+    (local.set $v (i32.load8_u (local.get $p)))
+    (if (local.get $set)
+      (then (i32.store8 (local.get $p) (i32.or (local.get $v) (local.get $m)))))
+    (i32.and (local.get $v) (local.get $m)))
+
+  ;; Returns the address of the index slot for the given name (containing
+  ;; either the entry, or 0 if the name isn't in the index)
+  (func $indexSlot (param $addr i32) (param $len i32) (param $h i32) (result i32)
+    (local $slot i32)
+    (local $entryP i32)
+    (local.set $slot (i32.and (local.get $h) (global.get $dictionaryIndexMask)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop
+          (i32.eqz
+            (local.tee $entryP
+              (i32.load
+                (i32.add (global.get $dictionaryIndexBase)
+                         (i32.shl (local.get $slot) (i32.const 2)))))))
+        (br_if $endLoop
+          (call $stringEqual
+            (local.get $addr) (local.get $len)
+            (i32.add (local.get $entryP) (i32.const 5))
+            (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
+                     (i32.const 0x1f (; = LENGTH_MASK ;)))))
+        (local.set $slot (i32.and (i32.add (local.get $slot) (i32.const 1)) (global.get $dictionaryIndexMask)))
+        (br $loop)))
+    (i32.add (global.get $dictionaryIndexBase)
+             (i32.shl (local.get $slot) (i32.const 2))))
+
+  ;; Adds an entry to the index. If there already is a word with the same name,
+  ;; it is replaced if $replace is true.
+  (func $indexEntry (param $entryP i32) (param $replace i32)
+    (local $addr i32)
+    (local $len i32)
+    (local $h i32)
+    (local $slot i32)
+    (local.set $addr (i32.add (local.get $entryP) (i32.const 5)))
+    (local.set $len (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
+                             (i32.const 0x1f (; = LENGTH_MASK ;))))
+    (if (i32.or (i32.eqz (local.get $len))
+                (i32.gt_u (global.get $dictionaryIndexCount) (global.get $dictionaryIndexMax)))
+      (then (return)))
+    (local.set $h (call $hashName (local.get $addr) (local.get $len)))
+    (local.set $slot (call $indexSlot (local.get $addr) (local.get $len) (local.get $h)))
+    (if (i32.load (local.get $slot))
+      (then
+        (if (local.get $replace)
+          (then (i32.store (local.get $slot) (local.get $entryP))))
+        (return)))
+    (global.set $dictionaryIndexCount (i32.add (global.get $dictionaryIndexCount) (i32.const 1)))
+    (if (i32.gt_u (global.get $dictionaryIndexCount) (global.get $dictionaryIndexMax))
+      (then (return)))
+    (i32.store (local.get $slot) (local.get $entryP))
+    (drop (call $bloomBit (local.get $h) (i32.const 1)))
+    (drop (call $bloomBit (i32.shr_u (local.get $h) (i32.const 18)) (i32.const 1))))
+
+  ;; Rebuilds the index from scratch
+  (func $indexDictionary
+    (local $entryP i32)
+    (memory.fill
+      (i32.const 0x32800 (; = DICTIONARY_BLOOM_BASE ;))
+      (i32.const 0)
+      (i32.const 0x800 (; = DICTIONARY_BLOOM_BITS/8 ;)))
+    (memory.fill
+      (global.get $dictionaryIndexBase)
+      (i32.const 0)
+      (i32.shl (i32.add (global.get $dictionaryIndexMask) (i32.const 1)) (i32.const 2)))
+    (global.set $dictionaryIndexCount (i32.const 0))
+    (local.set $entryP (global.get $latest))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eqz (local.get $entryP)))
+        (if (i32.eqz (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
+                              (i32.const 0x20 (; = F_HIDDEN ;))))
+          (then (call $indexEntry (local.get $entryP) (i32.const 0))))
+        (local.set $entryP (i32.load (local.get $entryP)))
+        (br $loop)))
+    (global.set $dictionaryIndexLatest (global.get $latest)))
+
+  ;; The `latest` entry the index is up to date with
+  (global $dictionaryIndexLatest (mut i32) (i32.const 0))
+
+  ;; Number of names in the index
+  (global $dictionaryIndexCount (mut i32) (i32.const 0))
+
+  ;; The index table, and the number of names it can hold
+  (global $dictionaryIndexBase (mut i32) (i32.const 0x33000 (; = DICTIONARY_INDEX_BASE ;)))
+  (global $dictionaryIndexMask (mut i32) (i32.const 0x1fff (; = DICTIONARY_INDEX_SLOTS - 1 ;)))
+  (global $dictionaryIndexMax (mut i32) (i32.const 0x1800 (; = DICTIONARY_INDEX_SLOTS * 3 / 4 ;)))
+
+  ;; Uses a table with the given number of slots at the given address
+  (func $setIndexTable (param $base i32) (param $slots i32)
+    (global.set $dictionaryIndexBase (local.get $base))
+    (global.set $dictionaryIndexMask (i32.sub (local.get $slots) (i32.const 1)))
+    (global.set $dictionaryIndexMax
+      (i32.sub (local.get $slots) (i32.shr_u (local.get $slots) (i32.const 2)))))
+
+  ;; Moves the index to a table at HERE that is at least twice as big, and
+  ;; has room for all words in the dictionary
+  (func $growIndex
+    (local $n i32)
+    (local $entryP i32)
+    (local $slots i32)
+    (local $base i32)
+    (local.set $entryP (global.get $latest))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eqz (local.get $entryP)))
+        (local.set $n (i32.add (local.get $n) (i32.const 1)))
+        (local.set $entryP (i32.load (local.get $entryP)))
+        (br $loop)))
+    (local.set $slots (i32.shl (i32.add (global.get $dictionaryIndexMask) (i32.const 1)) (i32.const 1)))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop
+          (i32.le_u
+            (i32.add (local.get $n) (i32.const 2))
+            (i32.sub (local.get $slots) (i32.shr_u (local.get $slots) (i32.const 2)))))
+        (local.set $slots (i32.shl (local.get $slots) (i32.const 1)))
+        (br $loop)))
+    (local.set $base (global.get $here))
+    (call $setHere (i32.add (local.get $base) (i32.shl (local.get $slots) (i32.const 2))))
+    (call $setIndexTable (local.get $base) (local.get $slots))
+    (call $indexDictionary))
+
   ;; Returns xt, type (0 = not found, 1 = immediate, -1 = non-immediate)
   (func $find (param $addr i32) (param $len i32) (result i32) (result i32)
+    (local $h i32)
+    (local $entryP i32)
+    (if (i32.ne (global.get $latest) (global.get $dictionaryIndexLatest))
+      (then (call $indexDictionary)))
+    (if (i32.gt_u (global.get $dictionaryIndexCount) (global.get $dictionaryIndexMax))
+      (then (return (call $findSlow (local.get $addr) (local.get $len)))))
+    (local.set $h (call $hashName (local.get $addr) (local.get $len)))
+    (block $notFound
+      (br_if $notFound (i32.eqz (call $bloomBit (local.get $h) (i32.const 0))))
+      (br_if $notFound (i32.eqz (call $bloomBit (i32.shr_u (local.get $h) (i32.const 18)) (i32.const 0))))
+      (br_if $notFound (i32.eqz (local.get $len)))
+      (br_if $notFound
+        (i32.eqz
+          (local.tee $entryP
+            (i32.load (call $indexSlot (local.get $addr) (local.get $len) (local.get $h))))))
+      (return
+        (local.get $entryP)
+        (if (result i32) (i32.eqz (i32.and (i32.load8_u (i32.add (local.get $entryP) (i32.const 4)))
+                                           (i32.const 0x80 (; = F_IMMEDIATE ;))))
+          (then (i32.const -1))
+          (else (i32.const 1)))))
+    (i32.const 0) (i32.const 0))
+
+  ;; Walks the dictionary to find a word (see $find)
+  (func $findSlow (param $addr i32) (param $len i32) (result i32) (result i32)
     (local $entryP i32)
     (local $entryLF i32)
     (local.set $entryP (global.get $latest))
@@ -3248,14 +5532,347 @@
       (i32.add (local.get $addr) (i32.const 3))
       (i32.const -4 (; ~3 ;))))
 
-  (func $U._ (param $v i32) (param $base i32)
-    (local $m i32)
-    (local.set $m (i32.rem_u (local.get $v) (local.get $base)))
-    (local.set $v (i32.div_u (local.get $v) (local.get $base)))
-    (if (i32.eqz (local.get $v))
-      (then)
-      (else (call $U._ (local.get $v) (local.get $base))))
-    (call $shell_emit (call $numberToChar (local.get $m))))
+  ;; Types an unsigned number in the current base, followed by a space, and
+  ;; preceded by a minus sign if `negative` is set.
+  ;; The number is formatted in the pictured output region, so it can be
+  ;; typed in one go.
+  (func $U._ (param $v i32) (param $negative i32)
+    (local $base i32)
+    (local $p i32)
+    (local $end i32)
+    (local.set $base (i32.load (i32.const 0x3b4d8 (; = body(BASE) ;))))
+    (local.set $end (i32.add (global.get $here) (i32.const 0x200 (; = PICTURED_OUTPUT_OFFSET ;))))
+    (i32.store8 (local.tee $p (i32.sub (local.get $end) (i32.const 1))) (i32.const 0x20 (; = ' ' ;)))
+    (loop $loop
+      (i32.store8 (local.tee $p (i32.sub (local.get $p) (i32.const 1)))
+        (call $numberToChar (i32.rem_u (local.get $v) (local.get $base))))
+      (br_if $loop (local.tee $v (i32.div_u (local.get $v) (local.get $base)))))
+    (if (local.get $negative)
+      (then (i32.store8 (local.tee $p (i32.sub (local.get $p) (i32.const 1))) (i32.const 0x2d (; = '-' ;)))))
+    (call $shell_type (local.get $p) (i32.sub (local.get $end) (local.get $p))))
+
+  ;; Heap
+  ;;
+  ;; Memory for ALLOCATE, FREE, and RESIZE. The heap lives in its own region
+  ;; above the data space (which can't grow beyond it), and grows upward,
+  ;; growing memory as needed. The region is set up on the first allocation,
+  ;; at the end of memory, leaving the data space at least
+  ;; HEAP_DATA_SPACE_ROOM bytes to grow. Until then, the data space can grow
+  ;; up to MAX_MEMORY_SIZE.
+  ;;
+  ;; Every block starts with a header cell holding the size of the block
+  ;; (including the header, a multiple of 8) OR-ed with flags. The address
+  ;; handed out is the one right after the header.
+  ;;
+  ;; Free small blocks (up to HEAP_SMALL_MAX bytes) are kept in a singly
+  ;; linked list per size (the bins at the start of the heap), and are reused as is, so
+  ;; allocating and freeing them is a matter of popping and pushing a list
+  ;; entry. Free large blocks are kept in a doubly linked list, and are split
+  ;; on allocation (also for small requests whose bin is empty), and merged
+  ;; with their free large neighbours when freed.
+  ;; A free large block has the address of the next and previous free large
+  ;; block after its header, and repeats its size in its last cell, so the
+  ;; block after it can find it (see HEAP_PREV_FREE). Free large blocks at
+  ;; the end of the heap are given back to the unused part of the region.
+  ;; Requests that can't be served from the free lists are carved from the
+  ;; end of the heap.
+  ;;
+  ;;   HEAP_DATA_SPACE_ROOM := 0x100000
+  ;;   HEAP_BINS_SIZE       :=    0x100   (room for the bins, before the first block)
+  ;;   HEAP_SMALL_MAX       :=    0x100
+  ;;   HEAP_MAX_REQUEST     := 0x7fff0000 (MAX_MEMORY_SIZE - 64 KiB)
+  ;;
+  ;; Block header flags:
+  ;;   HEAP_USED      := 0x1  (Block is allocated)
+  ;;   HEAP_PREV_FREE := 0x2  (Previous block is a free large block)
+  ;;
+  ;; Error codes (the THROW codes of the standard):
+  ;;   ERR_ALLOCATE := -59
+  ;;   ERR_FREE     := -60
+  ;;   ERR_RESIZE   := -61
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; Start of the heap region (0 if the heap hasn't been set up yet)
+  (global $heapBase (mut i32) (i32.const 0))
+
+  ;; End of the heap (0 if the heap hasn't been set up yet)
+  (global $heapTop (mut i32) (i32.const 0))
+
+  ;; First block in the list of free large blocks
+  (global $heapLarge (mut i32) (i32.const 0))
+
+  ;; Statistics (see HEAP-STATS)
+  (global $heapUsed (mut i32) (i32.const 0))
+  (global $heapFree (mut i32) (i32.const 0))
+  (global $heapFreeBlocks (mut i32) (i32.const 0))
+
+  ;; Returns where the data space has to end (on task threads, where their
+  ;; transient regions end; see Tasks)
+  (func $dataSpaceEnd (result i32)
+    (if (global.get $taskStacks)
+      (then (return (i32.add (global.get $taskStacks) (i32.const 0x5800 (; = TASK_STACKS_SIZE ;))))))
+    (select
+      (global.get $heapBase)
+      (i32.const 0x80000000 (; = MAX_MEMORY_SIZE ;))
+      (global.get $heapBase)))
+
+  ;; Makes sure memory extends up to `end`, growing it if necessary.
+  ;; Returns 0 if memory can't grow that far (or can't grow at all, see Tasks).
+  (func $heapReserve (param $end i32) (result i32)
+    (if (i32.le_u (local.get $end) (i32.shl (memory.size) (i32.const 16)))
+      (then (return (i32.const 1))))
+    (if (global.get $spawnedTasks)
+      (then (return (i32.const 0))))
+    (i32.ne
+      (memory.grow
+        (i32.sub
+          (i32.shr_u (i32.add (local.get $end) (i32.const 0xffff)) (i32.const 16))
+          (memory.size)))
+      (i32.const -1)))
+
+  ;; Returns the size of the block that holds `u` bytes, or 0 if
+  ;; there is no such block
+  (func $heapBlockSize (param $u i32) (result i32)
+    (local $size i32)
+    (if (i32.gt_u (local.get $u) (i32.const 0x7fff0000 (; = HEAP_MAX_REQUEST ;)))
+      (then (return (i32.const 0))))
+    (select
+      (i32.const 16)
+      (local.tee $size (i32.and (i32.add (local.get $u) (i32.const 11)) (i32.const -8 (; ~7 ;))))
+      (i32.lt_u (local.get $size) (i32.const 16))))
+
+  ;; Returns the block of an allocated address, or 0 if it can't be one.
+  ;; This is a sanity check, not a validation: it only checks that the address
+  ;; is aligned, lies within the heap, and follows a header marked as used.
+  ;; An address inside an allocated block can pass, and FREE or RESIZE of such
+  ;; an address corrupts the heap.
+  (func $heapBlock (param $addr i32) (result i32)
+    (if (i32.or
+          (i32.or
+            (i32.and (local.get $addr) (i32.const 3))
+            (i32.lt_u (local.get $addr) (i32.add (global.get $heapBase) (i32.const 0x104 (; = HEAP_BINS_SIZE + 4 ;)))))
+          (i32.ge_u (local.get $addr) (global.get $heapTop)))
+      (then (return (i32.const 0))))
+    (if (i32.eqz (i32.and (i32.load (i32.sub (local.get $addr) (i32.const 4))) (i32.const 0x1 (; = HEAP_USED ;))))
+      (then (return (i32.const 0))))
+    (i32.sub (local.get $addr) (i32.const 4)))
+
+  (func $heapLink (param $b i32)
+    (i32.store (i32.add (local.get $b) (i32.const 4)) (global.get $heapLarge))
+    (i32.store (i32.add (local.get $b) (i32.const 8)) (i32.const 0))
+    (if (global.get $heapLarge)
+      (then (i32.store (i32.add (global.get $heapLarge) (i32.const 8)) (local.get $b))))
+    (global.set $heapLarge (local.get $b)))
+
+  (func $heapUnlink (param $b i32)
+    (local $next i32)
+    (local $prev i32)
+    (local.set $next (i32.load (i32.add (local.get $b) (i32.const 4))))
+    (if (local.tee $prev (i32.load (i32.add (local.get $b) (i32.const 8))))
+      (then (i32.store (i32.add (local.get $prev) (i32.const 4)) (local.get $next)))
+      (else (global.set $heapLarge (local.get $next))))
+    (if (local.get $next)
+      (then (i32.store (i32.add (local.get $next) (i32.const 8)) (local.get $prev)))))
+
+  ;; Returns the address of a new block of `u` bytes, or 0 if there
+  ;; is no room for it.
+  (func $heapAllocate (param $u i32) (result i32)
+    (local $size i32)
+    (local $bin i32)
+    (local $b i32)
+    (local $bsize i32)
+    (if (i32.eqz (local.tee $size (call $heapBlockSize (local.get $u))))
+      (then (return (i32.const 0))))
+
+    ;; Set up the heap region
+    (if (i32.eqz (global.get $heapTop))
+      (then
+        (local.set $b (i32.add (global.get $here) (i32.const 0x100000 (; = HEAP_DATA_SPACE_ROOM ;))))
+        (if (i32.lt_u (local.get $b) (i32.shl (memory.size) (i32.const 16)))
+          (then (local.set $b (i32.shl (memory.size) (i32.const 16)))))
+        (local.set $b (i32.and (i32.add (local.get $b) (i32.const 0xffff)) (i32.const -0x10000)))
+        (if (i32.eqz (call $heapReserve (i32.add (local.get $b) (i32.const 0x100 (; = HEAP_BINS_SIZE ;)))))
+          (then (return (i32.const 0))))
+        (memory.fill (local.get $b) (i32.const 0) (i32.const 0x100 (; = HEAP_BINS_SIZE ;)))
+        (global.set $heapBase (local.get $b))
+        (global.set $heapTop (i32.add (local.get $b) (i32.const 0x100 (; = HEAP_BINS_SIZE ;))))))
+
+    (block $found
+      (if (i32.le_u (local.get $size) (i32.const 0x100 (; = HEAP_SMALL_MAX ;)))
+        (then
+          ;; Reuse a free block from the bin of this size
+          (if (local.tee $b
+                (i32.load
+                  (local.tee $bin
+                    (i32.add (global.get $heapBase) (i32.shr_u (local.get $size) (i32.const 1))))))
+            (then
+              (i32.store (local.get $bin) (i32.load (i32.add (local.get $b) (i32.const 4))))
+              (i32.store (local.get $b) (i32.or (i32.load (local.get $b)) (i32.const 0x1 (; = HEAP_USED ;))))
+              (global.set $heapUsed (i32.add (global.get $heapUsed) (local.get $size)))
+              (global.set $heapFree (i32.sub (global.get $heapFree) (local.get $size)))
+              (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1)))
+              (return (i32.add (local.get $b) (i32.const 4)))))
+          ;; Any free large block will do
+          (local.set $b (global.get $heapLarge)))
+        (else
+          ;; Take the first free large block that is large enough
+          (local.set $b (global.get $heapLarge))
+          (block $endLoop
+            (loop $loop
+              (br_if $endLoop (i32.eqz (local.get $b)))
+              (br_if $endLoop (i32.ge_u (i32.load (local.get $b)) (local.get $size)))
+              (local.set $b (i32.load (i32.add (local.get $b) (i32.const 4))))
+              (br $loop)))))
+
+      ;; Carve a new block from the end of the heap
+      (if (i32.eqz (local.get $b))
+        (then
+          (local.set $b (global.get $heapTop))
+          (if (i32.eqz (call $heapReserve (i32.add (local.get $b) (local.get $size))))
+            (then (return (i32.const 0))))
+          (i32.store (local.get $b) (i32.or (local.get $size) (i32.const 0x1 (; = HEAP_USED ;))))
+          (global.set $heapTop (i32.add (local.get $b) (local.get $size)))
+          (global.set $heapUsed (i32.add (global.get $heapUsed) (local.get $size)))
+          (return (i32.add (local.get $b) (i32.const 4)))))
+
+      ;; Take the free large block
+      (call $heapUnlink (local.get $b))
+      (i32.store (local.get $b) (i32.or (local.tee $bsize (i32.load (local.get $b))) (i32.const 0x1 (; = HEAP_USED ;))))
+      (i32.store (i32.add (local.get $b) (local.get $bsize))
+        (i32.and (i32.load (i32.add (local.get $b) (local.get $bsize))) (i32.const -3 (; ~HEAP_PREV_FREE ;)))))
+
+    (global.set $heapUsed (i32.add (global.get $heapUsed) (local.get $bsize)))
+    (global.set $heapFree (i32.sub (global.get $heapFree) (local.get $bsize)))
+    (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1)))
+    (call $heapShrink (local.get $b) (local.get $size))
+    (i32.add (local.get $b) (i32.const 4)))
+
+  ;; Frees an allocated block
+  (func $heapRelease (param $b i32)
+    (local $h i32)
+    (local $size i32)
+    (local $n i32)
+    (local $nh i32)
+    (local.set $size (i32.and (local.tee $h (i32.load (local.get $b))) (i32.const -8 (; ~7 ;))))
+    (global.set $heapUsed (i32.sub (global.get $heapUsed) (local.get $size)))
+    (global.set $heapFree (i32.add (global.get $heapFree) (local.get $size)))
+    (global.set $heapFreeBlocks (i32.add (global.get $heapFreeBlocks) (i32.const 1)))
+
+    ;; Push small blocks onto their bin
+    (if (i32.le_u (local.get $size) (i32.const 0x100 (; = HEAP_SMALL_MAX ;)))
+      (then
+        (i32.store (local.get $b) (i32.and (local.get $h) (i32.const -2 (; ~HEAP_USED ;))))
+        (i32.store (i32.add (local.get $b) (i32.const 4))
+          (i32.load (local.tee $n (i32.add (global.get $heapBase) (i32.shr_u (local.get $size) (i32.const 1))))))
+        (i32.store (local.get $n) (local.get $b))
+        (return)))
+
+    ;; Merge with the previous block
+    (if (i32.and (local.get $h) (i32.const 0x2 (; = HEAP_PREV_FREE ;)))
+      (then
+        (local.set $b (i32.sub (local.get $b) (local.tee $n (i32.load (i32.sub (local.get $b) (i32.const 4))))))
+        (local.set $size (i32.add (local.get $size) (local.get $n)))
+        (call $heapUnlink (local.get $b))
+        (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1)))))
+
+    ;; Give the block back if it's at the end of the heap
+    (if (i32.eq (local.tee $n (i32.add (local.get $b) (local.get $size))) (global.get $heapTop))
+      (then
+        (global.set $heapTop (local.get $b))
+        (global.set $heapFree (i32.sub (global.get $heapFree) (local.get $size)))
+        (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1)))
+        (return)))
+
+    ;; Merge with the next block
+    (if (i32.and
+          (i32.eqz (i32.and (local.tee $nh (i32.load (local.get $n))) (i32.const 0x1 (; = HEAP_USED ;))))
+          (i32.gt_u (i32.and (local.get $nh) (i32.const -8 (; ~7 ;))) (i32.const 0x100 (; = HEAP_SMALL_MAX ;))))
+      (then
+        (call $heapUnlink (local.get $n))
+        (local.set $size (i32.add (local.get $size) (local.get $nh)))
+        (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1))))
+      (else
+        (i32.store (local.get $n) (i32.or (local.get $nh) (i32.const 0x2 (; = HEAP_PREV_FREE ;))))))
+
+    (i32.store (local.get $b) (local.get $size))
+    (i32.store (i32.sub (i32.add (local.get $b) (local.get $size)) (i32.const 4)) (local.get $size))
+    (call $heapLink (local.get $b)))
+
+  ;; Shrinks an allocated block to `size` bytes, freeing the rest.
+  ;; Only splits off blocks that can be merged again, so small blocks keep
+  ;; their size, and the number of free small blocks stays bounded.
+  (func $heapShrink (param $b i32) (param $size i32)
+    (local $h i32)
+    (local $rest i32)
+    (if (i32.le_u
+          (local.tee $rest
+            (i32.sub
+              (i32.and (local.tee $h (i32.load (local.get $b))) (i32.const -8 (; ~7 ;)))
+              (local.get $size)))
+          (i32.const 0x100 (; = HEAP_SMALL_MAX ;)))
+      (then (return)))
+    (i32.store (local.get $b) (i32.or (local.get $size) (i32.and (local.get $h) (i32.const 7))))
+    (i32.store (i32.add (local.get $b) (local.get $size)) (i32.or (local.get $rest) (i32.const 0x1 (; = HEAP_USED ;))))
+    (call $heapRelease (i32.add (local.get $b) (local.get $size))))
+
+  ;; Returns the address of a block of `u` bytes with the contents of the
+  ;; block at `b`, or 0 if there is no room for it (in which case the
+  ;; original block is left as is)
+  (func $heapResize (param $b i32) (param $u i32) (result i32)
+    (local $h i32)
+    (local $size i32)
+    (local $bsize i32)
+    (local $n i32)
+    (local $nh i32)
+    (local $addr i32)
+    (if (i32.eqz (local.tee $size (call $heapBlockSize (local.get $u))))
+      (then (return (i32.const 0))))
+    (local.set $bsize (i32.and (local.tee $h (i32.load (local.get $b))) (i32.const -8 (; ~7 ;))))
+
+    ;; Shrink in place (large blocks stay large, so the number of small
+    ;; blocks only grows when their bin is empty)
+    (if (i32.le_u (local.get $size) (local.get $bsize))
+      (then
+        (call $heapShrink (local.get $b)
+          (select
+            (i32.const 0x108 (; = HEAP_SMALL_MAX + 8 ;))
+            (local.get $size)
+            (i32.and
+              (i32.le_u (local.get $size) (i32.const 0x100 (; = HEAP_SMALL_MAX ;)))
+              (i32.gt_u (local.get $bsize) (i32.const 0x100 (; = HEAP_SMALL_MAX ;))))))
+        (return (i32.add (local.get $b) (i32.const 4)))))
+
+    (block $move
+      ;; Small blocks keep their size (see `heapShrink`)
+      (br_if $move (i32.le_u (local.get $size) (i32.const 0x100 (; = HEAP_SMALL_MAX ;))))
+      (if (i32.eq (local.tee $n (i32.add (local.get $b) (local.get $bsize))) (global.get $heapTop))
+        (then
+          ;; Grow in place at the end of the heap
+          (br_if $move (i32.eqz (call $heapReserve (i32.add (local.get $b) (local.get $size)))))
+          (i32.store (local.get $b) (i32.or (local.get $size) (i32.and (local.get $h) (i32.const 7))))
+          (global.set $heapTop (i32.add (local.get $b) (local.get $size)))
+          (global.set $heapUsed (i32.add (global.get $heapUsed) (i32.sub (local.get $size) (local.get $bsize)))))
+        (else
+          ;; Grow in place into a free large block after it
+          (br_if $move (i32.and (local.tee $nh (i32.load (local.get $n))) (i32.const 0x1 (; = HEAP_USED ;))))
+          (br_if $move (i32.le_u (local.get $nh) (i32.const 0x100 (; = HEAP_SMALL_MAX ;))))
+          (br_if $move (i32.lt_u (i32.add (local.get $bsize) (local.get $nh)) (local.get $size)))
+          (call $heapUnlink (local.get $n))
+          (i32.store (i32.add (local.get $n) (local.get $nh))
+            (i32.and (i32.load (i32.add (local.get $n) (local.get $nh))) (i32.const -3 (; ~HEAP_PREV_FREE ;))))
+          (i32.store (local.get $b) (i32.or (i32.add (local.get $bsize) (local.get $nh)) (i32.and (local.get $h) (i32.const 7))))
+          (global.set $heapUsed (i32.add (global.get $heapUsed) (local.get $nh)))
+          (global.set $heapFree (i32.sub (global.get $heapFree) (local.get $nh)))
+          (global.set $heapFreeBlocks (i32.sub (global.get $heapFreeBlocks) (i32.const 1)))
+          (call $heapShrink (local.get $b) (local.get $size))))
+      (return (i32.add (local.get $b) (i32.const 4))))
+
+    ;; Move to a new block
+    (if (i32.eqz (local.tee $addr (call $heapAllocate (local.get $u))))
+      (then (return (i32.const 0))))
+    (memory.copy (local.get $addr) (i32.add (local.get $b) (i32.const 4)) (i32.sub (local.get $bsize) (i32.const 4)))
+    (call $heapRelease (local.get $b))
+    (local.get $addr))
 
   ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
   ;; API Functions
@@ -3273,4 +5890,186 @@
   (func (export "tos") (result i32) (global.get $tos))
   (func (export "here") (result i32) (global.get $here))
   (func (export "error") (result i32) (global.get $error))
+
+  ;; Limits the size of the modules of compiled words (at most 64 KiB).
+  ;; Definitions that don't fit fail with "definition too long".
+  (func (export "setModuleSizeLimit") (param $size i32)
+    (global.set $codeLimit
+      (i32.sub
+        (i32.add (i32.const 0x20000 (; = MODULE_HEADER_BASE ;))
+          (select (local.get $size) (i32.const 0x10000)
+            (i32.lt_u (local.get $size) (i32.const 0x10000))))
+        (i32.const 0x200 (; = MODULE_CODE_ROOM ;)))))
+
+  ;; Tasks
+  ;;
+  ;; Hosts with threads can run the iterations of PAR-DO, and tasks started
+  ;; with SPAWN, on other threads. Every thread needs its own instance of the
+  ;; core (sharing the memory and the table entries of the main instance),
+  ;; and its own stacks, which it allocates from the heap of the main
+  ;; instance up front. The stacks start with a TCB (see Scheduler), which
+  ;; holds the USER variables of the thread, and end with the transient
+  ;; regions of the thread (PAD, WORD, pictured output), which is where HERE
+  ;; points on the thread.
+  ;;
+  ;;   TASK_TCB_OFFSET          := 0x0
+  ;;   TASK_RETURN_STACK_OFFSET := 0x100
+  ;;   TASK_STACK_OFFSET        := 0x1000
+  ;;   TASK_HERE_OFFSET         := 0x5000
+  ;;   TASK_STACKS_SIZE         := 0x5800 (TASK_HERE_OFFSET + 0x800, at least HERE_RESERVE)
+  ;;
+  ;; The globals of an instance are only its own, so before handing out
+  ;; work, the main instance publishes what task threads need to find words
+  ;; at TASK_STATE_BASE:
+  ;;
+  ;;   TASK_STATE_LATEST       := 0x0
+  ;;   TASK_STATE_INDEX_LATEST := 0x4  (see Dictionary index)
+  ;;   TASK_STATE_INDEX_COUNT  := 0x8
+  ;;   TASK_STATE_INDEX_BASE   := 0xc
+  ;;   TASK_STATE_INDEX_MASK   := 0x10
+  ;;   TASK_STATE_INDEX_MAX    := 0x14
+  ;;
+  ;; Task threads only read the dictionary and the heap, and don't have an
+  ;; input source, so they can't change the data space (e.g. ALLOT or `,`),
+  ;; compile, ALLOCATE, RESIZE, or FREE memory, or parse (e.g. EVALUATE or
+  ;; WORD). These throw EXC_UNSUPPORTED. Hosts keep a copy of the memory for
+  ;; every task, so memory can't grow while tasks started with SPAWN haven't
+  ;; been waited for with JOIN.
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; The stacks of the task thread this instance runs on, or 0 on the main
+  ;; thread
+  (global $taskStacks (mut i32) (i32.const 0))
+
+  ;; Number of tasks started with SPAWN that haven't been joined
+  (global $spawnedTasks (mut i32) (i32.const 0))
+
+  ;; Fails if called on a task thread
+  (func $checkMainThread
+    (if (global.get $taskStacks)
+      (then (call $fail (i32.const -0x15 (; = EXC_UNSUPPORTED ;)) (i32.const 0x3b0ef (; = str("not supported in a task thread") ;))))))
+
+  ;; Publishes the state for the task threads at TASK_STATE_BASE
+  (func $publishTaskState
+    ;; Bring the dictionary index up to date, so task threads don't update it
+    (if (i32.ne (global.get $latest) (global.get $dictionaryIndexLatest))
+      (then (call $indexDictionary)))
+    (i32.store (i32.const 0x30900 (; = TASK_STATE_BASE + TASK_STATE_LATEST ;)) (global.get $latest))
+    (i32.store (i32.const 0x30904 (; = TASK_STATE_BASE + TASK_STATE_INDEX_LATEST ;)) (global.get $dictionaryIndexLatest))
+    (i32.store (i32.const 0x30908 (; = TASK_STATE_BASE + TASK_STATE_INDEX_COUNT ;)) (global.get $dictionaryIndexCount))
+    (i32.store (i32.const 0x3090c (; = TASK_STATE_BASE + TASK_STATE_INDEX_BASE ;)) (global.get $dictionaryIndexBase))
+    (i32.store (i32.const 0x30910 (; = TASK_STATE_BASE + TASK_STATE_INDEX_MASK ;)) (global.get $dictionaryIndexMask))
+    (i32.store (i32.const 0x30914 (; = TASK_STATE_BASE + TASK_STATE_INDEX_MAX ;)) (global.get $dictionaryIndexMax)))
+
+  ;; Returns the address of the stacks for a task thread, or 0 if there is no
+  ;; room for them.
+  (func (export "allocateTaskStacks") (result i32)
+    (local $stacks i32)
+    (local $tcb i32)
+    (if (i32.eqz (local.tee $stacks (call $heapAllocate (i32.const 0x5800 (; = TASK_STACKS_SIZE ;)))))
+      (then (return (i32.const 0))))
+    (local.set $tcb (i32.add (local.get $stacks) (i32.const 0x0 (; = TASK_TCB_OFFSET ;))))
+    (memory.fill (local.get $tcb) (i32.const 0) (i32.const 0x94 (; = TCB_SIZE ;)))
+    (i32.store (i32.add (local.get $tcb) (i32.const 0x10 (; = TCB_STACK_BASE ;)))
+      (i32.add (local.get $stacks) (i32.const 0x1000 (; = TASK_STACK_OFFSET ;))))
+    (local.get $stacks))
+
+  ;; Executes `xt` `count` times, with the indexes from `start` on the stack,
+  ;; on the task thread with the stacks at `stacks`.
+  ;; Returns the code of the first exception, or 0.
+  (func (export "runTask") (param $stacks i32) (param $xt i32) (param $start i32) (param $count i32) (result i32)
+    (local $i i32)
+    (local $n i32)
+    (local $prevCatchDepth i32)
+    (local $prevTors i32)
+    (local $prevUp i32)
+    (local $prevHere i32)
+    (local $prevLatest i32)
+    (local $prevIndexBase i32)
+    (local $prevIndexMask i32)
+    (local $prevIndexMax i32)
+    (local.set $i (local.get $start))
+    (local.set $prevCatchDepth (global.get $catchDepth))
+    (local.set $prevTors (global.get $tors))
+    (local.set $prevUp (global.get $up))
+    (local.set $prevHere (global.get $here))
+    (local.set $prevLatest (global.get $latest))
+    (local.set $prevIndexBase (global.get $dictionaryIndexBase))
+    (local.set $prevIndexMask (global.get $dictionaryIndexMask))
+    (local.set $prevIndexMax (global.get $dictionaryIndexMax))
+    (global.set $latest (i32.load (i32.const 0x30900 (; = TASK_STATE_BASE + TASK_STATE_LATEST ;))))
+    (global.set $dictionaryIndexLatest (i32.load (i32.const 0x30904 (; = TASK_STATE_BASE + TASK_STATE_INDEX_LATEST ;))))
+    (global.set $dictionaryIndexCount (i32.load (i32.const 0x30908 (; = TASK_STATE_BASE + TASK_STATE_INDEX_COUNT ;))))
+    (global.set $dictionaryIndexBase (i32.load (i32.const 0x3090c (; = TASK_STATE_BASE + TASK_STATE_INDEX_BASE ;))))
+    (global.set $dictionaryIndexMask (i32.load (i32.const 0x30910 (; = TASK_STATE_BASE + TASK_STATE_INDEX_MASK ;))))
+    (global.set $dictionaryIndexMax (i32.load (i32.const 0x30914 (; = TASK_STATE_BASE + TASK_STATE_INDEX_MAX ;))))
+    (global.set $taskStacks (local.get $stacks))
+    (global.set $here (i32.add (local.get $stacks) (i32.const 0x5000 (; = TASK_HERE_OFFSET ;))))
+    ;; Exceptions end the task, instead of aborting
+    (global.set $catchDepth (i32.const 1))
+    (global.set $up (i32.add (local.get $stacks) (i32.const 0x0 (; = TASK_TCB_OFFSET ;))))
+    (block $endLoop
+      (loop $loop
+        (br_if $endLoop (i32.eqz (local.get $count)))
+        (global.set $tors (i32.add (local.get $stacks) (i32.const 0x100 (; = TASK_RETURN_STACK_OFFSET ;))))
+        (call $tryExecute
+          (call $push
+            (i32.add (local.get $stacks) (i32.const 0x1000 (; = TASK_STACK_OFFSET ;)))
+            (local.get $i))
+          (local.get $xt))
+        (local.set $n)
+        (drop)
+        (br_if $endLoop (local.get $n))
+        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+        (local.set $count (i32.sub (local.get $count) (i32.const 1)))
+        (br $loop)))
+    (global.set $catchDepth (local.get $prevCatchDepth))
+    (global.set $tors (local.get $prevTors))
+    (global.set $up (local.get $prevUp))
+    (global.set $here (local.get $prevHere))
+    (global.set $taskStacks (i32.const 0))
+    ;; Rebuild the dictionary index on the next lookup
+    (global.set $latest (local.get $prevLatest))
+    (global.set $dictionaryIndexBase (local.get $prevIndexBase))
+    (global.set $dictionaryIndexMask (local.get $prevIndexMask))
+    (global.set $dictionaryIndexMax (local.get $prevIndexMax))
+    (global.set $dictionaryIndexLatest (i32.const 0))
+    (local.get $n))
+
+  ;; Used by the host to implement $tryExecute on engines without exception
+  ;; handling (see `Exceptions`)
+  ;; traps: (export "execute" (func $execute))
+
+  ;; Fuel
+  ;;
+  ;; Hosts that run untrusted code (e.g. the server of the standalone shell)
+  ;; can limit how long a run takes, by giving it fuel (see `setFuel`). Every
+  ;; loop iteration burns fuel, and running out aborts the run, without
+  ;; giving CATCH a chance to continue.
+  ;;
+  ;; Loops only count iterations if they were compiled while there was a
+  ;; limit, so words compiled without one (e.g. in an image) cost nothing
+  ;; extra, but aren't limited either. The loops of built-in words aren't
+  ;; limited, except for PAR-DO (when the host doesn't run it).
+  ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+  ;; Loop iterations left in this run, or -1 if there is no limit
+  (global $fuel (mut i32) (i32.const -1))
+
+  (func $burnFuel (param $tos i32) (result i32)
+    (if (i32.eqz (global.get $fuel))
+      (then
+        (call $ctype (i32.const 0x3b130 (; = str("out of fuel") ;)))
+        (call $shell_emit (i32.const 10))
+        (global.set $error (i32.const 0x3 (; = ERR_ABORT ;)))
+        (return (call $quit (i32.const 0x10000 (; = STACK_BASE ;))))))
+    (if (i32.ne (global.get $fuel) (i32.const -1))
+      (then (global.set $fuel (i32.sub (global.get $fuel) (i32.const 1)))))
+    (local.get $tos))
+  (elem (i32.const 0xc (; = BURN_FUEL_INDEX ;)) $burnFuel)
+
+  ;; Sets the number of loop iterations the next runs can take together
+  ;; (or -1 for no limit). Hosts typically set it before every run.
+  (func (export "setFuel") (param $fuel i32)
+    (global.set $fuel (local.get $fuel)))
 )
@@ -1,13 +1,25 @@
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <termios.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "wasm-rt-exceptions.h"
 #include "wasm-rt-impl.h"
 
 #include "_waforth.h"
 #include "_waforth_config.h"
+#include "_waforth_input.h"
 
 #define ERR_UNKNOWN 0x1
 #define ERR_QUIT 0x2
@@ -15,45 +27,43 @@
 #define ERR_EOI 0x4
 #define ERR_BYE 0x5
 
-#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+// The initialization program, or standard input if there is none
+input_t input;
 
-size_t initOffset = 0;
+// Whether to show prompts, and flush output before reading input
+static bool interactive = sizeof(waforth_init) == 0;
 
 struct w2c_shell {
   wasm_rt_memory_t *memory;
 };
 
+// Output is fully buffered, and flushed before waiting for user input,
+// on errors, and at exit
+static char outputBuffer[0x10000];
+
 void w2c_shell_emit(struct w2c_shell *mod, u32 c) {
   putchar(c);
 }
 
-u32 w2c_shell_read(struct w2c_shell *mod, u32 addr_, u32 len_) {
-  size_t len = len_;
-  char *addr = (char *)&mod->memory->data[addr_];
-  int n = 0;
-  if (sizeof(waforth_init) == 0) {
-    // Read from stdin
-    while (!(n = getline(&addr, &len, stdin))) {
-    }
-    if (n < 0) {
-      n = 0;
-    }
-  } else {
-    // Read from static input
-    int nend = MIN((size_t)len, sizeof(waforth_init) - initOffset);
-    for (; n < nend; ++n) {
-      if (waforth_init[initOffset + n] == '\n') {
-        n += 1;
-        break;
-      }
-    }
-    memcpy(addr, waforth_init + initOffset, n);
-    initOffset += n;
+void w2c_shell_type(struct w2c_shell *mod, u32 addr, u32 len) {
+  fwrite(&mod->memory->data[addr], 1, len, stdout);
+}
+
+u32 w2c_shell_read(struct w2c_shell *mod, u32 addr, u32 len) {
+  if (interactive) {
+    fflush(stdout);
+  }
+  int n = input_read_line(&input, (char *)&mod->memory->data[addr], len);
+  if (n == INPUT_LINE_TOO_LONG) {
+    // Stop reading, instead of splitting the line
+    printf("input line %zu is longer than %u bytes\n", input.lines + 1, len);
+    n = 0;
   }
   return n;
 }
 
 u32 w2c_shell_key(struct w2c_shell *mod) {
+  fflush(stdout);
   struct termios old, current;
   tcgetattr(0, &old);
   current = old;
@@ -79,12 +89,311 @@ void w2c_shell_load(struct w2c_shell *mod, u32 addr, u32 len) {
   wasm_rt_trap(WASM_RT_TRAP_UNREACHABLE);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Tasks
+//
+// The iterations of PAR-DO (split into chunks), and tasks started with SPAWN,
+// are jobs for a pool of worker threads. Every worker runs jobs on its own copy
+// of the instance, which shares the memory of the main instance, but has its
+// own globals, table entries that point back to the copy, and its own stacks
+// (see `runTask` in the core). PAR-DO and SPAWN publish the dictionary state of
+// the main instance in memory before queueing jobs, and `runTask` loads it, so
+// the globals of a copy are up to date for every job.
+//
+// Every worker has a queue of jobs. Workers take jobs from the back of their own
+// queue, and idle workers steal jobs from the front of other queues.
+//
+// The memory of the main instance may have grown (and moved) since a copy was
+// made, so every job carries the memory of the main instance at the time it was
+// queued, and the worker updates its copy before running the job. The core
+// makes sure that this memory stays valid: jobs can't change the data space,
+// compile, parse, or use the heap (these throw), their transient regions (such
+// as PAD) are part of their own stacks, and the main instance can't grow the
+// memory while tasks started with SPAWN haven't been joined.
+// PAR-DO and SPAWN from within a job run sequentially.
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of chunks per worker that the iterations of PAR-DO are split into
+#define CHUNKS_PER_WORKER 4
+
+// Exception code for a job that trapped
+#define EXC_ABORT ((u32)-1)
+
+// A set of jobs that are waited for together
+struct group {
+  size_t remaining;
+  u32 code; // Exception code of the first job that failed
+};
+
+struct job {
+  u32 xt;
+  u32 start;
+  u32 count;
+  wasm_rt_memory_t memory; // Memory of the main instance
+  struct group *group;
+  struct job *prev;
+  struct job *next;
+};
+
+struct worker {
+  pthread_t thread;
+  w2c_waforth instance;
+  u32 stacks;
+  pthread_mutex_t lock; // Protects the queue
+  struct job *first;
+  struct job *last;
+};
+
+static w2c_waforth *mainInstance;
+static struct worker *workers;
+static size_t workerCount;
+static size_t nextWorker;
+static bool noWorkers; // Whether the workers couldn't be started
+
+// Protects `pendingJobs`, `stopping`, and the `remaining` count of groups
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobsAvailable = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobsDone = PTHREAD_COND_INITIALIZER;
+static size_t pendingJobs;
+static bool stoppingWorkers;
+
+// Groups of the tasks started with SPAWN, indexed by task handle - 1
+static struct group **tasks;
+static size_t taskCount;
+
+static _Thread_local struct worker *currentWorker;
+
+static struct job *takeJob(struct worker *w, bool steal) {
+  pthread_mutex_lock(&w->lock);
+  struct job *job = steal ? w->first : w->last;
+  if (job != NULL) {
+    if (job->prev != NULL) {
+      job->prev->next = job->next;
+    } else {
+      w->first = job->next;
+    }
+    if (job->next != NULL) {
+      job->next->prev = job->prev;
+    } else {
+      w->last = job->prev;
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+  return job;
+}
+
+static void addJob(u32 xt, u32 start, u32 count, struct group *group) {
+  struct job *job = malloc(sizeof(struct job));
+  *job = (struct job){.xt = xt, .start = start, .count = count, .memory = *w2c_waforth_memory(mainInstance), .group = group};
+  struct worker *w = &workers[nextWorker];
+  nextWorker = (nextWorker + 1) % workerCount;
+  pthread_mutex_lock(&w->lock);
+  job->prev = w->last;
+  if (w->last != NULL) {
+    w->last->next = job;
+  } else {
+    w->first = job;
+  }
+  w->last = job;
+  pthread_mutex_unlock(&w->lock);
+
+  pthread_mutex_lock(&poolLock);
+  pendingJobs += 1;
+  pthread_cond_signal(&jobsAvailable);
+  pthread_mutex_unlock(&poolLock);
+}
+
+static u32 runJob(struct worker *w, struct job *job) {
+  wasm_rt_trap_t code = wasm_rt_impl_try();
+  if (code != 0) {
+    printf("trap %d in task\n", code);
+    return EXC_ABORT;
+  }
+  *w2c_waforth_memory(&w->instance) = job->memory;
+  return w2c_waforth_runTask(&w->instance, w->stacks, job->xt, job->start, job->count);
+}
+
+static void *work(void *arg) {
+  struct worker *w = arg;
+  currentWorker = w;
+  wasm_rt_init_thread();
+  for (;;) {
+    struct job *job = takeJob(w, false);
+    for (size_t i = 1; job == NULL && i < workerCount; ++i) {
+      job = takeJob(&workers[(w - workers + i) % workerCount], true);
+    }
+    if (job == NULL) {
+      pthread_mutex_lock(&poolLock);
+      while (pendingJobs == 0 && !stoppingWorkers) {
+        pthread_cond_wait(&jobsAvailable, &poolLock);
+      }
+      bool stop = pendingJobs == 0 && stoppingWorkers;
+      pthread_mutex_unlock(&poolLock);
+      if (stop) {
+        break;
+      }
+      continue;
+    }
+
+    pthread_mutex_lock(&poolLock);
+    pendingJobs -= 1;
+    pthread_mutex_unlock(&poolLock);
+
+    u32 code = runJob(w, job);
+
+    pthread_mutex_lock(&poolLock);
+    if (code != 0 && job->group->code == 0) {
+      job->group->code = code;
+    }
+    job->group->remaining -= 1;
+    if (job->group->remaining == 0) {
+      pthread_cond_broadcast(&jobsDone);
+    }
+    pthread_mutex_unlock(&poolLock);
+    free(job);
+  }
+  wasm_rt_free_thread();
+  return NULL;
+}
+
+static void waitForGroup(struct group *group) {
+  pthread_mutex_lock(&poolLock);
+  while (group->remaining > 0) {
+    pthread_cond_wait(&jobsDone, &poolLock);
+  }
+  pthread_mutex_unlock(&poolLock);
+}
+
+// Starts the workers if they aren't running yet.
+// The number of workers is the number of CPUs, or WAFORTH_THREADS.
+// Returns false if jobs need to run sequentially.
+static bool startWorkers() {
+  if (currentWorker != NULL || noWorkers) {
+    return false;
+  }
+  if (workerCount > 0) {
+    return true;
+  }
+  const char *threads = getenv("WAFORTH_THREADS");
+  long count = threads != NULL ? atol(threads) : sysconf(_SC_NPROCESSORS_ONLN);
+  if (count < 1) {
+    noWorkers = true;
+    return false;
+  }
+  workers = calloc(count, sizeof(struct worker));
+  for (long i = 0; i < count; ++i) {
+    struct worker *w = &workers[i];
+    w->stacks = w2c_waforth_allocateTaskStacks(mainInstance);
+    if (w->stacks == 0) {
+      printf("no room for task stacks\n");
+      for (long j = 0; j < i; ++j) {
+        free(w2c_waforth_table(&workers[j].instance)->data);
+      }
+      free(workers);
+      noWorkers = true;
+      return false;
+    }
+    w->instance = *mainInstance;
+
+    // Make the table entries of the copy call into the copy
+    wasm_rt_funcref_table_t *table = w2c_waforth_table(&w->instance);
+    wasm_rt_funcref_t *entries = malloc(table->size * sizeof(wasm_rt_funcref_t));
+    for (u32 j = 0; j < table->size; ++j) {
+      entries[j] = table->data[j];
+      if (entries[j].module_instance == mainInstance) {
+        entries[j].module_instance = &w->instance;
+      }
+    }
+    table->data = entries;
+
+    pthread_mutex_init(&w->lock, NULL);
+  }
+  workerCount = count;
+  for (size_t i = 0; i < workerCount; ++i) {
+    pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+  }
+  return true;
+}
+
+static void stopWorkers() {
+  pthread_mutex_lock(&poolLock);
+  stoppingWorkers = true;
+  pthread_cond_broadcast(&jobsAvailable);
+  pthread_mutex_unlock(&poolLock);
+  for (size_t i = 0; i < workerCount; ++i) {
+    pthread_join(workers[i].thread, NULL);
+    free(w2c_waforth_table(&workers[i].instance)->data);
+  }
+  free(workers);
+  workerCount = 0;
+}
+
+// Drops the workers of the parent in a forked process (which only has the
+// forking thread). The workers are started again on demand.
+static void forgetWorkers() {
+  workers = NULL;
+  workerCount = 0;
+  nextWorker = 0;
+  pendingJobs = 0;
+  tasks = NULL;
+  taskCount = 0;
+  pthread_mutex_init(&poolLock, NULL);
+}
+
+u32 w2c_shell_parallel(struct w2c_shell *mod, u32 xt, u32 start, u32 limit) {
+  if (!startWorkers()) {
+    return -1;
+  }
+  u32 n = limit - start;
+  u32 chunks = n < workerCount * CHUNKS_PER_WORKER ? n : workerCount * CHUNKS_PER_WORKER;
+  struct group group = {.remaining = chunks};
+  for (u32 i = 0; i < chunks; ++i) {
+    u32 chunkStart = (uint64_t)n * i / chunks;
+    addJob(xt, start + chunkStart, (uint64_t)n * (i + 1) / chunks - chunkStart, &group);
+  }
+  waitForGroup(&group);
+  return group.code;
+}
+
+u32 w2c_shell_spawn(struct w2c_shell *mod, u32 xt, u32 x) {
+  if (!startWorkers()) {
+    return 0;
+  }
+  size_t i = 0;
+  while (i < taskCount && tasks[i] != NULL) {
+    ++i;
+  }
+  if (i == taskCount) {
+    taskCount = taskCount * 2 + 16;
+    tasks = realloc(tasks, taskCount * sizeof(struct group *));
+    memset(&tasks[i], 0, (taskCount - i) * sizeof(struct group *));
+  }
+  tasks[i] = calloc(1, sizeof(struct group));
+  tasks[i]->remaining = 1;
+  addJob(xt, x, 1, tasks[i]);
+  return i + 1;
+}
+
+u32 w2c_shell_join(struct w2c_shell *mod, u32 task) {
+  if (task == 0 || task > taskCount || tasks[task - 1] == NULL) {
+    printf("invalid task\n");
+    return EXC_ABORT;
+  }
+  struct group *group = tasks[task - 1];
+  waitForGroup(group);
+  u32 code = group->code;
+  free(group);
+  tasks[task - 1] = NULL;
+  return code;
+}
+
 int run(w2c_waforth *mod) {
   u32 err;
 
   wasm_rt_trap_t code = wasm_rt_impl_try();
   if (code == WASM_RT_TRAP_UNREACHABLE) {
   trap:
+    fflush(stdout);
     err = w2c_waforth_error(mod);
     switch (err) {
     case ERR_QUIT:
@@ -103,18 +412,416 @@ int run(w2c_waforth *mod) {
     printf("trap %d\n", code);
     return -1;
   }
-  w2c_waforth_run(mod, sizeof(waforth_init) > 0);
+  w2c_waforth_run(mod, !interactive);
   goto trap;
 }
 
+#ifdef WAFORTH_PRECOMPILED_INIT
+// Runs the initialization program, compiled ahead of time into the `init` function.
+// Errors are handled as if the program was interpreted.
+int runInit(w2c_waforth *mod) {
+  wasm_rt_trap_t code = wasm_rt_impl_try();
+  if (code == WASM_RT_TRAP_UNREACHABLE) {
+    u32 err = w2c_waforth_error(mod);
+    switch (err) {
+    case 0: // Not set by the core
+    case ERR_QUIT:
+    case ERR_ABORT:
+    case ERR_UNKNOWN:
+    case ERR_BYE:
+      return 0;
+    default:
+      printf("unknown error: %d\n", err);
+      assert(false);
+    }
+  } else if (code != 0) {
+    printf("trap %d\n", code);
+    return -1;
+  }
+  w2c_waforth_init(mod);
+  if (w2c_waforth_tos(mod) < 0x10000) {
+    printf("stack empty\n");
+  }
+  return 0;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Server mode
+//
+// The initialization program runs once, to warm up the instance. Every request
+// is then handled by a forked worker, which inherits the warmed-up memory
+// (copy-on-write), interprets the request, and exits. Workers that run longer
+// than the request timeout are killed.
+//
+// Requests come from standard input, or from the connections to a Unix socket
+// (one connection at a time). Requests and responses are framed as a decimal
+// byte count on a line of its own, followed by that many bytes. Responses are
+// written in the order of the requests.
+////////////////////////////////////////////////////////////////////////////////
+
+struct request {
+  pid_t pid;
+  int fd; // Output of the worker, or -1 when finished
+  char *output;
+  size_t outputSize;
+  size_t outputCapacity;
+  double start;
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+// Seconds a worker can run (0 for no limit)
+static unsigned requestTimeout = 30;
+
+// Listening socket in socket mode, and the connection being served (closed in
+// the workers)
+static int listenFD = -1;
+static int connectionFD = -1;
+
+// Latencies of all requests, reported at shutdown
+static double *latencies = NULL;
+static size_t latenciesSize = 0, latenciesCapacity = 0;
+
+static void stop(int sig) {
+  stopping = 1;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compareLatencies(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Starts a worker for `program`, with its output going to a pipe
+static bool startWorker(w2c_waforth *mod, struct request *r, const char *program, size_t size) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return false;
+  }
+  fflush(stdout);
+  r->start = now();
+  r->pid = fork();
+  if (r->pid < 0) {
+    perror("fork");
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (r->pid == 0) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    forgetWorkers();
+    if (listenFD >= 0) {
+      close(listenFD);
+    }
+    if (connectionFD >= 0) {
+      close(connectionFD);
+    }
+    close(fds[0]);
+    dup2(fds[1], 1);
+    close(fds[1]);
+    int null = open("/dev/null", O_RDONLY);
+    dup2(null, 0);
+    close(null);
+    input_open_memory(&input, program, size);
+    alarm(requestTimeout);
+    int ret = run(mod);
+    fflush(stdout);
+    _exit(ret == 0 ? 0 : 1);
+  }
+  close(fds[1]);
+  r->fd = fds[0];
+  r->outputSize = 0;
+  return true;
+}
+
+// Reads the available output of a worker. Returns false at the end of the output.
+static bool readWorker(struct request *r) {
+  if (r->outputCapacity - r->outputSize < 0x1000) {
+    r->outputCapacity = r->outputCapacity * 2 + 0x1000;
+    r->output = realloc(r->output, r->outputCapacity);
+  }
+  ssize_t n = read(r->fd, r->output + r->outputSize, r->outputCapacity - r->outputSize);
+  if (n > 0) {
+    r->outputSize += n;
+    return true;
+  }
+  close(r->fd);
+  r->fd = -1;
+  int status;
+  if (waitpid(r->pid, &status, 0) == r->pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+    static const char timedOut[] = "\nrequest timed out\n";
+    if (r->outputCapacity - r->outputSize < sizeof(timedOut)) {
+      r->outputCapacity = r->outputSize + sizeof(timedOut);
+      r->output = realloc(r->output, r->outputCapacity);
+    }
+    memcpy(r->output + r->outputSize, timedOut, sizeof(timedOut) - 1);
+    r->outputSize += sizeof(timedOut) - 1;
+  }
+  return false;
+}
+
+// Takes the next complete request from the start of `buffer`.
+// Returns -1 if the request header is invalid.
+static int nextRequest(char *buffer, size_t size, size_t *offset, const char **program, size_t *programSize) {
+  char *header = buffer + *offset;
+  char *eol = memchr(header, '\n', size - *offset);
+  if (eol == NULL) {
+    return 0;
+  }
+  char *end;
+  unsigned long n = strtoul(header, &end, 10);
+  if (end == header || end != eol) {
+    return -1;
+  }
+  if ((size_t)(buffer + size - (eol + 1)) < n) {
+    return 0;
+  }
+  *program = eol + 1;
+  *programSize = n;
+  *offset = eol + 1 + n - buffer;
+  return 1;
+}
+
+// Serves the requests read from `in` until it is closed (or until stopping)
+static int serve(w2c_waforth *mod, int in, FILE *responses, size_t workers) {
+  struct request *requests = calloc(workers, sizeof(struct request));
+  size_t first = 0, active = 0;
+  struct pollfd *fds = calloc(workers + 1, sizeof(struct pollfd));
+  char *buffer = NULL;
+  size_t bufferSize = 0, bufferCapacity = 0, bufferOffset = 0;
+  bool eof = false;
+  int ret = 0;
+
+  for (;;) {
+    // Write the responses of finished workers, in order
+    while (active > 0 && requests[first].fd < 0) {
+      struct request *r = &requests[first];
+      fprintf(responses, "%zu\n", r->outputSize);
+      fwrite(r->output, 1, r->outputSize, responses);
+      fflush(responses);
+      first = (first + 1) % workers;
+      active -= 1;
+    }
+
+    // Start workers for the complete requests
+    const char *program;
+    size_t programSize;
+    int n;
+    while (ret == 0 && !stopping && active < workers && (n = nextRequest(buffer, bufferSize, &bufferOffset, &program, &programSize)) != 0) {
+      if (n < 0) {
+        fprintf(stderr, "invalid request header\n");
+        eof = true;
+        ret = -1;
+        break;
+      }
+      if (!startWorker(mod, &requests[(first + active) % workers], program, programSize)) {
+        eof = true;
+        ret = -1;
+        break;
+      }
+      active += 1;
+    }
+
+    if ((eof || stopping) && active == 0) {
+      break;
+    }
+
+    // Wait for more input, or output of the workers
+    nfds_t nfds = 0;
+    bool pollInput = !eof && !stopping && active < workers;
+    if (pollInput) {
+      fds[nfds].fd = in;
+      fds[nfds].events = POLLIN;
+      nfds += 1;
+    }
+    for (size_t i = 0; i < active; ++i) {
+      struct request *r = &requests[(first + i) % workers];
+      if (r->fd >= 0) {
+        fds[nfds].fd = r->fd;
+        fds[nfds].events = POLLIN;
+        nfds += 1;
+      }
+    }
+    if (poll(fds, nfds, -1) < 0) {
+      continue; // Interrupted
+    }
+    nfds_t fd = 0;
+    if (pollInput) {
+      if (fds[0].revents) {
+        if (bufferOffset > 0) {
+          memmove(buffer, buffer + bufferOffset, bufferSize - bufferOffset);
+          bufferSize -= bufferOffset;
+          bufferOffset = 0;
+        }
+        if (bufferCapacity - bufferSize < 0x1000) {
+          bufferCapacity = bufferCapacity * 2 + 0x1000;
+          buffer = realloc(buffer, bufferCapacity);
+        }
+        ssize_t n = read(in, buffer + bufferSize, bufferCapacity - bufferSize);
+        if (n > 0) {
+          bufferSize += n;
+        } else {
+          eof = true;
+        }
+      }
+      fd += 1;
+    }
+    for (size_t i = 0; i < active; ++i) {
+      struct request *r = &requests[(first + i) % workers];
+      if (r->fd < 0) {
+        continue;
+      }
+      if (fds[fd].revents && !readWorker(r)) {
+        if (latenciesSize == latenciesCapacity) {
+          latenciesCapacity = latenciesCapacity * 2 + 1024;
+          latencies = realloc(latencies, latenciesCapacity * sizeof(double));
+        }
+        latencies[latenciesSize++] = now() - r->start;
+      }
+      fd += 1;
+    }
+  }
+  if (ret == 0 && !stopping && bufferOffset < bufferSize) {
+    fprintf(stderr, "incomplete request\n");
+  }
+
+  for (size_t i = 0; i < workers; ++i) {
+    free(requests[i].output);
+  }
+  free(requests);
+  free(fds);
+  free(buffer);
+  return ret;
+}
+
+// Serves the connections to a Unix socket at `path`, one at a time
+static int serveSocket(w2c_waforth *mod, const char *path, size_t workers) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long\n");
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFD < 0) {
+    perror("socket");
+    return -1;
+  }
+  unlink(path);
+  if (bind(listenFD, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFD, 16) != 0) {
+    perror(path);
+    close(listenFD);
+    listenFD = -1;
+    return -1;
+  }
+  // Clients that go away shouldn't take the server down
+  signal(SIGPIPE, SIG_IGN);
+  int ret = 0;
+  while (ret == 0 && !stopping) {
+    connectionFD = accept(listenFD, NULL, NULL);
+    if (connectionFD < 0) {
+      if (errno != EINTR) {
+        perror("accept");
+        ret = -1;
+      }
+      continue;
+    }
+    FILE *responses = fdopen(dup(connectionFD), "w");
+    ret = serve(mod, connectionFD, responses, workers);
+    fclose(responses);
+    close(connectionFD);
+    connectionFD = -1;
+  }
+  close(listenFD);
+  listenFD = -1;
+  unlink(path);
+  return ret;
+}
+
+static void reportLatencies() {
+  if (latenciesSize > 0) {
+    qsort(latencies, latenciesSize, sizeof(double), compareLatencies);
+    fprintf(stderr, "%zu requests, latency (ms): p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", latenciesSize,
+            latencies[latenciesSize * 50 / 100] * 1000, latencies[latenciesSize * 90 / 100] * 1000, latencies[latenciesSize * 99 / 100] * 1000,
+            latencies[latenciesSize - 1] * 1000);
+  }
+  free(latencies);
+}
+
 int main(int argc, char *argv[]) {
   struct w2c_shell shell;
   w2c_waforth mod;
+  bool serving = false;
+  const char *socketPath = NULL;
+  int workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--serve") == 0) {
+      serving = true;
+    } else if (strncmp(argv[i], "--socket=", 9) == 0 && argv[i][9] != '\0') {
+      serving = true;
+      socketPath = argv[i] + 9;
+    } else if (strncmp(argv[i], "--workers=", 10) == 0 && atoi(argv[i] + 10) > 0) {
+      workers = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--timeout=", 10) == 0 && atoi(argv[i] + 10) >= 0) {
+      requestTimeout = atoi(argv[i] + 10);
+    } else {
+      printf("usage: %s [--serve | --socket=PATH] [--workers=N] [--timeout=SECONDS]\n", argv[0]);
+      return 1;
+    }
+  }
+  // When serving, responses go to the original standard output, and all other
+  // output (e.g. of the initialization program) goes to standard error.
+  FILE *responses = NULL;
+  if (serving) {
+    interactive = false;
+    responses = fdopen(dup(1), "w");
+    dup2(2, 1);
+  }
 
+  setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+  if (interactive) {
+    input_open_fd(&input, 0);
+  } else {
+    input_open_memory(&input, (const char *)waforth_init, sizeof(waforth_init));
+  }
   wasm_rt_init();
   wasm2c_waforth_instantiate(&mod, &shell);
   shell.memory = w2c_waforth_memory(&mod);
-  int ret = run(&mod);
+  mainInstance = &mod;
+  int ret = 0;
+  if (!serving || sizeof(waforth_init) > 0) {
+#ifdef WAFORTH_PRECOMPILED_INIT
+    ret = runInit(&mod);
+#else
+    ret = run(&mod);
+#endif
+  }
+  if (serving && ret == 0) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    ret = socketPath != NULL ? serveSocket(&mod, socketPath, workers) : serve(&mod, 0, responses, workers);
+    reportLatencies();
+  }
+  if (responses != NULL) {
+    fclose(responses);
+  }
+  fflush(stdout);
+  stopWorkers();
+  input_close(&input);
   wasm2c_waforth_free(&mod);
   wasm_rt_free();
   return ret;
@@ -1,12 +1,21 @@
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cerrno>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
 #include <windows.h>
 #else
@@ -26,10 +35,13 @@
 #include <wabt/interp/interp.h>
 #include <wabt/ir.h>
 #include <wabt/resolve-names.h>
+#include <wabt/sha256.h>
 #include <wabt/stream.h>
 #include <wabt/validator.h>
 
+#include "../standalone/input.h"
 #include "waforth_core.h"
+#include "waforth_input.h"
 #include "waforth_rt.h"
 #include "waforth_wabt_wasm-rt-exceptions-impl_c.h"
 #include "waforth_wabt_wasm-rt-exceptions_h.h"
@@ -54,6 +66,26 @@ static std::unique_ptr<wabt::FileStream> stderrStream;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Reports the wall-clock time spent in each phase of the build.
+ */
+struct PhaseTimer {
+  bool enabled = false;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  void done(const std::string &phase) {
+    auto now = std::chrono::steady_clock::now();
+    if (enabled) {
+      std::cerr << phase << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() << "ms" << std::endl;
+    }
+    start = now;
+  }
+};
+
+static PhaseTimer timer;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool endsWith(const std::string &x, const std::string &y) {
   return x.size() >= y.size() && x.compare(x.size() - y.size(), std::string::npos, y) == 0;
 }
@@ -112,13 +144,220 @@ int runChild(const std::vector<std::string> &cmd) {
 #endif
 }
 
+/**
+ * Calls `fn` for every index in [0, n), spread over at most `jobs` threads.
+ */
+wabt::Result parallelFor(size_t n, unsigned jobs, const std::function<wabt::Result(size_t)> &fn) {
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto worker = [&]() {
+    for (size_t i; !failed && (i = next++) < n;) {
+      if (!Succeeded(fn(i))) {
+        failed = true;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min<size_t>(jobs, n); ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return failed ? wabt::Result::Error : wabt::Result::Ok;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+struct BuildOptions {
+  unsigned jobs = 1;
+  std::string pgo; // Training program for profile-guided optimization
+  uint64_t memory = 0; // Initial memory size
+};
+
+/**
+ * Returns a hex-encoded hash of the given parts.
+ */
+std::string contentHash(const std::vector<std::string_view> &parts) {
+  std::string input;
+  for (auto &part : parts) {
+    input += std::to_string(part.size()) + ":";
+    input.append(part);
+  }
+  std::string digest;
+  wabt::sha256(input, digest);
+  std::ostringstream result;
+  for (unsigned char c : digest) {
+    result << std::hex << std::setw(2) << std::setfill('0') << (int)c;
+  }
+  return result.str();
+}
+
+/**
+ * On-disk cache of build products (runtime objects, objects of generated code, and executables),
+ * keyed by the hash of everything that went into them.
+ */
+struct BuildCache {
+  fs::path dir;
+  unsigned hits = 0;
+  unsigned misses = 0;
+
+  bool enabled() const {
+    return !dir.empty();
+  }
+
+  void report() const {
+    if (enabled()) {
+      std::cerr << "cache: " << hits << " hits, " << misses << " misses" << std::endl;
+    }
+  }
+
+  /**
+   * Returns the path of the entry with the given key, and whether it exists.
+   */
+  fs::path lookup(const std::string &kind, const std::string &key, bool &hit) {
+    auto path = dir / kind / key;
+    hit = fs::exists(path);
+    (hit ? hits : misses) += 1;
+    return path;
+  }
+
+  /**
+   * Stores a file (or a directory of files) as the entry at `path`.
+   *
+   * The entry is first written to a temporary path and then renamed, so concurrent builds never see
+   * partial entries.
+   */
+  void store(const fs::path &path, const std::vector<fs::path> &files, bool directory) {
+    std::error_code ec;
+    auto tmp = path;
+    tmp += ".tmp." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "." + std::to_string(rand());
+    fs::create_directories(directory ? tmp : path.parent_path(), ec);
+    for (auto &file : files) {
+      fs::copy_file(file, directory ? tmp / file.filename() : tmp, fs::copy_options::overwrite_existing, ec);
+      if (ec) {
+        break;
+      }
+    }
+    if (!ec) {
+      fs::rename(tmp, path, ec);
+    }
+    if (ec) {
+      fs::remove_all(tmp, ec);
+    }
+  }
+};
+
+static BuildCache cache;
+
+struct CompileJob {
+  fs::path source;
+  fs::path object;
+};
+
+wabt::Result compileObjects(const std::vector<CompileJob> &jobs, const std::string &cc, const std::vector<std::string> &flags, unsigned n) {
+  return parallelFor(jobs.size(), n, [&](size_t i) {
+    std::vector<std::string> cmd = {cc, "-c", "-o", jobs[i].object.string(), jobs[i].source.string()};
+    cmd.insert(cmd.end(), flags.begin(), flags.end());
+    if (runChild(cmd) != 0) {
+      std::cerr << "error compiling " << jobs[i].source << std::endl;
+      return wabt::Result::Error;
+    }
+    return wabt::Result::Ok;
+  });
+}
+
+wabt::Result linkObjects(const std::vector<fs::path> &objects, const std::string &outfile, const std::string &cc, const std::vector<std::string> &flags) {
+  std::vector<std::string> cmd = {cc, "-o", outfile};
+  for (auto &object : objects) {
+    cmd.push_back(object.string());
+  }
+  cmd.insert(cmd.end(), flags.begin(), flags.end());
+  if (runChild(cmd) != 0) {
+    std::cerr << "error linking";
+    return wabt::Result::Error;
+  }
+  return wabt::Result::Ok;
+}
+
+void writeConfig(const fs::path &wd, const std::string &init, bool precompiledInit) {
+  std::ofstream inith(wd / "_waforth_config.h");
+  inith << "static uint8_t waforth_init[] = {";
+  for (size_t i = 0; i < init.size(); ++i) {
+    inith << (int)init[i];
+    if (i != init.size() - 1) {
+      inith << ",";
+    }
+  }
+  inith << "};" << std::endl;
+  if (precompiledInit) {
+    inith << "#define WAFORTH_PRECOMPILED_INIT 1" << std::endl;
+  }
+}
+
+template <size_t N> std::string_view fileData(const unsigned char (&data)[N]) {
+  return std::string_view((const char *)data, N);
+}
+
+/**
+ * The files of the wasm2c runtime, as they are written to the working directory.
+ *
+ * Every file is part of the cache key of the runtime objects, as the runtime sources include each other.
+ */
+static const std::pair<const char *, std::string_view> runtimeFiles[] = {
+    {"wasm-rt.h", fileData(waforth_wabt_wasm_rt_h)},
+    {"wasm-rt-impl.h", fileData(waforth_wabt_wasm_rt_impl_h)},
+    {"wasm-rt-exceptions.h", fileData(waforth_wabt_wasm_rt_exceptions_h)},
+    {"wasm-rt-impl.c", fileData(waforth_wabt_wasm_rt_impl_c)},
+    {"wasm-rt-impl-tableops.inc", fileData(waforth_wabt_wasm_rt_impl_tableops_inc)},
+    {"wasm-rt-exceptions-impl.c", fileData(waforth_wabt_wasm_rt_exceptions_impl_c)},
+    {"wasm-rt-mem-impl.c", fileData(waforth_wabt_wasm_rt_mem_impl_c)},
+    {"wasm-rt-mem-impl-helper.inc", fileData(waforth_wabt_wasm_rt_mem_impl_helper_inc)},
+};
+
 /**
  * Compiles a WASM module to a native file named `outfile`.
+ *
+ * With more than 1 job, the C code is split over multiple files, which are compiled in parallel
+ * and then linked. If the build cache is enabled, the objects of the runtime and of the generated code are
+ * taken from the cache if possible.
+ *
+ * With profile-guided optimization, all code is first compiled with instrumentation, and the result is run with the
+ * training program. The profile is then used to compile the final executable.
  */
-wabt::Result compileToNative(wabt::Module &mod, const std::string &init, const std::string &outfile, const std::string &cc,
-                             const std::vector<std::string> &cflags) {
+wabt::Result compileToNative(wabt::Module &mod, const std::string &init, bool precompiledInit, const std::string &outfile, const std::string &cc,
+                             std::vector<std::string> cflags, const BuildOptions &buildOptions) {
+  // Profiles depend on the paths of the objects, so can't be combined with cached objects
+  bool useCache = cache.enabled() && buildOptions.pgo.empty();
+
+  // Linker flags are only passed when linking
+  std::vector<std::string> compileFlags;
+  std::copy_if(cflags.begin(), cflags.end(), std::back_inserter(compileFlags), [](const std::string &flag) { return flag.rfind("-l", 0) != 0; });
+  std::string compilerKey = cc;
+  for (auto &flag : compileFlags) {
+    compilerKey += " " + flag;
+  }
+
+  std::string moduleKey;
+  if (useCache) {
+    wabt::MemoryStream out(nullptr);
+    CHECK_RESULT(wabt::WriteBinaryModule(&out, &mod, wabt::WriteBinaryOptions(features, false, false, true)));
+    auto &data = out.output_buffer().data;
+    auto jobCount = std::to_string(buildOptions.jobs);
+    std::vector<std::string_view> parts = {std::string_view((const char *)data.data(), data.size()),
+                                           init,
+                                           precompiledInit ? "1" : "0",
+                                           compilerKey,
+                                           jobCount,
+                                           fileData(waforth_rt),
+                                           fileData(waforth_input)};
+    for (auto &file : runtimeFiles) {
+      parts.push_back(file.second);
+    }
+    moduleKey = contentHash(parts);
+  }
+
   CHECK_RESULT(GenerateNames(&mod));
   CHECK_RESULT(ApplyNames(&mod));
   // CHECK_RESULT(wabt::ResolveNamesModule(&mod, &errors));
@@ -132,53 +371,155 @@ wabt::Result compileToNative(wabt::Module &mod, const std::string &init, const s
     return wabt::Result::Error;
   }
 
+  // Runtime (the headers are also needed by the generated code)
+  for (auto &file : runtimeFiles) {
+    wabt::FileStream((wd / file.first).string()).WriteData(file.second.data(), file.second.size());
+  }
+  wabt::FileStream((wd / "_waforth_input.h").string()).WriteData(waforth_input, sizeof(waforth_input));
+  std::vector<CompileJob> jobs;
+  std::vector<fs::path> objects;
+  std::vector<std::pair<fs::path, std::vector<fs::path>>> newEntries;
   {
-    std::ofstream inith(wd / "_waforth_config.h");
-    inith << "static uint8_t waforth_init[] = {";
-    for (size_t i = 0; i < init.size(); ++i) {
-      inith << (int)init[i];
-      if (i != init.size() - 1) {
-        inith << ",";
+    std::vector<std::string> sources = {"wasm-rt-impl.c", "wasm-rt-exceptions-impl.c", "wasm-rt-mem-impl.c"};
+    bool hit = false;
+    fs::path entry;
+    if (useCache) {
+      std::vector<std::string_view> parts = {compilerKey};
+      for (auto &file : runtimeFiles) {
+        parts.push_back(file.second);
+      }
+      entry = cache.lookup("runtime", contentHash(parts), hit);
+    }
+    if (hit) {
+      for (auto &source : sources) {
+        objects.push_back(entry / fs::path(source).replace_extension(".o"));
+      }
+    } else {
+      std::vector<fs::path> entryObjects;
+      for (auto &source : sources) {
+        jobs.push_back({wd / source, (wd / source).replace_extension(".o")});
+        objects.push_back(jobs.back().object);
+        entryObjects.push_back(jobs.back().object);
+      }
+      if (useCache) {
+        newEntries.push_back({entry, entryObjects});
       }
     }
-    inith << "};" << std::endl;
   }
 
+  // Generated code
   {
-    wabt::WriteCOptions wcopt;
-    wcopt.module_name = "waforth";
-    wabt::FileStream c_stream((wd / "_waforth.c").string());
-    wabt::FileStream h_stream((wd / "_waforth.h").string());
-    CHECK_RESULT(WriteC({&c_stream}, &h_stream, &c_stream, "_waforth.h", "", &mod, wcopt));
-    wabt::FileStream((wd / "_waforth_rt.c").string()).WriteData(waforth_rt, sizeof(waforth_rt));
-    wabt::FileStream((wd / "wasm-rt.h").string()).WriteData(waforth_wabt_wasm_rt_h, sizeof(waforth_wabt_wasm_rt_h));
-    wabt::FileStream((wd / "wasm-rt-impl.h").string()).WriteData(waforth_wabt_wasm_rt_impl_h, sizeof(waforth_wabt_wasm_rt_impl_h));
-    wabt::FileStream((wd / "wasm-rt-impl.c").string()).WriteData(waforth_wabt_wasm_rt_impl_c, sizeof(waforth_wabt_wasm_rt_impl_c));
-    wabt::FileStream((wd / "wasm-rt-impl-tableops.inc").string())
-        .WriteData(waforth_wabt_wasm_rt_impl_tableops_inc, sizeof(waforth_wabt_wasm_rt_impl_tableops_inc));
-    wabt::FileStream((wd / "wasm-rt-exceptions.h").string()).WriteData(waforth_wabt_wasm_rt_exceptions_h, sizeof(waforth_wabt_wasm_rt_exceptions_h));
-    wabt::FileStream((wd / "wasm-rt-exceptions-impl.c").string())
-        .WriteData(waforth_wabt_wasm_rt_exceptions_impl_c, sizeof(waforth_wabt_wasm_rt_exceptions_impl_c));
-    wabt::FileStream((wd / "wasm-rt-mem-impl.c").string()).WriteData(waforth_wabt_wasm_rt_mem_impl_c, sizeof(waforth_wabt_wasm_rt_mem_impl_c));
-    wabt::FileStream((wd / "wasm-rt-mem-impl-helper.inc").string())
-        .WriteData(waforth_wabt_wasm_rt_mem_impl_helper_inc, sizeof(waforth_wabt_wasm_rt_mem_impl_helper_inc));
-  }
-
-  std::vector<std::string> cmd = {
-      cc,
-      "-o",
-      outfile,
-      (wd / "_waforth_rt.c").string(),
-      (wd / "_waforth.c").string(),
-      (wd / "wasm-rt-impl.c").string(),
-      (wd / "wasm-rt-exceptions-impl.c").string(),
-      (wd / "wasm-rt-mem-impl.c").string(),
-  };
-  cmd.insert(cmd.end(), cflags.begin(), cflags.end());
-  if (runChild(cmd) != 0) {
-    std::cerr << "error compiling";
-    return wabt::Result::Error;
+    std::vector<std::string> sources = {"_waforth_rt.c"};
+    if (buildOptions.jobs <= 1) {
+      sources.push_back("_waforth.c");
+    } else {
+      for (unsigned i = 0; i < buildOptions.jobs; ++i) {
+        sources.push_back("_waforth_" + std::to_string(i) + ".c");
+      }
+    }
+    bool hit = false;
+    fs::path entry;
+    if (useCache) {
+      entry = cache.lookup("module", moduleKey, hit);
+    }
+    if (hit) {
+      for (auto &source : sources) {
+        objects.push_back(entry / fs::path(source).replace_extension(".o"));
+      }
+    } else {
+      writeConfig(wd, init, precompiledInit);
+
+      wabt::WriteCOptions wcopt;
+      wcopt.module_name = "waforth";
+      wabt::FileStream h_stream((wd / "_waforth.h").string());
+      if (buildOptions.jobs <= 1) {
+        wabt::FileStream c_stream((wd / "_waforth.c").string());
+        CHECK_RESULT(WriteC({&c_stream}, &h_stream, &c_stream, "_waforth.h", "", &mod, wcopt));
+      } else {
+        std::vector<std::unique_ptr<wabt::FileStream>> c_streams;
+        std::vector<wabt::Stream *> c_stream_ptrs;
+        for (unsigned i = 0; i < buildOptions.jobs; ++i) {
+          c_streams.push_back(std::make_unique<wabt::FileStream>((wd / sources[i + 1]).string()));
+          c_stream_ptrs.push_back(c_streams.back().get());
+        }
+        wabt::FileStream h_impl_stream((wd / "_waforth-impl.h").string());
+        CHECK_RESULT(WriteC(std::move(c_stream_ptrs), &h_stream, &h_impl_stream, "_waforth.h", "_waforth-impl.h", &mod, wcopt));
+      }
+      wabt::FileStream((wd / "_waforth_rt.c").string()).WriteData(waforth_rt, sizeof(waforth_rt));
+
+      std::vector<fs::path> entryObjects;
+      for (auto &source : sources) {
+        jobs.push_back({wd / source, (wd / source).replace_extension(".o")});
+        objects.push_back(jobs.back().object);
+        entryObjects.push_back(jobs.back().object);
+      }
+      if (useCache) {
+        newEntries.push_back({entry, entryObjects});
+      }
+    }
+  }
+  timer.done("write C");
+
+  if (!useCache && buildOptions.jobs <= 1 && buildOptions.pgo.empty()) {
+    std::vector<std::string> cmd = {cc, "-o", outfile};
+    for (auto &job : jobs) {
+      cmd.push_back(job.source.string());
+    }
+    cmd.insert(cmd.end(), cflags.begin(), cflags.end());
+    if (runChild(cmd) != 0) {
+      std::cerr << "error compiling";
+      return wabt::Result::Error;
+    }
+    timer.done("compile C");
+    return wabt::Result::Ok;
+  }
+
+  if (!buildOptions.pgo.empty()) {
+    auto profileDir = wd / "profile";
+    auto training = wd / "training";
+    std::vector<std::string> generateFlags = {"-fprofile-generate=" + profileDir.string()};
+    writeConfig(wd, buildOptions.pgo, false);
+    auto trainingCompileFlags = compileFlags;
+    trainingCompileFlags.insert(trainingCompileFlags.end(), generateFlags.begin(), generateFlags.end());
+    CHECK_RESULT(compileObjects(jobs, cc, trainingCompileFlags, buildOptions.jobs));
+    auto trainingFlags = cflags;
+    trainingFlags.insert(trainingFlags.end(), generateFlags.begin(), generateFlags.end());
+    CHECK_RESULT(linkObjects(objects, training.string(), cc, trainingFlags));
+    timer.done("compile instrumented C");
+    if (runChild({training.string()}) != 0) {
+      std::cerr << "warning: training run failed" << std::endl;
+    }
+    timer.done("training run");
+    writeConfig(wd, init, precompiledInit);
+
+    std::string useFlag = "-fprofile-use=" + profileDir.string();
+    if (cc.find("clang") != std::string::npos) {
+      // Clang needs the raw profiles to be merged first
+      std::vector<std::string> cmd = {"llvm-profdata", "merge", "-output=" + (profileDir / "default.profdata").string()};
+      for (auto &file : fs::directory_iterator(profileDir)) {
+        cmd.push_back(file.path().string());
+      }
+      if (runChild(cmd) != 0) {
+        std::cerr << "error merging profiles" << std::endl;
+        return wabt::Result::Error;
+      }
+      useFlag = "-fprofile-use=" + (profileDir / "default.profdata").string();
+    } else {
+      // rt.c is trained with a different initialization program
+      compileFlags.push_back("-Wno-coverage-mismatch");
+    }
+    compileFlags.push_back(useFlag);
+    cflags.push_back(useFlag);
+  }
+
+  CHECK_RESULT(compileObjects(jobs, cc, compileFlags, buildOptions.jobs));
+  for (auto &entry : newEntries) {
+    cache.store(entry.first, entry.second, true);
   }
+  timer.done("compile C");
+
+  CHECK_RESULT(linkObjects(objects, outfile, cc, cflags));
+  timer.done("link");
   return wabt::Result::Ok;
 }
 
@@ -205,22 +546,49 @@ wabt::Result writeModule(const std::string &filename, const wabt::Module &mod) {
 #define ERR_BYE 0x5
 
 // FIXME: This is unsafe. Need a better way to extract this (e.g. through symbols)
+#define TOS_GLOBAL_INDEX 0
 #define LATEST_GLOBAL_INDEX 5
 #define HERE_GLOBAL_INDEX 6
 
+// State of the heap: heapBase, heapTop, heapLarge, heapUsed, heapFree, heapFreeBlocks
+// (see Heap in waforth.wat)
+#define HEAP_GLOBAL_INDEX 31
+#define HEAP_GLOBAL_COUNT 6
+
+// Space after HERE used for transient regions (PAD, WORD, pictured output)
+#define HERE_RESERVE 0x404
+
+// Task control block of the operator, followed by the next USER offset
+// (see Scheduler in waforth.wat)
+#define OPERATOR_BASE 0x30800
+#define OPERATOR_SIZE 0x98
+
 static wabti::Store store;
 
 typedef std::vector<uint8_t> RawModule;
 
+struct DictionaryEntry {
+  wabti::u32 xt;
+  std::string name;
+  uint8_t flags;
+  wabti::u32 body;
+  wabti::u32 tableIndex;
+  wabti::u32 value; // First cell of the data field
+};
+
 struct RunResult {
   std::vector<RawModule> modules;
+  std::vector<DictionaryEntry> dictionary;
   std::vector<uint8_t> data;
   wabti::u32 dataOffset;
+  std::vector<uint8_t> operatorData;
   wabti::u32 latest;
+  std::vector<uint8_t> heap; // Starting at heapGlobals[0] (if the heap was set up)
+  std::vector<wabti::u32> heapGlobals;
   bool success;
 };
 
-wabt::Result run(const std::vector<uint8_t> &input, RunResult &result, wabt::Errors &errors) {
+wabt::Result run(input_t &input, RunResult &result, wabt::Errors &errors) {
   // Load core module
   wabti::ModuleDesc desc;
   CHECK_RESULT(wabti::ReadBinaryInterp("waforth.wasm", waforth_core, sizeof(waforth_core),
@@ -234,7 +602,7 @@ wabt::Result run(const std::vector<uint8_t> &input, RunResult &result, wabt::Err
   wabti::Table::Ptr table;
 
   // Input
-  size_t inputOffset = 0;
+  bool inputTooLong = false;
 
   // Bind core imports
   wabti::RefVec imports;
@@ -245,20 +613,21 @@ wabt::Result run(const std::vector<uint8_t> &input, RunResult &result, wabt::Err
         if (import.type.name == "read") {
           auto addr = params[0].Get<wabti::s32>();
           auto size = params[1].Get<wabti::s32>();
-          int n, nend;
-          for (n = 0, nend = std::min((size_t)size, input.size() - inputOffset); n < nend; ++n) {
-            if (input[inputOffset + n] == '\n') {
-              n += 1;
-              break;
-            }
+          int n = input_read_line(&input, (char *)memory->UnsafeData() + addr, size);
+          if (n == INPUT_LINE_TOO_LONG) {
+            // Stop reading, instead of splitting the line
+            std::cerr << "input line " << (input.lines + 1) << " is longer than " << size << " bytes" << std::endl;
+            inputTooLong = true;
+            n = 0;
           }
-          std::memcpy(memory->UnsafeData() + addr, &input[inputOffset], n);
-          inputOffset += n;
           results[0].Set((wabti::s32)n);
           return wabt::Result::Ok;
         } else if (import.type.name == "emit") {
           putchar(params[0].Get<wabti::s32>());
           return wabt::Result::Ok;
+        } else if (import.type.name == "type") {
+          fwrite(memory->UnsafeData() + params[0].Get<wabti::s32>(), 1, params[1].Get<wabti::s32>(), stdout);
+          return wabt::Result::Ok;
         } else if (import.type.name == "load") {
           auto addr = params[0].Get<wabti::s32>();
           auto size = params[1].Get<wabti::s32>();
@@ -276,6 +645,13 @@ wabt::Result run(const std::vector<uint8_t> &input, RunResult &result, wabt::Err
             ;
           }
           return wabt::Result::Ok;
+        } else if (import.type.name == "parallel") {
+          // Words run on a single thread while compiling, so the core runs PAR-DO and SPAWN itself
+          results[0].Set((wabti::s32)-1);
+          return wabt::Result::Ok;
+        } else if (import.type.name == "spawn" || import.type.name == "join") {
+          results[0].Set((wabti::s32)0);
+          return wabt::Result::Ok;
         } else {
           std::cerr << "`" << import.type.name << "` is not implemented" << std::endl;
           return wabt::Result::Error;
@@ -353,19 +729,81 @@ wabt::Result run(const std::vector<uint8_t> &input, RunResult &result, wabt::Err
       assert(false);
     }
   }
+  if (inputTooLong) {
+    return wabt::Result::Error;
+  }
 
   result.data =
       std::vector<uint8_t>((uint8_t *)(memory->UnsafeData() + initialHere), (uint8_t *)(memory->UnsafeData() + here->Get().Get<wabti::s32>()));
   result.dataOffset = initialHere;
+  result.operatorData =
+      std::vector<uint8_t>((uint8_t *)(memory->UnsafeData() + OPERATOR_BASE), (uint8_t *)(memory->UnsafeData() + OPERATOR_BASE + OPERATOR_SIZE));
   result.latest = store.UnsafeGet<wabti::Global>(corei->globals()[LATEST_GLOBAL_INDEX])->Get().Get<wabti::s32>();
+  for (int i = 0; i < HEAP_GLOBAL_COUNT; ++i) {
+    result.heapGlobals.push_back(store.UnsafeGet<wabti::Global>(corei->globals()[HEAP_GLOBAL_INDEX + i])->Get().Get<wabti::u32>());
+  }
+  result.heap = std::vector<uint8_t>((uint8_t *)(memory->UnsafeData() + result.heapGlobals[0]),
+                                     (uint8_t *)(memory->UnsafeData() + result.heapGlobals[1]));
+  for (auto xt = result.latest; xt != 0;) {
+    auto p = memory->UnsafeData();
+    DictionaryEntry entry;
+    entry.xt = xt;
+    entry.flags = p[xt + 4];
+    auto length = entry.flags & 0x1f;
+    entry.name = std::string((const char *)p + xt + 5, length);
+    entry.body = (xt + length + 8) & ~3;
+    std::memcpy(&entry.tableIndex, p + entry.body, 4);
+    std::memcpy(&entry.value, p + entry.body + 4, 4);
+    result.dictionary.push_back(entry);
+    std::memcpy(&xt, p + xt, 4);
+  }
   result.success = true;
   return wabt::Result::Ok;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-wabt::Result compileToModule(std::vector<wabt::Module> &words, const std::vector<uint8_t> &data, wabti::u32 dataOffset, wabti::u32 latest,
-                             wabt::Module &compiled, wabt::Errors &errors) {
+/**
+ * Moves the direct calls of a word to the functions of its own module (see RECURSE in the core) to
+ * where these functions end up in the compiled module.
+ */
+void relocateCalls(wabt::ExprList &exprs, wabt::Index funcBase) {
+  for (auto &expr : exprs) {
+    switch (expr.type()) {
+    case wabt::ExprType::Block:
+      relocateCalls(wabt::cast<wabt::BlockExpr>(&expr)->block.exprs, funcBase);
+      break;
+    case wabt::ExprType::Loop:
+      relocateCalls(wabt::cast<wabt::LoopExpr>(&expr)->block.exprs, funcBase);
+      break;
+    case wabt::ExprType::If: {
+      auto ifExpr = wabt::cast<wabt::IfExpr>(&expr);
+      relocateCalls(ifExpr->true_.exprs, funcBase);
+      relocateCalls(ifExpr->false_, funcBase);
+      break;
+    }
+    case wabt::ExprType::Try: {
+      auto tryExpr = wabt::cast<wabt::TryExpr>(&expr);
+      relocateCalls(tryExpr->block.exprs, funcBase);
+      for (auto &c : tryExpr->catches) {
+        relocateCalls(c.exprs, funcBase);
+      }
+      break;
+    }
+    case wabt::ExprType::Call: {
+      auto &var = wabt::cast<wabt::CallExpr>(&expr)->var;
+      var.set_index(funcBase + var.index());
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+wabt::Result compileToModule(std::vector<wabt::Module> &words, const std::vector<uint8_t> &data, wabti::u32 dataOffset,
+                             const std::vector<uint8_t> &operatorData, wabti::u32 latest,
+                             const std::vector<uint8_t> &heap, const std::vector<wabti::u32> &heapGlobals, uint64_t memorySize, wabt::Module &compiled, wabt::Errors &errors) {
   CHECK_RESULT(readModule("waforth.wasm", waforth_core, sizeof(waforth_core), compiled, errors));
 
   auto dsf = std::make_unique<wabt::DataSegmentModuleField>();
@@ -375,71 +813,925 @@ wabt::Result compileToModule(std::vector<wabt::Module> &words, const std::vector
   ds.data = data;
   compiled.AppendField(std::move(dsf));
 
+  // The tasks created at compile time are linked to the operator
+  auto osf = std::make_unique<wabt::DataSegmentModuleField>();
+  wabt::DataSegment &os = osf->data_segment;
+  os.memory_var = wabt::Var(0, wabt::Location());
+  os.offset.push_back(std::make_unique<wabt::ConstExpr>(wabt::Const::I32(OPERATOR_BASE)));
+  os.data = operatorData;
+  compiled.AppendField(std::move(osf));
+
   compiled.globals[HERE_GLOBAL_INDEX]->init_expr = wabt::ExprList{std::make_unique<wabt::ConstExpr>(wabt::Const::I32(dataOffset + data.size()))};
   compiled.globals[LATEST_GLOBAL_INDEX]->init_expr = wabt::ExprList{std::make_unique<wabt::ConstExpr>(wabt::Const::I32(latest))};
 
+  // Memory allocated at compile time stays where it is
+  auto heapBase = heapGlobals[0];
+  if (heapBase != 0) {
+    auto hsf = std::make_unique<wabt::DataSegmentModuleField>();
+    wabt::DataSegment &hs = hsf->data_segment;
+    hs.memory_var = wabt::Var(0, wabt::Location());
+    hs.offset.push_back(std::make_unique<wabt::ConstExpr>(wabt::Const::I32(heapBase)));
+    hs.data = heap;
+    compiled.AppendField(std::move(hsf));
+    for (int i = 0; i < HEAP_GLOBAL_COUNT; ++i) {
+      compiled.globals[HEAP_GLOBAL_INDEX + i]->init_expr =
+          wabt::ExprList{std::make_unique<wabt::ConstExpr>(wabt::Const::I32(heapGlobals[i]))};
+    }
+  }
+
+  // Memory grows on demand, but needs to hold the data space (and the heap) from the start
+  auto &memoryLimits = compiled.memories[0]->page_limits;
+  auto memoryEnd = std::max<uint64_t>({memorySize, dataOffset + data.size() + HERE_RESERVE, heapBase + heap.size()});
+  memoryLimits.initial = std::max<uint64_t>(memoryLimits.initial, (memoryEnd + WABT_PAGE_SIZE - 1) / WABT_PAGE_SIZE);
+  if (memoryLimits.has_max && memoryLimits.initial > memoryLimits.max) {
+    std::cerr << "memory size exceeds maximum" << std::endl;
+    return wabt::Result::Error;
+  }
+
+  // Compiled words are loaded in batches, so every module can contain multiple functions
+  size_t functionCount = 0;
   for (auto &word : words) {
-    assert(word.funcs.size() == 1);
-    // compiled.funcs.push_back(word.funcs[0]);
-
-    auto ff = std::make_unique<wabt::FuncModuleField>();
-    auto &f = ff->func;
-    f.name = word.funcs[0]->name;
-    f.decl = word.funcs[0]->decl;
-    f.local_types = word.funcs[0]->local_types;
-    f.bindings = word.funcs[0]->bindings;
-    f.exprs.splice(f.exprs.end(), word.funcs[0]->exprs);
-    compiled.AppendField(std::move(ff));
-
-    assert(word.elem_segments.size() == 1);
-    auto elem = word.elem_segments[0];
-    auto esf = std::make_unique<wabt::ElemSegmentModuleField>();
-    wabt::ElemSegment &es = esf->elem_segment;
-    es.kind = elem->kind;
-    es.name = elem->name;
-    es.table_var = elem->table_var;
-    es.elem_type = elem->elem_type;
-    assert(elem->elem_type = wabt::Type::FuncRef);
-    es.offset = std::move(elem->offset);
-    es.elem_exprs.push_back(wabt::ExprList{std::make_unique<wabt::RefFuncExpr>(wabt::Var(compiled.funcs.size() - 1, wabt::Location()))});
-    compiled.AppendField(std::move(esf));
-
-    // Make sure the function is marked as used, so the wrapper gets emitted
-    compiled.used_func_refs.insert(compiled.funcs.size() - 1);
-  }
-
-  compiled.tables[0]->elem_limits.initial += words.size();
+    auto funcBase = compiled.funcs.size();
+    for (auto wordFunc : word.funcs) {
+      auto ff = std::make_unique<wabt::FuncModuleField>();
+      auto &f = ff->func;
+      f.name = wordFunc->name;
+      f.decl = wordFunc->decl;
+      f.local_types = wordFunc->local_types;
+      f.bindings = wordFunc->bindings;
+      f.exprs.splice(f.exprs.end(), wordFunc->exprs);
+      relocateCalls(f.exprs, funcBase);
+      compiled.AppendField(std::move(ff));
+
+      // Make sure the function is marked as used, so the wrapper gets emitted
+      compiled.used_func_refs.insert(compiled.funcs.size() - 1);
+    }
+    functionCount += word.funcs.size();
+
+    for (auto elem : word.elem_segments) {
+      auto esf = std::make_unique<wabt::ElemSegmentModuleField>();
+      wabt::ElemSegment &es = esf->elem_segment;
+      es.kind = elem->kind;
+      es.name = elem->name;
+      es.table_var = elem->table_var;
+      es.elem_type = elem->elem_type;
+      assert(elem->elem_type == wabt::Type::FuncRef);
+      es.offset = std::move(elem->offset);
+      for (auto &expr : elem->elem_exprs) {
+        assert(expr.size() == 1 && expr.front().type() == wabt::ExprType::RefFunc);
+        auto index = wabt::cast<wabt::RefFuncExpr>(&expr.front())->var.index();
+        es.elem_exprs.push_back(wabt::ExprList{std::make_unique<wabt::RefFuncExpr>(wabt::Var(funcBase + index, wabt::Location()))});
+      }
+      compiled.AppendField(std::move(esf));
+    }
+  }
+
+  compiled.tables[0]->elem_limits.initial += functionCount;
+
+  return wabt::Result::Ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct OptimizeOptions {
+  bool devirtualize = true;
+  wabt::Index inlineThreshold = 24;
+  bool strip = false;
+  bool simd = false;
+};
+
+/**
+ * Returns the signature of a function declaration.
+ */
+const wabt::FuncSignature &getSignature(const wabt::Module &mod, const wabt::FuncDeclaration &decl) {
+  if (decl.has_func_type) {
+    if (auto type = mod.GetFuncType(decl.type_var)) {
+      return type->sig;
+    }
+  }
+  return decl.sig;
+}
+
+/**
+ * Returns the function index of every table entry initialized by an active element segment with a constant offset.
+ *
+ * Since compilation isn't available anymore in the final module, the table doesn't change after initialization.
+ */
+std::map<uint32_t, wabt::Index> getTableFunctions(const wabt::Module &mod) {
+  std::map<uint32_t, wabt::Index> result;
+  for (auto elem : mod.elem_segments) {
+    if (elem->kind != wabt::SegmentKind::Active || elem->table_var.index() != 0 || elem->offset.size() != 1 ||
+        elem->offset.front().type() != wabt::ExprType::Const) {
+      continue;
+    }
+    auto offset = wabt::cast<wabt::ConstExpr>(&elem->offset.front())->const_.u32();
+    for (size_t i = 0; i < elem->elem_exprs.size(); ++i) {
+      auto &expr = elem->elem_exprs[i];
+      if (expr.size() == 1 && expr.front().type() == wabt::ExprType::RefFunc) {
+        result[offset + i] = wabt::cast<wabt::RefFuncExpr>(&expr.front())->var.index();
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * Replaces every `i32.const N; call_indirect` with a direct call to the function in table entry N.
+ *
+ * Calls of which the signature doesn't match the function's signature are left alone, so they still
+ * trap at runtime.
+ */
+size_t devirtualizeCalls(const wabt::Module &mod, wabt::ExprList &exprs, const std::map<uint32_t, wabt::Index> &table) {
+  size_t count = 0;
+  for (auto it = exprs.begin(); it != exprs.end(); ++it) {
+    switch (it->type()) {
+    case wabt::ExprType::Block:
+      count += devirtualizeCalls(mod, wabt::cast<wabt::BlockExpr>(&*it)->block.exprs, table);
+      break;
+    case wabt::ExprType::Loop:
+      count += devirtualizeCalls(mod, wabt::cast<wabt::LoopExpr>(&*it)->block.exprs, table);
+      break;
+    case wabt::ExprType::If: {
+      auto ifExpr = wabt::cast<wabt::IfExpr>(&*it);
+      count += devirtualizeCalls(mod, ifExpr->true_.exprs, table);
+      count += devirtualizeCalls(mod, ifExpr->false_, table);
+      break;
+    }
+    case wabt::ExprType::Try: {
+      auto tryExpr = wabt::cast<wabt::TryExpr>(&*it);
+      count += devirtualizeCalls(mod, tryExpr->block.exprs, table);
+      for (auto &c : tryExpr->catches) {
+        count += devirtualizeCalls(mod, c.exprs, table);
+      }
+      break;
+    }
+    case wabt::ExprType::CallIndirect: {
+      if (it == exprs.begin()) {
+        break;
+      }
+      auto prev = std::prev(it);
+      if (prev->type() != wabt::ExprType::Const) {
+        break;
+      }
+      auto &index = wabt::cast<wabt::ConstExpr>(&*prev)->const_;
+      if (index.type() != wabt::Type::I32) {
+        break;
+      }
+      auto entry = table.find(index.u32());
+      if (entry == table.end()) {
+        break;
+      }
+      auto callIndirect = wabt::cast<wabt::CallIndirectExpr>(&*it);
+      if (callIndirect->table.index() != 0 ||
+          !(getSignature(mod, callIndirect->decl) == getSignature(mod, mod.funcs[entry->second]->decl))) {
+        break;
+      }
+      auto call = std::make_unique<wabt::CallExpr>(wabt::Var(entry->second, it->loc));
+      exprs.erase(prev);
+      it = exprs.erase(it);
+      it = exprs.insert(it, std::move(call));
+      count += 1;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return count;
+}
+
+/**
+ * Copies the instructions of a function body into `dst`, renumbering its locals starting at `localBase`,
+ * and turning `return` into a branch out of the (inlined) body.
+ *
+ * Only supports the instructions that can occur in a leaf word. Returns the number of copied instructions,
+ * or 0 if an unsupported instruction was encountered.
+ */
+wabt::Index cloneInlineBody(const wabt::ExprList &src, wabt::ExprList &dst, wabt::Index localBase, wabt::Index depth) {
+  wabt::Index count = 0;
+  for (auto &expr : src) {
+    std::unique_ptr<wabt::Expr> copy;
+    switch (expr.type()) {
+    case wabt::ExprType::Const:
+      copy = std::make_unique<wabt::ConstExpr>(wabt::cast<wabt::ConstExpr>(&expr)->const_, expr.loc);
+      break;
+    case wabt::ExprType::LocalGet:
+      copy = std::make_unique<wabt::LocalGetExpr>(wabt::Var(localBase + wabt::cast<wabt::LocalGetExpr>(&expr)->var.index(), expr.loc), expr.loc);
+      break;
+    case wabt::ExprType::LocalSet:
+      copy = std::make_unique<wabt::LocalSetExpr>(wabt::Var(localBase + wabt::cast<wabt::LocalSetExpr>(&expr)->var.index(), expr.loc), expr.loc);
+      break;
+    case wabt::ExprType::LocalTee:
+      copy = std::make_unique<wabt::LocalTeeExpr>(wabt::Var(localBase + wabt::cast<wabt::LocalTeeExpr>(&expr)->var.index(), expr.loc), expr.loc);
+      break;
+    case wabt::ExprType::GlobalGet:
+      copy = std::make_unique<wabt::GlobalGetExpr>(wabt::cast<wabt::GlobalGetExpr>(&expr)->var, expr.loc);
+      break;
+    case wabt::ExprType::GlobalSet:
+      copy = std::make_unique<wabt::GlobalSetExpr>(wabt::cast<wabt::GlobalSetExpr>(&expr)->var, expr.loc);
+      break;
+    case wabt::ExprType::Load: {
+      auto load = wabt::cast<wabt::LoadExpr>(&expr);
+      copy = std::make_unique<wabt::LoadExpr>(load->opcode, load->memidx, load->align, load->offset, expr.loc);
+      break;
+    }
+    case wabt::ExprType::Store: {
+      auto store = wabt::cast<wabt::StoreExpr>(&expr);
+      copy = std::make_unique<wabt::StoreExpr>(store->opcode, store->memidx, store->align, store->offset, expr.loc);
+      break;
+    }
+    case wabt::ExprType::Binary:
+      copy = std::make_unique<wabt::BinaryExpr>(wabt::cast<wabt::BinaryExpr>(&expr)->opcode, expr.loc);
+      break;
+    case wabt::ExprType::Compare:
+      copy = std::make_unique<wabt::CompareExpr>(wabt::cast<wabt::CompareExpr>(&expr)->opcode, expr.loc);
+      break;
+    case wabt::ExprType::Unary:
+      copy = std::make_unique<wabt::UnaryExpr>(wabt::cast<wabt::UnaryExpr>(&expr)->opcode, expr.loc);
+      break;
+    case wabt::ExprType::Convert:
+      copy = std::make_unique<wabt::ConvertExpr>(wabt::cast<wabt::ConvertExpr>(&expr)->opcode, expr.loc);
+      break;
+    case wabt::ExprType::Select:
+      copy = std::make_unique<wabt::SelectExpr>(wabt::cast<wabt::SelectExpr>(&expr)->result_type, expr.loc);
+      break;
+    case wabt::ExprType::Drop:
+      copy = std::make_unique<wabt::DropExpr>(expr.loc);
+      break;
+    case wabt::ExprType::Nop:
+      copy = std::make_unique<wabt::NopExpr>(expr.loc);
+      break;
+    case wabt::ExprType::Unreachable:
+      copy = std::make_unique<wabt::UnreachableExpr>(expr.loc);
+      break;
+    case wabt::ExprType::Br:
+      copy = std::make_unique<wabt::BrExpr>(wabt::cast<wabt::BrExpr>(&expr)->var, expr.loc);
+      break;
+    case wabt::ExprType::BrIf:
+      copy = std::make_unique<wabt::BrIfExpr>(wabt::cast<wabt::BrIfExpr>(&expr)->var, expr.loc);
+      break;
+    case wabt::ExprType::Return:
+      copy = std::make_unique<wabt::BrExpr>(wabt::Var(depth, expr.loc), expr.loc);
+      break;
+    case wabt::ExprType::Block:
+    case wabt::ExprType::Loop: {
+      auto &block = expr.type() == wabt::ExprType::Block ? wabt::cast<wabt::BlockExpr>(&expr)->block : wabt::cast<wabt::LoopExpr>(&expr)->block;
+      std::unique_ptr<wabt::Expr> blockCopy;
+      wabt::Block *blockCopyBlock;
+      if (expr.type() == wabt::ExprType::Block) {
+        auto b = std::make_unique<wabt::BlockExpr>(expr.loc);
+        blockCopyBlock = &b->block;
+        blockCopy = std::move(b);
+      } else {
+        auto b = std::make_unique<wabt::LoopExpr>(expr.loc);
+        blockCopyBlock = &b->block;
+        blockCopy = std::move(b);
+      }
+      blockCopyBlock->decl = block.decl;
+      auto n = cloneInlineBody(block.exprs, blockCopyBlock->exprs, localBase, depth + 1);
+      if (n == 0 && !block.exprs.empty()) {
+        return 0;
+      }
+      count += n;
+      copy = std::move(blockCopy);
+      break;
+    }
+    case wabt::ExprType::If: {
+      auto ifExpr = wabt::cast<wabt::IfExpr>(&expr);
+      auto ifCopy = std::make_unique<wabt::IfExpr>(expr.loc);
+      ifCopy->true_.decl = ifExpr->true_.decl;
+      auto n = cloneInlineBody(ifExpr->true_.exprs, ifCopy->true_.exprs, localBase, depth + 1);
+      if (n == 0 && !ifExpr->true_.exprs.empty()) {
+        return 0;
+      }
+      count += n;
+      n = cloneInlineBody(ifExpr->false_, ifCopy->false_, localBase, depth + 1);
+      if (n == 0 && !ifExpr->false_.empty()) {
+        return 0;
+      }
+      count += n;
+      copy = std::move(ifCopy);
+      break;
+    }
+    default:
+      return 0;
+    }
+    dst.push_back(std::move(copy));
+    count += 1;
+  }
+  return count;
+}
+
+/**
+ * Returns whether a function can be inlined: it needs to be a small leaf function, with at most 1
+ * result, and only numeric locals.
+ */
+bool isInlinable(const wabt::Module &mod, const wabt::Func &func, wabt::Index threshold) {
+  if (func.exprs.empty() || getSignature(mod, func.decl).result_types.size() > 1) {
+    return false;
+  }
+  for (auto type : func.local_types) {
+    if (type != wabt::Type::I32 && type != wabt::Type::I64 && type != wabt::Type::F32 && type != wabt::Type::F64) {
+      return false;
+    }
+  }
+  wabt::ExprList body;
+  auto size = cloneInlineBody(func.exprs, body, 0, 0);
+  return size > 0 && size <= threshold;
+}
+
+wabt::Const zero(wabt::Type type) {
+  switch (type) {
+  case wabt::Type::I64:
+    return wabt::Const::I64(0);
+  case wabt::Type::F32:
+    return wabt::Const::F32(0);
+  case wabt::Type::F64:
+    return wabt::Const::F64(0);
+  default:
+    return wabt::Const::I32(0);
+  }
+}
+
+/**
+ * Replaces direct calls to inlinable functions by a block containing the body of the function.
+ *
+ * The arguments are moved from the stack into fresh locals of the caller before entering the block.
+ */
+size_t inlineCalls(wabt::Module &mod, wabt::Func &caller, wabt::ExprList &exprs, const std::vector<bool> &inlinable) {
+  size_t count = 0;
+  for (auto it = exprs.begin(); it != exprs.end(); ++it) {
+    switch (it->type()) {
+    case wabt::ExprType::Block:
+      count += inlineCalls(mod, caller, wabt::cast<wabt::BlockExpr>(&*it)->block.exprs, inlinable);
+      break;
+    case wabt::ExprType::Loop:
+      count += inlineCalls(mod, caller, wabt::cast<wabt::LoopExpr>(&*it)->block.exprs, inlinable);
+      break;
+    case wabt::ExprType::If: {
+      auto ifExpr = wabt::cast<wabt::IfExpr>(&*it);
+      count += inlineCalls(mod, caller, ifExpr->true_.exprs, inlinable);
+      count += inlineCalls(mod, caller, ifExpr->false_, inlinable);
+      break;
+    }
+    case wabt::ExprType::Try: {
+      auto tryExpr = wabt::cast<wabt::TryExpr>(&*it);
+      count += inlineCalls(mod, caller, tryExpr->block.exprs, inlinable);
+      for (auto &c : tryExpr->catches) {
+        count += inlineCalls(mod, caller, c.exprs, inlinable);
+      }
+      break;
+    }
+    case wabt::ExprType::Call: {
+      auto index = wabt::cast<wabt::CallExpr>(&*it)->var.index();
+      if (!inlinable[index]) {
+        break;
+      }
+      auto loc = it->loc;
+      auto &callee = *mod.funcs[index];
+      auto &sig = getSignature(mod, callee.decl);
+      auto localBase = caller.GetNumParamsAndLocals();
+      for (auto type : sig.param_types) {
+        caller.local_types.AppendDecl(type, 1);
+      }
+      for (auto type : callee.local_types) {
+        caller.local_types.AppendDecl(type, 1);
+      }
+
+      auto block = std::make_unique<wabt::BlockExpr>(loc);
+      block->block.decl.sig.result_types = sig.result_types;
+      // Locals are zero-initialized on every function entry, so do the same when entering the inlined body
+      auto localIndex = localBase + sig.GetNumParams();
+      for (auto type : callee.local_types) {
+        block->block.exprs.push_back(std::make_unique<wabt::ConstExpr>(zero(type)));
+        block->block.exprs.push_back(std::make_unique<wabt::LocalSetExpr>(wabt::Var(localIndex++, loc)));
+      }
+      cloneInlineBody(callee.exprs, block->block.exprs, localBase, 0);
+
+      it = exprs.erase(it);
+      it = exprs.insert(it, std::move(block));
+      // The last argument is on top of the stack
+      for (wabt::Index i = sig.GetNumParams(); i > 0; --i) {
+        exprs.insert(it, std::make_unique<wabt::LocalSetExpr>(wabt::Var(localBase + i - 1, loc)));
+      }
+      count += 1;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return count;
+}
+
+/**
+ * Replaces the functions of the core that use SIMD instructions by a call to their scalar
+ * version, so the resulting module (and the generated C code) doesn't need SIMD support.
+ *
+ * The scalar version of a function `$f` is the function `$fScalar`, with the same signature.
+ */
+wabt::Result lowerSimd(wabt::Module &mod) {
+  // Names are only available if the core was compiled with debug names
+  for (wabt::Index i = 0; i < mod.funcs.size(); ++i) {
+    auto func = mod.funcs[i];
+    if (!endsWith(func->name, "Scalar")) {
+      continue;
+    }
+    auto name = func->name.substr(0, func->name.size() - std::strlen("Scalar"));
+    auto simdFunc = std::find_if(mod.funcs.begin(), mod.funcs.end(), [&](const wabt::Func *f) { return f->name == name; });
+    if (simdFunc == mod.funcs.end()) {
+      continue;
+    }
+    auto &exprs = (*simdFunc)->exprs;
+    exprs.clear();
+    for (wabt::Index j = 0; j < (*simdFunc)->GetNumParams(); ++j) {
+      exprs.push_back(std::make_unique<wabt::LocalGetExpr>(wabt::Var(j, wabt::Location())));
+    }
+    exprs.push_back(std::make_unique<wabt::CallExpr>(wabt::Var(i, wabt::Location())));
+    (*simdFunc)->local_types.Set({});
+  }
+  mod.features_used.simd = false;
+  return wabt::Result::Ok;
+}
+
+wabt::Result optimizeModule(wabt::Module &mod, const OptimizeOptions &options) {
+  if (!options.devirtualize) {
+    return wabt::Result::Ok;
+  }
+
+  auto table = getTableFunctions(mod);
+  for (auto func : mod.funcs) {
+    devirtualizeCalls(mod, func->exprs, table);
+  }
+
+  if (options.inlineThreshold > 0) {
+    std::vector<bool> inlinable(mod.funcs.size(), false);
+    for (wabt::Index i = mod.num_func_imports; i < mod.funcs.size(); ++i) {
+      inlinable[i] = isInlinable(mod, *mod.funcs[i], options.inlineThreshold);
+    }
+    for (wabt::Index i = mod.num_func_imports; i < mod.funcs.size(); ++i) {
+      if (!inlinable[i]) {
+        inlineCalls(mod, *mod.funcs[i], mod.funcs[i]->exprs, inlinable);
+      }
+    }
+  }
+
+  return wabt::Result::Ok;
+}
+
+/**
+ * Finds the functions reachable from the given program, and replaces all other functions by a stub.
+ *
+ * The words used by the program are the words it names, the words of which the execution token
+ * is stored in the data space (e.g. by `IS`) or used as constant in reachable code (e.g. by `[']`),
+ * and the words these call. If a word that looks up words at runtime (`EVALUATE`, `FIND`) is
+ * reachable, all words are kept.
+ *
+ * Table entries of removed words are cleared. If the program is precompiled, the interpreter is
+ * removed as well.
+ */
+wabt::Result stripModule(wabt::Module &mod, const RunResult &rresult, const std::string &init, bool precompiledInit) {
+  auto toUpper = [](std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::toupper(c); });
+    return s;
+  };
+  auto table = getTableFunctions(mod);
+
+  std::map<wabti::u32, const DictionaryEntry *> entries;
+  std::set<wabti::u32> wordTableIndices;
+  for (auto &entry : rresult.dictionary) {
+    entries[entry.xt] = &entry;
+    // Table entries of data words (e.g. PUSH_DATA_ADDRESS, or DOES> code) are shared, and can be used by
+    // words created at runtime.
+    if (!(entry.flags & 0x40)) {
+      wordTableIndices.insert(entry.tableIndex);
+    }
+  }
+
+  std::vector<bool> liveFuncs(mod.funcs.size(), false);
+  std::set<wabti::u32> liveTableIndices;
+  std::set<wabti::u32> liveEntries;
+  std::vector<wabt::Index> queue;
+  auto markFunc = [&](wabt::Index index) {
+    if (index < liveFuncs.size() && !liveFuncs[index]) {
+      liveFuncs[index] = true;
+      queue.push_back(index);
+    }
+  };
+  auto markTableIndex = [&](wabti::u32 index) {
+    if (liveTableIndices.insert(index).second) {
+      auto func = table.find(index);
+      if (func != table.end()) {
+        markFunc(func->second);
+      }
+    }
+  };
+  bool keepAllEntries = false;
+  auto markEntry = [&](wabti::u32 xt) {
+    auto entry = entries.find(xt);
+    if (entry == entries.end() || !liveEntries.insert(xt).second) {
+      return;
+    }
+    auto name = toUpper(entry->second->name);
+    if (name == "EVALUATE" || name == "FIND") {
+      keepAllEntries = true;
+    }
+    markTableIndex(entry->second->tableIndex);
+  };
+
+  // Roots: exported functions, table entries that aren't the code of a single word, and the words named in
+  // the program
+  for (auto export_ : mod.exports) {
+    // A precompiled initialization program doesn't need the interpreter
+    if (precompiledInit && export_->name == "run") {
+      continue;
+    }
+    if (export_->kind == wabt::ExternalKind::Func) {
+      markFunc(mod.GetFuncIndex(export_->var));
+    }
+  }
+  for (auto start : mod.starts) {
+    markFunc(mod.GetFuncIndex(*start));
+  }
+  for (auto &func : table) {
+    if (wordTableIndices.find(func.first) == wordTableIndices.end()) {
+      markTableIndex(func.first);
+    }
+  }
+  std::set<std::string> names;
+  std::istringstream initss(init);
+  for (std::string name; initss >> name;) {
+    names.insert(toUpper(name));
+  }
+  for (auto &entry : rresult.dictionary) {
+    if (!(entry.flags & 0x20) && names.find(toUpper(entry.name)) != names.end()) {
+      markEntry(entry.xt);
+    }
+  }
+
+  // Execution tokens stored in the data space (skipping the links of the dictionary entries themselves) and the heap
+  for (size_t i = 0; i + 4 <= rresult.data.size(); ++i) {
+    wabti::u32 value;
+    std::memcpy(&value, &rresult.data[i], 4);
+    if (entries.find(rresult.dataOffset + i) == entries.end()) {
+      markEntry(value);
+    }
+  }
+  for (size_t i = 0; i + 4 <= rresult.heap.size(); ++i) {
+    wabti::u32 value;
+    std::memcpy(&value, &rresult.heap[i], 4);
+    markEntry(value);
+  }
+
+  std::function<void(const wabt::ExprList &)> scan = [&](const wabt::ExprList &exprs) {
+    for (auto it = exprs.begin(); it != exprs.end(); ++it) {
+      switch (it->type()) {
+      case wabt::ExprType::Block:
+        scan(wabt::cast<wabt::BlockExpr>(&*it)->block.exprs);
+        break;
+      case wabt::ExprType::Loop:
+        scan(wabt::cast<wabt::LoopExpr>(&*it)->block.exprs);
+        break;
+      case wabt::ExprType::If:
+        scan(wabt::cast<wabt::IfExpr>(&*it)->true_.exprs);
+        scan(wabt::cast<wabt::IfExpr>(&*it)->false_);
+        break;
+      case wabt::ExprType::Try:
+        scan(wabt::cast<wabt::TryExpr>(&*it)->block.exprs);
+        for (auto &c : wabt::cast<wabt::TryExpr>(&*it)->catches) {
+          scan(c.exprs);
+        }
+        break;
+      case wabt::ExprType::Call:
+        markFunc(wabt::cast<wabt::CallExpr>(&*it)->var.index());
+        break;
+      case wabt::ExprType::ReturnCall:
+        markFunc(wabt::cast<wabt::ReturnCallExpr>(&*it)->var.index());
+        break;
+      case wabt::ExprType::RefFunc:
+        markFunc(wabt::cast<wabt::RefFuncExpr>(&*it)->var.index());
+        break;
+      case wabt::ExprType::Const: {
+        auto &value = wabt::cast<wabt::ConstExpr>(&*it)->const_;
+        if (value.type() == wabt::Type::I32) {
+          markEntry(value.u32());
+          auto next = std::next(it);
+          if (next != exprs.end() && next->type() == wabt::ExprType::CallIndirect) {
+            markTableIndex(value.u32());
+          }
+        }
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  };
+
+  while (true) {
+    while (!queue.empty()) {
+      auto index = queue.back();
+      queue.pop_back();
+      scan(mod.funcs[index]->exprs);
+    }
+    if (!keepAllEntries || liveEntries.size() == entries.size()) {
+      break;
+    }
+    for (auto &entry : rresult.dictionary) {
+      markEntry(entry.xt);
+    }
+  }
+
+  for (wabt::Index i = mod.num_func_imports; i < mod.funcs.size(); ++i) {
+    if (liveFuncs[i]) {
+      continue;
+    }
+    auto func = mod.funcs[i];
+    func->exprs.clear();
+    func->exprs.push_back(std::make_unique<wabt::UnreachableExpr>());
+    func->local_types.Set({});
+    mod.used_func_refs.erase(i);
+  }
+  for (auto elem : mod.elem_segments) {
+    for (auto &expr : elem->elem_exprs) {
+      if (expr.size() == 1 && expr.front().type() == wabt::ExprType::RefFunc &&
+          !liveFuncs[wabt::cast<wabt::RefFuncExpr>(&expr.front())->var.index()]) {
+        expr = wabt::ExprList{std::make_unique<wabt::RefNullExpr>(wabt::Type::FuncRef)};
+      }
+    }
+  }
 
   return wabt::Result::Ok;
 }
 
+/**
+ * Returns whether the code reachable from a function is safe to call from a precompiled
+ * initialization program: it can't call one of the `forbidden` functions (e.g. anything that reads
+ * the input), refer to one of the `forbidden` addresses, or do indirect calls to unknown functions.
+ */
+bool isPrecompilable(const wabt::Module &mod, const std::map<uint32_t, wabt::Index> &table, wabt::Index root,
+                     const std::set<std::string> &forbiddenFuncs, const std::set<uint32_t> &forbiddenAddresses) {
+  std::vector<bool> visited(mod.funcs.size(), false);
+  std::vector<wabt::Index> queue = {root};
+  bool ok = true;
+  auto visit = [&](wabt::Index index) {
+    if (!visited[index]) {
+      visited[index] = true;
+      queue.push_back(index);
+    }
+  };
+  std::function<void(const wabt::ExprList &)> scan = [&](const wabt::ExprList &exprs) {
+    for (auto it = exprs.begin(); ok && it != exprs.end(); ++it) {
+      switch (it->type()) {
+      case wabt::ExprType::Block:
+        scan(wabt::cast<wabt::BlockExpr>(&*it)->block.exprs);
+        break;
+      case wabt::ExprType::Loop:
+        scan(wabt::cast<wabt::LoopExpr>(&*it)->block.exprs);
+        break;
+      case wabt::ExprType::If:
+        scan(wabt::cast<wabt::IfExpr>(&*it)->true_.exprs);
+        scan(wabt::cast<wabt::IfExpr>(&*it)->false_);
+        break;
+      case wabt::ExprType::Try:
+        scan(wabt::cast<wabt::TryExpr>(&*it)->block.exprs);
+        for (auto &c : wabt::cast<wabt::TryExpr>(&*it)->catches) {
+          scan(c.exprs);
+        }
+        break;
+      case wabt::ExprType::Call:
+        visit(wabt::cast<wabt::CallExpr>(&*it)->var.index());
+        break;
+      case wabt::ExprType::ReturnCall:
+        visit(wabt::cast<wabt::ReturnCallExpr>(&*it)->var.index());
+        break;
+      case wabt::ExprType::CallIndirect: {
+        auto prev = it == exprs.begin() ? exprs.end() : std::prev(it);
+        if (prev == exprs.end() || prev->type() != wabt::ExprType::Const) {
+          ok = false;
+          break;
+        }
+        auto func = table.find(wabt::cast<wabt::ConstExpr>(&*prev)->const_.u32());
+        if (func == table.end()) {
+          ok = false;
+          break;
+        }
+        visit(func->second);
+        break;
+      }
+      case wabt::ExprType::Const: {
+        auto &value = wabt::cast<wabt::ConstExpr>(&*it)->const_;
+        if (value.type() == wabt::Type::I32 && forbiddenAddresses.find(value.u32()) != forbiddenAddresses.end()) {
+          ok = false;
+        }
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  };
+  visited[root] = true;
+  while (ok && !queue.empty()) {
+    auto &func = *mod.funcs[queue.back()];
+    queue.pop_back();
+    if (forbiddenFuncs.find(func.name) != forbiddenFuncs.end()) {
+      return false;
+    }
+    scan(func.exprs);
+  }
+  return ok;
+}
+
+/**
+ * Tries to compile the initialization program into an exported `init` function, which can be called
+ * instead of running the interpreter on the program.
+ *
+ * This only works if the program is a sequence of (decimal) numbers and words that don't interact with the
+ * interpreter (by parsing input, changing state or base, executing other words, ...).
+ */
+wabt::Result precompileInit(wabt::Module &mod, const RunResult &rresult, const std::string &init, bool &precompiled) {
+  precompiled = false;
+  auto table = getTableFunctions(mod);
+
+  // Names are only available if the core was compiled with debug names
+  const std::set<std::string> forbiddenFuncs = {"$interpret", "$execute",  "$parse",  "$parseName", "$skip",       "$REFILL",
+                                                "$SOURCE",    "$EVALUATE", "$HEX",    "$DECIMAL",   "$shell_read"};
+  if (std::find_if(mod.funcs.begin(), mod.funcs.end(), [](const wabt::Func *f) { return f->name == "$interpret"; }) == mod.funcs.end()) {
+    return wabt::Result::Ok;
+  }
+  std::set<uint32_t> forbiddenAddresses;
+  wabti::u32 base = 10;
+  for (auto &entry : rresult.dictionary) {
+    if (entry.name == "BASE" || entry.name == ">IN" || entry.name == "STATE") {
+      forbiddenAddresses.insert(entry.body + 4);
+    }
+    if (entry.name == "BASE" && base == 10) {
+      base = entry.value;
+    }
+  }
+  if (base != 10) {
+    return wabt::Result::Ok;
+  }
+
+  wabt::ExprList exprs;
+  exprs.push_back(std::make_unique<wabt::GlobalGetExpr>(wabt::Var(TOS_GLOBAL_INDEX, wabt::Location())));
+  exprs.push_back(std::make_unique<wabt::LocalSetExpr>(wabt::Var(0, wabt::Location())));
+  std::istringstream initss(init);
+  for (std::string token; initss >> token;) {
+    // Numbers
+    auto digits = token[0] == '-' ? token.substr(1) : token;
+    if (!digits.empty() && digits.size() <= 10 && std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+      auto n = std::stoll(digits);
+      if (n > 0xffffffffLL) {
+        return wabt::Result::Ok;
+      }
+      exprs.push_back(std::make_unique<wabt::LocalGetExpr>(wabt::Var(0, wabt::Location())));
+      exprs.push_back(std::make_unique<wabt::ConstExpr>(wabt::Const::I32(token[0] == '-' ? -(uint32_t)n : (uint32_t)n)));
+      exprs.push_back(std::make_unique<wabt::StoreExpr>(wabt::Opcode::I32Store, wabt::Var(0, wabt::Location()), 4, 0));
+      exprs.push_back(std::make_unique<wabt::LocalGetExpr>(wabt::Var(0, wabt::Location())));
+      exprs.push_back(std::make_unique<wabt::ConstExpr>(wabt::Const::I32(4)));
+      exprs.push_back(std::make_unique<wabt::BinaryExpr>(wabt::Opcode::I32Add));
+      exprs.push_back(std::make_unique<wabt::LocalSetExpr>(wabt::Var(0, wabt::Location())));
+      continue;
+    }
+
+    // Words
+    std::string name(token);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
+    auto entry = std::find_if(rresult.dictionary.begin(), rresult.dictionary.end(), [&](const DictionaryEntry &e) {
+      if (e.flags & 0x20 || e.name.size() != name.size()) {
+        return false;
+      }
+      return std::equal(e.name.begin(), e.name.end(), name.begin(), [](char a, char b) { return std::toupper(a) == b; });
+    });
+    if (entry == rresult.dictionary.end() || (entry->flags & 0x80)) {
+      return wabt::Result::Ok;
+    }
+    auto func = table.find(entry->tableIndex);
+    if (func == table.end()) {
+      return wabt::Result::Ok;
+    }
+    auto &sig = getSignature(mod, mod.funcs[func->second]->decl);
+    bool isData = entry->flags & 0x40;
+    if (sig.GetNumParams() != (isData ? 2 : 1) || sig.GetNumResults() != 1 ||
+        !isPrecompilable(mod, table, func->second, forbiddenFuncs, forbiddenAddresses)) {
+      return wabt::Result::Ok;
+    }
+    exprs.push_back(std::make_unique<wabt::LocalGetExpr>(wabt::Var(0, wabt::Location())));
+    if (isData) {
+      exprs.push_back(std::make_unique<wabt::ConstExpr>(wabt::Const::I32(entry->body + 4)));
+    }
+    exprs.push_back(std::make_unique<wabt::CallExpr>(wabt::Var(func->second, wabt::Location())));
+    exprs.push_back(std::make_unique<wabt::LocalSetExpr>(wabt::Var(0, wabt::Location())));
+  }
+  exprs.push_back(std::make_unique<wabt::LocalGetExpr>(wabt::Var(0, wabt::Location())));
+  exprs.push_back(std::make_unique<wabt::GlobalSetExpr>(wabt::Var(TOS_GLOBAL_INDEX, wabt::Location())));
+
+  auto ff = std::make_unique<wabt::FuncModuleField>();
+  auto &f = ff->func;
+  f.name = "$precompiledInit";
+  f.local_types.Set({wabt::Type::I32});
+  f.exprs = std::move(exprs);
+  mod.AppendField(std::move(ff));
+
+  auto ef = std::make_unique<wabt::ExportModuleField>();
+  ef->export_.name = "init";
+  ef->export_.kind = wabt::ExternalKind::Func;
+  ef->export_.var = wabt::Var(mod.funcs.size() - 1, wabt::Location());
+  mod.AppendField(std::move(ef));
+
+  precompiled = true;
+  return wabt::Result::Ok;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 wabt::Result main_(const std::string &infile, const std::string &outfile, const std::string &init, const std::string &cc,
-                   const std::vector<std::string> &cflags, wabt::Errors &errors) {
+                   const std::vector<std::string> &cflags, const OptimizeOptions &optimizeOptions, const BuildOptions &buildOptions,
+                   wabt::Errors &errors) {
   stderrStream = wabt::FileStream::CreateStderr();
 
-  std::vector<uint8_t> in;
-  CHECK_RESULT(wabt::ReadFile(infile, &in));
+  input_t in;
+  if (!input_open_file(&in, infile.c_str())) {
+    std::cerr << "error opening " << infile << ": " << std::strerror(errno) << std::endl;
+    return wabt::Result::Error;
+  }
+  defer _(nullptr, [&](...) { input_close(&in); });
+  timer.done("read input");
+
+  // Executables are determined by the compiler itself, the input, and all options
+  fs::path executableEntry;
+  if (cache.enabled() && !endsWith(outfile, ".wasm")) {
+    std::ostringstream options;
+    options << cc << " " << optimizeOptions.devirtualize << " " << optimizeOptions.inlineThreshold << " " << optimizeOptions.strip << " "
+            << optimizeOptions.simd << " " << buildOptions.jobs << " " << buildOptions.memory << " " << buildOptions.pgo;
+    for (auto &flag : cflags) {
+      options << " " << flag;
+    }
+    bool hit;
+    executableEntry = cache.lookup("executable",
+                                   contentHash({VERSION, std::string_view((const char *)waforth_core, sizeof(waforth_core)),
+                                                std::string_view((const char *)waforth_rt, sizeof(waforth_rt)),
+                                                std::string_view((const char *)waforth_input, sizeof(waforth_input)),
+                                                std::string_view(in.data, in.size), init, options.str()}),
+                                   hit);
+    if (hit) {
+      std::error_code ec;
+      fs::copy_file(executableEntry, outfile, fs::copy_options::overwrite_existing, ec);
+      if (ec) {
+        std::cerr << "error copying " << executableEntry << ": " << ec.message() << std::endl;
+        return wabt::Result::Error;
+      }
+      timer.done("copy cached executable");
+      cache.report();
+      return wabt::Result::Ok;
+    }
+  }
 
   RunResult rresult;
   CHECK_RESULT(run(in, rresult, errors));
+  timer.done("run");
 
-  std::vector<wabt::Module> words;
-  for (auto rmod : rresult.modules) {
-    wabt::Module mod;
-    CHECK_RESULT(readModule("word.wasm", &rmod[0], rmod.size(), mod, errors));
-    words.push_back(std::move(mod));
+  std::vector<wabt::Module> words(rresult.modules.size());
+  std::vector<wabt::Errors> wordErrors(rresult.modules.size());
+  auto wordsResult = parallelFor(rresult.modules.size(), buildOptions.jobs, [&](size_t i) {
+    auto &rmod = rresult.modules[i];
+    return readModule("word.wasm", &rmod[0], rmod.size(), words[i], wordErrors[i]);
+  });
+  for (auto &e : wordErrors) {
+    errors.insert(errors.end(), std::make_move_iterator(e.begin()), std::make_move_iterator(e.end()));
   }
+  CHECK_RESULT(wordsResult);
+  timer.done("read words");
 
   wabt::Module compiled;
-  CHECK_RESULT(compileToModule(words, rresult.data, rresult.dataOffset, rresult.latest, compiled, errors));
+  CHECK_RESULT(compileToModule(words, rresult.data, rresult.dataOffset, rresult.operatorData, rresult.latest, rresult.heap, rresult.heapGlobals, buildOptions.memory, compiled, errors));
+  timer.done("link module");
+  if (!optimizeOptions.simd) {
+    CHECK_RESULT(lowerSimd(compiled));
+  }
+  CHECK_RESULT(optimizeModule(compiled, optimizeOptions));
+  bool precompiledInit = false;
+  if (!init.empty()) {
+    CHECK_RESULT(precompileInit(compiled, rresult, init, precompiledInit));
+  }
+  if (optimizeOptions.strip) {
+    // The interpreter is needed for the training run, which uses words of its own
+    CHECK_RESULT(stripModule(compiled, rresult, init + "\n" + buildOptions.pgo, precompiledInit && buildOptions.pgo.empty()));
+  }
+  timer.done("optimize");
 
   if (endsWith(outfile, ".wasm")) {
     CHECK_RESULT(writeModule(outfile, compiled));
+    timer.done("write module");
   } else {
-    CHECK_RESULT(compileToNative(compiled, init, outfile, cc, cflags));
+    CHECK_RESULT(compileToNative(compiled, init, precompiledInit, outfile, cc, cflags, buildOptions));
+    if (!executableEntry.empty()) {
+      cache.store(executableEntry, {outfile}, false);
+    }
   }
+  cache.report();
 
   return wabt::Result::Ok;
 }
@@ -461,8 +1753,110 @@ Options:
                              resulting executable is run. Otherwise, the 
                              resulting executable will start an interactive 
                              session.
+  --no-devirtualize          Keep indirect calls between words, instead of
+                             replacing them by direct calls
+  --inline-threshold=N       Inline words of at most N instructions that don't
+                             call other words (default: 24, 0 to disable)
+  --strip                    Remove all words that are not used by the
+                             initialization program from the executable.
+                             Requires --init.
+  --simd                     Keep the core's SIMD string functions. The
+                             generated code then needs the SIMDe headers to
+                             compile. This is the default if the output is a
+                             WebAssembly module, or if the SIMDe headers are
+                             found in the include path (e.g. given with
+                             --ccflag=-I/path/to/simde).
+  --no-simd                  Use the scalar versions of the core's SIMD
+                             string functions.
+  --jobs=N                   Number of parallel jobs (default: 1)
+                             Word modules are read, and the C code is split
+                             and compiled, using N threads.
+  --time                     Report the time spent in each build phase
+  --cache-dir=DIR            Cache runtime objects, objects of generated code,
+                             and executables in DIR, and reuse them in later
+                             builds with the same inputs
+  --pgo=PROGRAM              Use profile-guided optimization, with PROGRAM as
+                             initialization program for the training run
+  --memcheck=MODE            How memory accesses are checked:
+                               bounds: explicit bounds checks
+                               guard: reserve a guard region, and trap on 
+                                 accesses into it (64-bit only)
+                               none: no checks, and no recovery from invalid 
+                                 accesses (64-bit only)
+                             Defaults to the choice of the WebAssembly runtime.
+  --memory=SIZE              Initial memory size, with an optional K, M, or G 
+                             suffix. Memory grows on demand beyond this.
 )";
 
+/**
+ * Parses a size in bytes, with an optional K, M, or G suffix.
+ */
+bool parseSize(const std::string &s, uint64_t &result) {
+  char *end;
+  auto n = std::strtoull(s.c_str(), &end, 10);
+  if (end == s.c_str()) {
+    return false;
+  }
+  switch (*end) {
+  case 'G':
+  case 'g':
+    n <<= 10;
+    [[fallthrough]];
+  case 'M':
+  case 'm':
+    n <<= 10;
+    [[fallthrough]];
+  case 'K':
+  case 'k':
+    n <<= 10;
+    ++end;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+  result = n;
+  return true;
+}
+
+/**
+ * Returns whether the SIMDe headers, which the C code generated for SIMD instructions includes,
+ * can be found in the include directories given in the compiler flags, in the
+ * compiler's include path environment variables, or in the usual system include directories.
+ */
+bool findSimde(const std::vector<std::string> &ccflags) {
+  std::vector<fs::path> dirs;
+  for (size_t i = 0; i < ccflags.size(); ++i) {
+    if (ccflags[i] == "-I" && i + 1 < ccflags.size()) {
+      dirs.push_back(ccflags[++i]);
+    } else if (ccflags[i].rfind("-I", 0) == 0) {
+      dirs.push_back(ccflags[i].substr(2));
+    }
+  }
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+  const char separator = ';';
+#else
+  const char separator = ':';
+#endif
+  for (auto var : {"CPATH", "C_INCLUDE_PATH"}) {
+    if (auto value = std::getenv(var)) {
+      std::istringstream ss(value);
+      for (std::string dir; std::getline(ss, dir, separator);) {
+        if (!dir.empty()) {
+          dirs.push_back(dir);
+        }
+      }
+    }
+  }
+  dirs.insert(dirs.end(), {"/usr/local/include", "/usr/include", "/opt/homebrew/include"});
+  for (auto &dir : dirs) {
+    std::error_code ec;
+    if (fs::exists(dir / "simde" / "wasm" / "simd128.h", ec)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 std::pair<std::string, std::string> splitOption(const std::string &s) {
   auto i = s.find("=");
   if (i == std::string::npos) {
@@ -477,6 +1871,15 @@ int main(int argc, char *argv[]) {
   std::string init;
   std::string cc("gcc");
   std::vector<std::string> ccflags;
+  std::vector<std::string> memcheckFlags;
+  OptimizeOptions optimizeOptions;
+  BuildOptions buildOptions;
+  // The core uses SIMD instructions (see --simd)
+  features.enable_simd();
+  // Whether to keep the SIMD instructions (-1: if the SIMDe headers are found)
+  int simd = -1;
+  // The core uses exceptions for CATCH and THROW
+  features.enable_exceptions();
   for (int i = 1; i < argc; ++i) {
     std::string arg(argv[i]);
     if (arg.size() >= 0 && arg[0] == '-') {
@@ -492,6 +1895,41 @@ int main(int argc, char *argv[]) {
         cc = opt.second;
       } else if (opt.first == "--ccflag") {
         ccflags.push_back(opt.second);
+      } else if (opt.first == "--no-devirtualize") {
+        optimizeOptions.devirtualize = false;
+      } else if (opt.first == "--inline-threshold") {
+        optimizeOptions.inlineThreshold = std::atoi(opt.second.c_str());
+      } else if (opt.first == "--strip") {
+        optimizeOptions.strip = true;
+      } else if (opt.first == "--simd") {
+        simd = 1;
+      } else if (opt.first == "--no-simd") {
+        simd = 0;
+      } else if (opt.first == "--jobs") {
+        buildOptions.jobs = std::max(1, std::atoi(opt.second.c_str()));
+      } else if (opt.first == "--time") {
+        timer.enabled = true;
+      } else if (opt.first == "--pgo") {
+        buildOptions.pgo = opt.second;
+      } else if (opt.first == "--memcheck") {
+        if (opt.second == "bounds") {
+          memcheckFlags = {"-DWASM_RT_MEMCHECK_BOUNDS_CHECK=1", "-DWASM_RT_MEMCHECK_GUARD_PAGES=0"};
+        } else if (opt.second == "guard") {
+          memcheckFlags = {"-DWASM_RT_USE_MMAP=1", "-DWASM_RT_MEMCHECK_BOUNDS_CHECK=0", "-DWASM_RT_MEMCHECK_GUARD_PAGES=1"};
+        } else if (opt.second == "none") {
+          memcheckFlags = {"-DWASM_RT_USE_MMAP=1", "-DWASM_RT_MEMCHECK_BOUNDS_CHECK=0", "-DWASM_RT_MEMCHECK_GUARD_PAGES=1",
+                           "-DWASM_RT_SKIP_SIGNAL_RECOVERY=1"};
+        } else {
+          std::cerr << "invalid memcheck mode: " << opt.second << std::endl;
+          return -1;
+        }
+      } else if (opt.first == "--memory") {
+        if (!parseSize(opt.second, buildOptions.memory)) {
+          std::cerr << "invalid memory size: " << opt.second << std::endl;
+          return -1;
+        }
+      } else if (opt.first == "--cache-dir") {
+        cache.dir = opt.second;
       } else {
         std::cerr << "unrecognized option: " << arg << std::endl;
         return -1;
@@ -508,10 +1946,20 @@ int main(int argc, char *argv[]) {
     std::cout << help;
     return 0;
   }
+  if (optimizeOptions.strip && init.empty()) {
+    std::cerr << "--strip requires --init" << std::endl;
+    return -1;
+  }
+  // Only the generated C code needs SIMDe
+  optimizeOptions.simd = features.simd_enabled() && (simd < 0 ? endsWith(outfile, ".wasm") || findSimde(ccflags) : simd > 0);
+  // The runtime and the generated code need to agree on how memory is checked
+  ccflags.insert(ccflags.end(), memcheckFlags.begin(), memcheckFlags.end());
   ccflags.push_back("-lm");
+  // The runtime runs PAR-DO and SPAWN on worker threads
+  ccflags.push_back("-pthread");
 
   wabt::Errors errors;
-  if (!Succeeded(main_(infile, outfile, init, cc, ccflags, errors))) {
+  if (!Succeeded(main_(infile, outfile, init, cc, ccflags, optimizeOptions, buildOptions, errors))) {
     FormatErrorsToFile(errors, wabt::Location::Type::Binary);
     return -1;
   }
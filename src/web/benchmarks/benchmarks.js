@@ -26,6 +26,9 @@ forth.onEmit = withCharacterBuffer((c) => {
 setup.push(
   forth.load().then(() => {
     forth.interpret(sieve);
+    forth.interpret(textSource);
+    forth.interpret(arraySource);
+    forth.interpret(tasksSource);
   })
 );
 
@@ -47,11 +50,135 @@ setup.push(
   })()
 );
 
+// Large generated source, to measure how fast definitions are loaded
+const COMPILE_DEFINITIONS = 2000;
+const compileSource = ["MARKER COMPILE-BENCH"];
+for (let i = 0; i < COMPILE_DEFINITIONS; i++) {
+  compileSource.push(`${i} CONSTANT C${i}`);
+  compileSource.push(
+    i === 0
+      ? `: W0 C0 1 + ;`
+      : `: W${i} W${i - 1} C${i} + ${i * 3} - DUP 0< IF NEGATE THEN ;`
+  );
+}
+compileSource.push(`W${COMPILE_DEFINITIONS - 1} . COMPILE-BENCH`);
+
+// Long lines with comments, to measure how fast input is parsed
+const PARSE_LINES = 20000;
+const parseSource = [];
+for (let i = 0; i < PARSE_LINES; i++) {
+  parseSource.push(
+    `( ${"stack comment ".repeat(8)})    ${i}      DROP          \\ ${"line comment ".repeat(8)}`
+  );
+}
+
+// String processing
+const TEXT_ITERATIONS = 1000000;
+const textSource = `
+  : TEXT-BENCH-LINE S" the quick brown fox jumps over the lazy dog, and keeps on running      " ;
+  : TEXT-BENCH
+    0 ${TEXT_ITERATIONS} 0 DO
+      TEXT-BENCH-LINE S" keeps on" SEARCH NIP NIP 1 AND +
+      TEXT-BENCH-LINE TEXT-BENCH-LINE COMPARE +
+      TEXT-BENCH-LINE -TRAILING NIP +
+    LOOP . ;
+`;
+
+// Array arithmetic, with the array words and with the equivalent Forth loops
+const ARRAY_SIZE = 10000;
+const ARRAY_ITERATIONS = 1000;
+const arraySource = `
+  ${ARRAY_SIZE} CONSTANT ARRAY-SIZE
+  CREATE ARRAY-A ARRAY-SIZE CELLS ALLOT
+  CREATE ARRAY-B ARRAY-SIZE CELLS ALLOT
+  CREATE ARRAY-C ARRAY-SIZE CELLS ALLOT
+  : ARRAY-INIT ARRAY-SIZE 0 DO I ARRAY-A I CELLS + ! I 3 MOD ARRAY-B I CELLS + ! LOOP ;
+  ARRAY-INIT
+  : ARRAY-BENCH
+    0 ${ARRAY_ITERATIONS} 0 DO
+      ARRAY-A ARRAY-B ARRAY-C ARRAY-SIZE V+
+      ARRAY-C ARRAY-B ARRAY-SIZE VDOT +
+      ARRAY-C ARRAY-SIZE VSUM +
+    LOOP . ;
+  : ARRAY-BENCH-FORTH
+    0 ${ARRAY_ITERATIONS} 0 DO
+      ARRAY-SIZE 0 DO ARRAY-A I CELLS + @ ARRAY-B I CELLS + @ + ARRAY-C I CELLS + ! LOOP
+      ARRAY-SIZE 0 DO ARRAY-C I CELLS + @ ARRAY-B I CELLS + @ * + LOOP
+      ARRAY-SIZE 0 DO ARRAY-C I CELLS + @ + LOOP
+    LOOP . ;
+`;
+
+// Task turns: every RUN-TASKS gives all tasks a turn, which only increments
+// a counter
+const TASKS = 10;
+const TASK_ROUNDS = 1000000;
+const taskNames = Array.from(Array(TASKS).keys()).map((i) => `TASK-${i}`);
+const tasksSource = `
+  VARIABLE TASK-COUNTER
+  VARIABLE TASKS-RUNNING
+  : TASK-TICK 1 TASK-COUNTER +! TASKS-RUNNING @ 0= IF STOP THEN ;
+  ${taskNames.map((name) => `TASK ${name}`).join(" ")}
+  : TASKS-BENCH
+    0 TASK-COUNTER ! TRUE TASKS-RUNNING !
+    ${taskNames.map((name) => `['] TASK-TICK ${name} SCHEDULE`).join(" ")}
+    ${TASK_ROUNDS} 0 DO RUN-TASKS LOOP
+    FALSE TASKS-RUNNING ! RUN-TASKS
+    TASK-COUNTER @ . ;
+`;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 const ITERATIONS = 5;
 const LIMIT = 90000000;
 const benchmarks = [
+  {
+    name: "compile",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret(compileSource.join("\n"));
+      return outputBuffer.join("");
+    },
+  },
+  {
+    name: "parse",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret(parseSource.join("\n"));
+      return outputBuffer.join("");
+    },
+  },
+  {
+    name: "text",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret("TEXT-BENCH");
+      return outputBuffer.join("");
+    },
+  },
+  {
+    name: "arrays",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret("ARRAY-BENCH");
+      return outputBuffer.join("");
+    },
+  },
+  {
+    name: "arrays-forth",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret("ARRAY-BENCH-FORTH");
+      return outputBuffer.join("");
+    },
+  },
+  {
+    name: "tasks",
+    fn: () => {
+      outputBuffer = [];
+      forth.interpret("TASKS-BENCH");
+      return outputBuffer.join("");
+    },
+  },
   {
     name: "sieve",
     fn: () => {
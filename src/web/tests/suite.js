@@ -33,8 +33,7 @@ function loadTests() {
           core = forth.core.exports;
 
           output = "";
-          memory = new Int32Array(core.memory.buffer, 0, 0x30000);
-          memory8 = new Uint8Array(core.memory.buffer, 0, 0x30000);
+          updateMemory();
           // dictionary = new Uint8Array(core.memory.buffer, 0x1000, 0x1000);
           initialTOS = core.tos();
         },
@@ -45,6 +44,12 @@ function loadTests() {
       return x;
     });
 
+    // Memory grows on demand, which detaches previous views on it
+    function updateMemory() {
+      memory = new Int32Array(core.memory.buffer);
+      memory8 = new Uint8Array(core.memory.buffer);
+    }
+
     // eslint-disable-next-line no-unused-vars, @typescript-eslint/no-unused-vars
     function dumpTable() {
       for (let i = 0; i < core.table.length; ++i) {
@@ -95,6 +100,7 @@ function loadTests() {
 
     function run(s, expectErrors = false) {
       forth.interpret(s, true);
+      updateMemory();
       const r = forth.core.exports.error();
       if (expectErrors) {
         expect(r).to.not.eql(4);
@@ -278,6 +284,15 @@ function loadTests() {
         forth.interpret(p.join("\n"));
         expect(stackValues()).to.eql([1001]);
       });
+
+      it("should interpret long lines", () => {
+        const p = ["1"];
+        for (let i = 0; i < 300; i++) {
+          p.push(`${" ".repeat(i % 37)}1   +`);
+        }
+        forth.interpret(p.join(" ") + "   ( " + "x".repeat(100) + " ) ");
+        expect(stackValues()).to.eql([301]);
+      });
     });
 
     describe("DUP", () => {
@@ -772,6 +787,12 @@ function loadTests() {
         expect(stackValues()[5]).to.eql(3);
         expect(stackValues()[6]).to.eql(5);
       });
+
+      it("should have room for a deep return stack", () => {
+        run(": F 8000 0 DO I >R LOOP 8000 0 DO R> DROP LOOP ; F");
+        run(": G 1 2 + . ; G");
+        expect(output.trim()).to.eql("3");
+      });
     });
 
     describe("?DO/LOOP", () => {
@@ -861,6 +882,20 @@ function loadTests() {
         expect(stackValues()[5]).to.eql(1);
         expect(stackValues()[6]).to.eql(5);
       });
+
+      it("should work in a called word", () => {
+        run(`: GETI I ;`);
+        run(`: FOO 4 1 DO GETI I LOOP ;`);
+        run("FOO 5");
+        expect(stackValues()).to.eql([1, 1, 2, 2, 3, 3, 5]);
+      });
+
+      it("should work in a called word after a nested loop", () => {
+        run(`: GETI I ;`);
+        run(`: FOO 3 1 DO 2 0 DO I LOOP GETI LOOP ;`);
+        run("FOO 5");
+        expect(stackValues()).to.eql([0, 1, 1, 0, 1, 2, 5]);
+      });
     });
 
     describe("J", () => {
@@ -887,6 +922,13 @@ function loadTests() {
         expect(stackValues()[5]).to.eql(2);
         expect(stackValues()[6]).to.eql(5);
       });
+
+      it("should work in a called word", () => {
+        run(`: GETJ J ;`);
+        run(`: FOO 3 1 DO 2 0 DO GETJ I + LOOP LOOP ;`);
+        run("FOO 5");
+        expect(stackValues()).to.eql([1, 2, 2, 3, 5]);
+      });
     });
 
     describe("BEGIN / WHILE / REPEAT", () => {
@@ -1060,6 +1102,43 @@ function loadTests() {
         run("FIND");
         expect(stackValues()[1]).to.eql(0);
       });
+
+      it("should find the latest definition", () => {
+        run(": FOO 1 ; : FOO FOO 2 ;");
+        run("FOO");
+        expect(stackValues()).to.eql([1, 2]);
+      });
+
+      it("should find earlier definitions after a marker", () => {
+        run(": FOO 1 ; MARKER UNDO : FOO 2 ; : BAR 3 ;");
+        run("UNDO FOO");
+        expect(stackValues()).to.eql([1]);
+        run("BAR", true);
+        expect(output.trim()).to.eql("undefined word: BAR");
+      });
+
+      it("should find words in a large dictionary", () => {
+        const defs = [];
+        for (let i = 0; i < 7000; i++) {
+          defs.push(`${i} CONSTANT C${i}`);
+        }
+        run(defs.join("\n"));
+        run("C0 C3000 C6999 DUP");
+        expect(stackValues()).to.eql([0, 3000, 6999, 6999]);
+      });
+
+      it("should find words after a marker forgot a grown index", () => {
+        const defs = [];
+        for (let i = 0; i < 7000; i++) {
+          defs.push(`${i} CONSTANT C${i}`);
+        }
+        run(": FOO 1 ; MARKER UNDO");
+        run(defs.join("\n"));
+        run("UNDO : BAR 2 ; FOO BAR");
+        run(defs.join("\n"));
+        run("C6999 C0");
+        expect(stackValues()).to.eql([1, 2, 6999, 0]);
+      });
     });
 
     describe("BASE", () => {
@@ -1227,6 +1306,16 @@ function loadTests() {
         run("FOO");
         expect(output).to.eql("Foo Bar");
       });
+
+      it("should output strings in one go", () => {
+        const strings = [];
+        forth.onType = (s) => {
+          strings.push(new TextDecoder().decode(s));
+        };
+        run(': FOO S" Foo Bar" TYPE -123 . 456 U. ;');
+        run("FOO");
+        expect(strings).to.eql(["Foo Bar", "-123 ", "456 "]);
+      });
     });
 
     describe('."', () => {
@@ -1310,6 +1399,57 @@ function loadTests() {
         expect(stackValues()[8]).to.eql(13);
         expect(stackValues()[9]).to.eql(5);
       });
+
+      it("should recurse in words that are loaded together", () => {
+        run(": FOO 1 ; : FAC DUP 1 > IF DUP 1- RECURSE * THEN ;");
+        run(": SUM DUP IF DUP 1- RECURSE + THEN ; : BAR 2 ;");
+        run("5 FAC 4 SUM FOO BAR");
+        expect(stackValues()).to.eql([120, 10, 1, 2]);
+      });
+
+      it("should recurse in DOES>", () => {
+        run(": DOWN CREATE , DOES> @ OVER IF DROP 1- DUP RECURSE ELSE DROP THEN ;");
+        run("5 DOWN D 3 D");
+        expect(stackValues()).to.eql([2, 1, 0, 0]);
+      });
+
+      it("should recurse in words that don't fit in a batch", () => {
+        run(": SUM DUP IF DUP 1- RECURSE + THEN" + " 1 +".repeat(340) + " ;");
+        run("2 SUM");
+        expect(stackValues()).to.eql([1023]);
+      });
+    });
+
+    describe("FLUSH-CODE", () => {
+      it("should load pending words", () => {
+        run(": FOO 1 ; : BAR FOO 2 ; FLUSH-CODE BAR");
+        expect(stackValues()).to.eql([1, 2]);
+      });
+
+      it("should load pending words when executing them", () => {
+        run(": FOO 1 ; : BAR FOO 2 ; BAR :NONAME 3 ; EXECUTE");
+        expect(stackValues()).to.eql([1, 2, 3]);
+      });
+
+      it("should load pending immediate words while compiling", () => {
+        run(": FIVE 5 POSTPONE LITERAL ; IMMEDIATE : FOO FIVE 6 ; FOO");
+        expect(stackValues()).to.eql([5, 6]);
+      });
+
+      it("should load many words", () => {
+        const defs = [": W0 0 ;"];
+        for (let i = 1; i < 200; i++) {
+          defs.push(`: W${i} W${i - 1} 1+ ;`);
+        }
+        run(defs.join("\n") + " W199");
+        expect(stackValues()).to.eql([199]);
+      });
+
+      it("should load words that don't fit in a batch", () => {
+        run(": FOO 1 ; : BAR 0" + " 1 +".repeat(340) + " ; : BAZ 2 ;");
+        run("FOO BAR BAZ : QUX 3 ; QUX");
+        expect(stackValues()).to.eql([1, 340, 2, 3]);
+      });
     });
 
     describe("CREATE", () => {
@@ -1408,6 +1548,69 @@ function loadTests() {
       it("should compile a name with an illegal WASM character", () => {
         run(': F" 3 0 DO 2 LOOP ;');
       });
+
+      it("should compile long definitions", () => {
+        run(": FOOBAR 0\n" + "1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 +\n".repeat(100) + ";");
+        run("FOOBAR 5");
+        expect(stackValues()).to.eql([1000, 5]);
+      });
+
+      it("should fail on definitions that are too long", () => {
+        run(": ONES 0 DO 1 POSTPONE LITERAL POSTPONE + LOOP ; IMMEDIATE");
+        run(": FOOBAR 0 [ 10000 ] ONES ;", true);
+        expect(output.trim()).to.eql("definition too long");
+        run(": BAR 1 2 + ; BAR");
+        expect(stackValues()).to.eql([3]);
+      });
+
+      it("should compile inlined primitives like executing them", () => {
+        const cases = [
+          "7 -3 + 7 -3 - 7 -3 * 12 10 AND 12 10 OR 12 10 XOR",
+          "3 2 LSHIFT -8 2 RSHIFT -8 2/ 5 2* 5 1+ 5 1- 5 CELLS 5 CELL+",
+          "5 CHAR+ 5 CHARS 5 INVERT 5 NEGATE -5 ABS 5 ABS -3 4 MIN -3 4 MAX",
+          "1 2 < 2 1 < 1 1 = 1 2 <> -1 1 U< -1 1 U> 2 1 >",
+          "0 0= 3 0= -3 0< 3 0< 3 0> 0 0> 0 0<> 3 0<>",
+          "3 0 5 WITHIN 5 0 5 WITHIN -3 S>D TRUE FALSE BL",
+          "1 2 SWAP 3 OVER 4 DUP 5 NIP 6 TUCK 7 ROT 8 DROP",
+          "1 2 3 4 2SWAP 2OVER 2DUP 2DROP 0 ?DUP 9 ?DUP",
+          "HERE 42 OVER ! DUP @ SWAP 3 OVER +! DUP @ SWAP 65 OVER C! C@",
+        ];
+        for (const c of cases) {
+          run(c);
+          const expected = stackValues();
+          run(`: FOOBAR ${c} ; FOOBAR`);
+          expect(stackValues().slice(expected.length)).to.eql(expected, c);
+          run(": CLEAR DEPTH 0 ?DO DROP LOOP ; CLEAR");
+        }
+      });
+
+      it("should compile more cells than fit in the stack cache", () => {
+        run(": FOO 1 2 3 4 5 6 7 8 9 10 11 + 2OVER 2OVER DUP * ;");
+        run("FOO");
+        expect(stackValues()).to.eql([
+          1, 2, 3, 4, 5, 6, 7, 8, 9, 21, 7, 8, 9, 441,
+        ]);
+      });
+
+      it("should spill the stack cache across control flow", () => {
+        run(": FOO 1 2 ROT IF SWAP 3 ELSE 4 THEN 5 ;");
+        run("0 FOO -1 FOO");
+        expect(stackValues()).to.eql([1, 2, 4, 5, 2, 1, 3, 5]);
+      });
+
+      it("should not inline redefined primitives", () => {
+        run(": FOO 3 4 + ;");
+        run(": + * ;");
+        run(": BAR 3 4 + ;");
+        run("FOO BAR");
+        expect(stackValues()).to.eql([7, 12]);
+      });
+
+      it("should compile ticked primitives", () => {
+        run(": FOO [ ' SWAP COMPILE, ] ;");
+        run("1 2 FOO");
+        expect(stackValues()).to.eql([2, 1]);
+      });
     });
 
     describe("POSTPONE", () => {
@@ -1448,6 +1651,310 @@ function loadTests() {
         expect(stackValues()[1]).to.eql(13);
         expect(stackValues()[2]).to.eql(5);
       });
+
+      it("should work compiled", () => {
+        run("VARIABLE FOO");
+        run(": BAR FOO ! FOO @ 1+ ;");
+        run("12 BAR");
+        expect(stackValues()).to.eql([13]);
+      });
+    });
+
+    describe("ALLOT", () => {
+      it("should grow memory", () => {
+        const size = core.memory.buffer.byteLength;
+        run("HERE 1000000 ALLOT HERE SWAP - UNUSED");
+        expect(core.memory.buffer.byteLength).to.be.above(size);
+        expect(stackValues()[0]).to.eql(1000000);
+        expect(stackValues()[1]).to.eql(0x80000000 - here());
+      });
+
+      it("should keep PAD accessible", () => {
+        run("65536 ALLOT 123 PAD ! PAD @");
+        expect(stackValues()).to.eql([123]);
+      });
+
+      it("should fail when out of memory", () => {
+        run("2147483647 ALLOT", true);
+        expect(output.trim()).to.eql("out of memory");
+      });
+    });
+
+    describe("load", () => {
+      it("should accept an initial memory size", async () => {
+        const forth2 = await new WAForth().load({ memory: 0x100000 });
+        expect(forth2.memory().buffer.byteLength).to.eql(0x100000);
+      });
+
+      it("should limit the size of compiled modules", async () => {
+        const forth2 = await new WAForth().load({ moduleSizeLimit: 4096 });
+        let output2 = "";
+        forth2.onEmit = withCharacterBuffer((c) => {
+          output2 = output2 + c;
+        });
+        forth2.interpret(": FOO 0" + " 1 +".repeat(340) + " ;\n");
+        expect(output2).to.include("definition too long");
+        output2 = "";
+        forth2.interpret(": BAR 0" + " 1 +".repeat(100) + " ; BAR .\n");
+        expect(output2).to.eql("100 ok\n");
+      });
+    });
+
+    describe("ALLOCATE / FREE / RESIZE", () => {
+      it("should allocate memory", () => {
+        run("10 ALLOCATE 123 2 PICK ! SWAP @");
+        expect(stackValues()).to.eql([0, 123]);
+      });
+
+      it("should allocate aligned memory outside the data space", () => {
+        run("1 ALLOCATE DROP 7 ALLOCATE DROP 1000 ALLOCATE DROP");
+        const addrs = stackValues();
+        for (const addr of addrs) {
+          expect(addr % 4).to.eql(0);
+          expect(addr).to.be.above(here());
+        }
+        expect(new Set(addrs).size).to.eql(3);
+      });
+
+      it("should put the heap right after the memory in use", () => {
+        run("16 ALLOCATE DROP UNUSED");
+        expect(here() + 0x200000).to.be.above(core.memory.buffer.byteLength);
+        expect(stackValues()[0]).to.be.above(here());
+        expect(stackValues()[1]).to.be.above(0xfffff);
+        run("DROP 2000000 ALLOT", true);
+        expect(output.trim()).to.eql("out of memory");
+      });
+
+      it("should reuse freed blocks", () => {
+        run("32 ALLOCATE DROP DUP FREE DROP 32 ALLOCATE DROP =");
+        expect(stackValues()).to.eql([-1]);
+      });
+
+      it("should merge freed large blocks", () => {
+        run(
+          "1000 ALLOCATE DROP 1000 ALLOCATE DROP 16 ALLOCATE DROP ROT FREE ROT FREE"
+        );
+        expect(stackValues().slice(1)).to.eql([0, 0]);
+        run("HEAP-STATS");
+        expect(stackValues().slice(3)).to.eql([24, 2016, 1]);
+        run("2000 ALLOCATE");
+        expect(stackValues()[7]).to.eql(0);
+        run("HEAP-STATS");
+        expect(stackValues().slice(8)).to.eql([24 + 2016, 0, 0]);
+      });
+
+      it("should give back free blocks at the end of the heap", () => {
+        run("HEAP-STATS 2DROP 1000 ALLOCATE DROP FREE HEAP-STATS");
+        const [used, ior, used2, free2, blocks2] = stackValues();
+        expect([ior, used2, free2, blocks2]).to.eql([0, used, 0, 0]);
+      });
+
+      it("should fail to free an unallocated address", () => {
+        run("HERE FREE");
+        expect(stackValues()).to.eql([-60]);
+      });
+
+      it("should fail to free twice", () => {
+        run("100 ALLOCATE DROP DUP FREE SWAP FREE");
+        expect(stackValues()).to.eql([0, -60]);
+      });
+
+      it("should fail when out of memory", () => {
+        run("2147483647 ALLOCATE NIP");
+        expect(stackValues()).to.eql([-59]);
+      });
+
+      it("should resize memory", () => {
+        run("VARIABLE P 8 ALLOCATE DROP P ! 12345 P @ !");
+        run("P @ 4000 RESIZE SWAP P ! 100 ALLOCATE NIP");
+        run("P @ 8000 RESIZE SWAP P ! P @ @");
+        expect(stackValues()).to.eql([0, 0, 0, 12345]);
+      });
+
+      it("should resize memory in place", () => {
+        run(
+          "1000 ALLOCATE DROP DUP DUP 2000 RESIZE DROP = SWAP DUP 500 RESIZE DROP ="
+        );
+        expect(stackValues()).to.eql([-1, -1]);
+      });
+
+      it("should leave the block as is when resizing fails", () => {
+        run("8 ALLOCATE DROP DUP 2147483647 RESIZE ROT ROT =");
+        expect(stackValues()).to.eql([-61, -1]);
+      });
+    });
+
+    describe("COMPARE", () => {
+      it("should compare equal strings", () => {
+        run(': FOO S" Hello World, this is a long string" 2DUP COMPARE ;');
+        run("FOO");
+        expect(stackValues()).to.eql([0]);
+      });
+
+      it("should compare differing strings", () => {
+        run(
+          ': FOO S" abcdefghijklmnopqrstuvwxyz" S" abcdefghijklmnopqrstuvwxzz" ;'
+        );
+        run("FOO COMPARE FOO 2SWAP COMPARE");
+        expect(stackValues()).to.eql([-1, 1]);
+      });
+
+      it("should compare unsigned characters", () => {
+        run(': FOO S\\" a\\xe9" S" az" ;');
+        run("FOO COMPARE");
+        expect(stackValues()).to.eql([1]);
+      });
+
+      it("should compare prefixes", () => {
+        run(': FOO S" abcdefghijklmnopqrstuvwxyz" ;');
+        run(
+          "FOO FOO 1- COMPARE FOO 1- FOO COMPARE FOO DROP 0 FOO DROP 0 COMPARE"
+        );
+        expect(stackValues()).to.eql([1, -1, 0]);
+      });
+    });
+
+    describe("SEARCH", () => {
+      it("should find a substring", () => {
+        run(
+          ': FOO S" the quick brown fox jumps over the lazy dog" S" lazy" SEARCH ;'
+        );
+        run("FOO");
+        expect(stackValues()[2]).to.eql(-1);
+        expect(getString(stackValues()[0], stackValues()[1])).to.eql(
+          "lazy dog"
+        );
+      });
+
+      it("should find a substring at the start and the end", () => {
+        run(': FOO S" the quick brown fox jumps over the lazy dog" ;');
+        run(': BAR FOO S" the" SEARCH DROP NIP FOO S" dog" SEARCH DROP NIP ;');
+        run("BAR");
+        expect(stackValues()).to.eql([43, 3]);
+      });
+
+      it("should not find a missing substring", () => {
+        run(': FOO S" the quick brown fox jumps over the lazy dog" ;');
+        run(': BAR FOO S" lazy cat" SEARCH ;');
+        run(
+          ': BAZ FOO S" the quick brown fox jumps over the lazy dog!" SEARCH ;'
+        );
+        run("BAR ROT DROP BAZ ROT DROP");
+        expect(stackValues()).to.eql([43, 0, 43, 0]);
+      });
+
+      it("should find an empty string", () => {
+        run(': FOO S" abc" 2DUP 2DUP DROP 0 SEARCH ;');
+        run("FOO");
+        const [addr1, u1, addr3, u3, flag] = stackValues();
+        expect([addr3, u3, flag]).to.eql([addr1, u1, -1]);
+      });
+    });
+
+    describe("-TRAILING", () => {
+      it("should remove trailing spaces", () => {
+        run(
+          ': FOO S" abc                                    " -TRAILING NIP ;'
+        );
+        run(': BAR S" a b c  " -TRAILING NIP S"    " -TRAILING NIP ;');
+        run("FOO BAR");
+        expect(stackValues()).to.eql([3, 5, 0]);
+      });
+    });
+
+    describe("/STRING", () => {
+      it("should work", () => {
+        run(': FOO S" abcdef" 2 /STRING ;');
+        run("FOO");
+        expect(getString(stackValues()[0], stackValues()[1])).to.eql("cdef");
+      });
+    });
+
+    describe("BLANK", () => {
+      it("should fill with spaces", () => {
+        run("HERE 20 ALLOT DUP 20 CHAR x FILL DUP 1+ 18 BLANK 20");
+        expect(getString(stackValues()[0], 20)).to.eql(
+          "x" + " ".repeat(18) + "x"
+        );
+      });
+    });
+
+    describe("V+ / V* / VAND / VOR", () => {
+      beforeEach(() => {
+        run("CREATE A 1 , 2 , 3 , 4 , 5 , 6 , 7 ,");
+        run("CREATE B 10 , 20 , 30 , 40 , 50 , 60 , -1 ,");
+        run("CREATE C 7 CELLS ALLOT");
+      });
+
+      function cells(name, n) {
+        run(name);
+        const addr = stackValues()[0];
+        run("DROP");
+        return Array.from(memory.slice(addr / 4, addr / 4 + n));
+      }
+
+      it("should add", () => {
+        run("A B C 7 V+");
+        expect(cells("C", 7)).to.eql([11, 22, 33, 44, 55, 66, 6]);
+      });
+
+      it("should multiply", () => {
+        run("A B C 7 V*");
+        expect(cells("C", 7)).to.eql([10, 40, 90, 160, 250, 360, -7]);
+      });
+
+      it("should and / or", () => {
+        run("A B C 7 VAND");
+        expect(cells("C", 7)).to.eql([0, 0, 2, 0, 0, 4, 7]);
+        run("A B C 7 VOR");
+        expect(cells("C", 7)).to.eql([11, 22, 31, 44, 55, 62, -1]);
+      });
+
+      it("should work in place", () => {
+        run("A A A 7 V+");
+        expect(cells("A", 7)).to.eql([2, 4, 6, 8, 10, 12, 14]);
+      });
+
+      it("should fill", () => {
+        run("-3 C 6 VFILL");
+        expect(cells("C", 7)).to.eql([-3, -3, -3, -3, -3, -3, 0]);
+      });
+
+      it("should compute running sums", () => {
+        run("A C 7 VPREFIX");
+        expect(cells("C", 7)).to.eql([1, 3, 6, 10, 15, 21, 28]);
+      });
+    });
+
+    describe("VSUM / VMIN / VMAX / VDOT", () => {
+      it("should reduce", () => {
+        run("CREATE A 3 , -4 , 1 , 5 , 9 , -2 , 6 , 0 , 8 ,");
+        run("A 9 VSUM A 9 VMIN A 9 VMAX A 3 VSUM");
+        expect(stackValues()).to.eql([26, -4, 9, 0]);
+      });
+
+      it("should reduce empty arrays", () => {
+        run("HERE 0 VSUM HERE 0 VMIN HERE 0 VMAX");
+        expect(stackValues()).to.eql([0, 2147483647, -2147483648]);
+      });
+
+      it("should compute dot products", () => {
+        run("CREATE A 1 , 2 , 3 , 4 , 5 , 6 ,");
+        run("A A 6 VDOT A A CELL+ 5 VDOT");
+        expect(stackValues()).to.eql([91, 70]);
+      });
+    });
+
+    describe("VHISTOGRAM", () => {
+      it("should count characters", () => {
+        run("CREATE H 256 CELLS ALLOT H 256 CELLS ERASE");
+        run(': FOO S" hello world" H VHISTOGRAM ;');
+        run("FOO FOO");
+        run(
+          "H CHAR l CELLS + @ H CHAR o CELLS + @ H BL CELLS + @ H CHAR x CELLS + @"
+        );
+        expect(stackValues()).to.eql([6, 4, 2, 0]);
+      });
     });
 
     describe("CONSTANT", () => {
@@ -1534,6 +2041,273 @@ function loadTests() {
         expect(output.trim()).to.eql("Error occurred");
         expect(stackValues()[0]).to.eql(8);
       });
+
+      it("should be caught by CATCH", () => {
+        run(': FOO 5 = ABORT" Error occurred" 6 ;');
+        run(": BAR ['] FOO CATCH ;");
+        run("1 5 BAR 7");
+        expect(output.trim()).to.eql("");
+        expect(stackValues().length).to.eql(4);
+        expect(stackValues()[0]).to.eql(1);
+        expect(stackValues()[2]).to.eql(-2);
+        expect(stackValues()[3]).to.eql(7);
+      });
+    });
+
+    describe("CATCH / THROW", () => {
+      it("should return 0 without exception", () => {
+        run(": FOO 1 2 ;");
+        run("' FOO CATCH");
+        expect(stackValues()).to.eql([1, 2, 0]);
+      });
+
+      it("should catch exceptions", () => {
+        run(": FOO 1 2 3 33 THROW ;");
+        run(": BAR 10 20 ['] FOO CATCH 40 ;");
+        run("BAR");
+        expect(stackValues()).to.eql([10, 20, 33, 40]);
+      });
+
+      it("should ignore THROW 0", () => {
+        run(": FOO 1 0 THROW 2 ;");
+        run("' FOO CATCH");
+        expect(stackValues()).to.eql([1, 2, 0]);
+      });
+
+      it("should catch exceptions in nested frames", () => {
+        run(": FOO 12 THROW ;");
+        run(": BAR ['] FOO CATCH 1+ ;");
+        run("' BAR CATCH");
+        expect(stackValues()).to.eql([13, 0]);
+      });
+
+      it("should catch ABORT", () => {
+        run(": FOO 1 ABORT ;");
+        run("' FOO CATCH 2");
+        expect(stackValues()).to.eql([-1, 2]);
+      });
+
+      it("should catch undefined words", () => {
+        run(': FOO S" 1 2 BAZ" EVALUATE ;');
+        run("' FOO CATCH 3");
+        expect(output.trim()).to.eql("");
+        expect(stackValues()).to.eql([-13, 3]);
+      });
+
+      it("should restore the input source", () => {
+        run(': FOO S" 1 BAZ" EVALUATE ;');
+        run("' FOO CATCH 2 3");
+        expect(stackValues()).to.eql([-13, 2, 3]);
+      });
+
+      it("should catch division by 0", () => {
+        run(": FOO 4 0 / ;");
+        run("' FOO CATCH");
+        expect(stackValues()).to.eql([-10]);
+      });
+
+      it("should abort on uncaught exceptions", () => {
+        run("1 2 -33 THROW 3", true);
+        run("4");
+        expect(output.trim()).to.eql("uncaught exception: -33");
+        expect(stackValues()).to.eql([4]);
+      });
+
+      it("should still report uncaught errors", () => {
+        run(": FOO 1 BAZ ;", true);
+        run("2");
+        expect(output.trim()).to.eql("undefined word: BAZ");
+        expect(stackValues()).to.eql([2]);
+      });
+    });
+
+    describe("PAR-DO / SPAWN / JOIN", () => {
+      it("should execute every iteration", () => {
+        run("CREATE SQUARES 10 CELLS ALLOT");
+        run(": SQUARE ( i -- ) DUP DUP * SWAP CELLS SQUARES + ! ;");
+        run("10 0 ' SQUARE PAR-DO");
+        run("SQUARES @ SQUARES 3 CELLS + @ SQUARES 9 CELLS + @");
+        expect(stackValues()).to.eql([0, 9, 81]);
+      });
+
+      it("should not execute empty ranges", () => {
+        run(": FOO 1 THROW ;");
+        run("5 5 ' FOO PAR-DO 1 5 ' FOO PAR-DO 2");
+        expect(stackValues()).to.eql([2]);
+      });
+
+      it("should rethrow exceptions of iterations", () => {
+        run(": FOO 3 = IF 42 THROW THEN ;");
+        run(": BAR 10 0 ['] FOO PAR-DO ;");
+        run("' BAR CATCH");
+        expect(stackValues()).to.eql([42]);
+      });
+
+      it("should run and join tasks", () => {
+        run("VARIABLE RESULT");
+        run(": TASK ( x -- ) 2 * RESULT ! ;");
+        run("21 ' TASK SPAWN JOIN RESULT @");
+        expect(stackValues()).to.eql([42]);
+      });
+
+      it("should rethrow exceptions of tasks", () => {
+        run(": TASK ( x -- ) THROW ;");
+        run(": FOO 7 ['] TASK SPAWN JOIN ;");
+        run("' FOO CATCH");
+        expect(stackValues()).to.eql([7]);
+      });
+
+      it("should run tasks on their own stacks", () => {
+        run("CREATE SQUARES 10 CELLS ALLOT");
+        run(": SQUARE ( i -- ) DUP DUP * SWAP CELLS SQUARES + ! ;");
+        run(": FOO 5 = IF 42 THROW THEN ;");
+        run("' SQUARE ' FOO");
+        const foo = forth.pop();
+        const square = forth.pop();
+        const stacks = core.allocateTaskStacks();
+        expect(core.runTask(stacks, square, 0, 10)).to.eql(0);
+        expect(core.runTask(stacks, foo, 3, 5)).to.eql(42);
+        run("SQUARES 7 CELLS + @");
+        expect(stackValues()).to.eql([49]);
+      });
+
+      it("should give task threads their own transient regions", () => {
+        run("VARIABLE P : SET-PAD ( i -- ) DROP PAD P ! ;");
+        run("' SET-PAD");
+        const setPad = forth.pop();
+        const stacks = core.allocateTaskStacks();
+        expect(core.runTask(stacks, setPad, 0, 1)).to.eql(0);
+        run("P @");
+        const pad = forth.pop();
+        expect(pad > stacks && pad < stacks + 0x5800).to.eql(true);
+      });
+
+      it("should not change the data space or the heap on task threads", () => {
+        run(": GROW ( i -- ) ALLOT ;");
+        run(": ALLOC ( i -- ) ALLOCATE THROW DROP ;");
+        run(": COMPILE-WORD ( i -- ) DROP S\" : FOO ;\" EVALUATE ;");
+        run(": FOO ( i -- ) DROP ] ;");
+        run("1 0 ' DROP PAR-DO ' GROW ' ALLOC ' COMPILE-WORD ' FOO");
+        const foo = forth.pop();
+        const compileWord = forth.pop();
+        const alloc = forth.pop();
+        const grow = forth.pop();
+        const here = core.here();
+        const stacks = core.allocateTaskStacks();
+        expect(core.runTask(stacks, grow, 4, 1)).to.eql(-21);
+        expect(core.runTask(stacks, alloc, 4, 1)).to.eql(-21);
+        expect(core.runTask(stacks, compileWord, 0, 1)).to.eql(-21);
+        expect(core.runTask(stacks, foo, 0, 1)).to.eql(-21);
+        expect(core.here()).to.eql(here);
+        run("4 ALLOCATE THROW FREE THROW 1 ALLOT STATE @");
+        expect(core.here()).to.eql(here + 1);
+        expect(stackValues()).to.eql([0]);
+      });
+
+      it("should find words on task threads", () => {
+        run("VARIABLE R : CALL-LATER ( i -- ) C\" LATER\" FIND DROP EXECUTE + R ! ;");
+        run(": LATER ( -- n ) 42 ;");
+        run("1 0 ' DROP PAR-DO ' CALL-LATER");
+        const callLater = forth.pop();
+        const stacks = core.allocateTaskStacks();
+        expect(core.runTask(stacks, callLater, 3, 1)).to.eql(0);
+        run("R @");
+        expect(stackValues()).to.eql([45]);
+      });
+    });
+
+    describe("Scheduler", () => {
+      it("should give active tasks a turn on RUN-TASKS", () => {
+        run("VARIABLE COUNTER TASK T1 : TICK 1 COUNTER +! ;");
+        run(": FOO ['] TICK T1 SCHEDULE RUN-TASKS RUN-TASKS RUN-TASKS COUNTER @ ;");
+        run("FOO");
+        expect(stackValues()).to.eql([3]);
+      });
+
+      it("should stop tasks", () => {
+        run("VARIABLE COUNTER TASK T1");
+        run(": TICK COUNTER @ 1+ DUP COUNTER ! 2 = IF STOP THEN ;");
+        run(": FOO ['] TICK T1 SCHEDULE RUN-TASKS RUN-TASKS RUN-TASKS RUN-TASKS COUNTER @ ;");
+        run("FOO");
+        expect(stackValues()).to.eql([2]);
+      });
+
+      it("should keep the stack of a task between turns", () => {
+        run("VARIABLE RESULT TASK T1");
+        run(": PRODUCER DEPTH RESULT ! 1 ;");
+        run(": FOO ['] PRODUCER T1 SCHEDULE 5 RUN-TASKS RUN-TASKS RUN-TASKS RESULT @ ;");
+        run("FOO");
+        expect(stackValues()).to.eql([5, 2]);
+      });
+
+      it("should have task-local user variables", () => {
+        run("USER COLOR TASK T1 TASK T2");
+        run(": PAINT-1 2 COLOR ! STOP ; : PAINT-2 3 COLOR ! STOP ;");
+        run("' PAINT-1 T1 SCHEDULE ' PAINT-2 T2 SCHEDULE 1 COLOR ! RUN-TASKS");
+        run("COLOR @ T1 ' COLOR >BODY @ + @ T2 ' COLOR >BODY @ + @");
+        expect(stackValues()).to.eql([1, 2, 3]);
+      });
+
+      it("should stop tasks that throw", () => {
+        run("VARIABLE COUNTER TASK T1");
+        run(": TICK 1 COUNTER +! 42 THROW ;");
+        run(": FOO ['] TICK T1 SCHEDULE RUN-TASKS RUN-TASKS 7 ;");
+        run("FOO COUNTER @");
+        expect(stackValues()).to.eql([7, 1]);
+      });
+
+      it("should fail on RUN-TASKS in a task", () => {
+        run("VARIABLE COUNTER TASK T1 : TICK BEGIN 1 COUNTER +! RUN-TASKS 0 UNTIL ;");
+        run(": FOO ['] TICK T1 SCHEDULE RUN-TASKS RUN-TASKS COUNTER @ ;");
+        run("FOO");
+        expect(stackValues()).to.eql([1]);
+        expect(output.trim()).to.eql("RUN-TASKS in a task");
+      });
+
+      it("should give tasks a turn while waiting for input", () => {
+        run("VARIABLE COUNTER TASK T1 : TICK 1 COUNTER +! ;");
+        run("' TICK T1 SCHEDULE");
+        run("COUNTER @ 0>");
+        expect(stackValues()).to.eql([-1]);
+      });
+
+      it("should unlink forgotten tasks", () => {
+        run("VARIABLE COUNTER : TICK 1 COUNTER +! ;");
+        run("MARKER FORGET-TASKS TASK T1 ' TICK T1 SCHEDULE FORGET-TASKS");
+        run(": FOO 0 COUNTER ! RUN-TASKS RUN-TASKS COUNTER @ ;");
+        run("FOO");
+        expect(stackValues()).to.eql([0]);
+      });
+
+      it("should link tasks to the operator", () => {
+        run("OPERATOR @ OPERATOR = TASK T1 OPERATOR @ T1 = T1 @ OPERATOR =");
+        expect(stackValues()).to.eql([-1, -1, -1]);
+      });
+    });
+
+    describe("Fuel", () => {
+      it("should abort loops that run out of fuel", () => {
+        core.setFuel(10);
+        run(": FOO 5 0 DO LOOP ;");
+        run("FOO FOO");
+        run("FOO 1", true);
+        expect(output.trim()).to.eql("out of fuel");
+        expect(stackValues()).to.eql([]);
+      });
+
+      it("should not let CATCH continue after running out of fuel", () => {
+        core.setFuel(1000);
+        run(": BAR BEGIN 0 UNTIL ; : BAZ BEGIN ['] BAR CATCH DROP 0 UNTIL ;");
+        run("BAZ", true);
+        expect(output.trim()).to.eql("out of fuel");
+      });
+
+      it("should not count loops compiled without a limit", () => {
+        run(": FOO 100 0 DO LOOP ;");
+        core.setFuel(10);
+        run("FOO 1");
+        expect(stackValues()).to.eql([1]);
+      });
     });
 
     describe("S>D", () => {
@@ -1720,6 +2494,14 @@ CODE DUP' ( n -- n n )
         run("100 sieve");
         expect(output.trim()).to.eql("97");
       });
+
+      it("should run sieve beyond the initial memory", () => {
+        run(sieve);
+        const here = core.here();
+        run("1000000 sieve");
+        expect(output.trim()).to.eql("999983");
+        expect(core.here()).to.eql(here);
+      });
     });
 
     describe("forth2012 test suite", () => {
@@ -35,6 +35,13 @@ function saveString(s: string, memory: WebAssembly.Memory, addr: number) {
   return len;
 }
 
+function growMemory(memory: WebAssembly.Memory, size: number) {
+  const pages = Math.ceil((size - memory.buffer.byteLength) / 0x10000);
+  if (pages > 0) {
+    memory.grow(pages);
+  }
+}
+
 /**
  * Creates a function that accepts character codes in UTF-8 encoding, and calls
  * the callback whenever a complete character is received.
@@ -127,6 +134,14 @@ class WAForth {
    * `c` is the single-character string that is emitted
    */
   onEmit?: (c: number) => void;
+
+  /**
+   * Callback that is called when a string needs to be output.
+   *
+   * `s` contains the UTF-8 encoded bytes of the string, and is only valid
+   * during the call. If not set, `onEmit` is called for every byte.
+   */
+  onType?: (s: Uint8Array) => void;
   key: () => number;
 
   constructor() {
@@ -153,8 +168,16 @@ class WAForth {
    * Initialize WAForth.
    *
    * Needs to be called before interpret().
+   *
+   * `options.memory` is the initial size (in bytes) of the memory. Memory
+   * grows on demand beyond this.
+   *
+   * `options.moduleSizeLimit` is the maximum size (in bytes) of the modules
+   * of compiled words. On the main thread of a browser, this defaults to 4096,
+   * because Chrome refuses to compile larger modules synchronously there.
+   * Definitions that don't fit fail with "definition too long".
    */
-  async load() {
+  async load(options: { memory?: number; moduleSizeLimit?: number } = {}) {
     this.#buffer = "";
 
     const instance = await WebAssembly.instantiate(wasmModule, {
@@ -169,7 +192,17 @@ class WAForth {
           }
         },
 
-        // eslint-disable-next-line @typescript-eslint/no-unused-vars
+        type: (addr: number, len: number) => {
+          const s = new Uint8Array(memory.buffer, addr, len);
+          if (this.onType) {
+            this.onType(s);
+          } else if (this.onEmit) {
+            for (let i = 0; i < len; ++i) {
+              this.onEmit(s[i]);
+            }
+          }
+        },
+
         read: (addr: number, length: number): number => {
           let input: string;
           const i = this.#buffer!.indexOf("\n");
@@ -180,12 +213,18 @@ class WAForth {
             input = this.#buffer!.substring(0, i + 1);
             this.#buffer = this.#buffer!.substring(i + 1);
           }
-          // console.log("read: %s (%d remaining)", input, this.#buffer!.length);
-          return saveString(
+          // Lines that don't fit are passed on in pieces
+          const { read, written } = new TextEncoder().encodeInto(
             input,
-            this.core!.exports.memory as WebAssembly.Memory,
-            addr
+            new Uint8Array(
+              (this.core!.exports.memory as WebAssembly.Memory).buffer,
+              addr,
+              length
+            )
           );
+          this.#buffer = input.substring(read!) + this.#buffer;
+          // console.log("read: %s (%d remaining)", input, this.#buffer!.length);
+          return written!;
         },
 
         key: () => {
@@ -220,6 +259,9 @@ class WAForth {
             data = new Uint8Array(dataCopy);
           }
           // console.log("Load", arrayToBase64(data));
+          // Modules are compiled synchronously, as the words need to be available
+          // right away. Chrome only allows this on the main thread for modules
+          // up to 4 KiB (see `moduleSizeLimit`).
           try {
             const module = new WebAssembly.Module(data);
             new WebAssembly.Instance(module, {
@@ -246,11 +288,27 @@ class WAForth {
             fn(this);
           }
         },
+
+        ////////////////////////////////////////
+        // Tasks
+        ////////////////////////////////////////
+
+        // There are no threads, so the core runs PAR-DO and SPAWN itself
+        parallel: () => -1,
+        spawn: () => 0,
+        join: () => 0,
       },
     });
     this.core = instance.instance;
     const table = this.core.exports.table as WebAssembly.Table;
     const memory = this.core.exports.memory as WebAssembly.Memory;
+    growMemory(memory, options.memory ?? 0);
+    const moduleSizeLimit =
+      options.moduleSizeLimit ??
+      (typeof document !== "undefined" ? 4096 : undefined);
+    if (moduleSizeLimit != null) {
+      (this.core.exports.setModuleSizeLimit as any)(moduleSizeLimit);
+    }
     return this;
   }
 
@@ -279,6 +337,7 @@ class WAForth {
   // eslint-disable-next-line @typescript-eslint/no-unused-vars
   pushString(s: string, offset = 0): number {
     const addr = this.here() + PAD_OFFSET;
+    growMemory(this.memory(), addr + new TextEncoder().encode(s).length);
     const len = saveString(s, this.memory(), addr);
     this.push(addr);
     this.push(len);